@@ -13,260 +13,13 @@
 #include "rtc_common.h"
 #include "maths.h"
 
-//List of logger field names. This must be in the same order and length as logger_updateLogdataCSV()
-constexpr char header_0[] PROGMEM = "secl";
-constexpr char header_1[] PROGMEM = "status1";
-constexpr char header_2[] PROGMEM = "engine";
-constexpr char header_3[] PROGMEM = "Sync Loss #";
-constexpr char header_4[] PROGMEM = "MAP";
-constexpr char header_5[] PROGMEM = "IAT(C)";
-constexpr char header_6[] PROGMEM = "CLT(C)";
-constexpr char header_7[] PROGMEM = "Battery Correction";
-constexpr char header_8[] PROGMEM = "Battery V";
-constexpr char header_9[] PROGMEM = "AFR";
-constexpr char header_10[] PROGMEM = "EGO Correction";
-constexpr char header_11[] PROGMEM = "IAT Correction";
-constexpr char header_12[] PROGMEM = "WUE Correction";
-constexpr char header_13[] PROGMEM = "RPM";
-constexpr char header_14[] PROGMEM = "Accel. Correction";
-constexpr char header_15[] PROGMEM = "Gamma Correction";
-constexpr char header_16[] PROGMEM = "VE1";
-constexpr char header_17[] PROGMEM = "VE2";
-constexpr char header_18[] PROGMEM = "AFR Target";
-constexpr char header_19[] PROGMEM = "TPSdot";
-constexpr char header_20[] PROGMEM = "Advance Current";
-constexpr char header_21[] PROGMEM = "TPS";
-constexpr char header_22[] PROGMEM = "Loops/S";
-constexpr char header_23[] PROGMEM = "Free RAM";
-constexpr char header_24[] PROGMEM = "Boost Target";
-constexpr char header_25[] PROGMEM = "Boost Duty";
-constexpr char header_26[] PROGMEM = "status2";
-constexpr char header_27[] PROGMEM = "rpmDOT";
-constexpr char header_28[] PROGMEM = "Eth%";
-constexpr char header_29[] PROGMEM = "Flex Fuel Correction";
-constexpr char header_30[] PROGMEM = "Flex Adv Correction";
-constexpr char header_31[] PROGMEM = "IAC Steps/Duty";
-constexpr char header_32[] PROGMEM = "testoutputs";
-constexpr char header_33[] PROGMEM = "AFR2";
-constexpr char header_34[] PROGMEM = "Baro";
-constexpr char header_35[] PROGMEM = "AUX_IN 0";
-constexpr char header_36[] PROGMEM = "AUX_IN 1";
-constexpr char header_37[] PROGMEM = "AUX_IN 2";
-constexpr char header_38[] PROGMEM = "AUX_IN 3";
-constexpr char header_39[] PROGMEM = "AUX_IN 4";
-constexpr char header_40[] PROGMEM = "AUX_IN 5";
-constexpr char header_41[] PROGMEM = "AUX_IN 6";
-constexpr char header_42[] PROGMEM = "AUX_IN 7";
-constexpr char header_43[] PROGMEM = "AUX_IN 8";
-constexpr char header_44[] PROGMEM = "AUX_IN 9";
-constexpr char header_45[] PROGMEM = "AUX_IN 10";
-constexpr char header_46[] PROGMEM = "AUX_IN 11";
-constexpr char header_47[] PROGMEM = "AUX_IN 12";
-constexpr char header_48[] PROGMEM = "AUX_IN 13";
-constexpr char header_49[] PROGMEM = "AUX_IN 14";
-constexpr char header_50[] PROGMEM = "AUX_IN 15";
-constexpr char header_51[] PROGMEM = "TPS ADC";
-constexpr char header_52[] PROGMEM = "Errors";
-constexpr char header_53[] PROGMEM = "PW";
-constexpr char header_54[] PROGMEM = "PW2";
-constexpr char header_55[] PROGMEM = "PW3";
-constexpr char header_56[] PROGMEM = "PW4";
-constexpr char header_57[] PROGMEM = "status3";
-constexpr char header_58[] PROGMEM = "Engine Protect";
-constexpr char header_59[] PROGMEM = "";
-constexpr char header_60[] PROGMEM = "Fuel Load";
-constexpr char header_61[] PROGMEM = "Ign Load";
-constexpr char header_62[] PROGMEM = "Dwell Requested";
-constexpr char header_63[] PROGMEM = "Idle Target (RPM)";
-constexpr char header_64[] PROGMEM = "MAP DOT";
-constexpr char header_65[] PROGMEM = "VVT1 Angle";
-constexpr char header_66[] PROGMEM = "VVT1 Target";
-constexpr char header_67[] PROGMEM = "VVT1 Duty";
-constexpr char header_68[] PROGMEM = "Flex Boost Adj";
-constexpr char header_69[] PROGMEM = "Baro Correction";
-constexpr char header_70[] PROGMEM = "VE Current";
-constexpr char header_71[] PROGMEM = "ASE Correction";
-constexpr char header_72[] PROGMEM = "Vehicle Speed";
-constexpr char header_73[] PROGMEM = "Gear";
-constexpr char header_74[] PROGMEM = "Fuel Pressure";
-constexpr char header_75[] PROGMEM = "Oil Pressure";
-constexpr char header_76[] PROGMEM = "WMI PW";
-constexpr char header_77[] PROGMEM = "status4";
-constexpr char header_78[] PROGMEM = "VVT2 Angle";
-constexpr char header_79[] PROGMEM = "VVT2 Target";
-constexpr char header_80[] PROGMEM = "VVT2 Duty";
-constexpr char header_81[] PROGMEM = "outputs";
-constexpr char header_82[] PROGMEM = "Fuel Temp";
-constexpr char header_83[] PROGMEM = "Fuel Temp Correction";
-constexpr char header_84[] PROGMEM = "Advance 1";
-constexpr char header_85[] PROGMEM = "Advance 2";
-constexpr char header_86[] PROGMEM = "SD Status";
-constexpr char header_87[] PROGMEM = "EMAP";
-constexpr char header_88[] PROGMEM = "Fan Duty";
-constexpr char header_89[] PROGMEM = "AirConStatus";
-constexpr char header_90[] PROGMEM = "Dwell Actual";
-/*
-constexpr char header_91[] PROGMEM = "";
-constexpr char header_92[] PROGMEM = "";
-constexpr char header_93[] PROGMEM = "";
-constexpr char header_94[] PROGMEM = "";
-constexpr char header_95[] PROGMEM = "";
-constexpr char header_96[] PROGMEM = "";
-constexpr char header_97[] PROGMEM = "";
-constexpr char header_98[] PROGMEM = "";
-constexpr char header_99[] PROGMEM = "";
-constexpr char header_100[] PROGMEM = "";
-constexpr char header_101[] PROGMEM = "";
-constexpr char header_102[] PROGMEM = "";
-constexpr char header_103[] PROGMEM = "";
-constexpr char header_104[] PROGMEM = "";
-constexpr char header_105[] PROGMEM = "";
-constexpr char header_106[] PROGMEM = "";
-constexpr char header_107[] PROGMEM = "";
-constexpr char header_108[] PROGMEM = "";
-constexpr char header_109[] PROGMEM = "";
-constexpr char header_110[] PROGMEM = "";
-constexpr char header_111[] PROGMEM = "";
-constexpr char header_112[] PROGMEM = "";
-constexpr char header_113[] PROGMEM = "";
-constexpr char header_114[] PROGMEM = "";
-constexpr char header_115[] PROGMEM = "";
-constexpr char header_116[] PROGMEM = "";
-constexpr char header_117[] PROGMEM = "";
-constexpr char header_118[] PROGMEM = "";
-constexpr char header_119[] PROGMEM = "";
-constexpr char header_120[] PROGMEM = "";
-constexpr char header_121[] PROGMEM = "";
-*/
-
-constexpr const char* header_table[] PROGMEM = {  header_0,\
-                                              header_1,\
-                                              header_2,\
-                                              header_3,\
-                                              header_4,\
-                                              header_5,\
-                                              header_6,\
-                                              header_7,\
-                                              header_8,\
-                                              header_9,\
-                                              header_10,\
-                                              header_11,\
-                                              header_12,\
-                                              header_13,\
-                                              header_14,\
-                                              header_15,\
-                                              header_16,\
-                                              header_17,\
-                                              header_18,\
-                                              header_19,\
-                                              header_20,\
-                                              header_21,\
-                                              header_22,\
-                                              header_23,\
-                                              header_24,\
-                                              header_25,\
-                                              header_26,\
-                                              header_27,\
-                                              header_28,\
-                                              header_29,\
-                                              header_30,\
-                                              header_31,\
-                                              header_32,\
-                                              header_33,\
-                                              header_34,\
-                                              header_35,\
-                                              header_36,\
-                                              header_37,\
-                                              header_38,\
-                                              header_39,\
-                                              header_40,\
-                                              header_41,\
-                                              header_42,\
-                                              header_43,\
-                                              header_44,\
-                                              header_45,\
-                                              header_46,\
-                                              header_47,\
-                                              header_48,\
-                                              header_49,\
-                                              header_50,\
-                                              header_51,\
-                                              header_52,\
-                                              header_53,\
-                                              header_54,\
-                                              header_55,\
-                                              header_56,\
-                                              header_57,\
-                                              header_58,\
-                                              header_59,\
-                                              header_60,\
-                                              header_61,\
-                                              header_62,\
-                                              header_63,\
-                                              header_64,\
-                                              header_65,\
-                                              header_66,\
-                                              header_67,\
-                                              header_68,\
-                                              header_69,\
-                                              header_70,\
-                                              header_71,\
-                                              header_72,\
-                                              header_73,\
-                                              header_74,\
-                                              header_75,\
-                                              header_76,\
-                                              header_77,\
-                                              header_78,\
-                                              header_79,\
-                                              header_80,\
-                                              header_81,\
-                                              header_82,\
-                                              header_83,\
-                                              header_84,\
-                                              header_85,\
-                                              header_86,\
-                                              header_87,\
-                                              header_88,\
-                                              header_89,\
-                                              header_90,\
-                                              /*
-                                              header_91,\
-                                              header_92,\
-                                              header_93,\
-                                              header_94,\
-                                              header_95,\
-                                              header_96,\
-                                              header_97,\
-                                              header_98,\
-                                              header_99,\
-                                              header_100,\
-                                              header_101,\
-                                              header_102,\
-                                              header_103,\
-                                              header_104,\
-                                              header_105,\
-                                              header_106,\
-                                              header_107,\
-                                              header_108,\
-                                              header_109,\
-                                              header_110,\
-                                              header_111,\
-                                              header_112,\
-                                              header_113,\
-                                              header_114,\
-                                              header_115,\
-                                              header_116,\
-                                              header_117,\
-                                              header_118,\
-                                              header_119,\
-                                              header_120,\
-                                              header_121,\
-                                              */
-                                            };
-#define SD_LOG_NUM_FIELDS   91 /**< The number of fields that are in the log. This is always smaller than the entry size due to some fields being 2 bytes */
-
-static_assert(sizeof(header_table) == (sizeof(char*) * SD_LOG_NUM_FIELDS), "Number of header table titles must match number of log fields");
+//The log field types are written directly into binary log headers
+static_assert( (LOG_FIELD_U08 == MLG_TYPE_U08) && (LOG_FIELD_S08 == MLG_TYPE_S08) && (LOG_FIELD_U16 == MLG_TYPE_U16) && (LOG_FIELD_S16 == MLG_TYPE_S16), "Log field types must match the MLG field types");
+static_assert(LOG_FIELD_UNITS_LENGTH <= MLG_FIELD_UNITS_LENGTH, "Log field units must fit in the MLG field units");
+
+#define MLG_RECORD_SIZE   (sizeof(uint32_t) + sizeof(liveDataBlock)) /**< Each binary record is the log time (ms) followed by the live data block */
+#define MLG_BLOCK_SIZE    (MLG_BLOCK_HEADER_SIZE + MLG_RECORD_SIZE + 1U) /**< Block header, record and checksum */
+constexpr char mlg_info[] PROGMEM = "Speeduino onboard log";
 
 SdExFat sd;
 ExFile logFile;
@@ -275,6 +28,37 @@ uint8_t SD_status = SD_STATUS_OFF;
 uint16_t currentLogFileNumber;
 bool manualLogActive = false;
 uint32_t logStartTime = 0; //In ms
+static uint8_t logFileStyle = LOGGER_CSV; //The style of the log currently being written. Fixed for the life of each log file
+static uint8_t mlgSwapOffsets[LOG_FIELD_COUNT]; //Offsets of the 16 bit fields within the live data block. These must be byte swapped as MLG is big endian
+static uint8_t mlgSwapCount = 0;
+static uint8_t mlgBlockCounter = 0;
+static liveDataBlock logData; //The logs take their own snapshot of the live data. liveData can't be refreshed from here as a legacy serial send may be part way through reading it (See isLiveDataLocked())
+
+/** @brief A frame of the pre/post trigger capture buffer */
+struct captureFrame {
+  uint32_t time; //millis() when the frame was captured
+  liveDataBlock data;
+};
+static captureFrame captureBuffer[SD_CAPTURE_FRAMES]; //Ring buffer of the most recent frames
+static uint16_t captureHead = 0; //Index the next frame will be written to
+static uint16_t captureCount = 0; //Number of valid frames in the buffer
+static uint16_t capturePostRemaining = 0; //Frames still to be captured after the trigger
+static uint16_t captureFlushIndex = 0; //Next frame to be written to the card
+static uint16_t captureFlushRemaining = 0; //Frames still to be written to the card
+static uint32_t captureStartTime = 0; //millis() of the first frame written to the card
+static uint8_t captureTickCount = 0;
+static uint8_t captureLastSyncLoss = 0;
+static bool captureTriggerActive = false;
+static bool captureFileOpen = false; //The current log file is a capture being written out
+static uint8_t captureState = CAPTURE_STATE_IDLE;
+
+/** 
+ * Builds the filename for a given log number. TunerStudio only supports 8.3 filename format, so the buffer must be at least 13 chars
+ */
+static void getLogFilename(char *filenameBuffer, uint16_t logNumber, const char *extension)
+{
+  snprintf(filenameBuffer, 13, "%s%04d.%s", LOG_FILE_PREFIX, logNumber, extension);
+}
 
 void initSD()
 {
@@ -332,7 +116,7 @@ bool createLogFile()
   //Create the filename
   //sprintf(filenameBuffer, "%s%04d.%s", LOG_FILE_PREFIX, currentLogFileNumber, LOG_FILE_EXTENSION);
   if(currentLogFileNumber > MAX_LOG_FILES) { currentLogFileNumber = 1; } //If we've run out of file numbers, start again from 1
-  snprintf(filenameBuffer, 13, "%s%04d.%s", LOG_FILE_PREFIX, currentLogFileNumber, LOG_FILE_EXTENSION);
+  getLogFilename(filenameBuffer, currentLogFileNumber, (logFileStyle == LOGGER_BINARY) ? LOG_FILE_EXTENSION_BINARY : LOG_FILE_EXTENSION);
 
   logFile.close();
   if (logFile.open(filenameBuffer, O_RDWR | O_CREAT | O_TRUNC)) 
@@ -347,13 +131,16 @@ uint16_t getNextSDLogFileNumber()
 {
   uint16_t nextFileNumber = 1;
   char filenameBuffer[13]; //8 + 1 + 3 + 1
-  sprintf(filenameBuffer, "%s%04d.%s", LOG_FILE_PREFIX, nextFileNumber, LOG_FILE_EXTENSION);
+  char binaryFilenameBuffer[13];
+  getLogFilename(filenameBuffer, nextFileNumber, LOG_FILE_EXTENSION);
+  getLogFilename(binaryFilenameBuffer, nextFileNumber, LOG_FILE_EXTENSION_BINARY);
 
-  //Lookup the next available file number
-  while( (nextFileNumber < MAX_LOG_FILES) && (sd.exists(filenameBuffer)) )
+  //Lookup the next available file number. CSV and binary logs share the numbering
+  while( (nextFileNumber < MAX_LOG_FILES) && (sd.exists(filenameBuffer) || sd.exists(binaryFilenameBuffer)) )
   {
     nextFileNumber++;
-    sprintf(filenameBuffer, "%s%04d.%s", LOG_FILE_PREFIX, nextFileNumber, LOG_FILE_EXTENSION);
+    getLogFilename(filenameBuffer, nextFileNumber, LOG_FILE_EXTENSION);
+    getLogFilename(binaryFilenameBuffer, nextFileNumber, LOG_FILE_EXTENSION_BINARY);
   }
 
   return nextFileNumber;
@@ -367,7 +154,8 @@ bool getSDLogFileDetails(uint8_t* buffer, uint16_t logNumber)
 
   char filenameBuffer[13]; //8 + 1 + 3 + 1
   if(logNumber > MAX_LOG_FILES) { logNumber = MAX_LOG_FILES; } //If we've run out of file numbers, start again from 1
-  snprintf(filenameBuffer, 13, "%s%04d.%s", LOG_FILE_PREFIX, logNumber, LOG_FILE_EXTENSION);
+  getLogFilename(filenameBuffer, logNumber, LOG_FILE_EXTENSION);
+  if(!sd.exists(filenameBuffer)) { getLogFilename(filenameBuffer, logNumber, LOG_FILE_EXTENSION_BINARY); }
   
   if(sd.exists(filenameBuffer))
   {
@@ -437,12 +225,19 @@ void readSDSectors(uint8_t* buffer, uint32_t sectorNumber, uint16_t sectorCount)
 
 // Forward declare
 void writeSDLogHeader();
+static void writeBinaryLogHeader(void);
+static void writeBinaryLogEntry(void);
 
-void beginSDLogging()
+/** 
+ * Creates a new log file of the given style (LOGGER_CSV or LOGGER_BINARY) and writes its header.
+ * SD_status is set to SD_STATUS_ACTIVE if this succeeds
+ */
+static void beginLogFile(uint8_t style)
 {
   if(SD_status == SD_STATUS_READY)
   {
     SD_status = SD_STATUS_ACTIVE; //Set the status as being active so that entries will begin to be written. This will be updated below if there is an error
+    logFileStyle = style;
 
     // Open or create file - truncate existing file.
     if (!createLogFile()) 
@@ -464,13 +259,19 @@ void beginSDLogging()
     rb.begin(&logFile);
 
     //Write a header row
-    writeSDLogHeader();
+    if(logFileStyle == LOGGER_BINARY) { writeBinaryLogHeader(); }
+    else { writeSDLogHeader(); }
 
     //Note the start time
     logStartTime = millis();
   }
 }
 
+void beginSDLogging()
+{
+  beginLogFile( (configPage13.onboard_log_file_style == LOGGER_BINARY) ? LOGGER_BINARY : LOGGER_CSV );
+}
+
 void endSDLogging()
 {
   if(SD_status == SD_STATUS_ACTIVE)
@@ -493,6 +294,9 @@ void checkForSDStop();
 
 void writeSDLogEntry()
 {
+  //Once frozen, the capture buffer has the card to itself until it has been written out (See flushSDCapture())
+  if(captureState == CAPTURE_STATE_FLUSHING) { return; }
+
   //Check if we're already running a log
   if(SD_status == SD_STATUS_READY)
   {
@@ -502,30 +306,40 @@ void writeSDLogEntry()
 
   if(SD_status == SD_STATUS_ACTIVE)
   {
-    //Write the timestamp (x.yyy seconds format)
-    uint32_t duration = millis() - logStartTime;
-    uint32_t seconds = duration / 1000;
-    uint32_t milliseconds = duration % 1000;
-    rb.print(seconds);
-    rb.print('.');
-    if (milliseconds < 100) { rb.print("0"); }
-    if (milliseconds < 10) { rb.print("0"); }
-    rb.print(milliseconds);
-    rb.print(',');
-
-    //Write the line to the ring buffer
-    for(byte x=0; x<SD_LOG_NUM_FIELDS; x++)
+    if(logFileStyle == LOGGER_BINARY)
     {
-      #if FPU_MAX_SIZE >= 32
-        float entryValue = getReadableFloatLogEntry(x);
-        if(IS_INTEGER(entryValue)) { rb.print((uint16_t)entryValue); }
-        else { rb.print(entryValue); }
-      #else
-        rb.print(getReadableLogEntry(x));
-      #endif
-      if(x < (SD_LOG_NUM_FIELDS - 1)) { rb.print(","); }
+      writeBinaryLogEntry();
+    }
+    else
+    {
+      //Write the timestamp (x.yyy seconds format)
+      uint32_t duration = millis() - logStartTime;
+      uint32_t seconds = duration / 1000;
+      uint32_t milliseconds = duration % 1000;
+      rb.print(seconds);
+      rb.print('.');
+      if (milliseconds < 100) { rb.print("0"); }
+      if (milliseconds < 10) { rb.print("0"); }
+      rb.print(milliseconds);
+      rb.print(',');
+
+      //Write the line to the ring buffer. All fields are read from a single snapshot of the live data
+      updateLiveData(logData);
+      for(byte x=0; x<LOG_FIELD_COUNT; x++)
+      {
+        #if FPU_MAX_SIZE >= 32
+          logFieldDescriptor field;
+          getLogField(x, field);
+          float entryValue = getLogFieldValue(field, logData);
+          if(field.digits == 0U) { rb.print((int32_t)entryValue); }
+          else { rb.print(entryValue, field.digits); }
+        #else
+          rb.print(getReadableLogEntry(x, logData));
+        #endif
+        if(x < (LOG_FIELD_COUNT - 1)) { rb.print(","); }
+      }
+      rb.println("");
     }
-    rb.println("");
 
     //Check if write to SD from ringbuffer is needed
     //We write to SD when there is more than 1 sector worth of data in the ringbuffer and there is not already a write being performed
@@ -559,21 +373,303 @@ void writeSDLogHeader()
   rb.print("Time,");
 
   //WRite remaining fields based on log definitions
-  for(byte x=0; x<SD_LOG_NUM_FIELDS; x++)
+  for(byte x=0; x<LOG_FIELD_COUNT; x++)
   {
+    logFieldDescriptor field;
+    getLogField(x, field);
     #ifdef CORE_AVR
       //This will probably never be used
       char buffer[30];
-      strcpy_P(buffer, (char *)pgm_read_word(&(header_table[x])));
+      strcpy_P(buffer, field.name);
       rb.print(buffer);
     #else
-      rb.print(header_table[x]);
+      rb.print(field.name);
     #endif
-    if(x < (SD_LOG_NUM_FIELDS - 1)) { rb.print(","); }
+    if(x < (LOG_FIELD_COUNT - 1)) { rb.print(","); }
   }
   rb.println("");
 }
 
+/** 
+ * Writes to the ring buffer, flushing whole sectors out to the card as they fill.
+ * Only used for the binary header, which is several times larger than the ring buffer
+ */
+static void writeLogBytes(const byte *data, size_t length)
+{
+  rb.write(data, length);
+  while( (rb.bytesUsed() >= SD_SECTOR_SIZE) && (SD_status == SD_STATUS_ACTIVE) )
+  {
+    if (SD_SECTOR_SIZE != rb.writeOut(SD_SECTOR_SIZE)) { SD_status = SD_STATUS_ERROR_WRITE_FAIL; }
+  }
+}
+
+static void writeBigEndian(byte *buffer, uint32_t value)
+{
+  buffer[0] = (byte)(value >> 24);
+  buffer[1] = (byte)(value >> 16);
+  buffer[2] = (byte)(value >> 8);
+  buffer[3] = (byte)value;
+}
+
+static void writeBigEndianFloat(byte *buffer, float value)
+{
+  uint32_t raw;
+  memcpy(&raw, &value, sizeof(raw));
+  writeBigEndian(buffer, raw);
+}
+
+/** 
+ * Writes the MLVLG header for a binary log. 
+ * The header describes each field of the records (Name, units, type, scale) so that MegaLogViewer (Or TunerStudio) can read the file without any other information.
+ * The offsets of the fields that need byte swapping are also noted here so that writing each record does not need to look at the field descriptions
+ */
+static void writeBinaryLogHeader(void)
+{
+  byte buffer[MLG_FIELD_SIZE];
+  uint16_t numFields = 1U; //Time
+  mlgSwapCount = 0;
+  mlgBlockCounter = 0;
+  for(byte x=0; x<LOG_FIELD_COUNT; x++)
+  {
+    logFieldDescriptor field;
+    getLogField(x, field);
+    if(field.type != LOG_FIELD_NONE) { numFields++; }
+    if( (field.type == LOG_FIELD_U16) || (field.type == LOG_FIELD_S16) ) { mlgSwapOffsets[mlgSwapCount++] = field.offset; }
+  }
+  uint16_t infoStart = MLG_HEADER_SIZE + (numFields * MLG_FIELD_SIZE);
+  uint32_t dataStart = infoStart + sizeof(mlg_info);
+
+  memset(buffer, 0, sizeof(buffer));
+  memcpy(buffer, "MLVLG", 6); //Includes the null terminator
+  buffer[6] = highByte(MLG_FORMAT_VERSION);
+  buffer[7] = lowByte(MLG_FORMAT_VERSION);
+  //Bytes 8-11 are the log start time as a unix timestamp. The RTC is not guaranteed to be set, so this is left as 0
+  buffer[12] = highByte(infoStart);
+  buffer[13] = lowByte(infoStart);
+  writeBigEndian(&buffer[14], dataStart);
+  buffer[18] = highByte((uint16_t)MLG_RECORD_SIZE);
+  buffer[19] = lowByte((uint16_t)MLG_RECORD_SIZE);
+  buffer[20] = highByte(numFields);
+  buffer[21] = lowByte(numFields);
+  writeLogBytes(buffer, MLG_HEADER_SIZE);
+
+  //Time is not part of the live data block, it is added to the front of each record
+  memset(buffer, 0, sizeof(buffer));
+  buffer[0] = MLG_TYPE_U32;
+  strcpy((char *)&buffer[1], "Time");
+  strcpy((char *)&buffer[1 + MLG_FIELD_NAME_LENGTH], "s");
+  writeBigEndianFloat(&buffer[46], 0.001F); //Scale
+  writeBigEndianFloat(&buffer[50], 0.0F); //Transform
+  buffer[54] = 3; //Digits
+  writeLogBytes(buffer, MLG_FIELD_SIZE);
+
+  for(byte x=0; x<LOG_FIELD_COUNT; x++)
+  {
+    logFieldDescriptor field;
+    getLogField(x, field);
+    if(field.type == LOG_FIELD_NONE) { continue; }
+
+    memset(buffer, 0, sizeof(buffer));
+    buffer[0] = field.type;
+    #ifdef CORE_AVR
+      strncpy_P((char *)&buffer[1], field.name, MLG_FIELD_NAME_LENGTH - 1);
+    #else
+      strncpy((char *)&buffer[1], field.name, MLG_FIELD_NAME_LENGTH - 1);
+    #endif
+    memcpy(&buffer[1 + MLG_FIELD_NAME_LENGTH], field.units, LOG_FIELD_UNITS_LENGTH);
+    buffer[45] = 0; //Display style: Float
+    writeBigEndianFloat(&buffer[46], field.scale);
+    writeBigEndianFloat(&buffer[50], (float)field.transform);
+    buffer[54] = field.digits;
+    writeLogBytes(buffer, MLG_FIELD_SIZE);
+  }
+
+  char info[sizeof(mlg_info)];
+  strcpy_P(info, mlg_info);
+  writeLogBytes((const byte *)info, sizeof(info));
+}
+
+/** 
+ * Builds one binary record (MLG data block) from a copy of the live data block.
+ * The record is the live data block copied as a whole, rather than formatted field by field as with CSV logs. 
+ * The only per field work is swapping the byte order of the 16 bit values
+ * @param block - Buffer of at least MLG_BLOCK_SIZE bytes
+ * @param logTime - Time (ms) since the start of the log
+ * @param data - The live data to record
+ */
+static void buildBinaryLogBlock(byte *block, uint32_t logTime, const liveDataBlock *data)
+{
+  uint16_t timestamp = (uint16_t)(logTime * 100U); //10uS units. This is expected to wrap
+
+  block[0] = MLG_BLOCK_FIELD_DATA;
+  block[1] = mlgBlockCounter++;
+  block[2] = highByte(timestamp);
+  block[3] = lowByte(timestamp);
+  writeBigEndian(&block[MLG_BLOCK_HEADER_SIZE], logTime);
+
+  byte *record = &block[MLG_BLOCK_HEADER_SIZE + sizeof(uint32_t)];
+  memcpy(record, data, sizeof(liveDataBlock));
+  for(byte x=0; x<mlgSwapCount; x++)
+  {
+    byte *field = &record[mlgSwapOffsets[x]];
+    byte temp = field[0];
+    field[0] = field[1];
+    field[1] = temp;
+  }
+
+  //The checksum is the sum of the record bytes (Not including the block header)
+  byte checksum = 0;
+  for(uint16_t x=MLG_BLOCK_HEADER_SIZE; x<(MLG_BLOCK_HEADER_SIZE + MLG_RECORD_SIZE); x++) { checksum += block[x]; }
+  block[MLG_BLOCK_SIZE - 1U] = checksum;
+}
+
+/** 
+ * Writes one binary record of the current live data to the ring buffer.
+ */
+static void writeBinaryLogEntry(void)
+{
+  byte block[MLG_BLOCK_SIZE];
+
+  updateLiveData(logData);
+  buildBinaryLogBlock(block, (uint32_t)(millis() - logStartTime), &logData);
+  rb.write(block, sizeof(block));
+}
+
+/** 
+ * Checks the capture trigger condition. Only the transition into the condition triggers a capture
+ * @return True if the trigger has just occurred
+ */
+static bool checkCaptureTrigger(void)
+{
+  bool active = false;
+  switch(configPage13.onboard_log_capture_trigger)
+  {
+    case CAPTURE_TRIGGER_PROTECT: active = (currentStatus.engineProtectStatus != 0U); break;
+    case CAPTURE_TRIGGER_SYNCLOSS: 
+      active = (currentStatus.syncLossCounter != captureLastSyncLoss);
+      captureLastSyncLoss = currentStatus.syncLossCounter;
+      break;
+    case CAPTURE_TRIGGER_KNOCK: active = currentStatus.knockActive; break;
+    case CAPTURE_TRIGGER_OUTPUT: active = BIT_CHECK(currentStatus.outputsStatus, configPage13.onboard_log_capture_output); break;
+    default: break;
+  }
+
+  bool triggered = active && !captureTriggerActive;
+  captureTriggerActive = active;
+  return triggered;
+}
+
+/** 
+ * Adds a frame to the pre/post trigger capture buffer. Must be called at 200Hz (The capture rate is a divider of this).
+ * 
+ * While armed, the buffer holds the most recent frames. When the trigger occurs, capturing continues for the post trigger time and the 
+ * buffer is then frozen and written out to its own binary log by flushSDCapture(). The capture rearms once this is complete.
+ */
+void captureSDLogFrame(void)
+{
+  if(captureState == CAPTURE_STATE_FLUSHING) { return; }
+  if(configPage13.onboard_log_capture_trigger == CAPTURE_TRIGGER_OFF) 
+  { 
+    captureState = CAPTURE_STATE_IDLE;
+    return;
+  }
+  if(captureState == CAPTURE_STATE_IDLE)
+  {
+    captureHead = 0;
+    captureCount = 0;
+    captureLastSyncLoss = currentStatus.syncLossCounter;
+    captureTriggerActive = true; //Prevents a trigger if the condition is already true when arming
+    captureState = CAPTURE_STATE_ARMED;
+  }
+
+  //Rate is 200Hz divided by 10, 4, 2 or 1
+  static constexpr uint8_t captureDividers[] = { 10, 4, 2, 1 };
+  captureTickCount++;
+  if(captureTickCount < captureDividers[configPage13.onboard_log_capture_rate]) { return; }
+  captureTickCount = 0;
+
+  updateLiveData(captureBuffer[captureHead].data);
+  captureBuffer[captureHead].time = millis();
+  captureHead++;
+  if(captureHead >= SD_CAPTURE_FRAMES) { captureHead = 0; }
+  if(captureCount < SD_CAPTURE_FRAMES) { captureCount++; }
+
+  if(checkCaptureTrigger() && (captureState == CAPTURE_STATE_ARMED))
+  {
+    //Pre and post times are in 0.1s. Keep the trigger frame plus the pre trigger frames, limited by what is in the buffer
+    uint16_t rate = 200U / captureDividers[configPage13.onboard_log_capture_rate];
+    uint32_t preFrames = ((uint32_t)configPage13.onboard_log_capture_pre * rate) / 10U;
+    uint32_t postFrames = ((uint32_t)configPage13.onboard_log_capture_post * rate) / 10U;
+    if(preFrames >= captureCount) { preFrames = captureCount - 1U; }
+    if(postFrames > (SD_CAPTURE_FRAMES - preFrames - 1U)) { postFrames = SD_CAPTURE_FRAMES - preFrames - 1U; }
+
+    captureFlushRemaining = preFrames + 1U + postFrames;
+    capturePostRemaining = postFrames;
+    captureState = CAPTURE_STATE_TRIGGERED;
+  }
+  else if(captureState == CAPTURE_STATE_TRIGGERED)
+  {
+    if(capturePostRemaining > 0U) { capturePostRemaining--; }
+  }
+  else { /* MISRA - no-op */ }
+
+  if( (captureState == CAPTURE_STATE_TRIGGERED) && (capturePostRemaining == 0U) )
+  {
+    //Freeze the buffer. The oldest frame to write is captureFlushRemaining frames behind the head
+    captureFlushIndex = (captureHead + SD_CAPTURE_FRAMES - captureFlushRemaining) % SD_CAPTURE_FRAMES;
+    captureStartTime = captureBuffer[captureFlushIndex].time;
+    captureState = CAPTURE_STATE_FLUSHING;
+  }
+}
+
+/** 
+ * Writes a frozen capture buffer out to the card, a block at a time so that the main loop is never held up for long. 
+ * Should be called frequently (Every loop or at 1kHz).
+ * A capture is written to its own binary log file. If a normal log is already running, it is closed so that the capture can be written straight away. 
+ * Provided its start conditions are still met, the normal log carries on in a new file once the capture has been written (In the same way as when a log file fills up).
+ */
+void flushSDCapture(void)
+{
+  if(captureState != CAPTURE_STATE_FLUSHING) { return; }
+
+  if(!captureFileOpen)
+  {
+    //Close any normal log. Waiting for it to finish could hold the capture (And stop the capture rearming) for as long as the log runs
+    endSDLogging();
+
+    beginLogFile(LOGGER_BINARY);
+    if(SD_status != SD_STATUS_ACTIVE)
+    {
+      //No card or the log file could not be created. Throw the capture away and rearm
+      captureState = CAPTURE_STATE_IDLE;
+      return;
+    }
+    captureFileOpen = true;
+  }
+
+  if( (captureFlushRemaining > 0U) && (rb.bytesFree() >= MLG_BLOCK_SIZE) )
+  {
+    byte block[MLG_BLOCK_SIZE];
+    buildBinaryLogBlock(block, captureBuffer[captureFlushIndex].time - captureStartTime, &captureBuffer[captureFlushIndex].data);
+    rb.write(block, sizeof(block));
+    captureFlushIndex++;
+    if(captureFlushIndex >= SD_CAPTURE_FRAMES) { captureFlushIndex = 0; }
+    captureFlushRemaining--;
+  }
+
+  if( (rb.bytesUsed() >= SD_SECTOR_SIZE) && !logFile.isBusy() )
+  {
+    if (SD_SECTOR_SIZE != rb.writeOut(SD_SECTOR_SIZE)) { SD_status = SD_STATUS_ERROR_WRITE_FAIL; }
+  }
+
+  if( (captureFlushRemaining == 0U) || (SD_status != SD_STATUS_ACTIVE) )
+  {
+    endSDLogging();
+    captureFileOpen = false;
+    captureState = CAPTURE_STATE_IDLE;
+  }
+}
+
 //Sets the status variable for TunerStudio
 void setTS_SD_status()
 {
@@ -751,7 +847,7 @@ void formatExFat()
 /**
  * @brief Deletes a log file from the SD card
  * 
- * Log files all have the same name with a 4 digit number at the end (Eg SPD_0001.csv). TS sends the 4 digits as ASCII characters and they are combined here with the logfile prefix
+ * Log files all have the same name with a 4 digit number at the end (Eg SPD_0001.csv or SPD_0001.mlg). TS sends the 4 digits as ASCII characters and they are combined here with the logfile prefix
  * 
  * @param log1 
  * @param log2 
@@ -774,6 +870,13 @@ void deleteLogFile(char log1, char log2, char log3, char log4)
   {
     sd.remove(logFileName);
   }
+
+  //The log number could belong to a binary log instead
+  strcpy(logFileName + 9, LOG_FILE_EXTENSION_BINARY);
+  if(sd.exists(logFileName))
+  {
+    sd.remove(logFileName);
+  }
 }
 
 // Call back for file timestamps.  Only called for file create and sync().
@@ -42,7 +42,7 @@
 #endif
 
 #ifndef UNIT_TEST // Scope guard for unit testing
-  #define SD_LOG_ENTRY_SIZE   127 /**< The size of the live data packet used by the SD card.*/
+  #define SD_LOG_ENTRY_SIZE   129 /**< The size of the live data packet used by the SD card.*/
 #else
   #define SD_LOG_ENTRY_SIZE   1 /**< The size of the live data packet used by the SD card.*/
 #endif
@@ -52,8 +52,44 @@
 #define MAX_LOG_FILES     9999
 #define LOG_FILE_PREFIX "SPD_"
 #define LOG_FILE_EXTENSION "csv"
+#define LOG_FILE_EXTENSION_BINARY "mlg" //Binary logs are in the MegaLogViewer MLVLG format
 #define RING_BUF_CAPACITY (SD_LOG_ENTRY_SIZE * 10) //Allow for 10 entries in the ringbuffer. Will need tuning
 
+//MegaLogViewer binary (MLVLG version 1) format. All multi byte values in the file are big endian
+#define MLG_FORMAT_VERSION          1
+#define MLG_HEADER_SIZE             22 /**< Size of the fixed part of the file header, before the field descriptors */
+#define MLG_FIELD_SIZE              55 /**< Size of each field descriptor in the header */
+#define MLG_FIELD_NAME_LENGTH       34
+#define MLG_FIELD_UNITS_LENGTH      10
+#define MLG_BLOCK_HEADER_SIZE       4  /**< Block type, rolling counter and 10uS timestamp at the start of each record */
+#define MLG_BLOCK_FIELD_DATA        0  /**< Block type of a normal data record */
+
+#define MLG_TYPE_U08                0
+#define MLG_TYPE_S08                1
+#define MLG_TYPE_U16                2
+#define MLG_TYPE_S16                3
+#define MLG_TYPE_U32                4
+
+//Pre/post trigger capture. The buffer holds frames of the live data block, so the size is set by the available RAM on each board
+#if defined(CORE_TEENSY41)
+  #define SD_CAPTURE_FRAMES         1024 //~134kb. 10s at 100Hz
+#elif defined(CORE_TEENSY35)
+  #define SD_CAPTURE_FRAMES         256
+#else
+  #define SD_CAPTURE_FRAMES         128
+#endif
+
+#define CAPTURE_TRIGGER_OFF         0
+#define CAPTURE_TRIGGER_PROTECT     1 //Engine protection becomes active
+#define CAPTURE_TRIGGER_SYNCLOSS    2 //Any sync loss
+#define CAPTURE_TRIGGER_KNOCK       3 //Knock becomes active
+#define CAPTURE_TRIGGER_OUTPUT      4 //A programmable output turns on
+
+#define CAPTURE_STATE_IDLE          0
+#define CAPTURE_STATE_ARMED         1 //Continuously capturing, waiting for the trigger
+#define CAPTURE_STATE_TRIGGERED     2 //Trigger has occurred, capturing the post trigger frames
+#define CAPTURE_STATE_FLUSHING      3 //Buffer is frozen and being written to the card
+
 /*
 Standard FAT16/32
 SdFs sd; 
@@ -71,7 +107,7 @@ extern bool manualLogActive;
 
 void initSD();
 void writeSDLogEntry();
-void writetSDLogHeader();
+void writeSDLogHeader();
 void beginSDLogging();
 void endSDLogging();
 void syncSDLog();
@@ -84,6 +120,8 @@ uint16_t getNextSDLogFileNumber();
 bool getSDLogFileDetails(uint8_t* , uint16_t);
 void readSDSectors(uint8_t*, uint32_t, uint16_t);
 uint32_t sectorCount();
+void captureSDLogFrame(void);
+void flushSDCapture(void);
 
 
 
@@ -11,6 +11,10 @@
 #include "sensors.h"
 #include "storage.h"
 #include "SD_logger.h"
+#include "fuelLearn.h"
+#include "tuneBanks.h"
+#include "pages.h"
+#include "page_crc.h"
 #ifdef USE_MC33810
   #include "acc_mc33810.h"
 #endif
@@ -296,6 +300,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
         {
           //Calculate the ratio of VSS reading from Aux input and actual VSS (assuming that actual VSS is really 60km/h).
           configPage2.vssPulsesPerKm = (currentStatus.canin[configPage2.vssAuxCh] / 60);
+          invalidatePageCRC(veSetPage);
           writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
           BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
         }
@@ -306,6 +311,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
           if( calibrationGap > 0 )
           {
             configPage2.vssPulsesPerKm = MICROS_PER_MIN / calibrationGap;
+            invalidatePageCRC(veSetPage);
             writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
             BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
           }
@@ -318,6 +324,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio1 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
@@ -327,6 +334,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio2 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
@@ -336,6 +344,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio3 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
@@ -345,6 +354,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio4 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
@@ -354,6 +364,7 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio5 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
@@ -363,11 +374,27 @@ bool TS_CommandButtonsHandler(uint16_t buttonCommand)
       if(currentStatus.vss > 0)
       {
         configPage2.vssRatio6 = (currentStatus.vss * 10000UL) / currentStatus.RPM;
+        invalidatePageCRC(veSetPage);
         writeConfig(1); // Need to manually save the new config value as it will not trigger a burn in tunerStudio due to use of ControllerPriority
         BIT_SET(currentStatus.status3, BIT_STATUS3_VSS_REFRESH); //Set the flag to trigger the UI reset
       }
       break;
 
+    case TS_CMD_FUEL_LEARN_MERGE: //Apply the learnt fuel trims to the fuel table and burn it
+      mergeFuelLearn();
+      break;
+
+    case TS_CMD_FUEL_LEARN_RESET:
+      resetFuelLearn();
+      break;
+
+    case TS_CMD_TUNE_BANK_1:
+    case TS_CMD_TUNE_BANK_2:
+    case TS_CMD_TUNE_BANK_3:
+    case TS_CMD_TUNE_BANK_4: //Banks are numbered from 0 internally
+      selectTuneBank((uint8_t)(buttonCommand - TS_CMD_TUNE_BANK_1));
+      break;
+
     //STM32 Commands
     case TS_CMD_STM32_REBOOT: //
       doSystemReset();
@@ -70,5 +70,13 @@
 #define TS_CMD_VSS_RATIO5 39173
 #define TS_CMD_VSS_RATIO6 39174
 
+#define TS_CMD_FUEL_LEARN_MERGE 39424 //0x9A00
+#define TS_CMD_FUEL_LEARN_RESET 39425
+
+#define TS_CMD_TUNE_BANK_1  39680 //0x9B00
+#define TS_CMD_TUNE_BANK_2  39681
+#define TS_CMD_TUNE_BANK_3  39682
+#define TS_CMD_TUNE_BANK_4  39683
+
 /* the maximum id number is 65,535 */
 bool TS_CommandButtonsHandler(uint16_t buttonCommand);
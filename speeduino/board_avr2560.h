@@ -23,6 +23,7 @@
   #else
     #define EEPROM_LIB_H <EEPROM.h>
     typedef int eeprom_address_t;
+    #define EEPROM_BACKGROUND_WRITES //Burns are written a byte at a time from the EEPROM ready interrupt. See storage.cpp
   #endif
   #ifdef PLATFORMIO
     #define RTC_LIB_H <TimeLib.h>
@@ -163,5 +164,11 @@ static inline void IGN8_TIMER_DISABLE(void) { TIMSK3 &= ~(1 << OCIE3B); } //Repl
 #endif
 #define SECONDARY_SERIAL_T HardwareSerial
 
+/*
+***********************************************************************************************************
+* Crank angle synchronous MAP sampling
+*/
+#define MAP_SYNC_AVAILABLE //The trigger interrupt only starts the MAP conversion and the ADC interrupt collects the result (See sensors.cpp)
+
 #endif //CORE_AVR
 #endif //AVR2560_H
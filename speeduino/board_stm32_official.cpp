@@ -34,9 +34,18 @@ Default CAN3 pins are PA8 & PA15. Alternative (ALT) pins are PB3 & PB4.
     #endif
  
     //winbond W25Q16 SPI flash EEPROM emulation
-    EEPROM_Emulation_Config EmulatedEEPROMMconfig{255UL, 4096UL, 31, 0x00100000UL};
+    #if defined(USE_FLASH_JOURNAL)
+      //The last 8 sectors of the emulation area hold the config journal instead. The emulated EEPROM only needs 133 sectors for 4096 bytes
+      EEPROM_Emulation_Config EmulatedEEPROMMconfig{247UL, 4096UL, 31, 0x00100000UL};
+      Flash_Journal_Config FlashJournalConfig{8UL, 4096UL, 247UL * 4096UL};
+    #else
+      EEPROM_Emulation_Config EmulatedEEPROMMconfig{255UL, 4096UL, 31, 0x00100000UL};
+    #endif
     Flash_SPI_Config SPIconfig{USE_SPI_EEPROM, SPI_for_flash};
     SPI_EEPROM_Class EEPROM(EmulatedEEPROMMconfig, SPIconfig);
+    #if defined(USE_FLASH_JOURNAL)
+      FlashJournal configJournal(EEPROM, FlashJournalConfig);
+    #endif
 #elif defined(FRAM_AS_EEPROM) //https://github.com/VitorBoss/FRAM
     #if defined(STM32F407xx)
       SPIClass SPI_for_FRAM(PB5, PB4, PB3); //SPI1_MOSI, SPI1_MISO, SPI1_SCK
@@ -45,6 +45,7 @@
 //#define SRAM_AS_EEPROM /*Use 4K battery backed SRAM, requires a 3V continuous source (like battery) connected to Vbat pin */
 //#define USE_SPI_EEPROM PB0 /*Use M25Qxx SPI flash on BlackF407VE*/
 //#define FRAM_AS_EEPROM /*Use FRAM like FM25xxx, MB85RSxxx or any SPI compatible */
+//#define USE_FLASH_JOURNAL /*Store the config pages as whole records in a journal on the SPI flash rather than byte by byte. Requires USE_SPI_EEPROM*/
 
 #ifndef word
   #define word(h, l) ((h << 8) | l) //word() function not defined for this platform in the main library
@@ -161,6 +162,13 @@ void jumpToBootloader();
     extern Flash_SPI_Config SPIconfig;
     extern SPI_EEPROM_Class EEPROM;
 
+    #if defined(USE_FLASH_JOURNAL)
+      #include "src/SPIAsEEPROM/FlashJournal.h"
+      extern Flash_Journal_Config FlashJournalConfig;
+      extern FlashJournal configJournal;
+      #define TUNE_BANK_COUNT   4 //The journal has room to store the extra tables of each bank (See tuneBanks.h)
+    #endif
+
 #elif defined(FRAM_AS_EEPROM) //https://github.com/VitorBoss/FRAM
     #define EEPROM_LIB_H "src/FRAM/Fram.h"
     typedef uint16_t eeprom_address_t;
@@ -10,6 +10,9 @@ A full copy of the license may be found in the projects root directory
 #include "comms.h"
 #include "comms_secondary.h"
 #include "storage.h"
+#include "sensors.h"
+#include "corrections.h"
+#include "fuelLearn.h"
 #include "maths.h"
 #include "utilities.h"
 #include "decoders.h"
@@ -19,6 +22,11 @@ A full copy of the license may be found in the projects root directory
 #include "page_crc.h"
 #include "logger.h"
 #include "comms_legacy.h"
+#include "comms_CAN.h"
+#include "tuneBanks.h"
+#include "comms_delta.h"
+#include "comms_queue.h"
+#include "comms_stream.h"
 #include "src/FastCRC/FastCRC.h"
 #include <avr/pgmspace.h>
 #ifdef RTC_ENABLED
@@ -56,6 +64,12 @@ void sendCompositeLog(void);
 #define SERIAL_TIMEOUT      3000 //ms
 
 #define SEND_OUTPUT_CHANNELS 48U
+#define STREAM_OUTPUT_CHANNELS 49U //!< Start (Or stop, with a rate of 0) streaming the output channels. See serialStream()
+#define SEND_OUTPUT_CHANNELS_DELTA 50U //!< Send the output channels as a delta against the last acknowledged frame. See generateLiveValuesDelta()
+
+#define SERIAL_CAPABILITY_STREAM  0U //!< Bit in the capability flags of the 'f' response: Output channel streaming is supported
+#define SERIAL_CAPABILITY_DELTA   1U //!< Bit in the capability flags of the 'f' response: Delta encoded output channels are supported
+#define SERIAL_CAPABILITY_QUEUE   2U //!< Bit in the capability flags of the 'f' response: Commands can be sent before the response to the previous command has been received
 
 #if defined(RTC_ENABLED) && defined(SD_LOGGING)
   #define COMMS_SD            
@@ -98,6 +112,17 @@ static uint32_t SDreadCompletedSectors = 0;
 static uint8_t serialPayload[SERIAL_BUFFER_SIZE]; //!< Serial payload buffer. */
 static uint16_t serialPayloadLength = 0; //!< How many bytes in serialPayload were received or sent */
 
+static stream_state outputStream; //!< Output channel streaming (See comms_stream.h) */
+static_assert((LOG_ENTRY_SIZE + 1U) <= sizeof(serialPayload), "A streamed frame of the whole output channel block must fit in the serial payload");
+
+static delta_encoder liveValuesDelta; //!< Reference frame for the delta encoded output channels */
+static_assert(sizeof(liveDataBlock) <= DELTA_MAX_LENGTH, "The delta encoder must be able to hold the whole live data block");
+static_assert(sizeof(serialPayload) >= (1U + DELTA_MAX_FRAME_SIZE), "A delta encoded frame must fit in the serial payload");
+
+static serial_queue serialQueue; //!< Commands received while the response to an earlier command was still being sent */
+static uint32_t queueRxStartTime = 0; //!< The time at which the queued command receive started */
+static_assert(sizeof(crc_t) == SERIAL_QUEUE_CRC_SIZE, "The queue must receive the same CRC as the normal receive");
+
 #if defined(CORE_AVR)
 #pragma GCC push_options
 // These minimize RAM usage at no performance cost
@@ -302,10 +327,11 @@ static bool updatePageValues(uint8_t pageNum, uint16_t offset, const byte *buffe
 {
   if ( (offset + length) <= getPageSize(pageNum) )
   {
-    for(uint16_t i = 0; i < length; i++)
-    {
-      setPageValue(pageNum, (offset + i), buffer[i]);
-    }
+    setPageValues(pageNum, offset, buffer, length);
+    updateCorrectionStages(); //The write may have enabled or disabled a correction
+#if defined(NATIVE_CAN_AVAILABLE)
+    if ( (pageNum == canbusPage) || (pageNum == veSetPage) ) { updateCANReceive(); } //The write may have changed the CAN frames that are received
+#endif
     deferEEPROMWritesUntil = micros() + EEPROM_DEFER_DELAY;
     return true;
   }
@@ -323,10 +349,7 @@ static bool updatePageValues(uint8_t pageNum, uint16_t offset, const byte *buffe
  */
 static void loadPageValuesToBuffer(uint8_t pageNum, uint16_t offset, byte *buffer, uint16_t length)
 {
-  for(uint16_t i = 0; i < length; i++)
-  {
-    buffer[i] = getPageValue(pageNum, offset + i);
-  }
+  getPageValues(pageNum, offset, buffer, length);
 }
 
 /** @brief Send a status record back to tuning/logging SW.
@@ -335,7 +358,7 @@ static void loadPageValuesToBuffer(uint8_t pageNum, uint16_t offset, byte *buffe
  * @param packetLength - Length of actual message (after possible ack/confirm headers)
  * E.g. tuning sw command 'A' (Send all values) will send data from field number 0, LOG_ENTRY_SIZE fields.
  */
-static void generateLiveValues(uint16_t offset, uint16_t packetLength)
+static void refreshLiveValues(void)
 {  
   if(firstCommsRequest) 
   { 
@@ -345,15 +368,32 @@ static void generateLiveValues(uint16_t offset, uint16_t packetLength)
 
   currentStatus.spark ^= (-currentStatus.hasSync ^ currentStatus.spark) & (1U << BIT_SPARK_SYNC); //Set the sync bit of the Spark variable to match the hasSync variable
 
-  serialPayload[0] = SERIAL_RC_OK;
-  for(byte x=0; x<packetLength; x++)
-  {
-    serialPayload[x+1] = getTSLogEntry(offset+x); 
-  }
+  updateLiveData();
   // Reset any flags that are being used to trigger page refreshes
   BIT_CLEAR(currentStatus.status3, BIT_STATUS3_VSS_REFRESH);
 }
 
+static void generateLiveValues(uint16_t offset, uint16_t packetLength)
+{  
+  refreshLiveValues();
+  serialPayload[0] = SERIAL_RC_OK;
+  copyLiveData(&serialPayload[1], offset, packetLength);
+}
+
+/** @brief Send a status record back to tuning/logging SW, encoded as the changes since the last frame the client acknowledged (See comms_delta.h)
+ * Frame layout: [RC][sequence][type][data]
+ * @param offset - Start field number
+ * @param packetLength - Number of output channel bytes requested. Must have been checked with isDeltaRangeValid()
+ * @param ackSequence - The sequence number of the last frame that the client received
+ * @return The length of the payload
+ */
+static uint16_t generateLiveValuesDelta(uint16_t offset, uint16_t packetLength, uint8_t ackSequence)
+{
+  refreshLiveValues();
+  serialPayload[0] = SERIAL_RC_OK;
+  return 1U + encodeDeltaFrame(&liveValuesDelta, &serialPayload[1], ((const byte *)&liveData) + offset, offset, packetLength, ackSequence);
+}
+
 /**
  * @brief Update the oxygen sensor table from serialPayload
  * 
@@ -392,6 +432,7 @@ static void loadO2CalibrationChunk(uint16_t offset, uint16_t chunkSize)
     //All chunks have been received (1024 values). Finalise the CRC and burn to EEPROM
     storeCalibrationCRC32(O2_CALIBRATION_PAGE, ~calibrationCRC);
     writeCalibrationPage(O2_CALIBRATION_PAGE);
+    updateCalibrationLookups();
   }
 }
 
@@ -428,6 +469,7 @@ static void processTemperatureCalibrationTableUpdate(uint16_t calibrationLength,
     }
     storeCalibrationCRC32(calibrationPage, CRC32_serial.crc32(&serialPayload[7], 64));
     writeCalibrationPage(calibrationPage);
+    updateCalibrationLookups();
     sendReturnCodeMsg(SERIAL_RC_OK);
   }
   else 
@@ -439,6 +481,68 @@ static void processTemperatureCalibrationTableUpdate(uint16_t calibrationLength,
 // ====================================== End Internal Functions =============================
 
 
+bool serialCommandQueued(void)
+{
+  return serialQueue.rxInProgress || (serialQueue.count > 0U);
+}
+
+/** @brief Receives commands into the queue while a response is being sent, and processes them in order once it has been (See comms_queue.h).
+ * 
+ * Only the new (CRC checked) protocol is queued. Legacy commands have no length header, so they wait until the response has been sent.
+ * While the queue is full, new commands are left unread until there is room for them.
+ */
+static void serialReceiveQueued(void)
+{
+  if( (!serialQueue.rxInProgress) && (serialQueue.count < SERIAL_QUEUE_DEPTH) && (Serial.available() != 0) 
+      && (!BIT_CHECK(currentStatus.status4, BIT_STATUS4_ALLOW_LEGACY_COMMS)) )
+  {
+    //New command received. Any new command cancels output channel streaming
+    stopStream(&outputStream);
+    byte highByte = (byte)Serial.read();
+    while(Serial.available() == 0) { /* Wait for the 2nd byte to be received (This will almost never happen) */ }
+    (void)beginSerialQueueRx(&serialQueue, word(highByte, Serial.read()));
+    queueRxStartTime = millis();
+  }
+
+  if(serialQueue.rxInProgress)
+  {
+    bool complete = false;
+    while( (Serial.available() > 0) && (!complete) ) { complete = serialQueueRxByte(&serialQueue, (byte)Serial.read()); }
+
+    if(complete)
+    {
+      uint32_t payloadCrc = 0;
+      if(serialQueue.rxLength <= SERIAL_QUEUE_PAYLOAD_SIZE) { payloadCrc = CRC32_serial.crc32(serialQueueRxEntry(&serialQueue)->payload, serialQueue.rxLength); }
+      if(endSerialQueueRx(&serialQueue, payloadCrc) == SERIAL_QUEUE_CRC_ERR) { flushRXbuffer(); }
+    }
+    else if( (millis() - queueRxStartTime) > SERIAL_TIMEOUT )
+    {
+      timeoutSerialQueueRx(&serialQueue);
+      flushRXbuffer();
+    }
+    else { /* MISRA - no-op */ }
+  }
+
+  //Nothing more can be done until the current response has been sent
+  if(serialStatusFlag != SERIAL_INACTIVE) { return; }
+
+  const serial_queue_entry *pEntry = popSerialQueue(&serialQueue);
+  if(pEntry != nullptr)
+  {
+    switch(pEntry->status)
+    {
+      case SERIAL_QUEUE_OK:
+        memcpy(serialPayload, pEntry->payload, pEntry->length);
+        serialPayloadLength = pEntry->length;
+        processSerialCommand();
+        break;
+      case SERIAL_QUEUE_OVERSIZE: sendReturnCodeMsg(SERIAL_RC_BUSY_ERR); break; //Client retries once it has the earlier responses
+      case SERIAL_QUEUE_TIMEOUT: sendReturnCodeMsg(SERIAL_RC_TIMEOUT); break;
+      default: sendReturnCodeMsg(SERIAL_RC_CRC_ERR); break;
+    }
+  }
+}
+
 /** Processes the incoming data on the serial buffer based on the command sent.
 Can be either data for a new command or a continuation of data for command that is already in progress:
 
@@ -453,9 +557,22 @@ void serialReceive(void)
     return;
   }
 
+  //Commands that arrive while a response is still being sent, or behind other queued commands, go through the queue so they are processed in order
+  if( (serialStatusFlag != SERIAL_INACTIVE) && (serialStatusFlag != SERIAL_RECEIVE_INPROGRESS) )
+  {
+    serialReceiveQueued();
+    return;
+  }
+  if( serialCommandQueued() )
+  {
+    serialReceiveQueued();
+    if( serialTransmitInProgress() || serialCommandQueued() ) { return; }
+  }
+
   if (Serial.available()!=0 && serialStatusFlag == SERIAL_INACTIVE)
   { 
-    //New command received
+    //New command received. Any new command cancels output channel streaming
+    stopStream(&outputStream);
     //Need at least 2 bytes to read the length of the command
     byte highByte = (byte)Serial.peek();
 
@@ -526,6 +643,16 @@ void serialReceive(void)
   } //Timeout
 }
 
+void serialStream(void)
+{
+  if( (serialStatusFlag == SERIAL_INACTIVE) && (!serialCommandQueued()) && isStreamFrameDue(&outputStream, millis()) )
+  {
+    //Frames are identical to the response to an 'r' output channels request, so the client can use the same parser for both
+    generateLiveValues(outputStream.offset, outputStream.length);
+    sendSerialPayloadNonBlocking(outputStream.length + 1U);
+  }
+}
+
 void serialTransmit(void)
 {
   switch (serialStatusFlag)
@@ -566,7 +693,7 @@ void processSerialCommand(void)
       break;
 
     case 'b': // New EEPROM burn command to only burn a single page at a time 
-      if( (micros() > deferEEPROMWritesUntil)) { writeConfig(serialPayload[2]); } //Read the table number and perform burn. Note that byte 1 in the array is unused
+      if( (micros() > deferEEPROMWritesUntil)) { writeConfigChanges(serialPayload[2]); } //Read the table number and perform burn. Note that byte 1 in the array is unused
       else { BIT_SET(currentStatus.status4, BIT_STATUS4_BURNPENDING); }
       
       sendReturnCodeMsg(SERIAL_RC_BURN_OK);
@@ -575,7 +702,7 @@ void processSerialCommand(void)
     case 'B': // Same as above, but for the comms compat mode. Slows down the burn rate and increases the defer time
       BIT_SET(currentStatus.status4, BIT_STATUS4_COMMS_COMPAT); //Force the compat mode
       deferEEPROMWritesUntil += (EEPROM_DEFER_DELAY/4); //Add 25% more to the EEPROM defer time
-      if( (micros() > deferEEPROMWritesUntil)) { writeConfig(serialPayload[2]); } //Read the table number and perform burn. Note that byte 1 in the array is unused
+      if( (micros() > deferEEPROMWritesUntil)) { writeConfigChanges(serialPayload[2]); } //Read the table number and perform burn. Note that byte 1 in the array is unused
       else { BIT_SET(currentStatus.status4, BIT_STATUS4_BURNPENDING); }
       
       sendReturnCodeMsg(SERIAL_RC_BURN_OK);
@@ -589,6 +716,7 @@ void processSerialCommand(void)
     case 'd': // Send a CRC32 hash of a given page
     {
       uint32_t CRC32_val = reverse_bytes(calculatePageCRC32( serialPayload[2] ));
+      markTuneBankPageRead(serialPayload[2]); //The tuning software now knows whether the page differs from its copy
 
       serialPayload[0] = SERIAL_RC_OK;
       (void)memcpy(&serialPayload[1], &CRC32_val, sizeof(CRC32_val));
@@ -608,8 +736,9 @@ void processSerialCommand(void)
       serialPayload[3] = lowByte(BLOCKING_FACTOR);
       serialPayload[4] = highByte(TABLE_BLOCKING_FACTOR);
       serialPayload[5] = lowByte(TABLE_BLOCKING_FACTOR);
+      serialPayload[6] = (1U << SERIAL_CAPABILITY_STREAM) | (1U << SERIAL_CAPABILITY_DELTA) | (1U << SERIAL_CAPABILITY_QUEUE); //Optional capability flags. Clients that do not know about these ignore the extra byte
       
-      sendSerialPayloadNonBlocking(6);
+      sendSerialPayloadNonBlocking(7);
       break;
 
     case 'F': // send serial protocol version
@@ -652,6 +781,12 @@ void processSerialCommand(void)
       break;
     }
 
+    case 'l': //Send the learnt long term fuel trims (See fuelLearn.h)
+      serialPayload[0] = SERIAL_RC_OK;
+      (void)memcpy(&serialPayload[1], fuelLearnTrim, sizeof(fuelLearnTrim));
+      sendSerialPayloadNonBlocking(sizeof(fuelLearnTrim) + 1U);
+      break;
+
     case 'M':
     {
       //New write command
@@ -660,7 +795,12 @@ void processSerialCommand(void)
       //2 - offset
       //2 - Length
       //1 - 1st New value
-      if (updatePageValues(serialPayload[2], word(serialPayload[4], serialPayload[3]), &serialPayload[7], word(serialPayload[6], serialPayload[5])))
+      if (isTuneBankPageStale(serialPayload[2]))
+      {
+        //The tune bank has been switched since the tuning software read this page, so the write is an edit to the tables of the previous bank
+        sendReturnCodeMsg(SERIAL_RC_RANGE_ERR);
+      }
+      else if (updatePageValues(serialPayload[2], word(serialPayload[4], serialPayload[3]), &serialPayload[7], word(serialPayload[6], serialPayload[5])))
       {
         sendReturnCodeMsg(SERIAL_RC_OK);    
       }
@@ -706,6 +846,7 @@ void processSerialCommand(void)
       //Setup the transmit buffer
       serialPayload[0] = SERIAL_RC_OK;
       loadPageValuesToBuffer(serialPayload[2], word(serialPayload[4], serialPayload[3]), &serialPayload[1], length);
+      markTuneBankPageRead(serialPayload[2]);
       sendSerialPayloadNonBlocking(length + 1U);
       break;
     }
@@ -730,6 +871,24 @@ void processSerialCommand(void)
         generateLiveValues(offset, length);
         sendSerialPayloadNonBlocking(length + 1U);
       }
+      else if(cmd == STREAM_OUTPUT_CHANNELS) //Stream output channels command 0x31 is 49dec. Byte 7 and 8 are the rate in Hz
+      {
+        uint16_t rate = 0;
+        if(serialPayloadLength >= 9U) { rate = word(serialPayload[8], serialPayload[7]); }
+        if(rate == 0U) { sendReturnCodeMsg(SERIAL_RC_OK); } //Streaming has already been stopped by the arrival of this command
+        else if( !startStream(&outputStream, offset, length, rate, LOG_ENTRY_SIZE, millis()) ) { sendReturnCodeMsg(SERIAL_RC_RANGE_ERR); }
+        else
+        {
+          //The first frame is sent straight away and acts as the response to the command. The subset may have been clamped to the end of the output channels
+          generateLiveValues(outputStream.offset, outputStream.length);
+          sendSerialPayloadNonBlocking(outputStream.length + 1U);
+        }
+      }
+      else if(cmd == SEND_OUTPUT_CHANNELS_DELTA) //Delta encoded output channels command 0x32 is 50dec. Byte 7 is the sequence number of the last frame received
+      {
+        if( !isDeltaRangeValid(offset, length, sizeof(liveDataBlock)) || (serialPayloadLength < 8U) ) { sendReturnCodeMsg(SERIAL_RC_RANGE_ERR); }
+        else { sendSerialPayloadNonBlocking(generateLiveValuesDelta(offset, length, serialPayload[7])); }
+      }
       else if(cmd == 0x0f)
       {
         //Request for signature
@@ -1056,26 +1215,19 @@ void processSerialCommand(void)
 }
 
 /** 
- * 
+ * Sends the tooth log buffer that is ready (See addToothLogEntry()). The trigger interrupts continue to fill the other buffer while this is sent.
 */
 void sendToothLog(void)
 {
-  //We need TOOTH_LOG_SIZE number of records to send to TunerStudio. If there aren't that many in the buffer then we just return and wait for the next call
-  if (BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY) == false) 
-  {
-    //If the buffer is not yet full but TS has timed out, pad the rest of the buffer with 0s
-    while(toothHistoryIndex < TOOTH_LOG_SIZE)
-    {
-      toothHistory[toothHistoryIndex] = 0;
-      toothHistoryIndex++;
-    }
-  }
+  //We need TOOTH_LOG_SIZE number of records to send to TunerStudio. If there isn't a full buffer ready, TS has timed out and the partial buffer is sent instead
+  if(logItemsTransmitted == 0) { readyToothLog(); }
+  const uint8_t buffer = toothHistoryBuffer ^ 1U; //The buffer that is not being filled. This cannot change until the ready flag is cleared below
 
   uint32_t CRC32_val = 0;
   if(logItemsTransmitted == 0)
   {
     //Transmit the size of the packet
-    (void)serialWrite((uint16_t)(sizeof(toothHistory) + 1U)); //Size of the tooth log (uint32_t values) plus the return code
+    (void)serialWrite((uint16_t)((sizeof(uint32_t) * TOOTH_LOG_SIZE) + 1U)); //Size of the tooth log (uint32_t values) plus the return code
     //Begin new CRC hash
     const uint8_t returnCode = SERIAL_RC_OK;
     CRC32_val = CRC32_serial.crc32(&returnCode, 1, false);
@@ -1095,12 +1247,11 @@ void sendToothLog(void)
     }
 
     //Transmit the tooth time
-    uint32_t transmitted = serialWrite(toothHistory[logItemsTransmitted]);
+    uint32_t transmitted = serialWrite(decodeToothLogTime(toothHistory[buffer][logItemsTransmitted]));
     CRC32_val = CRC32_serial.crc32_upd((const byte*)&transmitted, sizeof(transmitted), false);
   }
   BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
   serialStatusFlag = SERIAL_INACTIVE;
-  toothHistoryIndex = 0;
   logItemsTransmitted = 0;
 
   //Apply the CRC reflection
@@ -1112,22 +1263,18 @@ void sendToothLog(void)
 
 void sendCompositeLog(void)
 {
-  if ( BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY) == false )
-  {
-    //If the buffer is not yet full but TS has timed out, pad the rest of the buffer with 0s
-    while(toothHistoryIndex < TOOTH_LOG_SIZE)
-    {
-      toothHistory[toothHistoryIndex] = toothHistory[toothHistoryIndex-1]; //Composite logger needs a realistic time value to display correctly. Copy the last value
-      compositeLogHistory[toothHistoryIndex] = 0;
-      toothHistoryIndex++;
-    }
-  }
+  static uint32_t compositeTime = 0; //The time of the last entry sent. The entries are stored as deltas, but sent as the combined runtime
+
+  if(logItemsTransmitted == 0) { readyToothLog(); }
+  const uint8_t buffer = toothHistoryBuffer ^ 1U; //The buffer that is not being filled. This cannot change until the ready flag is cleared below
 
   uint32_t CRC32_val = 0;
   if(logItemsTransmitted == 0)
   { 
+    compositeTime = compositeLogStartTime[buffer];
+
     //Transmit the size of the packet
-    (void)serialWrite((uint16_t)(sizeof(toothHistory) + sizeof(compositeLogHistory) + 1U)); //Size of the tooth log (uint32_t values) plus the return code
+    (void)serialWrite((uint16_t)(((sizeof(uint32_t) + sizeof(uint8_t)) * TOOTH_LOG_SIZE) + 1U)); //Size of the tooth log (uint32_t values) plus the return code
     
     //Begin new CRC hash
     const uint8_t returnCode = SERIAL_RC_OK;
@@ -1140,22 +1287,23 @@ void sendCompositeLog(void)
   for (; logItemsTransmitted < TOOTH_LOG_SIZE; logItemsTransmitted++)
   {
     //Check whether the tx buffer still has space
-    if((uint16_t)Serial.availableForWrite() < sizeof(toothHistory[logItemsTransmitted])+sizeof(compositeLogHistory[logItemsTransmitted])) 
+    if((uint16_t)Serial.availableForWrite() < sizeof(uint32_t)+sizeof(uint8_t)) 
     { 
       //tx buffer is full. Store the current state so it can be resumed later
       serialStatusFlag = SERIAL_TRANSMIT_COMPOSITE_INPROGRESS;
       return;
     }
 
-    uint32_t transmitted = serialWrite(toothHistory[logItemsTransmitted]); //This combined runtime (in us) that the log was going for by this record
+    compositeTime += decodeToothLogTime(toothHistory[buffer][logItemsTransmitted]);
+    uint32_t transmitted = serialWrite(compositeTime); //This combined runtime (in us) that the log was going for by this record
     CRC32_serial.crc32_upd((const byte*)&transmitted, sizeof(transmitted), false);
 
     //The status byte (Indicates the trigger edge, whether it was a pri/sec pulse, the sync status)
-    writeByteReliableBlocking(compositeLogHistory[logItemsTransmitted]);
-    CRC32_val = CRC32_serial.crc32_upd((const byte*)&compositeLogHistory[logItemsTransmitted], sizeof(compositeLogHistory[logItemsTransmitted]), false);
+    const uint8_t compositeStatus = compositeLogHistory[buffer][logItemsTransmitted];
+    writeByteReliableBlocking(compositeStatus);
+    CRC32_val = CRC32_serial.crc32_upd(&compositeStatus, sizeof(compositeStatus), false);
   }
   BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-  toothHistoryIndex = 0;
   serialStatusFlag = SERIAL_INACTIVE;
   logItemsTransmitted = 0;
 
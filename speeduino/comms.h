@@ -27,8 +27,21 @@
  */
 void serialReceive(void);
 
+/** @brief Whether any commands are waiting in the receive queue.
+ * 
+ * Commands that arrive while a response is still being sent are received and CRC checked into a small queue, 
+ * then processed in order once the response has gone. ::serialReceive() should be called while this is true, even if no new data is available */
+bool serialCommandQueued(void);
+
 /** @brief The serial transmit pump. Should be called when ::serialStatusFlag indicates a transmit
  * operation is in progress */
 void serialTransmit(void);
 
+/** @brief The output channel streaming pump. Should be called every loop.
+ * 
+ * Once a stream has been started by the client (Command 'r' with a sub command of 0x31), a frame of output channels is 
+ * sent at the requested rate without the client needing to request each one. Frames are only started when no other serial operation is in progress.
+ * Streaming stops when any new command is received from the client */
+void serialStream(void);
+
 #endif // COMMS_H
@@ -11,6 +11,7 @@ This is for handling the data broadcasted to various CAN dashes and instrument c
 
 #if defined(NATIVE_CAN_AVAILABLE)
 #include "comms_CAN.h"
+#include "comms_CAN_rx.h"
 #include "utilities.h"
 
 CAN_message_t inMsg;
@@ -26,6 +27,71 @@ CAN_message_t outMsg;
 // Forward declare
 void DashMessage(uint16_t DashMessageID);
 
+/*
+Received frames are dispatched through the table in comms_CAN_rx.h. The table is rebuilt whenever the config that it depends on changes (See updateCANReceive()).
+The same IDs are also programmed into the hardware acceptance filters where they fit, so that most other frames on the bus are never read at all.
+*/
+#if defined(CORE_STM32)
+  #define CAN_RX_FILTER_COUNT 14U //Filter banks belonging to CAN1. Each bank is used for a single ID
+#else
+  #define CAN_RX_FILTER_COUNT 8U  //FIFO filters with the default FlexCAN_T4 FIFO setup
+#endif
+
+static can_rx_table canRxTable;
+
+//The config that the receive table was last built from. Page writes only rebuild the table (And reprogram the filters) when one of these changes
+struct can_rx_config {
+  uint16_t obdAddress;
+  uint8_t canWBO;
+  uint8_t enableIntCAN;
+  uint8_t enableSecondarySerial;
+  uint8_t caninputSel[16];
+  uint16_t caninputAddress[16];
+};
+static can_rx_config canRxConfig;
+
+static void getCANRxConfig(can_rx_config *pConfig)
+{
+  memset(pConfig, 0, sizeof(can_rx_config)); //Clear any padding so that configs can be compared with memcmp()
+  pConfig->obdAddress = configPage9.obd_address;
+  pConfig->canWBO = configPage2.canWBO;
+  pConfig->enableIntCAN = configPage9.enable_intcan;
+  pConfig->enableSecondarySerial = configPage9.enable_secondarySerial;
+  memcpy(pConfig->caninputSel, configPage9.caninput_sel, sizeof(pConfig->caninputSel));
+  memcpy(pConfig->caninputAddress, configPage9.caninput_source_can_address, sizeof(pConfig->caninputAddress));
+}
+
+/*
+Programs the hardware filters with the IDs in the receive table. If there are more IDs than filters then all frames are accepted and only the table filters them
+*/
+static void setCANRxFilters(void)
+{
+#if defined(CORE_STM32)
+  //The library picks the frame format of a filter from the size of its ID, so an extended frame with an ID that would fit a standard one can't be given a filter
+  bool acceptAll = (canRxTable.idCount > CAN_RX_FILTER_COUNT);
+  for (uint8_t x = 0; x < canRxTable.idCount; x++) { acceptAll = acceptAll || (canRxTable.ids[x].extended && (canRxTable.ids[x].id <= CAN_STD_ID_MAX)); }
+
+  //The library has no way to disable a filter bank, so any unused banks repeat the first ID
+  for (uint8_t bank = 0; bank < CAN_RX_FILTER_COUNT; bank++)
+  {
+    if(acceptAll)
+    {
+      //Accept all standard (Bank 0) and all extended (Bank 1) frames
+      if(bank == 1U) { Can0.setMBFilterProcessing(MB1, 0x800, 0); }
+      else { Can0.setMBFilterProcessing((CAN_BANK)bank, 0, 0); }
+    }
+    else { Can0.setMBFilter((CAN_BANK)bank, canRxTable.ids[(bank < canRxTable.idCount) ? bank : 0U].id); }
+  }
+#else
+  if(canRxTable.idCount > CAN_RX_FILTER_COUNT) { Can0.setFIFOFilter(ACCEPT_ALL); }
+  else
+  {
+    Can0.setFIFOFilter(REJECT_ALL);
+    for (uint8_t filter = 0; filter < canRxTable.idCount; filter++) { Can0.setFIFOFilter(filter, canRxTable.ids[filter].id, canRxTable.ids[filter].extended ? EXT : STD); }
+  }
+#endif
+}
+
 
 void initCAN()
 {
@@ -44,9 +110,71 @@ void initCAN()
       Can0.setRX(DEF);
       Can0.setTX(DEF);
     #endif
+
+    initCANReceive();
   #endif
 }
 
+/** Checks whether a CAN input reads its value from the internal CAN bus. Inputs that are disabled, local or read over the secondary serial don't need their frames received.
+ * This is the same selection that the main loop uses when it requests the CAN input data
+ */
+static inline bool isCANInputOnIntCAN(uint8_t channel)
+{
+  if ( (configPage9.enable_intcan == 0) || ((configPage9.caninput_sel[channel] & 12U) != 4U) ) { return false; } //Not an external input
+  if (configPage9.enable_secondarySerial == 1) { return ((configPage9.caninput_sel[channel] & 64U) != 0U); }
+  return ((configPage9.caninput_sel[channel] & 128U) != 0U);
+}
+
+/** Builds the table of received frame IDs and programs the hardware filters to match.
+ */
+void initCANReceive(void)
+{
+  getCANRxConfig(&canRxConfig);
+  clearCANRxTable(&canRxTable);
+
+  addCANRxEntry(&canRxTable, uint16_t(configPage9.obd_address + TS_CAN_OFFSET), false, CAN_RX_OBD, 0);
+  addCANRxEntry(&canRxTable, 0x7DF, false, CAN_RX_OBD, 0); //OBD broadcast address
+  for (uint8_t i = 0; i < 16U; i++)
+  {
+    if (isCANInputOnIntCAN(i))
+    {
+      //The CAN inputs have no frame format setting. Source addresses that don't fit in a standard ID can only be received as extended frames
+      uint32_t id = (uint32_t)configPage9.caninput_source_can_address[i] + TS_CAN_OFFSET;
+      addCANRxEntry(&canRxTable, id, (id > CAN_STD_ID_MAX), CAN_RX_CANIN, (uint16_t)(1U << i));
+    }
+  }
+  if (configPage2.canWBO > 0)
+  {
+    addCANRxEntry(&canRxTable, 0x190, false, CAN_RX_WBO, 0);
+    addCANRxEntry(&canRxTable, 0x192, false, CAN_RX_WBO, 0);
+  }
+
+  setCANRxFilters();
+}
+
+/** Rebuilds the receive table and filters if the OBD address, CAN inputs (Page 9) or CAN wideband (Page 1) config has changed since they were last built.
+ * Called after each page write. Reprogramming the filters can drop frames, so this is skipped for writes that don't affect them.
+ */
+void updateCANReceive(void)
+{
+  can_rx_config newConfig;
+  getCANRxConfig(&newConfig);
+  if (memcmp(&newConfig, &canRxConfig, sizeof(can_rx_config)) != 0) { initCANReceive(); }
+}
+
+/** Passes the frame in inMsg to each of the functions that use its ID
+ */
+void receiveCAN(void)
+{
+  const can_rx_entry *pEntry = findCANRxEntry(&canRxTable, inMsg.id, (inMsg.flags.extended != 0U));
+  if (pEntry != nullptr)
+  {
+    if ((pEntry->handlers & CAN_RX_OBD) != 0U) { can_Command(); }
+    if ((pEntry->handlers & CAN_RX_CANIN) != 0U) { readAuxCanBus(pEntry->caninChannels); }
+    if ((pEntry->handlers & CAN_RX_WBO) != 0U) { receiveCANwbo(); }
+  }
+}
+
 int CAN_read()
 {
   return Can0.read(inMsg);
@@ -74,7 +202,9 @@ void sendVAGCluster()
   DashMessage(CAN_VAG_VSS);
   Can0.write(outMsg);
 }
-void receiveCANwbo() 
+/** Sends the battery voltage and heater enable to the wideband controller. Called at 30Hz (See speeduino.ino), so that the heater is controlled whether or not the wideband is sending any frames yet
+ */
+void sendCANwbo()
 {
   // Currently only RusEFI CAN Wideband supported: https://github.com/mck1117/wideband
   if(configPage2.canWBO == CAN_WBO_RUSEFI)
@@ -85,6 +215,14 @@ void receiveCANwbo()
     outMsg.buf[0] = currentStatus.battery10; // We don't do any conversion since factor is 0.1 and speeduino value is x10
     outMsg.buf[1] = BIT_CHECK(currentStatus.engine, BIT_ENGINE_RUN) ? 0x1 : 0x0; // Enable heater once engine is running (ie. above cranking rpm), this condition can be changed to CLT above certain temp and so on.
     Can0.write(outMsg);
+  }
+}
+
+void receiveCANwbo() 
+{
+  // Currently only RusEFI CAN Wideband supported: https://github.com/mck1117/wideband
+  if(configPage2.canWBO == CAN_WBO_RUSEFI)
+  {
     if ((inMsg.id == 0x190 || inMsg.id == 0x192))
     {
       uint32_t inLambda;
@@ -588,12 +726,14 @@ void obd_response(uint8_t PIDmode, uint8_t requestedPIDlow, uint8_t requestedPID
   }
 }
 
-void readAuxCanBus()
+/** Reads the CAN input values from the frame in inMsg
+ * @param channels Bit mask of the CAN inputs that read this frame (See receiveCAN())
+ */
+void readAuxCanBus(uint16_t channels)
 {
-  for (int i = 0; i < 16; i++)
+  for (uint8_t i = 0; channels != 0U; i++, channels >>= 1)
   {
-    uint16_t channelAddress = (configPage9.caninput_source_can_address[i] + TS_CAN_OFFSET);
-    if (inMsg.id == channelAddress ) //Filters frame ID
+    if ((channels & 1U) != 0U)
     {
 
       if (!BIT_CHECK(configPage9.caninput_source_num_bytes, i))
@@ -19,15 +19,19 @@
 #define TS_CAN_OFFSET 0x100
 
 void initCAN();
+void initCANReceive(void);
+void updateCANReceive(void);
+void receiveCAN(void);
 int CAN_read();
 void CAN_write();
 void sendBMWCluster();
 void sendVAGCluster();
+void sendCANwbo();
 void receiveCANwbo();
 void DashMessages(uint16_t DashMessageID);
 void can_Command(void);
 void obd_response(uint8_t therequestedPID , uint8_t therequestedPIDlow, uint8_t therequestedPIDhigh);
-void readAuxCanBus();
+void readAuxCanBus(uint16_t channels);
 
 extern CAN_message_t outMsg;
 extern CAN_message_t inMsg;
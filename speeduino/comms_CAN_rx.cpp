@@ -0,0 +1,37 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Lookup table of the received CAN frame IDs. See comms_CAN_rx.h
+ */
+#include "comms_CAN_rx.h"
+#include <string.h>
+
+void clearCANRxTable(can_rx_table *pTable)
+{
+  memset(pTable, 0, sizeof(can_rx_table));
+}
+
+/**
+ * Adds a function that uses frames with the given ID. A frame that is already in the table has the handler and channels added to its existing entry
+ * @param extended - True for an extended (29 bit ID) frame. An ID that is too large for the frame format can never be received, so is not added
+ */
+void addCANRxEntry(can_rx_table *pTable, uint32_t id, bool extended, uint8_t handler, uint16_t caninChannels)
+{
+  if(id > (extended ? CAN_EXT_ID_MAX : CAN_STD_ID_MAX)) { return; }
+
+  //Linear probing. The table is never full, so this always finds either the frame or an unused entry
+  uint8_t slot = canRxHash(id);
+  while( (pTable->entries[slot].handlers != 0U) && !isSameCANFrame(pTable->entries[slot].frame, id, extended) ) { slot = (slot + 1U) & (CAN_RX_TABLE_SIZE - 1U); }
+
+  if(pTable->entries[slot].handlers == 0U)
+  {
+    pTable->entries[slot].frame = { id, extended };
+    pTable->ids[pTable->idCount] = { id, extended };
+    pTable->idCount++;
+  }
+  pTable->entries[slot].handlers |= handler;
+  pTable->entries[slot].caninChannels |= caninChannels;
+}
@@ -0,0 +1,66 @@
+#ifndef COMMS_CAN_RX_H
+#define COMMS_CAN_RX_H
+/** @file
+ * Lookup table of the CAN frame IDs that are received (See initCANReceive()).
+ * Received frames are dispatched through a small hash table of the frame IDs that are in use, rather than comparing each frame against every configured ID.
+ * This has no hardware dependencies so that it can be tested on the host (See test/test_can_rx_native).
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#define CAN_RX_TABLE_SIZE   32U   //Must be a power of 2 and larger than the number of IDs that can be added (16 CAN inputs, 2 OBD and 2 WBO)
+#define CAN_RX_OBD          0x01U //Frame is passed to can_Command()
+#define CAN_RX_CANIN        0x02U //Frame is passed to readAuxCanBus()
+#define CAN_RX_WBO          0x04U //Frame is passed to receiveCANwbo()
+
+#define CAN_STD_ID_MAX      0x7FFUL      //Standard frames have 11 bit IDs
+#define CAN_EXT_ID_MAX      0x1FFFFFFFUL //Extended frames have 29 bit IDs
+
+//A frame ID and format. A standard and an extended frame with the same ID number are different frames
+struct can_rx_id {
+  uint32_t id;
+  bool extended;
+};
+
+struct can_rx_entry {
+  can_rx_id frame;
+  uint8_t handlers;       //CAN_RX_* bits. 0 if the entry is unused
+  uint16_t caninChannels; //Bit mask of the CAN inputs that read this frame
+};
+
+struct can_rx_table {
+  can_rx_entry entries[CAN_RX_TABLE_SIZE];
+  can_rx_id ids[CAN_RX_TABLE_SIZE]; //Each distinct frame in the table, in the order they were added. These are the IDs programmed into the hardware filters
+  uint8_t idCount;
+};
+
+static inline uint8_t canRxHash(uint32_t id)
+{
+  return (uint8_t)((id ^ (id >> 5)) & (CAN_RX_TABLE_SIZE - 1U));
+}
+
+static inline bool isSameCANFrame(const can_rx_id &frame, uint32_t id, bool extended)
+{
+  return (frame.id == id) && (frame.extended == extended);
+}
+
+void clearCANRxTable(can_rx_table *pTable);
+void addCANRxEntry(can_rx_table *pTable, uint32_t id, bool extended, uint8_t handler, uint16_t caninChannels);
+
+/**
+ * Finds the entry for a received frame
+ * @param extended - True if the frame was received in the extended (29 bit ID) format
+ * @return The entry, or nullptr if no function uses this frame
+ */
+static inline const can_rx_entry* findCANRxEntry(const can_rx_table *pTable, uint32_t id, bool extended)
+{
+  uint8_t slot = canRxHash(id);
+  while(pTable->entries[slot].handlers != 0U)
+  {
+    if(isSameCANFrame(pTable->entries[slot].frame, id, extended)) { return &pTable->entries[slot]; }
+    slot = (slot + 1U) & (CAN_RX_TABLE_SIZE - 1U);
+  }
+  return nullptr;
+}
+
+#endif // COMMS_CAN_RX_H
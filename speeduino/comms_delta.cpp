@@ -0,0 +1,67 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Delta encoding of the output channels. See comms_delta.h
+ */
+#include "comms_delta.h"
+#include <string.h>
+
+/**
+ * Drops the reference frame, so that the next frame is a keyframe
+ */
+void resetDeltaEncoder(delta_encoder *pEncoder)
+{
+  memset(pEncoder, 0, sizeof(delta_encoder));
+}
+
+/**
+ * Encodes a frame of the output channels
+ * @param pFrame - Buffer of at least DELTA_MAX_FRAME_SIZE bytes
+ * @param pValues - The current values of the requested output channels (length bytes)
+ * @param offset - Start field number of the requested output channels
+ * @param length - Number of output channel bytes requested. Must have been checked with isDeltaRangeValid()
+ * @param ackSequence - The sequence number of the last frame that the client received
+ * @return The length of the frame
+ */
+uint16_t encodeDeltaFrame(delta_encoder *pEncoder, uint8_t *pFrame, const uint8_t *pValues, uint16_t offset, uint16_t length, uint8_t ackSequence)
+{
+  bool keyframe = (pEncoder->length != length) || (pEncoder->offset != offset) || (ackSequence != pEncoder->sequence) || (pEncoder->framesSinceKey >= DELTA_KEYFRAME_INTERVAL);
+  pEncoder->sequence++;
+
+  pFrame[0] = pEncoder->sequence;
+  uint16_t frameLength = DELTA_HEADER_SIZE;
+
+  if(keyframe == true)
+  {
+    pFrame[1] = DELTA_FRAME_KEY;
+    memcpy(pEncoder->reference, pValues, length);
+    memcpy(&pFrame[frameLength], pValues, length);
+    frameLength += length;
+    pEncoder->offset = offset;
+    pEncoder->length = length;
+    pEncoder->framesSinceKey = 0;
+  }
+  else
+  {
+    pFrame[1] = DELTA_FRAME_DELTA;
+    uint8_t *bitmap = &pFrame[DELTA_HEADER_SIZE];
+    uint16_t bitmapSize = (length + 7U) / 8U;
+    memset(bitmap, 0, bitmapSize);
+    frameLength += bitmapSize;
+    for(uint16_t x = 0; x < length; x++)
+    {
+      if(pValues[x] != pEncoder->reference[x])
+      {
+        bitmap[x >> 3U] |= (uint8_t)(1U << (x & 7U));
+        pEncoder->reference[x] = pValues[x];
+        pFrame[frameLength++] = pValues[x];
+      }
+    }
+    pEncoder->framesSinceKey++;
+  }
+
+  return frameLength;
+}
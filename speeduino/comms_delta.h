@@ -0,0 +1,45 @@
+#ifndef COMMS_DELTA_H
+#define COMMS_DELTA_H
+/** @file
+ * Delta encoding of the output channels (See SEND_OUTPUT_CHANNELS_DELTA in comms.cpp).
+ * Each frame is encoded against the output channels that were sent in the previous frame. This has no hardware dependencies so that it can be tested on the host (See test/test_comms_delta_native).
+ *
+ * Frame layout: [sequence][type][data]
+ * - A keyframe (DELTA_FRAME_KEY) contains all of the requested bytes
+ * - A delta frame (DELTA_FRAME_DELTA) contains a bitmap (1 bit per requested byte, LSB first) of the bytes that have changed, followed by the value of each changed byte
+ *
+ * A delta frame is only sent if the client acknowledges (By sending its sequence number) the previous frame and the requested range has not changed.
+ * Otherwise a keyframe is sent. A keyframe is also forced every DELTA_KEYFRAME_INTERVAL frames so that the client can resync
+ */
+#include <stdint.h>
+
+#define DELTA_FRAME_KEY         0U //!< Frame type: Full copy of the requested output channels
+#define DELTA_FRAME_DELTA       1U //!< Frame type: Bitmap of changed bytes followed by the changed values
+#define DELTA_KEYFRAME_INTERVAL 32U //!< A keyframe is forced after this many delta frames
+#define DELTA_MAX_LENGTH        129U //!< The largest range of output channels that can be encoded. This is the size of the live data block (See liveDataBlock)
+#define DELTA_HEADER_SIZE       2U //!< Sequence number and frame type
+#define DELTA_MAX_FRAME_SIZE    (DELTA_HEADER_SIZE + ((DELTA_MAX_LENGTH + 7U) / 8U) + DELTA_MAX_LENGTH) //!< A delta frame where every byte has changed
+
+struct delta_encoder {
+  uint8_t reference[DELTA_MAX_LENGTH]; //The output channels as sent in the last frame
+  uint16_t offset; //The offset of the output channels held in reference
+  uint16_t length; //The number of output channels held in reference. 0 = No reference, a keyframe must be sent
+  uint8_t sequence; //Sequence number of the last frame
+  uint8_t framesSinceKey; //The number of delta frames sent since the last keyframe
+};
+
+/**
+ * Checks that a requested range of output channels can be encoded
+ * @param offset - Start field number
+ * @param length - Number of output channel bytes requested
+ * @param available - The size of the output channel block
+ */
+static inline bool isDeltaRangeValid(uint16_t offset, uint16_t length, uint16_t available)
+{
+  return (length != 0U) && (length <= DELTA_MAX_LENGTH) && (offset < available) && (length <= (available - offset));
+}
+
+void resetDeltaEncoder(delta_encoder *pEncoder);
+uint16_t encodeDeltaFrame(delta_encoder *pEncoder, uint8_t *pFrame, const uint8_t *pValues, uint16_t offset, uint16_t length, uint8_t ackSequence);
+
+#endif // COMMS_DELTA_H
@@ -9,7 +9,10 @@ A full copy of the license may be found in the projects root directory
 #include "globals.h"
 #include "comms_legacy.h"
 #include "comms_secondary.h"
+#include "comms_CAN.h"
 #include "storage.h"
+#include "sensors.h"
+#include "corrections.h"
 #include "maths.h"
 #include "utilities.h"
 #include "decoders.h"
@@ -19,6 +22,8 @@ A full copy of the license may be found in the projects root directory
 #include "page_crc.h"
 #include "logger.h"
 #include "table3d_axis_io.h"
+#include "init.h"
+#include "tuneBanks.h"
 #include BOARD_H
 #ifdef RTC_ENABLED
   #include "rtc_common.h"
@@ -169,6 +174,12 @@ void legacySerialCommand(void)
       stopToothLogger();
       break;
 
+    case 'I': // Display how long each part of the startup took
+      #ifndef SMALL_FLASH_MODE
+      sendBootTimes();
+      #endif
+      break;
+
     case 'J': //Start the composite logger
       startCompositeLogger();
       Serial.write(1); //TS needs an acknowledgement that this was received. I don't know if this is the correct response, but it seems to work
@@ -380,6 +391,10 @@ void legacySerialCommand(void)
           offset2 = Serial.read();
           valueOffset = word(offset2, offset1);
           setPageValue(currentPage, valueOffset, Serial.read());
+          updateCorrectionStages();
+#if defined(NATIVE_CAN_AVAILABLE)
+          if ( (currentPage == canbusPage) || (currentPage == veSetPage) ) { updateCANReceive(); }
+#endif
           serialStatusFlag = SERIAL_INACTIVE;
         }
       }
@@ -389,6 +404,10 @@ void legacySerialCommand(void)
         {
           valueOffset = Serial.read();
           setPageValue(currentPage, valueOffset, Serial.read());
+          updateCorrectionStages();
+#if defined(NATIVE_CAN_AVAILABLE)
+          if ( (currentPage == canbusPage) || (currentPage == veSetPage) ) { updateCANReceive(); }
+#endif
           serialStatusFlag = SERIAL_INACTIVE;
         }
       }
@@ -456,6 +475,7 @@ void legacySerialCommand(void)
 
       if (Serial.available() >= 1) {
         configPage4.bootloaderCaps = Serial.read();
+        invalidatePageCRC(ignSetPage);
         serialStatusFlag = SERIAL_INACTIVE;
       }
       break;
@@ -475,6 +495,7 @@ void legacySerialCommand(void)
          "B - Burn current map and configPage values to eeprom\n"
          "C - Test COM port.  Used by Tunerstudio to see whether an ECU is on a given serial \n"
          "    port. Returns a binary number.\n"
+         "I - Display the time (uS since power on) that each stage of the startup completed\n"
          "N - Print new line.\n"
          "P - Set current page.  Syntax:  P+<pageNumber>\n"
          "R - Same as A command\n"
@@ -514,7 +535,7 @@ void legacySerialHandler(byte cmd, Stream &targetPort, SerialStatus &targetStatu
       if (targetPort.available() >= 2)
       {
         targetPort.read(); //Ignore the first table value, it's always 0
-        writeConfig(targetPort.read());
+        writeConfigChanges(targetPort.read());
         targetStatusFlag = SERIAL_INACTIVE;
       }
       break;
@@ -525,7 +546,7 @@ void legacySerialHandler(byte cmd, Stream &targetPort, SerialStatus &targetStatu
       if (targetPort.available() >= 2)
       {
         targetPort.read(); //Ignore the first table value, it's always 0
-        writeConfig(targetPort.read());
+        writeConfigChanges(targetPort.read());
         targetStatusFlag = SERIAL_INACTIVE;
       }
       break;
@@ -586,7 +607,15 @@ void legacySerialHandler(byte cmd, Stream &targetPort, SerialStatus &targetStatu
           setPageValue(currentPage, (valueOffset + chunkComplete), targetPort.read());
           chunkComplete++;
         }
-        if(chunkComplete >= chunkSize) { targetStatusFlag = SERIAL_INACTIVE; chunkPending = false; }
+        if(chunkComplete >= chunkSize)
+        {
+          updateCorrectionStages();
+#if defined(NATIVE_CAN_AVAILABLE)
+          if ( (currentPage == canbusPage) || (currentPage == veSetPage) ) { updateCANReceive(); }
+#endif
+          targetStatusFlag = SERIAL_INACTIVE;
+          chunkPending = false;
+        }
       }
       break;
 
@@ -708,8 +737,11 @@ void sendValues(uint16_t offset, uint16_t packetLength, byte cmd, Stream &target
   }
 
   //
-  targetStatusFlag = SERIAL_TRANSMIT_INPROGRESS_LEGACY;
   currentStatus.spark ^= (-currentStatus.hasSync ^ currentStatus.spark) & (1U << BIT_SPARK_SYNC); //Set the sync bit of the Spark variable to match the hasSync variable
+  //Take a new snapshot of the live data, unless this or the other serial port is resuming a send that was interrupted by a full tx buffer (So the resumed bytes come from the same snapshot)
+  //Both the TS and legacy secondary serial byte orders are read from the snapshot
+  if(!isLiveDataLocked()) { updateLiveData(); }
+  targetStatusFlag = SERIAL_TRANSMIT_INPROGRESS_LEGACY;
 
   for(byte x=0; x<packetLength; x++)
   {
@@ -1047,7 +1079,7 @@ void sendPageASCII(void)
   {
     case veMapPage:
       Serial.println(F("\nVE Map"));
-      serial_print_3dtable(&fuelTable, fuelTable.type_key);
+      serial_print_3dtable(pFuelTable, pFuelTable->type_key);
       break;
 
     case veSetPage:
@@ -1068,7 +1100,7 @@ void sendPageASCII(void)
 
     case ignMapPage:
       Serial.println(F("\nIgnition Map"));
-      serial_print_3dtable(&ignitionTable, ignitionTable.type_key);
+      serial_print_3dtable(pIgnitionTable, pIgnitionTable->type_key);
       break;
 
     case ignSetPage:
@@ -1086,7 +1118,7 @@ void sendPageASCII(void)
 
     case afrMapPage:
       Serial.println(F("\nAFR Map"));
-      serial_print_3dtable(&afrTable, afrTable.type_key);
+      serial_print_3dtable(pAfrTable, pAfrTable->type_key);
       break;
 
     case afrSetPage:
@@ -1239,6 +1271,7 @@ void receiveCalibration(byte tableID)
   }
 
   writeCalibration();
+  updateCalibrationLookups();
 }
 
 /** Send 256 tooth log entries to serial.
@@ -1251,16 +1284,17 @@ void sendToothLog_legacy(byte startOffset) /* Blocking */
   if (BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY)) //Sanity check. Flagging system means this should always be true
   {
       serialStatusFlag = SERIAL_TRANSMIT_TOOTH_INPROGRESS_LEGACY; 
+      const uint8_t buffer = toothHistoryBuffer ^ 1U; //The full buffer. The interrupts are filling the other one
       for (int x = startOffset; x < TOOTH_LOG_SIZE; x++)
       {
-        Serial.write(toothHistory[x] >> 24);
-        Serial.write(toothHistory[x] >> 16);
-        Serial.write(toothHistory[x] >> 8);
-        Serial.write(toothHistory[x]);
+        uint32_t toothTime = decodeToothLogTime(toothHistory[buffer][x]);
+        Serial.write(toothTime >> 24);
+        Serial.write(toothTime >> 16);
+        Serial.write(toothTime >> 8);
+        Serial.write(toothTime);
       }
       BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
       serialStatusFlag = SERIAL_INACTIVE; 
-      toothHistoryIndex = 0;
   }
   else 
   { 
@@ -1278,6 +1312,11 @@ void sendCompositeLog_legacy(byte startOffset) /* Non-blocking */
   if (BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY)) //Sanity check. Flagging system means this should always be true
   {
       serialStatusFlag = SERIAL_TRANSMIT_COMPOSITE_INPROGRESS_LEGACY;
+      const uint8_t buffer = toothHistoryBuffer ^ 1U; //The full buffer. The interrupts are filling the other one
+
+      //Entries are stored as the time since the previous entry, so add up the ones that have already been sent
+      uint32_t inProgressCompositeTime = compositeLogStartTime[buffer];
+      for (int x = 0; x < startOffset; x++) { inProgressCompositeTime += decodeToothLogTime(toothHistory[buffer][x]); }
 
       for (int x = startOffset; x < TOOTH_LOG_SIZE; x++)
       {
@@ -1289,17 +1328,16 @@ void sendCompositeLog_legacy(byte startOffset) /* Non-blocking */
           return;
         }
 
-        uint32_t inProgressCompositeTime = toothHistory[x]; //This combined runtime (in us) that the log was going for by this record)
+        inProgressCompositeTime += decodeToothLogTime(toothHistory[buffer][x]); //This combined runtime (in us) that the log was going for by this record)
         
         Serial.write(inProgressCompositeTime >> 24);
         Serial.write(inProgressCompositeTime >> 16);
         Serial.write(inProgressCompositeTime >> 8);
         Serial.write(inProgressCompositeTime);
 
-        Serial.write(compositeLogHistory[x]); //The status byte (Indicates the trigger edge, whether it was a pri/sec pulse, the sync status)
+        Serial.write(compositeLogHistory[buffer][x]); //The status byte (Indicates the trigger edge, whether it was a pri/sec pulse, the sync status)
       }
       BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-      toothHistoryIndex = 0;
       serialStatusFlag = SERIAL_INACTIVE; 
   }
   else 
@@ -1313,6 +1351,35 @@ void sendCompositeLog_legacy(byte startOffset) /* Non-blocking */
   } 
 }
 
+/** Prints the time that each stage of initialiseAll() completed (See @ref bootPhaseTimes), along with the time taken by each stage
+ */
+void sendBootTimes(void)
+{
+  Serial.println(F("\nBoot times (uS)"));
+  for (uint8_t phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+  {
+    switch (phase)
+    {
+      case BOOT_PHASE_START: Serial.print(F("Start")); break;
+      case BOOT_PHASE_CONFIG: Serial.print(F("Config")); break;
+      case BOOT_PHASE_BOARD: Serial.print(F("Board")); break;
+      case BOOT_PHASE_OUTPUTS: Serial.print(F("Outputs")); break;
+      case BOOT_PHASE_TRIGGERS: Serial.print(F("Triggers")); break;
+      case BOOT_PHASE_COMPLETE: Serial.print(F("Complete")); break;
+      default: break;
+    }
+    Serial.print(F(": "));
+    Serial.print(bootPhaseTimes[phase]);
+    if (phase > 0U)
+    {
+      Serial.print(F(" (+"));
+      Serial.print(bootPhaseTimes[phase] - bootPhaseTimes[phase - 1U]);
+      Serial.print(F(")"));
+    }
+    Serial.println();
+  }
+}
+
 void testComm(void)
 {
   Serial.write(1);
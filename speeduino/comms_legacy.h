@@ -80,6 +80,7 @@ void sendValues(uint16_t offset, uint16_t packetLength, byte cmd, Stream &target
 void sendValuesLegacy(void);
 void sendPage(void);
 void sendPageASCII(void);
+void sendBootTimes(void);
 void receiveCalibration(byte tableID);
 void testComm(void);
 void sendToothLog_legacy(byte startOffset);
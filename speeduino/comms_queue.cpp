@@ -0,0 +1,92 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Receive queue for the new serial protocol. See comms_queue.h
+ */
+#include "comms_queue.h"
+#include <string.h>
+
+void clearSerialQueue(serial_queue *pQueue)
+{
+  memset(pQueue, 0, sizeof(serial_queue));
+}
+
+/**
+ * Starts receiving a command into the queue, once its length has been read
+ * @return False if the queue is full (Or a command is already being received). The command must be left unread until there is room for it
+ */
+bool beginSerialQueueRx(serial_queue *pQueue, uint16_t length)
+{
+  if( pQueue->rxInProgress || (pQueue->count >= SERIAL_QUEUE_DEPTH) ) { return false; }
+
+  pQueue->rxInProgress = true;
+  pQueue->rxLength = length;
+  pQueue->rxBytes = 0;
+  pQueue->rxCrc = 0;
+  return true;
+}
+
+/**
+ * Adds the next received byte of the payload or CRC. The payload of a command that is too large to be queued is thrown away
+ * @return True once the payload and CRC have been received in full. endSerialQueueRx() must then be called
+ */
+bool serialQueueRxByte(serial_queue *pQueue, uint8_t value)
+{
+  if( pQueue->rxBytes < pQueue->rxLength )
+  {
+    if( pQueue->rxLength <= SERIAL_QUEUE_PAYLOAD_SIZE ) { serialQueueRxEntry(pQueue)->payload[pQueue->rxBytes] = value; }
+  }
+  else { pQueue->rxCrc = (pQueue->rxCrc << 8U) | value; } //CRC is sent MSB first
+  pQueue->rxBytes++;
+
+  return (pQueue->rxBytes == (pQueue->rxLength + SERIAL_QUEUE_CRC_SIZE));
+}
+
+static void addSerialQueueEntry(serial_queue *pQueue, uint8_t status)
+{
+  serial_queue_entry *pEntry = serialQueueRxEntry(pQueue);
+  pEntry->length = (status == SERIAL_QUEUE_OK) ? (uint8_t)pQueue->rxLength : 0U;
+  pEntry->status = status;
+  pQueue->count++;
+  pQueue->rxInProgress = false;
+}
+
+/**
+ * Adds the received command to the queue
+ * @param payloadCrc - The CRC calculated over the received payload. Not used for a command that was too large to be queued
+ * @return The SERIAL_QUEUE_* status of the command
+ */
+uint8_t endSerialQueueRx(serial_queue *pQueue, uint32_t payloadCrc)
+{
+  uint8_t status = SERIAL_QUEUE_OK;
+  if( pQueue->rxLength > SERIAL_QUEUE_PAYLOAD_SIZE ) { status = SERIAL_QUEUE_OVERSIZE; }
+  else if( payloadCrc != pQueue->rxCrc ) { status = SERIAL_QUEUE_CRC_ERR; }
+  else { /* MISRA - no-op */ }
+  addSerialQueueEntry(pQueue, status);
+  return status;
+}
+
+/**
+ * Adds the command being received to the queue as timed out, so that the timeout is answered in order
+ */
+void timeoutSerialQueueRx(serial_queue *pQueue)
+{
+  if( pQueue->rxInProgress ) { addSerialQueueEntry(pQueue, SERIAL_QUEUE_TIMEOUT); }
+}
+
+/**
+ * Removes the oldest command from the queue
+ * @return The command, or nullptr if the queue is empty. This is only valid until the next command is received into the queue
+ */
+const serial_queue_entry* popSerialQueue(serial_queue *pQueue)
+{
+  if( pQueue->count == 0U ) { return nullptr; }
+
+  const serial_queue_entry *pEntry = &pQueue->entries[pQueue->head];
+  pQueue->head = (pQueue->head + 1U) % SERIAL_QUEUE_DEPTH;
+  pQueue->count--;
+  return pEntry;
+}
@@ -0,0 +1,51 @@
+#ifndef COMMS_QUEUE_H
+#define COMMS_QUEUE_H
+/** @file
+ * Receive queue for commands that arrive while the response to an earlier command is still being sent (See serialReceiveQueued() in comms.cpp).
+ * Commands are held oldest first and processed in the order they were received. This has no hardware dependencies so that it can be tested on the host (See test/test_comms_queue_native).
+ *
+ * Every command that is received into the queue gets an entry, so that every command gets exactly one response and the responses stay in order:
+ * - Commands larger than ::SERIAL_QUEUE_PAYLOAD_SIZE (Eg page writes) are read and thrown away. Their response is a busy error, which the client retries once it has the earlier responses
+ * - Commands that fail the CRC check, or that are not received in full before the timeout, are answered with the matching error
+ */
+#include <stdint.h>
+
+#define SERIAL_QUEUE_DEPTH        2U //!< The number of commands that can be received while a response is still being sent
+#define SERIAL_QUEUE_PAYLOAD_SIZE 16U //!< The largest command payload that can be queued
+#define SERIAL_QUEUE_CRC_SIZE     4U //!< Each command is followed by a 32 bit CRC of its payload
+
+#define SERIAL_QUEUE_OK           0U //!< Entry status: The command was received in full and the CRC matched
+#define SERIAL_QUEUE_CRC_ERR      1U //!< Entry status: The CRC did not match
+#define SERIAL_QUEUE_OVERSIZE     2U //!< Entry status: The command was too large to be queued and has been thrown away
+#define SERIAL_QUEUE_TIMEOUT      3U //!< Entry status: The command was not received in full before the timeout
+
+struct serial_queue_entry {
+  uint8_t payload[SERIAL_QUEUE_PAYLOAD_SIZE];
+  uint8_t length;
+  uint8_t status; //SERIAL_QUEUE_* status
+};
+
+struct serial_queue {
+  serial_queue_entry entries[SERIAL_QUEUE_DEPTH];
+  uint8_t head; //Index of the oldest command
+  uint8_t count; //The number of complete commands
+  bool rxInProgress; //A command is being received into the entry after the newest one
+  uint16_t rxLength; //Payload length of the command being received
+  uint16_t rxBytes; //The number of payload and CRC bytes received to date
+  uint32_t rxCrc; //The CRC of the command being received, as received
+};
+
+/** @brief The entry that the command being received is held in */
+static inline serial_queue_entry* serialQueueRxEntry(serial_queue *pQueue)
+{
+  return &pQueue->entries[(pQueue->head + pQueue->count) % SERIAL_QUEUE_DEPTH];
+}
+
+void clearSerialQueue(serial_queue *pQueue);
+bool beginSerialQueueRx(serial_queue *pQueue, uint16_t length);
+bool serialQueueRxByte(serial_queue *pQueue, uint8_t value);
+uint8_t endSerialQueueRx(serial_queue *pQueue, uint32_t payloadCrc);
+void timeoutSerialQueueRx(serial_queue *pQueue);
+const serial_queue_entry* popSerialQueue(serial_queue *pQueue);
+
+#endif // COMMS_QUEUE_H
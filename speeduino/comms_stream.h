@@ -0,0 +1,56 @@
+#ifndef COMMS_STREAM_H
+#define COMMS_STREAM_H
+/** @file
+ * Output channel streaming (See STREAM_OUTPUT_CHANNELS in comms.cpp).
+ * The client requests a subset of the output channels and a rate, then the frames are sent without further requests until any new command is received.
+ * This has no hardware dependencies so that it can be tested on the host (See test/test_comms_stream_native).
+ */
+#include <stdint.h>
+
+#define STREAM_MAX_RATE     1000U //!< Hz. The stream rate is limited by the main loop speed well before this
+
+struct stream_state {
+  uint16_t offset; //The first output channel byte included in each frame
+  uint16_t length; //The number of output channel bytes in each frame
+  uint16_t interval; //Time (ms) between frames. 0 = Streaming is not active
+  uint32_t lastFrame; //The time (ms) that the last frame was started
+};
+
+static inline void stopStream(stream_state *pStream)
+{
+  pStream->interval = 0;
+}
+
+/**
+ * Starts streaming a subset of the output channels. The subset is clamped to the end of the output channel block
+ * @param offset - The first output channel byte
+ * @param length - The number of output channel bytes requested
+ * @param rate - Frames per second. Must not be 0 (Which stops the stream)
+ * @param blockSize - The size of the output channel block (LOG_ENTRY_SIZE)
+ * @param now - The current time (ms). The first frame is treated as being sent at this time
+ * @return False if the subset has no output channels in it. Streaming is not started
+ */
+static inline bool startStream(stream_state *pStream, uint16_t offset, uint16_t length, uint16_t rate, uint16_t blockSize, uint32_t now)
+{
+  if( (length == 0U) || (offset >= blockSize) || (rate == 0U) ) { return false; }
+  if(length > (blockSize - offset)) { length = blockSize - offset; }
+  if(rate > STREAM_MAX_RATE) { rate = STREAM_MAX_RATE; }
+
+  pStream->offset = offset;
+  pStream->length = length;
+  pStream->interval = (uint16_t)(1000U / rate);
+  pStream->lastFrame = now;
+  return true;
+}
+
+/**
+ * Checks whether the next frame should be sent. If so, it is treated as being sent at the current time
+ */
+static inline bool isStreamFrameDue(stream_state *pStream, uint32_t now)
+{
+  if( (pStream->interval == 0U) || ((now - pStream->lastFrame) < pStream->interval) ) { return false; }
+  pStream->lastFrame = now;
+  return true;
+}
+
+#endif // COMMS_STREAM_H
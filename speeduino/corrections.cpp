@@ -29,6 +29,7 @@ There are 2 top level functions that call more detailed corrections for Fuel and
 #include "timers.h"
 #include "maths.h"
 #include "sensors.h"
+#include "tuneBanks.h"
 #include "src/PID_v1/PID_v1.h"
 
 long PID_O2, PID_output, PID_AFRTarget;
@@ -43,10 +44,6 @@ byte activateTPSDOT; //The tpsDOT value seen when the MAE was activated.
 
 bool idleAdvActive = false;
 uint16_t AFRnextCycle;
-unsigned long knockStartTime;
-byte lastKnockCount;
-int16_t knockWindowMin; //The current minimum crank angle for a knock pulse to be valid
-int16_t knockWindowMax;//The current maximum crank angle for a knock pulse to be valid
 uint8_t aseTaper;
 uint8_t dfcoDelay;
 uint8_t idleAdvTaper;
@@ -63,69 +60,279 @@ void initialiseCorrections(void)
   AFRnextCycle = 0;
   currentStatus.knockActive = false;
   currentStatus.battery10 = 125; //Set battery voltage to sensible value for dwell correction for "flying start" (else ignition gets spurious pulses after boot)  
+  updateCorrectionStages();
 }
 
-/** Dispatch calculations for all fuel related corrections.
-Calls all the other corrections functions and combines their results.
-This is the only function that should be called from anywhere outside the file
-*/
-uint16_t correctionsFuel(void)
+//Each fuel stage applies its correction to the running total and returns the new total
+typedef uint32_t (*fuelCorrectionStage_t)(uint32_t sumCorrections);
+typedef int8_t (*ignCorrectionStage_t)(int8_t advance);
+
+#define FUEL_CORRECTION_STAGES_MAX  13
+#define IGN_CORRECTION_STAGES_MAX   12
+
+static fuelCorrectionStage_t fuelCorrectionStages[FUEL_CORRECTION_STAGES_MAX];
+static ignCorrectionStage_t ignCorrectionStages[IGN_CORRECTION_STAGES_MAX];
+static uint8_t fuelCorrectionStageCount = 0;
+static uint8_t ignCorrectionStageCount = 0;
+
+//Corrections whose inputs only change at the slow sensor read rates (4Hz for CLT, IAT and battery, 1Hz for baro and flex) are cached rather than being recalculated every loop.
+//Each of these is only recalculated when the input it depends on changes, or when the config has changed (See @ref updateCorrectionStages())
+static uint32_t slowFuelCorrections = 100; //Combined factor of all the cached fuel corrections
+static bool slowFuelCorrectionsStale = true;
+static int lastFuelCoolant;
+static int lastFuelIAT;
+static byte lastFuelBattery;
+static byte lastFuelBaro;
+static byte lastFuelEthanolPct;
+static int8_t lastFuelTemp;
+
+static int8_t cachedIATRetard = 0; //Cached adjustments from correctionIATretard() and correctionCLTadvance()
+static int8_t cachedCLTAdvance = 0;
+static bool slowIgnCorrectionsStale = true;
+static int lastIgnCoolant;
+static int lastIgnIAT;
+
+static inline uint32_t applyFuelCorrection(uint32_t sumCorrections, uint32_t correction)
 {
-  uint32_t sumCorrections = 100;
-  uint16_t result; //temporary variable to store the result of each corrections function
+  if (correction != 100) { sumCorrections = div100(sumCorrections * correction); }
+  return sumCorrections;
+}
 
-  //The values returned by each of the correction functions are multiplied together and then divided back to give a single 0-255 value.
-  currentStatus.wueCorrection = correctionWUE();
-  if (currentStatus.wueCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.wueCorrection); }
+/** Recalculate any of the cached fuel corrections whose input has changed since they were last calculated, and the combined factor of them if so.
+ */
+static void updateSlowFuelCorrections(void)
+{
+  bool stale = slowFuelCorrectionsStale;
+  bool changed = stale;
 
+  if( stale || (currentStatus.coolant != lastFuelCoolant) )
+  {
+    lastFuelCoolant = currentStatus.coolant;
+    currentStatus.wueCorrection = correctionWUE();
+    changed = true;
+  }
+  if( stale || (currentStatus.battery10 != lastFuelBattery) )
+  {
+    lastFuelBattery = currentStatus.battery10;
+    currentStatus.batCorrection = correctionBatVoltage();
+    if (configPage2.battVCorMode == BATTV_COR_MODE_OPENTIME)
+    {
+      inj_opentime_uS = configPage2.injOpen * currentStatus.batCorrection; // Apply voltage correction to injector open time.
+      //currentStatus.batCorrection = 100; // This is to ensure that the correction is not applied twice. There is no battery correction fator as we have instead changed the open time
+    }
+    changed = true;
+  }
+  if( stale || (currentStatus.IAT != lastFuelIAT) )
+  {
+    lastFuelIAT = currentStatus.IAT;
+    currentStatus.iatCorrection = correctionIATDensity();
+    changed = true;
+  }
+  if( stale || (currentStatus.baro != lastFuelBaro) )
+  {
+    lastFuelBaro = currentStatus.baro;
+    currentStatus.baroCorrection = correctionBaro();
+    changed = true;
+  }
+  if(configPage2.flexEnabled == 1)
+  {
+    //Both of these are updated from the flex sensor interrupt
+    byte ethanolPct = currentStatus.ethanolPct;
+    int8_t fuelTemp = currentStatus.fuelTemp;
+    if( stale || (ethanolPct != lastFuelEthanolPct) )
+    {
+      lastFuelEthanolPct = ethanolPct;
+      currentStatus.flexCorrection = correctionFlex();
+      changed = true;
+    }
+    if( stale || (fuelTemp != lastFuelTemp) )
+    {
+      lastFuelTemp = fuelTemp;
+      currentStatus.fuelTempCorrection = correctionFuelTemp();
+      changed = true;
+    }
+  }
+
+  if(changed == true)
+  {
+    uint32_t sumSlowCorrections = 100;
+    sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.wueCorrection);
+    if (configPage2.battVCorMode == BATTV_COR_MODE_WHOLE) { sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.batCorrection); }
+    sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.iatCorrection);
+    sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.baroCorrection);
+    sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.flexCorrection); //Flex and fuel temp are 100 when flex is disabled
+    sumSlowCorrections = applyFuelCorrection(sumSlowCorrections, currentStatus.fuelTempCorrection);
+    slowFuelCorrections = sumSlowCorrections;
+  }
+  slowFuelCorrectionsStale = false;
+}
+
+/** Forces all of the cached fuel corrections to be recalculated on the next call to correctionsFuel().
+ * Called when the engine stalls or starts cranking. The engine status bits that the corrections set (Eg BIT_ENGINE_WARMUP) are cleared at these points and would otherwise stay clear until the input of that correction next changed.
+ */
+void invalidateSlowFuelCorrections(void)
+{
+  slowFuelCorrectionsStale = true;
+}
+
+/** Recalculate the cached IAT retard and CLT advance if their inputs have changed.
+ */
+static void updateSlowIgnCorrections(void)
+{
+  if( slowIgnCorrectionsStale || (currentStatus.IAT != lastIgnIAT) )
+  {
+    lastIgnIAT = currentStatus.IAT;
+    cachedIATRetard = correctionIATretard(0);
+  }
+  if( slowIgnCorrectionsStale || (currentStatus.coolant != lastIgnCoolant) )
+  {
+    lastIgnCoolant = currentStatus.coolant;
+    cachedCLTAdvance = correctionCLTadvance(0);
+  }
+  slowIgnCorrectionsStale = false;
+}
+
+static uint32_t fuelStageSlowCorrections(uint32_t sumCorrections)
+{
+  return applyFuelCorrection(sumCorrections, slowFuelCorrections);
+}
+
+static int8_t ignStageIATretard(int8_t advance)
+{
+  return advance + cachedIATRetard;
+}
+
+static int8_t ignStageCLTadvance(int8_t advance)
+{
+  return advance + cachedCLTAdvance;
+}
+
+static uint32_t fuelStageASE(uint32_t sumCorrections)
+{
   currentStatus.ASEValue = correctionASE();
-  if (currentStatus.ASEValue != 100) { sumCorrections = div100(sumCorrections * currentStatus.ASEValue); }
+  return applyFuelCorrection(sumCorrections, currentStatus.ASEValue);
+}
 
-  result = correctionCranking();
-  if (result != 100) { sumCorrections = div100(sumCorrections * result); }
+static uint32_t fuelStageCranking(uint32_t sumCorrections)
+{
+  return applyFuelCorrection(sumCorrections, correctionCranking());
+}
 
+static uint32_t fuelStageAccel(uint32_t sumCorrections)
+{
   currentStatus.AEamount = correctionAccel();
   if ( (configPage2.aeApplyMode == AE_MODE_MULTIPLIER) || BIT_CHECK(currentStatus.engine, BIT_ENGINE_DCC) ) // multiply by the AE amount in case of multiplier AE mode or Decel
   {
-    if (currentStatus.AEamount != 100) { sumCorrections = div100(sumCorrections * currentStatus.AEamount);}
+    sumCorrections = applyFuelCorrection(sumCorrections, currentStatus.AEamount);
   }
+  return sumCorrections;
+}
 
-  result = correctionFloodClear();
-  if (result != 100) { sumCorrections = div100(sumCorrections * result); }
+static uint32_t fuelStageFloodClear(uint32_t sumCorrections)
+{
+  return applyFuelCorrection(sumCorrections, correctionFloodClear());
+}
 
+static uint32_t fuelStageAFRClosedLoop(uint32_t sumCorrections)
+{
   currentStatus.egoCorrection = correctionAFRClosedLoop();
-  if (currentStatus.egoCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.egoCorrection); }
+  return applyFuelCorrection(sumCorrections, currentStatus.egoCorrection);
+}
 
-  currentStatus.batCorrection = correctionBatVoltage();
-  if (configPage2.battVCorMode == BATTV_COR_MODE_OPENTIME)
+static uint32_t fuelStageLaunch(uint32_t sumCorrections)
+{
+  currentStatus.launchCorrection = correctionLaunch();
+  return applyFuelCorrection(sumCorrections, currentStatus.launchCorrection);
+}
+
+static uint32_t fuelStageDFCO(uint32_t sumCorrections)
+{
+  bitWrite(currentStatus.status1, BIT_STATUS1_DFCO, correctionDFCO());
+  byte dfcoTaperCorrection = correctionDFCOfuel();
+  if (dfcoTaperCorrection == 0) { sumCorrections = 0; }
+  else { sumCorrections = applyFuelCorrection(sumCorrections, dfcoTaperCorrection); }
+  return sumCorrections;
+}
+
+/** Build the lists of fuel and ignition corrections that are run each loop.
+ * Stages that are disabled in the current config are left out of the lists entirely and their status values are set to their neutral (No correction) value once here instead.
+ * The order of the stages is the same as they have always been run in, with the fixed timing corrections last.
+ * This only removes the enable checks of the disabled stages from each loop. Its effect on loopsPerSecond has not been measured.
+ * Must be called whenever the config that enables or disables any of the corrections is loaded or changed.
+ */
+void updateCorrectionStages(void)
+{
+  uint8_t fuelCount = 0;
+  uint8_t ignCount = 0;
+
+  fuelCorrectionStages[fuelCount++] = fuelStageSlowCorrections; //WUE, battery voltage, IAT density, baro, flex and fuel temp
+  fuelCorrectionStages[fuelCount++] = fuelStageASE;
+  fuelCorrectionStages[fuelCount++] = fuelStageCranking;
+  if(configPage2.aeMode != AE_MODE_XTAU) { fuelCorrectionStages[fuelCount++] = fuelStageAccel; }
+  else
   {
-    inj_opentime_uS = configPage2.injOpen * currentStatus.batCorrection; // Apply voltage correction to injector open time.
-    //currentStatus.batCorrection = 100; // This is to ensure that the correction is not applied twice. There is no battery correction fator as we have instead changed the open time
+    //The wall wetting model is applied to the pulsewidth instead (See transientFuel.h)
+    BIT_CLEAR(currentStatus.engine, BIT_ENGINE_ACC);
+    BIT_CLEAR(currentStatus.engine, BIT_ENGINE_DCC);
   }
-  if (configPage2.battVCorMode == BATTV_COR_MODE_WHOLE)
+  fuelCorrectionStages[fuelCount++] = fuelStageFloodClear;
+  if( (configPage6.egoType > 0) || (configPage2.incorporateAFR == true) ) { fuelCorrectionStages[fuelCount++] = fuelStageAFRClosedLoop; }
+  else { currentStatus.egoCorrection = 100; }
+  if(configPage2.flexEnabled == 0)
   {
-    if (currentStatus.batCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.batCorrection); }  
+    currentStatus.flexCorrection = 100;
+    currentStatus.fuelTempCorrection = 100;
   }
+  if(configPage6.launchEnabled) { fuelCorrectionStages[fuelCount++] = fuelStageLaunch; }
+  else { currentStatus.launchCorrection = 100; }
+  fuelCorrectionStages[fuelCount++] = fuelStageDFCO;
+
+  if(configPage2.flexEnabled == 1) { ignCorrectionStages[ignCount++] = correctionFlexTiming; }
+  else { currentStatus.flexIgnCorrection = 0; }
+  if( (configPage10.wmiEnabled >= 1) && (configPage10.wmiAdvEnabled == 1) ) { ignCorrectionStages[ignCount++] = correctionWMITiming; }
+  ignCorrectionStages[ignCount++] = ignStageIATretard;
+  ignCorrectionStages[ignCount++] = ignStageCLTadvance;
+  ignCorrectionStages[ignCount++] = correctionIdleAdvance; //Always run as it also tracks whether idle advance can become active
+  if( (configPage6.engineProtectType == PROTECT_CUT_IGN) || (configPage6.engineProtectType == PROTECT_CUT_BOTH) ) { ignCorrectionStages[ignCount++] = correctionSoftRevLimit; }
+  else { BIT_CLEAR(currentStatus.spark, BIT_SPARK_SFTLIM); }
+  if(configPage10.n2o_enable > 0) { ignCorrectionStages[ignCount++] = correctionNitrous; }
+  if(configPage6.launchEnabled) { ignCorrectionStages[ignCount++] = correctionSoftLaunch; }
+  else
+  {
+    currentStatus.launchingSoft = false;
+    BIT_CLEAR(currentStatus.spark, BIT_SPARK_SLAUNCH);
+  }
+  if(configPage6.flatSEnable) { ignCorrectionStages[ignCount++] = correctionSoftFlatShift; }
+  else { BIT_CLEAR(currentStatus.spark2, BIT_SPARK2_FLATSS); }
+  if(configPage9.dfcoTaperEnable == 1) { ignCorrectionStages[ignCount++] = correctionDFCOignition; }
+  //Fixed timing check must go last
+  if(configPage2.fixAngEnable == 1) { ignCorrectionStages[ignCount++] = correctionFixedTiming; }
+  ignCorrectionStages[ignCount++] = correctionCrankingFixedTiming; //This overrides the regular fixed timing, must come last
 
-  currentStatus.iatCorrection = correctionIATDensity();
-  if (currentStatus.iatCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.iatCorrection); }
-
-  currentStatus.baroCorrection = correctionBaro();
-  if (currentStatus.baroCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.baroCorrection); }
+  //Config changes may alter any of the cached corrections, so recalculate them all on the next loop
+  slowFuelCorrectionsStale = true;
+  slowIgnCorrectionsStale = true;
 
-  currentStatus.flexCorrection = correctionFlex();
-  if (currentStatus.flexCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.flexCorrection); }
+  //The stage lists are only ever read from the main loop, so no interrupt protection is needed when swapping the counts
+  fuelCorrectionStageCount = fuelCount;
+  ignCorrectionStageCount = ignCount;
+}
 
-  currentStatus.fuelTempCorrection = correctionFuelTemp();
-  if (currentStatus.fuelTempCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.fuelTempCorrection); }
+/** Dispatch calculations for all fuel related corrections.
+Runs each of the enabled fuel correction stages (See @ref updateCorrectionStages()) and combines their results.
+This is the only function that should be called from anywhere outside the file
+*/
+uint16_t correctionsFuel(void)
+{
+  uint32_t sumCorrections = 100;
 
-  currentStatus.launchCorrection = correctionLaunch();
-  if (currentStatus.launchCorrection != 100) { sumCorrections = div100(sumCorrections * currentStatus.launchCorrection); }
+  updateSlowFuelCorrections();
 
-  bitWrite(currentStatus.status1, BIT_STATUS1_DFCO, correctionDFCO());
-  byte dfcoTaperCorrection = correctionDFCOfuel();
-  if (dfcoTaperCorrection == 0) { sumCorrections = 0; }
-  else if (dfcoTaperCorrection != 100) { sumCorrections = div100(sumCorrections * dfcoTaperCorrection); }
+  //The values returned by each of the correction functions are multiplied together and then divided back to give a single 0-255 value.
+  for(uint8_t stage = 0; stage < fuelCorrectionStageCount; stage++)
+  {
+    sumCorrections = fuelCorrectionStages[stage](sumCorrections);
+  }
 
   if(sumCorrections > 1500) { sumCorrections = 1500; } //This is the maximum allowable increase during cranking
   return (uint16_t)sumCorrections;
@@ -603,7 +810,7 @@ byte correctionAFRClosedLoop(void)
 
     //Determine whether the Y axis of the AFR target table tshould be MAP (Speed-Density) or TPS (Alpha-N)
     //Note that this should only run after the sensor warmup delay when using Include AFR option, but on Incorporate AFR option it needs to be done at all times
-    if( (currentStatus.runSecs > configPage6.ego_sdelay) || (configPage2.incorporateAFR == true) ) { currentStatus.afrTarget = get3DTableValue(&afrTable, currentStatus.fuelLoad, currentStatus.RPM); } //Perform the target lookup
+    if( (currentStatus.runSecs > configPage6.ego_sdelay) || (configPage2.incorporateAFR == true) ) { currentStatus.afrTarget = get3DTableValue(pAfrTable, currentStatus.fuelLoad, currentStatus.RPM); } //Perform the target lookup
   }
   
   if((configPage6.egoType > 0) && (BIT_CHECK(currentStatus.status1, BIT_STATUS1_DFCO) != 1  ) ) //egoType of 0 means no O2 sensor. If DFCO is active do not run the ego controllers to prevent iterator wind-up.
@@ -670,27 +877,18 @@ byte correctionAFRClosedLoop(void)
 //******************************** IGNITION ADVANCE CORRECTIONS ********************************
 /** Dispatch calculations for all ignition related corrections.
  * @param base_advance - Base ignition advance (deg. ?)
+ * Runs each of the enabled ignition correction stages (See @ref updateCorrectionStages()) in order.
  * @return Advance considering all (~12) individual corrections
  */
 int8_t correctionsIgn(int8_t base_advance)
 {
-  int8_t advance;
-  advance = correctionFlexTiming(base_advance);
-  advance = correctionWMITiming(advance);
-  advance = correctionIATretard(advance);
-  advance = correctionCLTadvance(advance);
-  advance = correctionIdleAdvance(advance);
-  advance = correctionSoftRevLimit(advance);
-  advance = correctionNitrous(advance);
-  advance = correctionSoftLaunch(advance);
-  advance = correctionSoftFlatShift(advance);
-  advance = correctionKnock(advance);
+  int8_t advance = base_advance;
 
-  advance = correctionDFCOignition(advance);
-
-  //Fixed timing check must go last
-  advance = correctionFixedTiming(advance);
-  advance = correctionCrankingFixedTiming(advance); //This overrides the regular fixed timing, must come last
+  updateSlowIgnCorrections();
+  for(uint8_t stage = 0; stage < ignCorrectionStageCount; stage++)
+  {
+    advance = ignCorrectionStages[stage](advance);
+  }
 
   return advance;
 }
@@ -885,43 +1083,6 @@ int8_t correctionSoftFlatShift(int8_t advance)
 
   return ignSoftFlatValue;
 }
-/** Ignition knock (retard) correction.
- */
-int8_t correctionKnock(int8_t advance)
-{
-  byte knockRetard = 0;
-
-  //First check is to do the window calculations (Assuming knock is enabled)
-  if( configPage10.knock_mode != KNOCK_MODE_OFF )
-  {
-    knockWindowMin = table2D_getValue(&knockWindowStartTable, currentStatus.RPMdiv100);
-    knockWindowMax = knockWindowMin + table2D_getValue(&knockWindowDurationTable, currentStatus.RPMdiv100);
-  }
-
-
-  if( (configPage10.knock_mode == KNOCK_MODE_DIGITAL)  )
-  {
-    //
-    if(knockCounter > configPage10.knock_count)
-    {
-      if(currentStatus.knockActive == true)
-      {
-        //Knock retard is currently 
-      }
-      else
-      {
-        //Knock needs to be activated
-        lastKnockCount = knockCounter;
-        knockStartTime = micros();
-        knockRetard = configPage10.knock_firstStep;
-      }
-    }
-
-  }
-
-  return advance - knockRetard;
-}
-
 /** Ignition DFCO taper correction.
  */
 int8_t correctionDFCOignition(int8_t advance)
@@ -8,6 +8,8 @@ All functions in the gamma file return
 #define IGN_IDLE_THRESHOLD 200 //RPM threshold (below CL idle target) for when ign based idle control will engage
 
 void initialiseCorrections(void);
+void updateCorrectionStages(void);
+void invalidateSlowFuelCorrections(void); //Recalculate all of the cached fuel corrections on the next loop
 uint16_t correctionsFuel(void);
 byte correctionWUE(void); //Warmup enrichment
 uint16_t correctionCranking(void); //Cranking enrichment
@@ -37,7 +39,6 @@ int8_t correctionSoftRevLimit(int8_t advance);
 int8_t correctionNitrous(int8_t advance);
 int8_t correctionSoftLaunch(int8_t advance);
 int8_t correctionSoftFlatShift(int8_t advance);
-int8_t correctionKnock(int8_t advance);
 int8_t correctionDFCOignition(int8_t advance);
 
 uint16_t correctionsDwell(uint16_t dwell);
@@ -46,10 +47,6 @@ extern byte activateMAPDOT; //The mapDOT value seen when the MAE was activated.
 extern byte activateTPSDOT; //The tpsDOT value seen when the MAE was activated. 
 
 extern uint16_t AFRnextCycle;
-extern unsigned long knockStartTime;
-extern byte lastKnockCount;
-extern int16_t knockWindowMin; //The current minimum crank angle for a knock pulse to be valid
-extern int16_t knockWindowMax;//The current maximum crank angle for a knock pulse to be valid
 extern uint8_t aseTaper;
 extern uint8_t dfcoDelay;
 extern uint8_t idleAdvTaper;
@@ -6,6 +6,7 @@
 
 //These are only part of the experimental 2nd deriv calcs
 #if SECOND_DERIV_ENABLED!=0
+#include "logger.h"
 byte deltaToothCount = 0; //The last tooth that was used with the deltaV calc
 int rpmDelta;
 #endif
@@ -73,8 +74,8 @@ void doCrankSpeedCalcs(void)
           }
           else { angle1 = triggerToothAngle; angle2 = triggerToothAngle; }
 
-          uint32_t toothDeltaV = (MICROS_PER_SEC * angle2 / toothHistory[toothHistoryIndex]) - (MICROS_PER_SEC * angle1 / toothHistory[toothHistoryIndex-1]);
-          uint32_t toothDeltaT = toothHistory[toothHistoryIndex];
+          uint32_t toothDeltaT = decodeToothLogTime(toothHistory[toothHistoryBuffer][toothHistoryIndex]);
+          uint32_t toothDeltaV = (MICROS_PER_SEC * angle2 / toothDeltaT) - (MICROS_PER_SEC * angle1 / decodeToothLogTime(toothHistory[toothHistoryBuffer][toothHistoryIndex-1]));
           //long timeToLastTooth = micros() - toothLastToothTime;
 
           rpmDelta = lshift<10>(toothDeltaV) / (6 * toothDeltaT);
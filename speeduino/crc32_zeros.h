@@ -0,0 +1,63 @@
+#ifndef CRC32_ZEROS_H
+#define CRC32_ZEROS_H
+/** @file
+ * Zero run CRC combine, used to pad the page CRCs (See computePageCRC32() in page_crc.cpp).
+ * Appending n zero bytes to a CRC is the same as multiplying the CRC register by x^(8n) modulo the
+ * CRC polynomial. Using precomputed x^(2^k) values, this takes log2(n) polynomial multiplications
+ * instead of n table lookups. Polynomials are in the reflected bit order used by CRC32 (Bit 31 is x^0).
+ * This has no hardware dependencies so that it can be tested on the host (See test/test_crc32_native).
+ */
+#include <stdint.h>
+
+#ifndef PROGMEM
+//Host builds have no program memory
+#define PROGMEM
+#endif
+#ifndef pgm_read_dword
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#endif
+
+#define CRC32_POLY_REFLECTED 0xEDB88320UL
+
+// Multiply a and b modulo the CRC polynomial
+static inline uint32_t multiply_mod_poly(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+    uint32_t mask = 1UL << 31U;
+    while (mask != 0U)
+    {
+        if ((a & mask) != 0U)
+        {
+            product ^= b;
+        }
+        b = (b & 1U) != 0U ? (b >> 1U) ^ CRC32_POLY_REFLECTED : b >> 1U;
+        mask >>= 1U;
+    }
+    return product;
+}
+
+// x^(2^k) modulo the CRC polynomial for k = 3 (1 byte) to k = 18. Enough for any run of up to 65535 bytes
+static constexpr uint32_t PROGMEM x2n_table[] = {
+    0x00800000UL, 0x00008000UL, 0xedb88320UL, 0xb1e6b092UL,
+    0xa06a2517UL, 0xed627daeUL, 0x88d14467UL, 0xd7bbfe6aUL,
+    0xec447f11UL, 0x8e7ea170UL, 0x6427800eUL, 0x4d47bae0UL,
+    0x09fe548fUL, 0x83852d0fUL, 0x30362f1aUL, 0x7b5a9cc3UL,
+};
+
+// Returns the CRC register after a run of zero bytes has been fed into it. Does not update any FastCRC32 state, so may only be used at the end of a calculation
+static inline uint32_t append_zeros_crc(uint16_t length, uint32_t crc)
+{
+    uint8_t k = 0;
+    while (length != 0U)
+    {
+        if ((length & 1U) != 0U)
+        {
+            crc = multiply_mod_poly(pgm_read_dword(&x2n_table[k]), crc);
+        }
+        length >>= 1U;
+        ++k;
+    }
+    return crc;
+}
+
+#endif // CRC32_ZEROS_H
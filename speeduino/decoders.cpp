@@ -42,6 +42,10 @@ A full copy of the license may be found in the projects root directory
 #include "crankMaths.h"
 #include "timers.h"
 #include "schedule_calcs.h"
+#include "sensors.h"
+#include "pages.h"
+#include "page_crc.h"
+#include "logger.h"
 
 void nullTriggerHandler (void){return;} //initialisation function for triggerhandlers, does exactly nothing
 uint16_t nullGetRPM(void){return 0;} //initialisation function for getRpm, returns safe value of 0
@@ -133,70 +137,98 @@ static libdivide::libdivide_s16_t divTriggerToothAngle;
 
 /** Add tooth log entry to toothHistory (array).
  * Enabled by (either) currentStatus.toothLogEnabled and currentStatus.compositeTriggerUsed.
+ * 
+ * The log is double buffered: Entries are added to the buffer selected by toothHistoryBuffer and when it is full the buffers are swapped, with 
+ * BIT_STATUS1_TOOTHLOG1READY indicating that the full one is ready to send. If the previous full buffer has still not been sent by then, 
+ * the current buffer is restarted instead (Leaving a gap in the log) and toothLogOverflows is incremented.
  * @param toothTime - Tooth Time
  * @param whichTooth - 0 for Primary (Crank), 2 for Secondary (Cam) 3 for Tertiary (Cam)
  */
 static inline void addToothLogEntry(unsigned long toothTime, byte whichTooth)
 {
-  if(BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY)) { return; }
+  static uint32_t compositeLogLastTime = 0; //The time of the previous composite log entry
+
   //High speed tooth logging history
   if( (currentStatus.toothLogEnabled == true) || (currentStatus.compositeTriggerUsed > 0) ) 
   {
     bool valueLogged = false;
+    const uint8_t buffer = toothHistoryBuffer;
     if(currentStatus.toothLogEnabled == true)
     {
       //Tooth log only works on the Crank tooth
       if(whichTooth == TOOTH_CRANK)
       { 
-        toothHistory[toothHistoryIndex] = toothTime; //Set the value in the log. 
+        toothHistory[buffer][toothHistoryIndex] = encodeToothLogTime(toothTime); //Set the value in the log. 
         valueLogged = true;
       } 
     }
     else if(currentStatus.compositeTriggerUsed > 0)
     {
-      compositeLogHistory[toothHistoryIndex] = 0;
+      uint8_t compositeStatus = 0;
       if(currentStatus.compositeTriggerUsed == 4)
       {
         // we want to display both cams so swap the values round to display primary as cam1 and secondary as cam2, include the crank in the data as the third output
-        if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_PRI); }
-        if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_SEC); }
-        if(READ_PRI_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_THIRD); }
-        if(whichTooth > TOOTH_CAM_SECONDARY) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_TRIG); }
+        if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_PRI); }
+        if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_SEC); }
+        if(READ_PRI_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_THIRD); }
+        if(whichTooth > TOOTH_CAM_SECONDARY) { BIT_SET(compositeStatus, COMPOSITE_LOG_TRIG); }
       }
       else
       {
         // we want to display crank and one of the cams
-        if(READ_PRI_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_PRI); }
+        if(READ_PRI_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_PRI); }
         if(currentStatus.compositeTriggerUsed == 3)
         { 
           // display cam2 and also log data for cam 1
-          if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_SEC); } // only the COMPOSITE_LOG_SEC value is visualised hence the swapping of the data
-          if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_THIRD); } 
+          if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_SEC); } // only the COMPOSITE_LOG_SEC value is visualised hence the swapping of the data
+          if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_THIRD); } 
         } 
         else
         { 
           // display cam1 and also log data for cam 2 - this is the historic composite view
-          if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_SEC); } 
-          if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_THIRD); }
+          if(READ_SEC_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_SEC); } 
+          if(READ_THIRD_TRIGGER() == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_THIRD); }
         }
-        if(whichTooth > TOOTH_CRANK) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_TRIG); }
+        if(whichTooth > TOOTH_CRANK) { BIT_SET(compositeStatus, COMPOSITE_LOG_TRIG); }
       }  
-      if(currentStatus.hasSync == true) { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_LOG_SYNC); }
+      if(currentStatus.hasSync == true) { BIT_SET(compositeStatus, COMPOSITE_LOG_SYNC); }
 
       if(revolutionOne == 1)
-      { BIT_SET(compositeLogHistory[toothHistoryIndex], COMPOSITE_ENGINE_CYCLE);}
+      { BIT_SET(compositeStatus, COMPOSITE_ENGINE_CYCLE);}
       else
-      { BIT_CLEAR(compositeLogHistory[toothHistoryIndex], COMPOSITE_ENGINE_CYCLE);}
+      { BIT_CLEAR(compositeStatus, COMPOSITE_ENGINE_CYCLE);}
+      compositeLogHistory[buffer][toothHistoryIndex] = compositeStatus;
 
-      toothHistory[toothHistoryIndex] = micros();
+      //Each buffer holds the time of its first entry, with the remaining entries stored as the time since the previous one
+      uint32_t logTime = micros();
+      if(toothHistoryIndex == 0U) 
+      { 
+        compositeLogStartTime[buffer] = logTime;
+        toothHistory[buffer][0] = 0;
+      }
+      else { toothHistory[buffer][toothHistoryIndex] = encodeToothLogTime(logTime - compositeLogLastTime); }
+      compositeLogLastTime = logTime;
       valueLogged = true;
     }
 
     //If there has been a value logged above, update the indexes
     if(valueLogged == true)
     {
-     if(toothHistoryIndex < (TOOTH_LOG_SIZE-1)) { toothHistoryIndex++; BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY); }
-     else { BIT_SET(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY); }
+      toothHistoryIndex++;
+      if(toothHistoryIndex >= TOOTH_LOG_SIZE)
+      {
+        toothHistoryIndex = 0;
+        if(BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY)) 
+        { 
+          //The other buffer has not been sent yet. Start this one again, leaving a gap in the log
+          if(toothLogOverflows < UINT8_MAX) { toothLogOverflows++; }
+        }
+        else 
+        { 
+          toothHistoryBuffer = buffer ^ 1U;
+          BIT_SET(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY); 
+        }
+      }
     }
 
 
@@ -478,6 +510,23 @@ static inline void checkPerToothTiming(int16_t crankAngle, uint16_t currentTooth
 #endif
   }
 }
+
+/**
+On decoders that support crank angle synchronous MAP sampling (BIT_DECODER_MAP_SYNC), this passes the angle of the current tooth on to the MAP sampler.
+The angle is brought into the same 0 - CRANK_ANGLE_MAX_IGN range that the ignition channels use. When running sequential from a crank speed wheel, the 2nd revolution is offset by 360 degrees.
+*/
+static inline void checkMAPSyncTooth(int16_t crankAngle)
+{
+#if defined(MAP_SYNC_AVAILABLE)
+  if( (configPage15.mapSyncEnable == true) && HasAnySync(currentStatus) )
+  {
+    if( (CRANK_ANGLE_MAX_IGN == 720) && (revolutionOne == true) && (configPage4.TrigSpeed == CRANK_SPEED) ) { crankAngle += 360; }
+    mapSyncTooth(ignitionLimits(crankAngle));
+  }
+#else
+  (void)crankAngle; //Boards without MAP_SYNC_AVAILABLE would have to do a blocking analogRead() from the trigger interrupt
+#endif
+}
 /** @} */
   
 /** A (single) multi-tooth wheel with one of more 'missing' teeth.
@@ -507,6 +556,7 @@ void triggerSetup_missingTooth(void)
     triggerSecFilterTime = (MICROS_PER_SEC / (MAX_RPM / 60U));
   }
   BIT_CLEAR(decoderState, BIT_DECODER_2ND_DERIV);
+  BIT_SET(decoderState, BIT_DECODER_MAP_SYNC);
   checkSyncToothCount = (configPage4.triggerTeeth) >> 1; //50% of the total teeth.
   toothLastMinusOneToothTime = 0;
   toothCurrentCount = 0;
@@ -639,6 +689,8 @@ void triggerPri_missingTooth(void)
         }
         else{ crankAngle = ignitionLimits(crankAngle); checkPerToothTiming(crankAngle, toothCurrentCount); }
       }
+
+      checkMAPSyncTooth( ( (toothCurrentCount-1) * triggerToothAngle ) + configPage4.triggerAngle );
    }
 }
 
@@ -866,6 +918,7 @@ void triggerSetup_DualWheel(void)
   triggerFilterTime = (MICROS_PER_SEC / (MAX_RPM / 60U * configPage4.triggerTeeth)); //Trigger filter time is the shortest possible time (in uS) that there can be between crank teeth (ie at max RPM). Any pulses that occur faster than this time will be discarded as noise
   triggerSecFilterTime = (MICROS_PER_SEC / (MAX_RPM / 60U * 2U)) / 2U; //Same as above, but fixed at 2 teeth on the secondary input and divided by 2 (for cam speed)
   BIT_CLEAR(decoderState, BIT_DECODER_2ND_DERIV);
+  BIT_SET(decoderState, BIT_DECODER_MAP_SYNC);
   BIT_SET(decoderState, BIT_DECODER_IS_SEQUENTIAL);
   BIT_SET(decoderState, BIT_DECODER_TOOTH_ANG_CORRECT); //This is always true for this pattern
   BIT_SET(decoderState, BIT_DECODER_HAS_SECONDARY);
@@ -916,6 +969,8 @@ void triggerPri_DualWheel(void)
         }
         else{ checkPerToothTiming(crankAngle, toothCurrentCount); }
       }
+
+      checkMAPSyncTooth( ( (toothCurrentCount-1) * triggerToothAngle ) + configPage4.triggerAngle );
    } //Trigger filter
 }
 /** Dual Wheel Secondary.
@@ -5279,6 +5334,7 @@ void triggerPri_RoverMEMS()
             toothAngles[SKIP_TOOTH4] = 30;
             toothAngles[ID_TOOTH_PATTERN] = 5;
             configPage4.triggerMissingTeeth = 4; // this could be read in from the config file, but people could adjust it.
+            invalidatePageCRC(ignSetPage);
             triggerActualTeeth = 36; // should be 32 if not hacking toothcounter 
           }  
           triggerRoverMEMSCommon();                         
@@ -5294,6 +5350,7 @@ void triggerPri_RoverMEMS()
             toothAngles[SKIP_TOOTH4] = 27;
             toothAngles[ID_TOOTH_PATTERN] = 4;
             configPage4.triggerMissingTeeth = 4; // this could be read in from the config file, but people could adjust it.
+            invalidatePageCRC(ignSetPage);
             triggerActualTeeth = 36; // should be 32 if not hacking toothcounter 
           }  
           triggerRoverMEMSCommon();                         
@@ -5309,6 +5366,7 @@ void triggerPri_RoverMEMS()
             toothAngles[SKIP_TOOTH4] = 27;
             toothAngles[ID_TOOTH_PATTERN] = 3;
             configPage4.triggerMissingTeeth = 4; // this could be read in from the config file, but people could adjust it.
+            invalidatePageCRC(ignSetPage);
             triggerActualTeeth = 36; // should be 32 if not hacking toothcounter 
           } 
           triggerRoverMEMSCommon();                           
@@ -5324,6 +5382,7 @@ void triggerPri_RoverMEMS()
             toothAngles[SKIP_TOOTH4] = 29;
             toothAngles[ID_TOOTH_PATTERN] = 2;
             configPage4.triggerMissingTeeth = 4; // this could be read in from the config file, but people could adjust it.
+            invalidatePageCRC(ignSetPage);
             triggerActualTeeth = 36; // should be 32 if not hacking toothcounter 
           }  
           triggerRoverMEMSCommon();  
@@ -5337,6 +5396,7 @@ void triggerPri_RoverMEMS()
             toothAngles[SKIP_TOOTH2] = 18;
             toothAngles[ID_TOOTH_PATTERN] = 1;
             configPage4.triggerMissingTeeth = 2; // this should be read in from the config file, but people could adjust it.            
+            invalidatePageCRC(ignSetPage);
             triggerActualTeeth = 36; // should be 34 if not hacking toothcounter 
           }
           triggerRoverMEMSCommon(); 
@@ -18,6 +18,8 @@
 #define ERR_BAT_LOW     11 //Battery voltage is too low
 #define ERR_MAP_HIGH    12 //MAP output is too high
 #define ERR_MAP_LOW     13 //MAP output is too low
+#define ERR_CONFIG_CRC  14 //A config page did not match the CRC stored when it was last burnt
+#define ERR_CONFIG_JOURNAL 15 //The config journal could not be read. The tune in use is the EEPROM copy, which is out of date, and nothing can be burnt
 
 #define ERR_DEFAULT_IAT_SHORT   80 //Note that the default is 40C. 80 is used due to the -40 offset
 #define ERR_DEFAULT_IAT_GND     80 //Note that the default is 40C. 80 is used due to the -40 offset
@@ -0,0 +1,225 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Long term fuel trim learning. See fuelLearn.h
+ */
+#include "fuelLearn.h"
+#include "storage.h"
+#include "pages.h"
+#include "page_crc.h"
+#include "maths.h"
+#include "tuneBanks.h"
+
+int8_t fuelLearnTrim[FUEL_LEARN_CELLS];
+
+static uint8_t fuelLearnDirty[FUEL_LEARN_CELLS / 8U]; //Bitfield of the trim cells that have changed since they were last written to the EEPROM
+static uint8_t fuelLearnCell = 0; //The trim cell covering the fuel cell nearest to the current operating point
+static uint8_t fuelLearnWeight = 0; //How close (0-255) the operating point is to the centre of that fuel cell
+static int16_t fuelLearnAccumulator = 0; //Weighted closed loop error accumulated against the current cell
+static table3d_axis_t fuelLearnLastX = INT16_MAX; //The fuel table lookup that the current cell was found for
+static table3d_axis_t fuelLearnLastY = INT16_MAX;
+
+static inline int8_t clampFuelLearnTrim(int16_t trim)
+{
+  int16_t maxTrim = configPage15.fuelLearnMaxTrim;
+  if(trim > maxTrim) { trim = maxTrim; }
+  else if(trim < -maxTrim) { trim = -maxTrim; }
+  return (int8_t)trim;
+}
+
+/** Loads the learnt trims from the EEPROM.
+ */
+void initialiseFuelLearn(void)
+{
+  for(uint8_t cell = 0; cell < FUEL_LEARN_CELLS; cell++)
+  {
+    //Clamp on load in case the max trim setting has been reduced since the trims were learnt
+    fuelLearnTrim[cell] = clampFuelLearnTrim((int8_t)EEPROMReadRaw(EEPROM_FUEL_LEARN + cell));
+  }
+  for(uint8_t x = 0; x < sizeof(fuelLearnDirty); x++) { fuelLearnDirty[x] = 0; }
+  fuelLearnAccumulator = 0;
+  fuelLearnLastX = INT16_MAX;
+  fuelLearnLastY = INT16_MAX;
+}
+
+/*
+Finds the axis index of whichever side of the current bin the value is closest to
+Also returns how close (128-255) the value is to that axis value, where 128 is midway between the 2 axis values
+*/
+static inline uint8_t nearestAxisIndex(table3d_axis_t value, table3d_dim_t binMax, const table3d_axis_t *pAxis, uint8_t *pWeight)
+{
+  //As in get3DTableValue(), the bin covers the axis values at binMax+1 (Min) and binMax (Max)
+  int32_t binMaxValue = pAxis[binMax];
+  int32_t binMinValue = pAxis[binMax + 1U];
+  int32_t clampedValue = value;
+  if(clampedValue > binMaxValue) { clampedValue = binMaxValue; }
+  else if(clampedValue < binMinValue) { clampedValue = binMinValue; }
+
+  uint8_t index = binMax;
+  int32_t distanceFromMid = (2 * clampedValue) - (binMaxValue + binMinValue);
+  if(distanceFromMid < 0)
+  {
+    index = binMax + 1U;
+    distanceFromMid = -distanceFromMid;
+  }
+
+  int32_t binWidth = binMaxValue - binMinValue;
+  if(binWidth > 0) { *pWeight = 128U + (uint8_t)((distanceFromMid * 127) / binWidth); }
+  else { *pWeight = 255U; }
+  return index;
+}
+
+/*
+Find the trim cell for the most recent fuel table lookup. This uses the bins that get3DTableValue() has already found and cached for that lookup
+*/
+static inline void updateFuelLearnCell(void)
+{
+  const table3DGetValueCache &cache = fuelTable.get_value_cache;
+  if( (cache.last_lookup.x == fuelLearnLastX) && (cache.last_lookup.y == fuelLearnLastY) ) { return; } //Same lookup as last time
+
+  fuelLearnLastX = cache.last_lookup.x;
+  fuelLearnLastY = cache.last_lookup.y;
+
+  const table3d_dim_t axisSize = decltype(fuelTable)::value_t::row_size;
+  uint8_t xWeight;
+  uint8_t yWeight;
+  uint8_t xIndex = nearestAxisIndex(fuelLearnLastX, cache.lastXBinMax, fuelTable.axisX.axis, &xWeight);
+  uint8_t row = nearestAxisIndex(fuelLearnLastY, cache.lastYBinMax, fuelTable.axisY.axis, &yWeight);
+  uint8_t col = axisSize - xIndex - 1U; //Same conversion from X axis index to column as get3DTableValue()
+
+  uint8_t newCell = ((row >> FUEL_LEARN_CELL_SHIFT) * FUEL_LEARN_SIZE) + (col >> FUEL_LEARN_CELL_SHIFT);
+  if(newCell != fuelLearnCell)
+  {
+    fuelLearnCell = newCell;
+    fuelLearnAccumulator = 0; //Any error accumulated so far belongs to the previous cell
+  }
+  fuelLearnWeight = ((uint16_t)xWeight * yWeight) >> 8;
+}
+
+/** Applies the learnt trim for the current operating point to the VE.
+ * Must be called immediately after the VE has been looked up from the fuel table.
+ * @param VE The VE from the fuel table
+ * @return byte The trimmed VE
+ */
+byte applyFuelLearn(byte VE)
+{
+  if( (configPage15.fuelLearnEnable == 0) || (activeTuneBank != 0U) ) { return VE; } //Trims are only learnt against the bank 0 fuel table
+
+  updateFuelLearnCell();
+  int8_t trim = fuelLearnTrim[fuelLearnCell];
+  if(trim != 0)
+  {
+    uint16_t trimmedVE = div100((uint16_t)((uint16_t)VE * (uint16_t)(100 + trim)));
+    if(trimmedVE > UINT8_MAX) { trimmedVE = UINT8_MAX; }
+    VE = (byte)trimmedVE;
+  }
+  return VE;
+}
+
+/** Learns the closed loop correction into the trim cell for the current operating point.
+ * Should be called at 10Hz. Learning only takes place while the closed loop correction is active and the engine is in a steady state.
+ */
+void fuelLearnControl(void)
+{
+  if( (configPage15.fuelLearnEnable == 0) || (configPage6.egoType == 0) || (configPage6.egoAlgorithm == EGO_ALGORITHM_NONE) || (activeTuneBank != 0U) ) { return; }
+
+  if( (currentStatus.runSecs > configPage6.ego_sdelay)
+   && (currentStatus.coolant > (int)(configPage6.egoTemp - CALIBRATION_TEMPERATURE_OFFSET))
+   && !BIT_CHECK(currentStatus.status1, BIT_STATUS1_DFCO)
+   && !BIT_CHECK(currentStatus.engine, BIT_ENGINE_CRANK)
+   && !BIT_CHECK(currentStatus.engine, BIT_ENGINE_ACC)
+   && !BIT_CHECK(currentStatus.engine, BIT_ENGINE_DCC) )
+  {
+    int16_t error = (int16_t)currentStatus.egoCorrection - 100;
+    fuelLearnAccumulator += (error * fuelLearnWeight) >> 8;
+
+    int16_t threshold = configPage15.fuelLearnThreshold;
+    if(threshold == 0) { threshold = 1; }
+    int16_t trim = fuelLearnTrim[fuelLearnCell];
+    if(fuelLearnAccumulator >= threshold)
+    {
+      fuelLearnAccumulator -= threshold;
+      trim++;
+    }
+    else if(fuelLearnAccumulator <= -threshold)
+    {
+      fuelLearnAccumulator += threshold;
+      trim--;
+    }
+    else { return; }
+
+    trim = clampFuelLearnTrim(trim);
+    if(trim != fuelLearnTrim[fuelLearnCell])
+    {
+      fuelLearnTrim[fuelLearnCell] = (int8_t)trim;
+      BIT_SET(fuelLearnDirty[fuelLearnCell >> 3], fuelLearnCell & 7U);
+    }
+  }
+  else { fuelLearnAccumulator = 0; }
+}
+
+bool isFuelLearnWritePending(void)
+{
+  for(uint8_t x = 0; x < sizeof(fuelLearnDirty); x++)
+  {
+    if(fuelLearnDirty[x] != 0) { return true; }
+  }
+  return false;
+}
+
+/** Writes changed trim cells to the EEPROM.
+ * Only a single cell is written per call while the engine is running so that the EEPROM write time never holds up the main loop.
+ */
+void writeFuelLearn(void)
+{
+  uint8_t maxWrites = (currentStatus.RPM > 0) ? 1U : FUEL_LEARN_CELLS;
+  for(uint8_t cell = 0; (cell < FUEL_LEARN_CELLS) && (maxWrites > 0U); cell++)
+  {
+    if( BIT_CHECK(fuelLearnDirty[cell >> 3], cell & 7U) )
+    {
+      EEPROMWriteRaw(EEPROM_FUEL_LEARN + cell, (uint8_t)fuelLearnTrim[cell]);
+      BIT_CLEAR(fuelLearnDirty[cell >> 3], cell & 7U);
+      maxWrites--;
+    }
+  }
+}
+
+/** Sets all the learnt trims back to 0.
+ */
+void resetFuelLearn(void)
+{
+  for(uint8_t cell = 0; cell < FUEL_LEARN_CELLS; cell++) { fuelLearnTrim[cell] = 0; }
+  for(uint8_t x = 0; x < sizeof(fuelLearnDirty); x++) { fuelLearnDirty[x] = 0xFF; }
+  fuelLearnAccumulator = 0;
+}
+
+/** Applies the learnt trims to the fuel table values, then resets the trims and burns the fuel table.
+ * The trims are only merged while bank 0 is active, as that is the fuel table they were learnt against.
+ */
+void mergeFuelLearn(void)
+{
+  if(activeTuneBank != 0U) { return; }
+
+  const table3d_dim_t axisSize = decltype(fuelTable)::value_t::row_size;
+  for(uint8_t row = 0; row < axisSize; row++)
+  {
+    for(uint8_t col = 0; col < axisSize; col++)
+    {
+      int8_t trim = fuelLearnTrim[((row >> FUEL_LEARN_CELL_SHIFT) * FUEL_LEARN_SIZE) + (col >> FUEL_LEARN_CELL_SHIFT)];
+      if(trim != 0)
+      {
+        table3d_value_t &value = fuelTable.values.values[((uint16_t)row * axisSize) + col];
+        uint16_t trimmedValue = div100((uint16_t)((uint16_t)value * (uint16_t)(100 + trim)));
+        if(trimmedValue > UINT8_MAX) { trimmedValue = UINT8_MAX; }
+        value = (table3d_value_t)trimmedValue;
+      }
+    }
+  }
+  invalidate_cache(&fuelTable.get_value_cache);
+  resetFuelLearn();
+  invalidatePageCRC(veMapPage);
+  writeConfig(veMapPage);
+}
@@ -0,0 +1,29 @@
+#ifndef FUELLEARN_H
+#define FUELLEARN_H
+
+#include "globals.h"
+
+/** @file
+ * Long term fuel trim learning.
+ *
+ * The closed loop correction (See correctionAFRClosedLoop()) is learnt into a trim overlay on top of the primary fuel (VE) table.
+ * The overlay is 8x8, with each trim cell covering 2x2 cells of the 16x16 fuel table. The trims are applied to the VE in getVE1().
+ * Learning only ever updates the trim cell that covers the fuel table cell nearest to the current operating point, weighted by how close the operating point is to that fuel cell.
+ * Learnt trims are held in RAM and written to their own area of the EEPROM when there is spare time to do so. They can be merged into the fuel table from a TunerStudio command button.
+ */
+
+#define FUEL_LEARN_SIZE       8 //Number of trim cells on each axis of the overlay
+#define FUEL_LEARN_CELLS      (FUEL_LEARN_SIZE * FUEL_LEARN_SIZE)
+#define FUEL_LEARN_CELL_SHIFT 1 //Fuel table cells are shifted by this to get the trim cell that covers them (16x16 -> 8x8)
+
+extern int8_t fuelLearnTrim[FUEL_LEARN_CELLS]; /**< Learnt trim (%) for each cell of the overlay */
+
+void initialiseFuelLearn(void);
+byte applyFuelLearn(byte VE);
+void fuelLearnControl(void);
+bool isFuelLearnWritePending(void);
+void writeFuelLearn(void);
+void mergeFuelLearn(void);
+void resetFuelLearn(void);
+
+#endif // FUELLEARN_H
@@ -50,6 +50,8 @@ struct table2D flexBoostTable; ///< 6 bin flex fuel correction table for boost a
 struct table2D fuelTempTable;  ///< 6 bin flex fuel correction table for fuel adjustments (2D)
 struct table2D knockWindowStartTable;
 struct table2D knockWindowDurationTable;
+struct table2D wallWetXTable;   ///< 6 bin wall wetting fraction (X) by coolant temperature (2D)
+struct table2D wallWetTauTable; ///< 6 bin wall wetting time constant (Tau) by coolant temperature (2D)
 struct table2D oilPressureProtectTable;
 struct table2D wmiAdvTable; //6 bin wmi correction table for timing advance (2D)
 struct table2D coolantProtectTable;
@@ -117,8 +119,11 @@ volatile unsigned long ms_counter = 0; //A counter that increments once per ms
 uint16_t fixedCrankingOverride = 0;
 bool clutchTrigger;
 bool previousClutchTrigger;
-volatile uint32_t toothHistory[TOOTH_LOG_SIZE]; ///< Tooth trigger history - delta time (in uS) from last tooth (Indexed by @ref toothHistoryIndex)
-volatile uint8_t compositeLogHistory[TOOTH_LOG_SIZE]; 
+volatile uint16_t toothHistory[TOOTH_LOG_BUFFERS][TOOTH_LOG_SIZE]; ///< Tooth trigger history - delta time from last tooth, encoded with encodeToothLogTime() (Indexed by @ref toothHistoryBuffer and @ref toothHistoryIndex)
+volatile uint8_t compositeLogHistory[TOOTH_LOG_BUFFERS][TOOTH_LOG_SIZE]; 
+volatile uint32_t compositeLogStartTime[TOOTH_LOG_BUFFERS]; ///< Time (uS) of the first entry in each composite log buffer. The entries hold the delta from the previous entry
+volatile uint8_t toothHistoryBuffer = 0; ///< The tooth log buffer currently being filled. The other buffer is the one sent to the tuning software
+volatile uint8_t toothLogOverflows = 0; ///< The number of times a tooth log buffer filled before the previous one had been sent (Ie the number of gaps in the log)
 volatile bool fpPrimed = false; ///< Tracks whether or not the fuel pump priming has been completed yet
 volatile bool injPrimed = false; ///< Tracks whether or not the injectors priming has been completed yet
 volatile unsigned int toothHistoryIndex = 0; ///< Current index to @ref toothHistory array
@@ -192,6 +197,8 @@ byte pinIdleUp;   //Input for triggering Idle Up
 byte pinIdleUpOutput; //Output that follows (normal or inverted) the idle up pin
 byte pinCTPS;     //Input for triggering closed throttle state
 byte pinFuel2Input;  //Input for switching to the 2nd fuel table
+byte pinTuneBank1;  //Inputs for selecting the tune bank
+byte pinTuneBank2;
 byte pinSpark2Input; //Input for switching to the 2nd ignition table
 byte pinSpareTemp1;  // Future use only
 byte pinSpareTemp2;  // Future use only
@@ -219,6 +226,7 @@ byte pinLaunch;
 byte pinIgnBypass; //The pin used for an ignition bypass (Optional)
 byte pinFlex; //Pin with the flex sensor attached
 byte pinVSS;  // VSS (Vehicle speed sensor) Pin
+byte pinKnock; //Pin for either the digital knock pulses or the analog knock level
 byte pinBaro; //Pin that an al barometric pressure sensor is attached to (If used)
 byte pinResetControl; // Output pin used control resetting the Arduino
 byte pinFuelPressure;
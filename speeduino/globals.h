@@ -212,6 +212,7 @@
 #else
 #define TOOTH_LOG_SIZE      1
 #endif
+#define TOOTH_LOG_BUFFERS   2 //The tooth/composite log is double buffered. The trigger interrupts fill one buffer while the other is sent
 
 #define O2_CALIBRATION_PAGE   2U
 #define IAT_CALIBRATION_PAGE  1U
@@ -278,6 +279,7 @@
 
 #define EGO_ALGORITHM_SIMPLE  0
 #define EGO_ALGORITHM_PID     2
+#define EGO_ALGORITHM_NONE    3
 
 #define STAGING_MODE_TABLE  0
 #define STAGING_MODE_AUTO   1
@@ -295,6 +297,7 @@
 
 #define AE_MODE_TPS         0
 #define AE_MODE_MAP         1
+#define AE_MODE_XTAU        2 ///< Wall wetting (X-Tau) model instead of threshold based AE. See transientFuel.h
 
 #define AE_MODE_MULTIPLIER  0
 #define AE_MODE_ADDER       1
@@ -457,6 +460,8 @@ extern struct table2D flexBoostTable; //6 bin flex fuel correction table for boo
 extern struct table2D fuelTempTable;  //6 bin fuel temperature correction table for fuel adjustments (2D)
 extern struct table2D knockWindowStartTable;
 extern struct table2D knockWindowDurationTable;
+extern struct table2D wallWetXTable;   //6 bin wall wetting fraction (X) by coolant temperature (2D)
+extern struct table2D wallWetTauTable; //6 bin wall wetting time constant (Tau) by coolant temperature (2D)
 extern struct table2D oilPressureProtectTable;
 extern struct table2D wmiAdvTable; //6 bin wmi correction table for timing advance (2D)
 extern struct table2D coolantProtectTable; //6 bin coolant temperature protection table for engine protection (2D)
@@ -525,9 +530,12 @@ extern unsigned long revolutionTime; //The time in uS that one revolution would
 extern volatile unsigned long timer5_overflow_count; //Increments every time counter 5 overflows. Used for the fast version of micros()
 extern volatile unsigned long ms_counter; //A counter that increments once per ms
 extern uint16_t fixedCrankingOverride;
-extern volatile uint32_t toothHistory[TOOTH_LOG_SIZE];
-extern volatile uint8_t compositeLogHistory[TOOTH_LOG_SIZE];
+extern volatile uint16_t toothHistory[TOOTH_LOG_BUFFERS][TOOTH_LOG_SIZE];
+extern volatile uint8_t compositeLogHistory[TOOTH_LOG_BUFFERS][TOOTH_LOG_SIZE];
+extern volatile uint32_t compositeLogStartTime[TOOTH_LOG_BUFFERS];
 extern volatile unsigned int toothHistoryIndex;
+extern volatile uint8_t toothHistoryBuffer;
+extern volatile uint8_t toothLogOverflows;
 extern unsigned long currentLoopTime; /**< The time (in uS) that the current mainloop started */
 extern volatile uint16_t ignitionCount; /**< The count of ignition events that have taken place since the engine started */
 //The below shouldn't be needed and probably should be cleaned up, but the Atmel SAM (ARM) boards use a specific type for the trigger edge values rather than a simple byte/int
@@ -712,7 +720,7 @@ struct config2 {
   byte aseTaperTime;
   byte aeColdPct;  //AE cold clt modifier %
   byte aeColdTaperMin; //AE cold modifier, taper start temp (full modifier, was ASE in early versions)
-  byte aeMode : 2;      /**< Acceleration Enrichment mode. 0 = TPS, 1 = MAP. Values 2 and 3 reserved for potential future use (ie blended TPS / MAP) */
+  byte aeMode : 2;      /**< Acceleration Enrichment mode. 0 = TPS, 1 = MAP, 2 = Wall wetting (X-Tau) model. Value 3 reserved for potential future use (ie blended TPS / MAP) */
   byte battVCorMode : 1;
   byte SoftLimitMode : 1;
   byte useTachoSweep : 1;
@@ -1365,7 +1373,12 @@ struct config13 {
 
   uint16_t candID[8]; ///< Actual CAN ID need 16bits, this is a placeholder
 
-  byte unused12_106_116[10];
+  byte onboard_log_capture_trigger :3; // "Disabled", "Engine protect", "Sync loss", "Knock", "Programmable output"
+  byte onboard_log_capture_output  :3; // Programmable output number (0-7) when the trigger is a programmable output
+  byte onboard_log_capture_rate    :2; // "20Hz", "50Hz", "100Hz", "200Hz"
+  byte onboard_log_capture_pre;        // Time captured before the trigger (0.1s)
+  byte onboard_log_capture_post;       // Time captured after the trigger (0.1s)
+  byte unused12_109_116[7];
 
   byte onboard_log_csv_separator :2;  //";", ",", "tab", "space"  
   byte onboard_log_file_style    :2;  // "Disabled", "CSV", "Binary", "INVALID" 
@@ -1439,8 +1452,46 @@ struct config15 {
   int8_t rollingProtRPMDelta[4]; // Signed RPM value representing how much below the RPM limit. Divided by 10
   byte rollingProtCutPercent[4];
   
-  //Bytes 106-255
-  byte Unused15_106_255[150];
+  //Byte 106 - Crank angle synchronous MAP sampling
+  byte mapSyncEnable : 1;   ///< Sample MAP at fixed crank angles from the trigger decoder instead of using @ref config2.mapSample (Only on decoders that set BIT_DECODER_MAP_SYNC)
+  byte mapSyncSamples : 2;  ///< Number of MAP samples taken per cylinder, minus 1 (0-3 = 1-4 samples)
+  byte mapSyncUnused : 5;
+  uint16_t mapSyncAngle;    ///< Angle (ATDC of each cylinders firing TDC) that the first MAP sample of each cylinder is taken at. Bytes 107-108
+  byte mapSyncSpacing;      ///< Crank degrees between each of the MAP samples for a cylinder. Byte 109
+
+  //Bytes 110-111 - Analog filter types. One of the ADCFILTER_TYPE_* values, applied before the ADCFILTER_* IIR filters in configPage4
+  byte adcFilterTypeTPS : 2;
+  byte adcFilterTypeCLT : 2;
+  byte adcFilterTypeIAT : 2;
+  byte adcFilterTypeO2 : 2;
+  byte adcFilterTypeBat : 2;
+  byte adcFilterTypeMAP : 2; ///< Also used for EMAP
+  byte adcFilterTypeBaro : 2;
+  byte adcFilterTypeUnused : 2;
+
+  //Bytes 112-114 - Long term fuel trim learning (See fuelLearn.h)
+  byte fuelLearnEnable : 1;
+  byte fuelLearnUnused : 7;
+  byte fuelLearnMaxTrim;    ///< Maximum learnt trim (+/- %) of any cell
+  byte fuelLearnThreshold;  ///< Accumulated closed loop error (% x 0.1s) needed to move a trim cell by 1%
+
+  //Bytes 115-132 - Wall wetting (X-Tau) transient fuel curves. Both curves share the same coolant bins
+  byte wallWetBins[6];      ///< Coolant temperature bins (+40 offset)
+  byte wallWetX[6];         ///< Fraction (%) of the injected fuel that goes into the wall film
+  byte wallWetTau[6];       ///< Time constant (10ms) for the wall film to evaporate
+
+  //Bytes 133-135 - Tune bank selection (See tuneBanks.h)
+  byte tuneBankMode : 2;      ///< How the bank is selected (TUNE_BANK_MODE_*)
+  byte tuneBankUnused : 2;
+  byte tuneBankCanInput : 4;  ///< CAN input (0-15) that holds the bank number when tuneBankMode is TUNE_BANK_MODE_CAN
+  byte tuneBankPin1 : 6;      ///< Input that adds 1 to the bank number when active
+  byte tuneBankPolarity : 1;  ///< Level (Both pins) that an input is active at
+  byte tuneBankPullup : 1;
+  byte tuneBankPin2 : 6;      ///< Input that adds 2 to the bank number when active
+  byte tuneBankUnused2 : 2;
+
+  //Bytes 136-255
+  byte Unused15_136_255[120];
 
 #if defined(CORE_AVR)
   };
@@ -1487,6 +1538,8 @@ extern byte pinIdleUp; //Input for triggering Idle Up
 extern byte pinIdleUpOutput; //Output that follows (normal or inverted) the idle up pin
 extern byte pinCTPS; //Input for triggering closed throttle state
 extern byte pinFuel2Input; //Input for switching to the 2nd fuel table
+extern byte pinTuneBank1; //Inputs for selecting the tune bank
+extern byte pinTuneBank2;
 extern byte pinSpark2Input; //Input for switching to the 2nd ignition table
 extern byte pinSpareTemp1; // Future use only
 extern byte pinSpareTemp2; // Future use only
@@ -1514,6 +1567,7 @@ extern byte pinLaunch;
 extern byte pinIgnBypass; //The pin used for an ignition bypass (Optional)
 extern byte pinFlex; //Pin with the flex sensor attached
 extern byte pinVSS; 
+extern byte pinKnock; //Pin for either the digital knock pulses or the analog knock level
 extern byte pinBaro; //Pin that an external barometric pressure sensor is attached to (If used)
 extern byte pinResetControl; // Output pin used control resetting the Arduino
 extern byte pinFuelPressure;
@@ -6,6 +6,8 @@ A full copy of the license may be found in the projects root directory
 #include "idle.h"
 #include "maths.h"
 #include "timers.h"
+#include "pages.h"
+#include "page_crc.h"
 #include "src/PID_v1/PID_v1.h"
 
 #define STEPPER_LESS_AIR_DIRECTION() ((configPage9.iacStepperInv == 0) ? STEPPER_BACKWARD : STEPPER_FORWARD)
@@ -71,6 +73,7 @@ static inline void enableIdle(void)
 
 void initialiseIdle(bool forcehoming)
 {
+  invalidatePageCRC(afrSetPage); //iacPWMrun may be changed below
   //By default, turn off the PWM interrupt (It gets turned on below if needed)
   IDLE_TIMER_DISABLE();
 
@@ -17,8 +17,14 @@
 #include "sensors.h"
 #include "decoders.h"
 #include "corrections.h"
+#include "knock.h"
+#include "fuelLearn.h"
+#include "transientFuel.h"
+#include "tuneBanks.h"
 #include "idle.h"
 #include "table2d.h"
+#include "pages.h"
+#include "page_crc.h"
 #include "acc_mc33810.h"
 #include BOARD_H //Note that this is not a real file, it is defined in globals.h. 
 #if defined(EEPROM_RESET_PIN)
@@ -29,17 +35,19 @@
   #include "rtc_common.h"
 #endif
 
+uint32_t bootPhaseTimes[BOOT_PHASE_COUNT];
+
 /** Initialise Speeduino for the main loop.
  * Top level init entry point for all initialisations:
  * - Initialise and set sizes of 3D tables
  * - Load config from EEPROM, update config structures to current version of SW if needed.
+ * - Check the loaded config pages against their stored CRCs
  * - Initialise board (The initBoard() is for board X implemented in board_X.ino file)
  * - Initialise timers (See timers.ino)
- * - Perform optional SD card and RTC battery inits
  * - Load calibration tables from EEPROM
  * - Perform pin mapping (calling @ref setPinMapping() based on @ref config2.pinMapping)
  * - Stop any coil charging and close injectors
- * - Initialise schedulers, Idle, Fan, auxPWM, Corrections, AD-conversions, Programmable I/O
+ * - Initialise schedulers, Fan, Corrections, AD-conversions, Programmable I/O
  * - Initialise baro (ambient pressure) by reading MAP (before engine runs)
  * - Initialise triggers (by @ref initialiseTriggers() )
  * - Perform cyl. count based initialisations (@ref config2.nCylinders)
@@ -47,10 +55,12 @@
  *   - Assign injector open/close and coil charge begin/end functions to their dedicated global vars
  * - Perform fuel pressure priming by turning fuel pump on
  * - Read CLT and TPS sensors to have cranking pulsewidths computed correctly
+ * - Perform the init that isn't needed to start the engine (CAN, secondary serial, SD card and RTC, Idle and auxPWM). This is done after the triggers are enabled so that it doesn't delay the first spark
  * - Mark Initialisation completed (this flag-marking is used in code to prevent after-init changes)
  */
 void initialiseAll(void)
 {   
+    bootPhaseTimes[BOOT_PHASE_START] = micros();
     currentStatus.fpPrimed = false;
     currentStatus.injPrimed = false;
 
@@ -102,7 +112,9 @@ void initialiseAll(void)
 #if !defined(UNIT_TEST)
     loadConfig();
     doUpdates(); //Check if any data items need updating (Occurs with firmware updates)
+    verifyConfigCRCs();
 #endif
+    bootPhaseTimes[BOOT_PHASE_CONFIG] = micros();
 
 
     //Always start with a clean slate on the bootloader capabilities level
@@ -111,11 +123,6 @@ void initialiseAll(void)
     
     initBoard(); //This calls the current individual boards init function. See the board_xxx.ino files for these.
     initialiseTimers();
-    
-  #ifdef SD_LOGGING
-    initRTC();
-    initSD();
-  #endif
 
     Serial.begin(115200);
     BIT_SET(currentStatus.status4, BIT_STATUS4_ALLOW_LEGACY_COMMS); //Flag legacy comms as being allowed on startup
@@ -240,6 +247,17 @@ void initialiseAll(void)
     knockWindowDurationTable.values = configPage10.knock_window_dur;
     knockWindowDurationTable.axisX = configPage10.knock_window_rpms;
 
+    wallWetXTable.valueSize = SIZE_BYTE;
+    wallWetXTable.axisSize = SIZE_BYTE; //Set this table to use byte axis bins
+    wallWetXTable.xSize = 6;
+    wallWetXTable.values = configPage15.wallWetX;
+    wallWetXTable.axisX = configPage15.wallWetBins;
+    wallWetTauTable.valueSize = SIZE_BYTE;
+    wallWetTauTable.axisSize = SIZE_BYTE; //Set this table to use byte axis bins
+    wallWetTauTable.xSize = 6;
+    wallWetTauTable.values = configPage15.wallWetTau;
+    wallWetTauTable.axisX = configPage15.wallWetBins;
+
     oilPressureProtectTable.valueSize = SIZE_BYTE;
     oilPressureProtectTable.axisSize = SIZE_BYTE; //Set this table to use byte axis bins
     oilPressureProtectTable.xSize = 4;
@@ -291,6 +309,8 @@ void initialiseAll(void)
     
     //Setup the calibration tables
     loadCalibration();
+    updateCalibrationLookups();
+    bootPhaseTimes[BOOT_PHASE_BOARD] = micros();
 
     
 
@@ -304,15 +324,6 @@ void initialiseAll(void)
     }
     else { setPinMapping(configPage2.pinMapping); }
 
-    #if defined(NATIVE_CAN_AVAILABLE)
-      initCAN();
-    #endif
-
-    //Must come after setPinMapping() as secondary serial can be changed on a per board basis
-    #if defined(secondarySerial_AVAILABLE)
-      if (configPage9.enable_secondarySerial == 1) { secondarySerial.begin(115200); }
-    #endif
-
     //End all coil charges to ensure no stray sparks on startup
     endCoil1Charge();
     endCoil2Charge();
@@ -350,11 +361,12 @@ void initialiseAll(void)
     //Perform all initialisations
     initialiseSchedulers();
     //initialiseDisplay();
-    initialiseIdle(true);
     initialiseFan();
     initialiseAirCon();
-    initialiseAuxPWM();
     initialiseCorrections();
+    initialiseKnock();
+    initialiseFuelLearn();
+    initialiseTransientFuel();
     BIT_CLEAR(currentStatus.engineProtectStatus, PROTECT_IO_ERROR); //Clear the I/O error bit. The bit will be set in initialiseADC() if there is problem in there.
     initialiseADC();
     initialiseProgrammableIO();
@@ -426,6 +438,7 @@ void initialiseAll(void)
     //Lookup the current MAP reading for barometric pressure
     instanteneousMAPReading();
     readBaro();
+    bootPhaseTimes[BOOT_PHASE_OUTPUTS] = micros();
     
     noInterrupts();
     initialiseTriggers();
@@ -1345,6 +1358,7 @@ void initialiseAll(void)
     else { currentStatus.fpPrimed = true; } //If the user has set 0 for the pump priming, immediately mark the priming as being completed
 
     interrupts();
+    bootPhaseTimes[BOOT_PHASE_TRIGGERS] = micros();
     readCLT(false); // Need to read coolant temp to make priming pulsewidth work correctly. The false here disables use of the filter
     readTPS(false); // Need to read tps to detect flood clear state
 
@@ -1353,7 +1367,29 @@ void initialiseAll(void)
     /* SweepMax is stored as a byte, RPM/100. divide by 60 to convert min to sec (net 5/3).  Multiply by ignition pulses per rev.
        tachoSweepIncr is also the number of tach pulses per second */
     tachoSweepIncr = configPage2.tachoSweepMaxRPM * maxIgnOutputs * 5 / 3;
-    
+
+    //The remaining init isn't needed to start the engine, so it is done after the triggers have been enabled. The decoder can gain sync while this runs
+    initialiseIdle(true);
+    initialiseAuxPWM();
+
+    #if defined(NATIVE_CAN_AVAILABLE)
+      initCAN();
+    #endif
+
+    //Must come after setPinMapping() as secondary serial can be changed on a per board basis
+    #if defined(secondarySerial_AVAILABLE)
+      if (configPage9.enable_secondarySerial == 1) { secondarySerial.begin(115200); }
+    #endif
+
+  #ifdef SD_LOGGING
+    initRTC();
+    initSD();
+  #endif
+
+    //Init changes several of the config pages directly (Eg bootloaderCaps, intcan_available and the trigger settings), so any CRCs that were cached while loading them are stale
+    invalidateAllPageCRCs();
+
+    bootPhaseTimes[BOOT_PHASE_COMPLETE] = micros();
     currentStatus.initialisationComplete = true;
     digitalWrite(LED_BUILTIN, HIGH);
 
@@ -2871,7 +2907,10 @@ void setPinMapping(byte boardID)
   if ( (configPage6.useEMAP != 0) && (configPage10.EMAPPin < BOARD_MAX_IO_PINS) ) { pinEMAP = pinTranslateAnalog(configPage10.EMAPPin); }
   if ( (configPage10.fuel2InputPin != 0) && (configPage10.fuel2InputPin < BOARD_MAX_IO_PINS) ) { pinFuel2Input = pinTranslate(configPage10.fuel2InputPin); }
   if ( (configPage10.spark2InputPin != 0) && (configPage10.spark2InputPin < BOARD_MAX_IO_PINS) ) { pinSpark2Input = pinTranslate(configPage10.spark2InputPin); }
+  if ( (configPage15.tuneBankPin1 != 0) && (configPage15.tuneBankPin1 < BOARD_MAX_IO_PINS) ) { pinTuneBank1 = pinTranslate(configPage15.tuneBankPin1); }
+  if ( (configPage15.tuneBankPin2 != 0) && (configPage15.tuneBankPin2 < BOARD_MAX_IO_PINS) ) { pinTuneBank2 = pinTranslate(configPage15.tuneBankPin2); }
   if ( (configPage2.vssPin != 0) && (configPage2.vssPin < BOARD_MAX_IO_PINS) ) { pinVSS = pinTranslate(configPage2.vssPin); }
+  if ( (configPage10.knock_mode != KNOCK_MODE_OFF) && (configPage10.knock_pin != 0) && (configPage10.knock_pin < BOARD_MAX_IO_PINS) ) { pinKnock = pinTranslate(configPage10.knock_pin); }
   if ( (configPage10.fuelPressureEnable) && (configPage10.fuelPressurePin < BOARD_MAX_IO_PINS) ) { pinFuelPressure = pinTranslateAnalog(configPage10.fuelPressurePin); }
   if ( (configPage10.oilPressureEnable) && (configPage10.oilPressurePin < BOARD_MAX_IO_PINS) ) { pinOilPressure = pinTranslateAnalog(configPage10.oilPressurePin); }
   
@@ -3087,6 +3126,16 @@ void setPinMapping(byte boardID)
     if (configPage10.spark2InputPullup == true) { pinMode(pinSpark2Input, INPUT_PULLUP); } //With pullup
     else { pinMode(pinSpark2Input, INPUT); } //Normal input
   }
+  if( (configPage15.tuneBankMode == TUNE_BANK_MODE_INPUT) && (configPage15.tuneBankPin1 != 0) && (!pinIsOutput(pinTuneBank1)) )
+  {
+    if (configPage15.tuneBankPullup == true) { pinMode(pinTuneBank1, INPUT_PULLUP); } //With pullup
+    else { pinMode(pinTuneBank1, INPUT); } //Normal input
+  }
+  if( (configPage15.tuneBankMode == TUNE_BANK_MODE_INPUT) && (configPage15.tuneBankPin2 != 0) && (!pinIsOutput(pinTuneBank2)) )
+  {
+    if (configPage15.tuneBankPullup == true) { pinMode(pinTuneBank2, INPUT_PULLUP); } //With pullup
+    else { pinMode(pinTuneBank2, INPUT); } //Normal input
+  }
   if( (configPage10.fuelPressureEnable > 0)  && (!pinIsOutput(pinFuelPressure)) )
   {
     pinMode(pinFuelPressure, INPUT);
@@ -3160,6 +3209,7 @@ void setPinMapping(byte boardID)
  */
 void initialiseTriggers(void)
 {
+  invalidatePageCRC(ignSetPage); //Some of the trigger setup functions override the trigger settings
   byte triggerInterrupt = 0; // By default, use the first interrupt
   byte triggerInterrupt2 = 1;
   byte triggerInterrupt3 = 2;
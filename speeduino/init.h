@@ -7,6 +7,17 @@ void setPinMapping(byte boardID);
 void changeHalfToFullSync(void);
 void changeFullToHalfSync(void);
 
+//The points during initialiseAll() that are timestamped. Used to profile the startup time
+#define BOOT_PHASE_START      0 //Start of initialiseAll()
+#define BOOT_PHASE_CONFIG     1 //Config pages loaded, updated and checked
+#define BOOT_PHASE_BOARD      2 //Board, timers, serial and calibration tables initialised
+#define BOOT_PHASE_OUTPUTS    3 //Pin mapping, outputs, schedulers and sensors initialised
+#define BOOT_PHASE_TRIGGERS   4 //Triggers attached and interrupts enabled. The engine can start from this point
+#define BOOT_PHASE_COMPLETE   5 //Non-critical initialisation (CAN, SD, idle and aux PWM) completed
+#define BOOT_PHASE_COUNT      6
+
+extern uint32_t bootPhaseTimes[BOOT_PHASE_COUNT]; /**< micros() value at each of the BOOT_PHASE_* points of the last startup */
+
 #define VSS_USES_RPM2() ((configPage2.vssMode > 1U) && (pinVSS == pinTrigger2) && !BIT_CHECK(decoderState, BIT_DECODER_HAS_SECONDARY)) // VSS is on the same pin as RPM2 and RPM2 is not used as part of the decoder
 #define FLEX_USES_RPM2() ((configPage2.flexEnabled > 0U) && (pinFlex == pinTrigger2) && !BIT_CHECK(decoderState, BIT_DECODER_HAS_SECONDARY)) // Same as above, but for Flex sensor
 
@@ -0,0 +1,175 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Per cylinder knock detection and retard. See knock.h
+ */
+#include "knock.h"
+#include "crankMaths.h"
+#include "table2d.h"
+#include "sensors.h"
+
+volatile uint8_t knockEventChannel = 0;
+volatile uint32_t knockEventTime = 0;
+volatile uint8_t knockWindowCount = 0;
+volatile uint8_t knockChannelsDetected = 0;
+uint8_t knockChannelRetard[IGN_CHANNELS];
+
+static volatile uint32_t knockWindowStart = 0; //Time (uS) after the ignition event that the knock window opens
+static volatile uint32_t knockWindowEnd = 0; //Time (uS) after the ignition event that the knock window closes
+static uint16_t knockThresholdADC = 0; //The analog knock threshold converted to ADC counts
+static uint8_t knockStepTimer[IGN_CHANNELS]; //Time (0.1s) since the last retard step on each channel
+static uint8_t knockRecoveryTimer[IGN_CHANNELS]; //Time (0.1s) since the last knock or recovery step on each channel
+static uint8_t knockRecovering = 0; //Bitfield of the channels that have started recovering (Ie knock_duration has passed since the last knock)
+static uint8_t knockTimerDivider = 0; //Calls of knockControl() since the 0.1s timers were last stepped
+
+void initialiseKnock(void)
+{
+  for(uint8_t x = 0; x < IGN_CHANNELS; x++)
+  {
+    knockChannelRetard[x] = 0;
+    knockStepTimer[x] = 0;
+    knockRecoveryTimer[x] = 0;
+  }
+  knockRecovering = 0;
+  knockTimerDivider = 0;
+  knockChannelsDetected = 0;
+  knockWindowCount = 0;
+  knockThresholdADC = ((uint16_t)configPage10.knock_threshold * 1023U) / 50U; //Threshold is in 0.1V
+  currentStatus.knockRetard = 0;
+  currentStatus.knockActive = false;
+
+  if( (configPage10.knock_mode == KNOCK_MODE_DIGITAL) && (pinKnock != 0) )
+  {
+    if(configPage10.knock_pullup == true) { pinMode(pinKnock, INPUT_PULLUP); }
+    else { pinMode(pinKnock, INPUT); }
+    if(configPage10.knock_trigger == 0) { attachInterrupt(digitalPinToInterrupt(pinKnock), knockPulse, RISING); } //Knock active when pin is HIGH
+    else { attachInterrupt(digitalPinToInterrupt(pinKnock), knockPulse, FALLING); }
+  }
+}
+
+/** Returns whether the current time is within the knock window of the most recent ignition event. Interrupts must be off when calling this */
+static inline bool inKnockWindow(void)
+{
+  uint32_t timeSinceEvent = micros() - knockEventTime;
+  return ( (timeSinceEvent >= knockWindowStart) && (timeSinceEvent <= knockWindowEnd) );
+}
+
+/*
+ * The interrupt function for pulses from a knock conditioner / controller
+ * Pulses are only counted if they fall within the window of the channel that most recently fired
+ */
+void knockPulse(void)
+{
+  if( inKnockWindow() )
+  {
+    if(knockWindowCount < UINT8_MAX) { knockWindowCount++; }
+    if(knockWindowCount >= configPage10.knock_count) { BIT_SET(knockChannelsDetected, knockEventChannel); }
+  }
+}
+
+/**
+ * Samples the analog knock input. Should be called at 1kHz
+ * The sample is only used if it is taken within the window of the channel that most recently fired
+ */
+void readKnock(void)
+{
+  if( (configPage10.knock_mode == KNOCK_MODE_ANALOG) && (pinKnock != 0) )
+  {
+    noInterrupts();
+    bool windowOpen = inKnockWindow();
+    uint8_t channel = knockEventChannel;
+    interrupts();
+
+    if(windowOpen == true)
+    {
+      uint16_t tempReading = readADC(pinKnock);
+      if(tempReading >= knockThresholdADC)
+      {
+        noInterrupts();
+        BIT_SET(knockChannelsDetected, channel);
+        interrupts();
+      }
+    }
+  }
+}
+
+/**
+ * Updates the knock window timing for the current RPM and advance, then steps the retard up or down on each channel depending on whether it has knocked.
+ * Must be called at KNOCK_CONTROL_RATE, as the step and recovery timers are counted in calls
+ */
+void knockControl(void)
+{
+  if( configPage10.knock_mode == KNOCK_MODE_OFF ) { return; }
+
+  //Knock windows are set in degrees ATDC, but are timed from the spark event
+  int16_t windowAngle = (int16_t)table2D_getValue(&knockWindowStartTable, currentStatus.RPMdiv100) - KNOCK_WINDOW_ANGLE_OFFSET + currentStatus.advance;
+  if(windowAngle < 0) { windowAngle = 0; }
+  uint32_t windowStart = angleToTimeMicroSecPerDegree(windowAngle);
+  uint32_t windowEnd = windowStart + angleToTimeMicroSecPerDegree(table2D_getValue(&knockWindowDurationTable, currentStatus.RPMdiv100));
+
+  noInterrupts();
+  knockWindowStart = windowStart;
+  knockWindowEnd = windowEnd;
+  uint8_t knockedChannels = knockChannelsDetected;
+  knockChannelsDetected = 0;
+  interrupts();
+
+  //Knock is ignored above the max MAP and RPM limits
+  if( (currentStatus.MAP > ((uint16_t)configPage10.knock_maxMAP * 2U)) || (currentStatus.RPMdiv100 > configPage10.knock_maxRPM) ) { knockedChannels = 0; }
+
+  //The step and recovery timers are in 0.1s
+  bool timerTick = false;
+  knockTimerDivider++;
+  if(knockTimerDivider >= (KNOCK_CONTROL_RATE / 10U))
+  {
+    knockTimerDivider = 0;
+    timerTick = true;
+  }
+  uint8_t maxRetard = 0;
+  for(uint8_t channel = 0; channel < maxIgnOutputs; channel++)
+  {
+    if(timerTick == true)
+    {
+      if(knockStepTimer[channel] < UINT8_MAX) { knockStepTimer[channel]++; }
+      if(knockRecoveryTimer[channel] < UINT8_MAX) { knockRecoveryTimer[channel]++; }
+    }
+
+    if( BIT_CHECK(knockedChannels, channel) )
+    {
+      if(knockChannelRetard[channel] == 0)
+      {
+        knockChannelRetard[channel] = configPage10.knock_firstStep;
+        knockStepTimer[channel] = 0;
+      }
+      else if(knockStepTimer[channel] >= configPage10.knock_stepTime)
+      {
+        knockChannelRetard[channel] += configPage10.knock_stepSize;
+        knockStepTimer[channel] = 0;
+      }
+      if(knockChannelRetard[channel] > configPage10.knock_maxRetard) { knockChannelRetard[channel] = configPage10.knock_maxRetard; }
+
+      knockRecoveryTimer[channel] = 0;
+      BIT_CLEAR(knockRecovering, channel);
+    }
+    else if(knockChannelRetard[channel] > 0)
+    {
+      //Recovery starts knock_duration after the last knock and then steps every knock_recoveryStepTime
+      uint8_t recoveryDelay = BIT_CHECK(knockRecovering, channel) ? configPage10.knock_recoveryStepTime : configPage10.knock_duration;
+      if(knockRecoveryTimer[channel] >= recoveryDelay)
+      {
+        if(knockChannelRetard[channel] > configPage10.knock_recoveryStep) { knockChannelRetard[channel] -= configPage10.knock_recoveryStep; }
+        else { knockChannelRetard[channel] = 0; }
+        knockRecoveryTimer[channel] = 0;
+        BIT_SET(knockRecovering, channel);
+      }
+    }
+
+    if(knockChannelRetard[channel] > maxRetard) { maxRetard = knockChannelRetard[channel]; }
+  }
+
+  currentStatus.knockRetard = maxRetard;
+  currentStatus.knockActive = (maxRetard > 0);
+}
@@ -0,0 +1,41 @@
+#ifndef KNOCK_H
+#define KNOCK_H
+
+#include "globals.h"
+
+/** @file
+ * Per cylinder knock detection and retard.
+ * 
+ * Each time an ignition channel fires, the scheduler calls knockIgnitionEvent(). The knock window for that channel is then timed from the spark event.
+ * Knock pulses (Digital mode) or samples above the threshold (Analog mode) that occur within the window are attributed to the channel that most recently fired.
+ * The retard for each channel is stepped up / recovered independently by knockControl() (Called at KNOCK_CONTROL_RATE) and applied to that channel only in calculateIgnitionAngles().
+ */
+
+#define KNOCK_WINDOW_ANGLE_OFFSET 50 //The knock window start angle table is offset by 50 degrees to allow for windows that start before TDC
+#define KNOCK_CONTROL_RATE        30 //Rate (Hz) that knockControl() is called at from the main loop
+
+extern volatile uint8_t knockEventChannel; /**< The ignition channel (0 based) that most recently fired */
+extern volatile uint32_t knockEventTime; /**< The time (micros()) that the most recent ignition event occurred */
+extern volatile uint8_t knockWindowCount; /**< Number of knock pulses seen in the current window */
+extern volatile uint8_t knockChannelsDetected; /**< Bitfield of the channels that have knocked since the last call to knockControl() */
+extern uint8_t knockChannelRetard[IGN_CHANNELS]; /**< The current knock retard (Degrees) for each ignition channel */
+
+/**
+ * @brief Called from the ignition schedule ISR each time an ignition channel fires. Must be kept as short as possible
+ * 
+ * @param channel The ignition channel that fired (0 based)
+ * @param eventTime The time (micros()) of the event
+ */
+static inline __attribute__((always_inline)) void knockIgnitionEvent(uint8_t channel, uint32_t eventTime)
+{
+  knockEventChannel = channel;
+  knockEventTime = eventTime;
+  knockWindowCount = 0;
+}
+
+void initialiseKnock(void);
+void knockPulse(void);
+void readKnock(void);
+void knockControl(void);
+
+#endif // KNOCK_H
@@ -5,471 +5,472 @@
 #include "init.h"
 #include "maths.h"
 #include "utilities.h"
+#include "tuneBanks.h"
+#include "comms_legacy.h"
 #include BOARD_H 
 
+liveDataBlock liveData;
+
+//Names of the readable log fields. These are the column names of the SD card logs
+constexpr char header_0[] PROGMEM = "secl";
+constexpr char header_1[] PROGMEM = "status1";
+constexpr char header_2[] PROGMEM = "engine";
+constexpr char header_3[] PROGMEM = "Sync Loss #";
+constexpr char header_4[] PROGMEM = "MAP";
+constexpr char header_5[] PROGMEM = "IAT(C)";
+constexpr char header_6[] PROGMEM = "CLT(C)";
+constexpr char header_7[] PROGMEM = "Battery Correction";
+constexpr char header_8[] PROGMEM = "Battery V";
+constexpr char header_9[] PROGMEM = "AFR";
+constexpr char header_10[] PROGMEM = "EGO Correction";
+constexpr char header_11[] PROGMEM = "IAT Correction";
+constexpr char header_12[] PROGMEM = "WUE Correction";
+constexpr char header_13[] PROGMEM = "RPM";
+constexpr char header_14[] PROGMEM = "Accel. Correction";
+constexpr char header_15[] PROGMEM = "Gamma Correction";
+constexpr char header_16[] PROGMEM = "VE1";
+constexpr char header_17[] PROGMEM = "VE2";
+constexpr char header_18[] PROGMEM = "AFR Target";
+constexpr char header_19[] PROGMEM = "TPSdot";
+constexpr char header_20[] PROGMEM = "Advance Current";
+constexpr char header_21[] PROGMEM = "TPS";
+constexpr char header_22[] PROGMEM = "Loops/S";
+constexpr char header_23[] PROGMEM = "Free RAM";
+constexpr char header_24[] PROGMEM = "Boost Target";
+constexpr char header_25[] PROGMEM = "Boost Duty";
+constexpr char header_26[] PROGMEM = "status2";
+constexpr char header_27[] PROGMEM = "rpmDOT";
+constexpr char header_28[] PROGMEM = "Eth%";
+constexpr char header_29[] PROGMEM = "Flex Fuel Correction";
+constexpr char header_30[] PROGMEM = "Flex Adv Correction";
+constexpr char header_31[] PROGMEM = "IAC Steps/Duty";
+constexpr char header_32[] PROGMEM = "testoutputs";
+constexpr char header_33[] PROGMEM = "AFR2";
+constexpr char header_34[] PROGMEM = "Baro";
+constexpr char header_35[] PROGMEM = "AUX_IN 0";
+constexpr char header_36[] PROGMEM = "AUX_IN 1";
+constexpr char header_37[] PROGMEM = "AUX_IN 2";
+constexpr char header_38[] PROGMEM = "AUX_IN 3";
+constexpr char header_39[] PROGMEM = "AUX_IN 4";
+constexpr char header_40[] PROGMEM = "AUX_IN 5";
+constexpr char header_41[] PROGMEM = "AUX_IN 6";
+constexpr char header_42[] PROGMEM = "AUX_IN 7";
+constexpr char header_43[] PROGMEM = "AUX_IN 8";
+constexpr char header_44[] PROGMEM = "AUX_IN 9";
+constexpr char header_45[] PROGMEM = "AUX_IN 10";
+constexpr char header_46[] PROGMEM = "AUX_IN 11";
+constexpr char header_47[] PROGMEM = "AUX_IN 12";
+constexpr char header_48[] PROGMEM = "AUX_IN 13";
+constexpr char header_49[] PROGMEM = "AUX_IN 14";
+constexpr char header_50[] PROGMEM = "AUX_IN 15";
+constexpr char header_51[] PROGMEM = "TPS ADC";
+constexpr char header_52[] PROGMEM = "Errors";
+constexpr char header_53[] PROGMEM = "PW";
+constexpr char header_54[] PROGMEM = "PW2";
+constexpr char header_55[] PROGMEM = "PW3";
+constexpr char header_56[] PROGMEM = "PW4";
+constexpr char header_57[] PROGMEM = "status3";
+constexpr char header_58[] PROGMEM = "Engine Protect";
+constexpr char header_59[] PROGMEM = "";
+constexpr char header_60[] PROGMEM = "Fuel Load";
+constexpr char header_61[] PROGMEM = "Ign Load";
+constexpr char header_62[] PROGMEM = "Dwell Requested";
+constexpr char header_63[] PROGMEM = "Idle Target (RPM)";
+constexpr char header_64[] PROGMEM = "MAP DOT";
+constexpr char header_65[] PROGMEM = "VVT1 Angle";
+constexpr char header_66[] PROGMEM = "VVT1 Target";
+constexpr char header_67[] PROGMEM = "VVT1 Duty";
+constexpr char header_68[] PROGMEM = "Flex Boost Adj";
+constexpr char header_69[] PROGMEM = "Baro Correction";
+constexpr char header_70[] PROGMEM = "VE Current";
+constexpr char header_71[] PROGMEM = "ASE Correction";
+constexpr char header_72[] PROGMEM = "Vehicle Speed";
+constexpr char header_73[] PROGMEM = "Gear";
+constexpr char header_74[] PROGMEM = "Fuel Pressure";
+constexpr char header_75[] PROGMEM = "Oil Pressure";
+constexpr char header_76[] PROGMEM = "WMI PW";
+constexpr char header_77[] PROGMEM = "status4";
+constexpr char header_78[] PROGMEM = "VVT2 Angle";
+constexpr char header_79[] PROGMEM = "VVT2 Target";
+constexpr char header_80[] PROGMEM = "VVT2 Duty";
+constexpr char header_81[] PROGMEM = "outputs";
+constexpr char header_82[] PROGMEM = "Fuel Temp";
+constexpr char header_83[] PROGMEM = "Fuel Temp Correction";
+constexpr char header_84[] PROGMEM = "Advance 1";
+constexpr char header_85[] PROGMEM = "Advance 2";
+constexpr char header_86[] PROGMEM = "SD Status";
+constexpr char header_87[] PROGMEM = "EMAP";
+constexpr char header_88[] PROGMEM = "Fan Duty";
+constexpr char header_89[] PROGMEM = "AirConStatus";
+constexpr char header_90[] PROGMEM = "Dwell Actual";
+constexpr char header_91[] PROGMEM = "Tooth Log Overflows";
+constexpr char header_92[] PROGMEM = "Tune Bank";
+
+/**
+ * The readable log fields (See @ref logFieldDescriptor). This is the single description of the fields for the SD card logs, both CSV and binary.
+ * Adding a field only needs a name above and a line here. The order is the log index used by getReadableLogEntry()
+ */
+constexpr logFieldDescriptor logFields[LOG_FIELD_COUNT] PROGMEM = {
+  //Name, Offset, Type, Digits, Scale, Transform, Units
+  { header_0,    0, LOG_FIELD_U08,  0, 1.0F,    0, "sec"   },
+  { header_1,    1, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_2,    2, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_3,    3, LOG_FIELD_U08,  0, 1.0F,    0, ""      },
+  { header_4,    4, LOG_FIELD_U16,  0, 1.0F,    0, "kPa"   },
+  { header_5,    6, LOG_FIELD_U08,  0, 1.0F,  -40, "C"     },
+  { header_6,    7, LOG_FIELD_U08,  0, 1.0F,  -40, "C"     },
+  { header_7,    8, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_8,    9, LOG_FIELD_U08,  1, 0.1F,    0, "V"     },
+  { header_9,   10, LOG_FIELD_U08,  1, 0.1F,    0, "AFR"   },
+  { header_10,  11, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_11,  12, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_12,  13, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_13,  14, LOG_FIELD_U16,  0, 1.0F,    0, "rpm"   },
+  { header_14,  16, LOG_FIELD_U08,  0, 2.0F,    0, "%"     },
+  { header_15,  17, LOG_FIELD_U16,  0, 1.0F,    0, "%"     },
+  { header_16,  19, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_17,  20, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_18,  21, LOG_FIELD_U08,  1, 0.1F,    0, "AFR"   },
+  { header_19,  22, LOG_FIELD_S16,  0, 1.0F,    0, "%/s"   },
+  { header_20,  24, LOG_FIELD_S08,  0, 1.0F,    0, "deg"   },
+  { header_21,  25, LOG_FIELD_U08,  1, 0.5F,    0, "%"     },
+  { header_22,  26, LOG_FIELD_U16,  0, 1.0F,    0, "loops" },
+  { header_23,  28, LOG_FIELD_U16,  0, 1.0F,    0, "bytes" },
+  { header_24,  30, LOG_FIELD_U08,  0, 2.0F,    0, "kPa"   },
+  { header_25,  31, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_26,  32, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_27,  33, LOG_FIELD_S16,  0, 1.0F,    0, "rpm/s" },
+  { header_28,  35, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_29,  36, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_30,  37, LOG_FIELD_S08,  0, 1.0F,    0, "deg"   },
+  { header_31,  38, LOG_FIELD_U08,  0, 1.0F,    0, ""      },
+  { header_32,  39, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_33,  40, LOG_FIELD_U08,  1, 0.1F,    0, "AFR"   },
+  { header_34,  41, LOG_FIELD_U08,  0, 1.0F,    0, "kPa"   },
+  { header_35,  42, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_36,  44, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_37,  46, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_38,  48, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_39,  50, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_40,  52, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_41,  54, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_42,  56, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_43,  58, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_44,  60, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_45,  62, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_46,  64, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_47,  66, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_48,  68, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_49,  70, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_50,  72, LOG_FIELD_U16,  0, 1.0F,    0, ""      },
+  { header_51,  74, LOG_FIELD_U08,  0, 1.0F,    0, "ADC"   },
+  { header_52,  75, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_53,  76, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_54,  78, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_55,  80, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_56,  82, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_57,  84, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_58,  85, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_59,   0, LOG_FIELD_NONE, 0, 1.0F,    0, ""      },
+  { header_60,  86, LOG_FIELD_S16,  0, 1.0F,    0, ""      },
+  { header_61,  88, LOG_FIELD_S16,  0, 1.0F,    0, ""      },
+  { header_62,  90, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_63,  92, LOG_FIELD_U08,  0, 10.0F,   0, "rpm"   },
+  { header_64,  93, LOG_FIELD_S16,  0, 1.0F,    0, "kPa/s" },
+  { header_65,  95, LOG_FIELD_S16,  1, 0.5F,    0, "deg"   },
+  { header_66,  97, LOG_FIELD_U08,  1, 0.5F,    0, "deg"   },
+  { header_67,  98, LOG_FIELD_U08,  1, 0.5F,    0, "%"     },
+  { header_68,  99, LOG_FIELD_S16,  0, 1.0F,    0, "kPa"   },
+  { header_69, 101, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_70, 102, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_71, 103, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_72, 104, LOG_FIELD_U16,  0, 1.0F,    0, "km/h"  },
+  { header_73, 106, LOG_FIELD_U08,  0, 1.0F,    0, ""      },
+  { header_74, 107, LOG_FIELD_U08,  0, 1.0F,    0, "psi"   },
+  { header_75, 108, LOG_FIELD_U08,  0, 1.0F,    0, "psi"   },
+  { header_76, 109, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_77, 110, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_78, 111, LOG_FIELD_S16,  1, 0.5F,    0, "deg"   },
+  { header_79, 113, LOG_FIELD_U08,  1, 0.5F,    0, "deg"   },
+  { header_80, 114, LOG_FIELD_U08,  1, 0.5F,    0, "%"     },
+  { header_81, 115, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_82, 116, LOG_FIELD_U08,  0, 1.0F,  -40, "C"     },
+  { header_83, 117, LOG_FIELD_U08,  0, 1.0F,    0, "%"     },
+  { header_84, 118, LOG_FIELD_S08,  0, 1.0F,    0, "deg"   },
+  { header_85, 119, LOG_FIELD_S08,  0, 1.0F,    0, "deg"   },
+  { header_86, 120, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_87, 121, LOG_FIELD_S16,  0, 1.0F,    0, "kPa"   },
+  { header_88, 123, LOG_FIELD_U08,  1, 0.5F,    0, "%"     },
+  { header_89, 124, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+  { header_90, 125, LOG_FIELD_U16,  3, 0.001F,  0, "ms"    },
+  { header_91, 127, LOG_FIELD_U08,  0, 1.0F,    0, ""      },
+  { header_92, 128, LOG_FIELD_U08,  0, 1.0F,    0, "bits"  },
+};
+
+/** 
+ * Checks whether a legacy sendValues() is part way through sending the live data snapshot on either serial port.
+ * A send that fills the transmit buffer is resumed on a later loop and reads the rest of its bytes from the same snapshot, so the snapshot must not be refreshed until it has completed.
+ */
+bool isLiveDataLocked(void)
+{
+  return (serialStatusFlag == SERIAL_TRANSMIT_INPROGRESS_LEGACY) || (serialSecondaryStatusFlag == SERIAL_TRANSMIT_INPROGRESS_LEGACY);
+}
+
 /** 
- * Returns a numbered byte-field (partial field in case of multi-byte fields) from "current status" structure in the format expected by TunerStudio
+ * Refreshes a live data snapshot (@ref liveData unless another block is given) from the @ref currentStatus struct.
+ * This is done once per request for live data rather than once per byte, so that the whole block is consistent and each value is only converted once.
  * Notes on fields:
- * - Numbered field will be fields from @ref currentStatus, but not at all in the internal order of strct (e.g. field RPM value, number 14 will be
- *   2nd field in struct)
- * - The fields stored in multi-byte types will be accessed lowbyte and highbyte separately (e.g. PW1 will be broken into numbered byte-fields 75,76)
+ * - The fields are not in the internal order of the @ref currentStatus struct (e.g. RPM is byte number 14)
  * - Values have the value offsets and shifts expected by TunerStudio. They will not all be a 'human readable value'
+ */
+void updateLiveData(liveDataBlock &block)
+{
+  if(currentStatus.loopsPerSecond > 60000U) { currentStatus.loopsPerSecond = 60000U;}
+  currentStatus.freeRAM = freeRam();
+
+  block.secl = currentStatus.secl; //secl is simply a counter that increments each second. Used to track unexpected resets (Which will reset this count to 0)
+  block.status1 = currentStatus.status1; //status1 Bitfield
+  block.engine = currentStatus.engine; //Engine Status Bitfield
+  block.syncLossCounter = currentStatus.syncLossCounter;
+  block.MAP = (uint16_t)currentStatus.MAP;
+  block.IAT = lowByte(currentStatus.IAT + CALIBRATION_TEMPERATURE_OFFSET); //mat
+  block.coolant = lowByte(currentStatus.coolant + CALIBRATION_TEMPERATURE_OFFSET); //Coolant ADC
+  block.batCorrection = currentStatus.batCorrection; //Battery voltage correction (%)
+  block.battery10 = currentStatus.battery10; //battery voltage
+  block.O2 = currentStatus.O2; //O2
+  block.egoCorrection = currentStatus.egoCorrection; //Exhaust gas correction (%)
+  block.iatCorrection = currentStatus.iatCorrection; //Air temperature Correction (%)
+  block.wueCorrection = currentStatus.wueCorrection; //Warmup enrichment (%)
+  block.RPM = currentStatus.RPM;
+  block.AEamount = lowByte(currentStatus.AEamount >> 1U); //TPS acceleration enrichment (%) divided by 2 (Can exceed 255)
+  block.corrections = currentStatus.corrections; //Total GammaE (%)
+  block.VE1 = currentStatus.VE1; //VE 1 (%)
+  block.VE2 = currentStatus.VE2; //VE 2 (%)
+  block.afrTarget = currentStatus.afrTarget;
+  block.tpsDOT = currentStatus.tpsDOT; //TPS DOT
+  block.advance = currentStatus.advance;
+  block.TPS = currentStatus.TPS; // TPS (0% to 100%)
+  block.loopsPerSecond = (uint16_t)currentStatus.loopsPerSecond;
+  block.freeRAM = currentStatus.freeRAM;
+  block.boostTarget = lowByte(currentStatus.boostTarget >> 1U); //Divide boost target by 2 to fit in a byte
+  block.boostDuty = lowByte(div100(currentStatus.boostDuty));
+  block.spark = currentStatus.spark; //Spark related bitfield
+  block.rpmDOT = (int16_t)currentStatus.rpmDOT; //rpmDOT must be sent as a signed integer
+  block.ethanolPct = currentStatus.ethanolPct; //Flex sensor value (or 0 if not used)
+  block.flexCorrection = currentStatus.flexCorrection; //Flex fuel correction (% above or below 100)
+  block.flexIgnCorrection = currentStatus.flexIgnCorrection; //Ignition correction (Increased degrees of advance) for flex fuel
+  block.idleLoad = currentStatus.idleLoad;
+  block.testOutputs = currentStatus.testOutputs;
+  block.O2_2 = currentStatus.O2_2; //O2
+  block.baro = currentStatus.baro; //Barometer value
+  for(uint8_t x = 0; x < _countof(block.canin); x++) { block.canin[x] = currentStatus.canin[x]; }
+  block.tpsADC = currentStatus.tpsADC;
+  block.nextError = getNextError();
+  block.PW1 = currentStatus.PW1; //Pulsewidth 1 in uS
+  block.PW2 = currentStatus.PW2; //Pulsewidth 2 in uS
+  block.PW3 = currentStatus.PW3; //Pulsewidth 3 in uS
+  block.PW4 = currentStatus.PW4; //Pulsewidth 4 in uS
+  block.status3 = currentStatus.status3;
+  block.engineProtectStatus = currentStatus.engineProtectStatus;
+  block.fuelLoad = currentStatus.fuelLoad;
+  block.ignLoad = currentStatus.ignLoad;
+  block.dwell = currentStatus.dwell;
+  block.CLIdleTarget = currentStatus.CLIdleTarget;
+  block.mapDOT = currentStatus.mapDOT;
+  block.vvt1Angle = currentStatus.vvt1Angle;
+  block.vvt1TargetAngle = currentStatus.vvt1TargetAngle;
+  block.vvt1Duty = lowByte(currentStatus.vvt1Duty);
+  block.flexBoostCorrection = currentStatus.flexBoostCorrection;
+  block.baroCorrection = currentStatus.baroCorrection;
+  block.VE = currentStatus.VE; //Current VE (%). Can be equal to VE1 or VE2 or a calculated value from both of them
+  block.ASEValue = currentStatus.ASEValue; //Current ASE (%)
+  block.vss = currentStatus.vss;
+  block.gear = currentStatus.gear;
+  block.fuelPressure = currentStatus.fuelPressure;
+  block.oilPressure = currentStatus.oilPressure;
+  block.wmiPW = currentStatus.wmiPW;
+  block.status4 = currentStatus.status4;
+  block.vvt2Angle = currentStatus.vvt2Angle;
+  block.vvt2TargetAngle = currentStatus.vvt2TargetAngle;
+  block.vvt2Duty = lowByte(currentStatus.vvt2Duty);
+  block.outputsStatus = currentStatus.outputsStatus;
+  block.fuelTemp = lowByte(currentStatus.fuelTemp + CALIBRATION_TEMPERATURE_OFFSET); //Fuel temperature from flex sensor
+  block.fuelTempCorrection = currentStatus.fuelTempCorrection; //Fuel temperature Correction (%)
+  block.advance1 = currentStatus.advance1; //advance 1 (%)
+  block.advance2 = currentStatus.advance2; //advance 2 (%)
+  block.TS_SD_Status = currentStatus.TS_SD_Status; //SD card status
+  block.EMAP = currentStatus.EMAP;
+  block.fanDuty = currentStatus.fanDuty;
+  block.airConStatus = currentStatus.airConStatus;
+  block.actualDwell = currentStatus.actualDwell;
+  block.toothLogOverflows = toothLogOverflows;
+  block.tuneBank = (uint8_t)((isTuneBankChanged() ? 0x80U : 0U) | (TUNE_BANK_COUNT << 4U) | activeTuneBank);
+}
+
+void updateLiveData(void)
+{
+  updateLiveData(liveData);
+}
+
+/**
+ * Copies a range of the live data snapshot into a buffer. Any bytes beyond the end of the block are returned as 0
+ * @param buffer - The buffer to copy into. Must be at least length bytes
+ * @param offset - The byte number within the block to start from
+ * @param length - The number of bytes to copy
+ */
+void copyLiveData(byte *buffer, uint16_t offset, uint16_t length)
+{
+  uint16_t available = 0;
+  if(offset < sizeof(liveData)) { available = sizeof(liveData) - offset; }
+  if(available > length) { available = length; }
+
+  if(available > 0U) { memcpy(buffer, ((const byte *)&liveData) + offset, available); }
+  if(length > available) { memset(buffer + available, 0, length - available); }
+}
+
+/** 
+ * Returns a numbered byte-field from the live data snapshot (@ref liveData) in the format expected by TunerStudio.
+ * The snapshot must have been refreshed with updateLiveData() beforehand
  * @param byteNum - byte-Field number. This is not the entry number (As some entries have multiple byets), but the byte number that is needed
  * @return Field value in 1 byte size struct fields or 1 byte partial value (chunk) on multibyte fields.
  */
 byte getTSLogEntry(uint16_t byteNum)
 {
   byte statusValue = 0;
+  if(byteNum < sizeof(liveData)) { statusValue = ((const byte *)&liveData)[byteNum]; }
+  return statusValue;
+}
+
+/** 
+ * Reads the descriptor of a readable log field from flash
+ * @param logIndex - The log index required. Note that this is NOT the byte number, but the index in the log
+ * @param field - Filled with the field descriptor
+ */
+void getLogField(uint16_t logIndex, logFieldDescriptor &field)
+{
+  memcpy_P(&field, &logFields[logIndex], sizeof(field));
+}
 
-  switch(byteNum)
+/** 
+ * Returns the value of a log field exactly as it is held in the live data snapshot (@ref liveData), without the transform or scale applied.
+ * The snapshot must have been refreshed with updateLiveData() beforehand
+ */
+int32_t getLogFieldRaw(const logFieldDescriptor &field, const liveDataBlock &block)
+{
+  const byte *source = ((const byte *)&block) + field.offset;
+  int32_t rawValue = 0;
+
+  switch(field.type)
   {
-    case 0: statusValue = currentStatus.secl; break; //secl is simply a counter that increments each second. Used to track unexpected resets (Which will reset this count to 0)
-    case 1: statusValue = currentStatus.status1; break; //status1 Bitfield
-    case 2: statusValue = currentStatus.engine; break; //Engine Status Bitfield
-    case 3: statusValue = currentStatus.syncLossCounter; break;
-    case 4: statusValue = lowByte(currentStatus.MAP); break; //2 bytes for MAP
-    case 5: statusValue = highByte(currentStatus.MAP); break;
-    case 6: statusValue = lowByte(currentStatus.IAT + CALIBRATION_TEMPERATURE_OFFSET); break; //mat
-    case 7: statusValue = lowByte(currentStatus.coolant + CALIBRATION_TEMPERATURE_OFFSET); break; //Coolant ADC
-    case 8: statusValue = currentStatus.batCorrection; break; //Battery voltage correction (%)
-    case 9: statusValue = currentStatus.battery10; break; //battery voltage
-    case 10: statusValue = currentStatus.O2; break; //O2
-    case 11: statusValue = currentStatus.egoCorrection; break; //Exhaust gas correction (%)
-    case 12: statusValue = currentStatus.iatCorrection; break; //Air temperature Correction (%)
-    case 13: statusValue = currentStatus.wueCorrection; break; //Warmup enrichment (%)
-    case 14: statusValue = lowByte(currentStatus.RPM); break; //rpm HB
-    case 15: statusValue = highByte(currentStatus.RPM); break; //rpm LB
-    case 16: statusValue = lowByte(currentStatus.AEamount >> 1U); break; //TPS acceleration enrichment (%) divided by 2 (Can exceed 255)
-    case 17: statusValue = lowByte(currentStatus.corrections); break; //Total GammaE (%)
-    case 18: statusValue = highByte(currentStatus.corrections); break; //Total GammaE (%)
-    case 19: statusValue = currentStatus.VE1; break; //VE 1 (%)
-    case 20: statusValue = currentStatus.VE2; break; //VE 2 (%)
-    case 21: statusValue = currentStatus.afrTarget; break;
-    case 22: statusValue = lowByte(currentStatus.tpsDOT); break; //TPS DOT
-    case 23: statusValue = highByte(currentStatus.tpsDOT); break; //TPS DOT
-    case 24: statusValue = currentStatus.advance; break;
-    case 25: statusValue = currentStatus.TPS; break; // TPS (0% to 100%)
-    
-    case 26: 
-      if(currentStatus.loopsPerSecond > 60000U) { currentStatus.loopsPerSecond = 60000U;}
-      statusValue = lowByte(currentStatus.loopsPerSecond); 
-      break;
-    case 27: 
-      if(currentStatus.loopsPerSecond > 60000U) { currentStatus.loopsPerSecond = 60000U;}
-      statusValue = highByte(currentStatus.loopsPerSecond); 
-      break;
-    
-    case 28: 
-      currentStatus.freeRAM = freeRam();
-      statusValue = lowByte(currentStatus.freeRAM); //(byte)((currentStatus.loopsPerSecond >> 8) & 0xFF);
-      break; 
-    case 29: 
-      currentStatus.freeRAM = freeRam();
-      statusValue = highByte(currentStatus.freeRAM); 
-      break;
-
-    case 30: statusValue = lowByte(currentStatus.boostTarget >> 1U); break; //Divide boost target by 2 to fit in a byte
-    case 31: statusValue = lowByte(div100(currentStatus.boostDuty)); break;
-    case 32: statusValue = currentStatus.spark; break; //Spark related bitfield
-
-    //rpmDOT must be sent as a signed integer
-    case 33: statusValue = lowByte(currentStatus.rpmDOT); break;
-    case 34: statusValue = highByte(currentStatus.rpmDOT); break;
-
-    case 35: statusValue = currentStatus.ethanolPct; break; //Flex sensor value (or 0 if not used)
-    case 36: statusValue = currentStatus.flexCorrection; break; //Flex fuel correction (% above or below 100)
-    case 37: statusValue = currentStatus.flexIgnCorrection; break; //Ignition correction (Increased degrees of advance) for flex fuel
-
-    case 38: statusValue = currentStatus.idleLoad; break;
-    case 39: statusValue = currentStatus.testOutputs; break;
-
-    case 40: statusValue = currentStatus.O2_2; break; //O2
-    case 41: statusValue = currentStatus.baro; break; //Barometer value
-
-    case 42: statusValue = lowByte(currentStatus.canin[0]); break;
-    case 43: statusValue = highByte(currentStatus.canin[0]); break;
-    case 44: statusValue = lowByte(currentStatus.canin[1]); break;
-    case 45: statusValue = highByte(currentStatus.canin[1]); break;
-    case 46: statusValue = lowByte(currentStatus.canin[2]); break;
-    case 47: statusValue = highByte(currentStatus.canin[2]); break;
-    case 48: statusValue = lowByte(currentStatus.canin[3]); break;
-    case 49: statusValue = highByte(currentStatus.canin[3]); break;
-    case 50: statusValue = lowByte(currentStatus.canin[4]); break;
-    case 51: statusValue = highByte(currentStatus.canin[4]); break;
-    case 52: statusValue = lowByte(currentStatus.canin[5]); break;
-    case 53: statusValue = highByte(currentStatus.canin[5]); break;
-    case 54: statusValue = lowByte(currentStatus.canin[6]); break;
-    case 55: statusValue = highByte(currentStatus.canin[6]); break;
-    case 56: statusValue = lowByte(currentStatus.canin[7]); break;
-    case 57: statusValue = highByte(currentStatus.canin[7]); break;
-    case 58: statusValue = lowByte(currentStatus.canin[8]); break;
-    case 59: statusValue = highByte(currentStatus.canin[8]); break;
-    case 60: statusValue = lowByte(currentStatus.canin[9]); break;
-    case 61: statusValue = highByte(currentStatus.canin[9]); break;
-    case 62: statusValue = lowByte(currentStatus.canin[10]); break;
-    case 63: statusValue = highByte(currentStatus.canin[10]); break;
-    case 64: statusValue = lowByte(currentStatus.canin[11]); break;
-    case 65: statusValue = highByte(currentStatus.canin[11]); break;
-    case 66: statusValue = lowByte(currentStatus.canin[12]); break;
-    case 67: statusValue = highByte(currentStatus.canin[12]); break;
-    case 68: statusValue = lowByte(currentStatus.canin[13]); break;
-    case 69: statusValue = highByte(currentStatus.canin[13]); break;
-    case 70: statusValue = lowByte(currentStatus.canin[14]); break;
-    case 71: statusValue = highByte(currentStatus.canin[14]); break;
-    case 72: statusValue = lowByte(currentStatus.canin[15]); break;
-    case 73: statusValue = highByte(currentStatus.canin[15]); break;
-
-    case 74: statusValue = currentStatus.tpsADC; break;
-    case 75: statusValue = getNextError(); break;
-
-    case 76: statusValue = lowByte(currentStatus.PW1); break; //Pulsewidth 1 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 77: statusValue = highByte(currentStatus.PW1); break; //Pulsewidth 1 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 78: statusValue = lowByte(currentStatus.PW2); break; //Pulsewidth 2 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 79: statusValue = highByte(currentStatus.PW2); break; //Pulsewidth 2 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 80: statusValue = lowByte(currentStatus.PW3); break; //Pulsewidth 3 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 81: statusValue = highByte(currentStatus.PW3); break; //Pulsewidth 3 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 82: statusValue = lowByte(currentStatus.PW4); break; //Pulsewidth 4 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 83: statusValue = highByte(currentStatus.PW4); break; //Pulsewidth 4 multiplied by 10 in ms. Have to convert from uS to mS.
-
-    case 84: statusValue = currentStatus.status3; break;
-    case 85: statusValue = currentStatus.engineProtectStatus; break;
-    case 86: statusValue = lowByte(currentStatus.fuelLoad); break;
-    case 87: statusValue = highByte(currentStatus.fuelLoad); break;
-    case 88: statusValue = lowByte(currentStatus.ignLoad); break;
-    case 89: statusValue = highByte(currentStatus.ignLoad); break;
-    case 90: statusValue = lowByte(currentStatus.dwell); break;
-    case 91: statusValue = highByte(currentStatus.dwell); break;
-    case 92: statusValue = currentStatus.CLIdleTarget; break;
-    case 93: statusValue = lowByte(currentStatus.mapDOT); break;
-    case 94: statusValue = highByte(currentStatus.mapDOT); break;
-    case 95: statusValue = lowByte(currentStatus.vvt1Angle); break; //2 bytes for vvt1Angle
-    case 96: statusValue = highByte(currentStatus.vvt1Angle); break;
-    case 97: statusValue = currentStatus.vvt1TargetAngle; break;
-    case 98: statusValue = lowByte(currentStatus.vvt1Duty); break;
-    case 99: statusValue = lowByte(currentStatus.flexBoostCorrection); break;
-    case 100: statusValue = highByte(currentStatus.flexBoostCorrection); break;
-    case 101: statusValue = currentStatus.baroCorrection; break;
-    case 102: statusValue = currentStatus.VE; break; //Current VE (%). Can be equal to VE1 or VE2 or a calculated value from both of them
-    case 103: statusValue = currentStatus.ASEValue; break; //Current ASE (%)
-    case 104: statusValue = lowByte(currentStatus.vss); break;
-    case 105: statusValue = highByte(currentStatus.vss); break;
-    case 106: statusValue = currentStatus.gear; break;
-    case 107: statusValue = currentStatus.fuelPressure; break;
-    case 108: statusValue = currentStatus.oilPressure; break;
-    case 109: statusValue = currentStatus.wmiPW; break;
-    case 110: statusValue = currentStatus.status4; break;
-    case 111: statusValue = lowByte(currentStatus.vvt2Angle); break; //2 bytes for vvt2Angle
-    case 112: statusValue = highByte(currentStatus.vvt2Angle); break;
-    case 113: statusValue = currentStatus.vvt2TargetAngle; break;
-    case 114: statusValue = lowByte(currentStatus.vvt2Duty); break;
-    case 115: statusValue = currentStatus.outputsStatus; break;
-    case 116: statusValue = lowByte(currentStatus.fuelTemp + CALIBRATION_TEMPERATURE_OFFSET); break; //Fuel temperature from flex sensor
-    case 117: statusValue = currentStatus.fuelTempCorrection; break; //Fuel temperature Correction (%)
-    case 118: statusValue = currentStatus.advance1; break; //advance 1 (%)
-    case 119: statusValue = currentStatus.advance2; break; //advance 2 (%)
-    case 120: statusValue = currentStatus.TS_SD_Status; break; //SD card status
-    case 121: statusValue = lowByte(currentStatus.EMAP); break; //2 bytes for EMAP
-    case 122: statusValue = highByte(currentStatus.EMAP); break;
-    case 123: statusValue = currentStatus.fanDuty; break;
-    case 124: statusValue = currentStatus.airConStatus; break;
-    case 125: statusValue = lowByte(currentStatus.actualDwell); break;
-    case 126: statusValue = highByte(currentStatus.actualDwell); break;
-    default: statusValue = 0; // MISRA check
+    case LOG_FIELD_U08: rawValue = source[0]; break;
+    case LOG_FIELD_S08: rawValue = (int8_t)source[0]; break;
+    case LOG_FIELD_U16: rawValue = word(source[1], source[0]); break;
+    case LOG_FIELD_S16: rawValue = (int16_t)word(source[1], source[0]); break;
+    default: rawValue = 0; break; //LOG_FIELD_NONE
   }
 
-  return statusValue;
+  return rawValue;
 }
 
 /** 
- * Similar to the @ref getTSLogEntry function, however this returns a full, unadjusted (ie human readable) log entry value.
- * See logger.h for the field names and order
+ * Returns a human readable log entry value. The value comes from the live data snapshot (@ref liveData), which must have been refreshed with updateLiveData() beforehand.
+ * See the logFields table for the field names and order
  * @param logIndex - The log index required. Note that this is NOT the byte number, but the index in the log
- * @return Raw, unadjusted value of the log entry. No offset or multiply is applied like it is with the TS log
+ * @return Value of the log entry with the transform applied. Scales that reduce the resolution of the value in the live data (e.g. Boost target / 2) are reversed, but fractional scales are not as the result is an integer
  */
-int16_t getReadableLogEntry(uint16_t logIndex)
+int16_t getReadableLogEntry(uint16_t logIndex, const liveDataBlock &block)
 {
   int16_t statusValue = 0;
 
-  switch(logIndex)
+  if(logIndex < LOG_FIELD_COUNT)
   {
-    case 0: statusValue = currentStatus.secl; break; //secl is simply a counter that increments each second. Used to track unexpected resets (Which will reset this count to 0)
-    case 1: statusValue = currentStatus.status1; break; //status1 Bitfield
-    case 2: statusValue = currentStatus.engine; break; //Engine Status Bitfield
-    case 3: statusValue = currentStatus.syncLossCounter; break;
-    case 4: statusValue = currentStatus.MAP; break; //2 bytes for MAP
-    case 5: statusValue = currentStatus.IAT; break; //mat
-    case 6: statusValue = currentStatus.coolant; break; //Coolant ADC
-    case 7: statusValue = currentStatus.batCorrection; break; //Battery voltage correction (%)
-    case 8: statusValue = currentStatus.battery10; break; //battery voltage
-    case 9: statusValue = currentStatus.O2; break; //O2
-    case 10: statusValue = currentStatus.egoCorrection; break; //Exhaust gas correction (%)
-    case 11: statusValue = currentStatus.iatCorrection; break; //Air temperature Correction (%)
-    case 12: statusValue = currentStatus.wueCorrection; break; //Warmup enrichment (%)
-    case 13: statusValue = currentStatus.RPM; break; //rpm HB
-    case 14: statusValue = currentStatus.AEamount; break; //TPS acceleration enrichment (%)
-    case 15: statusValue = currentStatus.corrections; break; //Total GammaE (%)
-    case 16: statusValue = currentStatus.VE1; break; //VE 1 (%)
-    case 17: statusValue = currentStatus.VE2; break; //VE 2 (%)
-    case 18: statusValue = currentStatus.afrTarget; break;
-    case 19: statusValue = currentStatus.tpsDOT; break; //TPS DOT
-    case 20: statusValue = currentStatus.advance; break;
-    case 21: statusValue = currentStatus.TPS; break; // TPS (0% to 100%)
-    
-    case 22: 
-      if(currentStatus.loopsPerSecond > 60000U) { currentStatus.loopsPerSecond = 60000U;}
-      statusValue = currentStatus.loopsPerSecond; 
-      break;
-    
-    case 23: 
-      currentStatus.freeRAM = freeRam();
-      statusValue = currentStatus.freeRAM;
-      break; 
-
-    case 24: statusValue = currentStatus.boostTarget; break;
-    case 25: statusValue = currentStatus.boostDuty; break;
-    case 26: statusValue = currentStatus.spark; break; //Spark related bitfield
-    case 27: statusValue = currentStatus.rpmDOT; break;
-    case 28: statusValue = currentStatus.ethanolPct; break; //Flex sensor value (or 0 if not used)
-    case 29: statusValue = currentStatus.flexCorrection; break; //Flex fuel correction (% above or below 100)
-    case 30: statusValue = currentStatus.flexIgnCorrection; break; //Ignition correction (Increased degrees of advance) for flex fuel
-    case 31: statusValue = currentStatus.idleLoad; break;
-    case 32: statusValue = currentStatus.testOutputs; break;
-    case 33: statusValue = currentStatus.O2_2; break; //O2
-    case 34: statusValue = currentStatus.baro; break; //Barometer value
-
-    case 35: statusValue = currentStatus.canin[0]; break;
-    case 36: statusValue = currentStatus.canin[1]; break;
-    case 37: statusValue = currentStatus.canin[2]; break;
-    case 38: statusValue = currentStatus.canin[3]; break;
-    case 39: statusValue = currentStatus.canin[4]; break;
-    case 40: statusValue = currentStatus.canin[5]; break;
-    case 41: statusValue = currentStatus.canin[6]; break;
-    case 42: statusValue = currentStatus.canin[7]; break;
-    case 43: statusValue = currentStatus.canin[8]; break;
-    case 44: statusValue = currentStatus.canin[9]; break;
-    case 45: statusValue = currentStatus.canin[10]; break;
-    case 46: statusValue = currentStatus.canin[11]; break;
-    case 47: statusValue = currentStatus.canin[12]; break;
-    case 48: statusValue = currentStatus.canin[13]; break;
-    case 49: statusValue = currentStatus.canin[14]; break;
-    case 50: statusValue = currentStatus.canin[15]; break;
-    
-    case 51: statusValue = currentStatus.tpsADC; break;
-    case 52: statusValue = getNextError(); break;
-
-    case 53: statusValue = currentStatus.PW1; break; //Pulsewidth 1 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 54: statusValue = currentStatus.PW2; break; //Pulsewidth 2 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 55: statusValue = currentStatus.PW3; break; //Pulsewidth 3 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 56: statusValue = currentStatus.PW4; break; //Pulsewidth 4 multiplied by 10 in ms. Have to convert from uS to mS.
-  
-    case 57: statusValue = currentStatus.status3; break;
-    case 58: statusValue = currentStatus.engineProtectStatus; break;
-
-    case 59: break; //UNUSED!!
-
-    case 60: statusValue = currentStatus.fuelLoad; break;
-    case 61: statusValue = currentStatus.ignLoad; break;
-    case 62: statusValue = (int16_t)currentStatus.dwell; break;
-    case 63: statusValue = currentStatus.CLIdleTarget; break;
-    case 64: statusValue = currentStatus.mapDOT; break;
-    case 65: statusValue = currentStatus.vvt1Angle; break;
-    case 66: statusValue = currentStatus.vvt1TargetAngle; break;
-    case 67: statusValue = currentStatus.vvt1Duty; break;
-    case 68: statusValue = currentStatus.flexBoostCorrection; break;
-    case 69: statusValue = currentStatus.baroCorrection; break;
-    case 70: statusValue = currentStatus.VE; break; //Current VE (%). Can be equal to VE1 or VE2 or a calculated value from both of them
-    case 71: statusValue = currentStatus.ASEValue; break; //Current ASE (%)
-    case 72: statusValue = currentStatus.vss; break;
-    case 73: statusValue = currentStatus.gear; break;
-    case 74: statusValue = currentStatus.fuelPressure; break;
-    case 75: statusValue = currentStatus.oilPressure; break;
-    case 76: statusValue = currentStatus.wmiPW; break;
-    case 77: statusValue = currentStatus.status4; break;
-    case 78: statusValue = currentStatus.vvt2Angle; break; //2 bytes for vvt2Angle
-    case 79: statusValue = currentStatus.vvt2TargetAngle; break;
-    case 80: statusValue = currentStatus.vvt2Duty; break;
-    case 81: statusValue = currentStatus.outputsStatus; break;
-    case 82: statusValue = currentStatus.fuelTemp; break; //Fuel temperature from flex sensor
-    case 83: statusValue = currentStatus.fuelTempCorrection; break; //Fuel temperature Correction (%)
-    case 84: statusValue = currentStatus.advance1; break; //advance 1 (%)
-    case 85: statusValue = currentStatus.advance2; break; //advance 2 (%)
-    case 86: statusValue = currentStatus.TS_SD_Status; break; //SD card status
-    case 87: statusValue = currentStatus.EMAP; break;
-    case 88: statusValue = currentStatus.fanDuty; break;
-    case 89: statusValue = currentStatus.airConStatus; break;
-    case 90: statusValue = currentStatus.actualDwell; break;
-    default: statusValue = 0; // MISRA check
+    logFieldDescriptor field;
+    getLogField(logIndex, field);
+    int32_t value = getLogFieldRaw(field, block) + field.transform;
+    if(field.scale > 1.0F) { value = value * (int32_t)field.scale; }
+    statusValue = (int16_t)value;
   }
 
   return statusValue;
 }
 
+#if defined(FPU_MAX_SIZE) && FPU_MAX_SIZE >= 32 //cppcheck-suppress misra-c2012-20.9
+/** 
+ * Returns the fully scaled, human readable value of a log field from the live data snapshot (@ref liveData)
+ */
+float getLogFieldValue(const logFieldDescriptor &field, const liveDataBlock &block)
+{
+  return (float)(getLogFieldRaw(field, block) + field.transform) * field.scale;
+}
+
 /** 
- * An expansion to the @ref getReadableLogEntry function for systems that have an FPU. It will provide a floating point value for any parameter that this is appropriate for, otherwise will return the result of @ref getReadableLogEntry.
- * See logger.h for the field names and order
+ * An expansion to the @ref getReadableLogEntry function for systems that have an FPU. This applies the full scale of the field, so values such as pulsewidths are returned in their readable units (ms) rather than the integer units they are stored in.
+ * See the logFields table for the field names and order
  * @param logIndex - The log index required. Note that this is NOT the byte number, but the index in the log
  * @return float value of the requested log entry. 
  */
-#if defined(FPU_MAX_SIZE) && FPU_MAX_SIZE >= 32 //cppcheck-suppress misra-c2012-20.9
 float getReadableFloatLogEntry(uint16_t logIndex)
 {
   float statusValue = 0.0;
 
-  switch(logIndex)
+  if(logIndex < LOG_FIELD_COUNT)
   {
-    case 8: statusValue = currentStatus.battery10 / 10.0; break; //battery voltage
-    case 9: statusValue = currentStatus.O2 / 10.0; break;
-    case 18: statusValue = currentStatus.afrTarget / 10.0; break;
-    case 21: statusValue = currentStatus.TPS / 2.0; break; // TPS (0% to 100% = 0 to 200)
-    case 33: statusValue = currentStatus.O2_2 / 10.0; break; //O2
-
-    case 53: statusValue = currentStatus.PW1 / 1000.0; break; //Pulsewidth 1 Have to convert from uS to mS.
-    case 54: statusValue = currentStatus.PW2 / 1000.0; break; //Pulsewidth 2 Have to convert from uS to mS.
-    case 55: statusValue = currentStatus.PW3 / 1000.0; break; //Pulsewidth 3 Have to convert from uS to mS.
-    case 56: statusValue = currentStatus.PW4 / 1000.0; break; //Pulsewidth 4 Have to convert from uS to mS.
-
-    default: statusValue = getReadableLogEntry(logIndex); break; //If logIndex value is NOT a float based one, use the regular function
+    logFieldDescriptor field;
+    getLogField(logIndex, field);
+    statusValue = getLogFieldValue(field);
   }
 
   return statusValue;
 }
 #endif
 
+#define LEGACY_SPECIAL  0xFFU //Byte of the legacy secondary serial packet that is not a copy of a live data byte
+/** 
+ * The live data byte that is sent for each byte of the legacy (Fixed order) secondary serial packet.
+ * Almost all of the legacy packet is the same values as the live data, just in a different order. The few that are not are marked as LEGACY_SPECIAL and handled in getLegacySecondarySerialLogEntry()
+ */
+constexpr uint8_t legacySerialMap[] PROGMEM = {
+    0,   1,   2, LEGACY_SPECIAL,   4,   5,   6,   7,   8,   9, //0
+   10,  11,  12,  13,  14,  15, LEGACY_SPECIAL,  17, 102,  21, //10
+   76,  77, LEGACY_SPECIAL,  24,  25,  26,  27,  28,  29,  30, //20
+   31,  32,  33,  34,  35,  36,  37,  38,  39,  40, //30
+   41,  42,  43,  44,  45,  46,  47,  48,  49,  50, //40
+   51,  52,  53,  54,  55,  56,  57,  58,  59,  60, //50
+   61,  62,  63,  64,  65,  66,  67,  68,  69,  70, //60
+   71,  72,  73,  74,  75, LEGACY_SPECIAL,  78,  79,  80,  81, //70
+   82,  83,  84,  85,  86,  87,  88,  89, LEGACY_SPECIAL, LEGACY_SPECIAL, //80
+   38,  92, LEGACY_SPECIAL,  95,  97,  98,  99, 100, 101, 103, //90
+  104, 105, 106, 107, 108, 109, 110, 111, 113, 114, //100
+  115, 116, 117,  19,  20, 118, 119, LEGACY_SPECIAL, 120, 121, //110
+  122, 123, 124 //120
+};
+
+/** 
+ * Returns a byte of the legacy (Fixed order) secondary serial packet. This is used by dashes etc that predate the ini file based order.
+ * The values come from the live data snapshot (@ref liveData), which must have been refreshed with updateLiveData() beforehand
+ * @param byteNum - The byte number of the legacy packet
+ */
 uint8_t getLegacySecondarySerialLogEntry(uint16_t byteNum)
 {
   uint8_t statusValue = 0;
-  currentStatus.spark ^= (-currentStatus.hasSync ^ currentStatus.spark) & (1U << BIT_SPARK_SYNC); //Set the sync bit of the Spark variable to match the hasSync variable
+  uint8_t liveDataByte = LEGACY_SPECIAL;
+  if(byteNum < sizeof(legacySerialMap)) { liveDataByte = pgm_read_byte(&legacySerialMap[byteNum]); }
 
-  switch(byteNum)
+  if(liveDataByte != LEGACY_SPECIAL) { statusValue = ((const byte *)&liveData)[liveDataByte]; }
+  else
   {
-    case 0: statusValue = currentStatus.secl; break; //secl is simply a counter that increments each second. Used to track unexpected resets (Which will reset this count to 0)
-    case 1: statusValue = currentStatus.status1; break; //status1 Bitfield, inj1Status(0), inj2Status(1), inj3Status(2), inj4Status(3), DFCOOn(4), boostCutFuel(5), toothLog1Ready(6), toothLog2Ready(7)
-    case 2: statusValue = currentStatus.engine; break; //Engine Status Bitfield, running(0), crank(1), ase(2), warmup(3), tpsaccaen(4), tpsacden(5), mapaccaen(6), mapaccden(7)
-    case 3: statusValue = (byte)div100(currentStatus.dwell); break; //Dwell in ms * 10
-    case 4: statusValue = lowByte(currentStatus.MAP); break; //2 bytes for MAP
-    case 5: statusValue = highByte(currentStatus.MAP); break;
-    case 6: statusValue = (byte)(currentStatus.IAT + CALIBRATION_TEMPERATURE_OFFSET); break; //mat
-    case 7: statusValue = (byte)(currentStatus.coolant + CALIBRATION_TEMPERATURE_OFFSET); break; //Coolant ADC
-    case 8: statusValue = currentStatus.batCorrection; break; //Battery voltage correction (%)
-    case 9: statusValue = currentStatus.battery10; break; //battery voltage
-    case 10: statusValue = currentStatus.O2; break; //O2
-    case 11: statusValue = currentStatus.egoCorrection; break; //Exhaust gas correction (%)
-    case 12: statusValue = currentStatus.iatCorrection; break; //Air temperature Correction (%)
-    case 13: statusValue = currentStatus.wueCorrection; break; //Warmup enrichment (%)
-    case 14: statusValue = lowByte(currentStatus.RPM); break; //rpm HB
-    case 15: statusValue = highByte(currentStatus.RPM); break; //rpm LB
-    case 16: statusValue = currentStatus.AEamount; break; //acceleration enrichment (%)
-    case 17: statusValue = currentStatus.corrections; break; //Total GammaE (%)
-    case 18: statusValue = currentStatus.VE; break; //Current VE 1 (%)
-    case 19: statusValue = currentStatus.afrTarget; break;
-    case 20: statusValue = lowByte(currentStatus.PW1); break; //Pulsewidth 1 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 21: statusValue = highByte(currentStatus.PW1); break; //Pulsewidth 1 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 22: statusValue = (uint8_t)(currentStatus.tpsDOT / 10); break; //TPS DOT
-    case 23: statusValue = currentStatus.advance; break;
-    case 24: statusValue = currentStatus.TPS; break; // TPS (0% to 100%)
-    case 25: statusValue = lowByte(currentStatus.loopsPerSecond); break;
-    case 26: statusValue = highByte(currentStatus.loopsPerSecond); break;
-
-    case 27: currentStatus.freeRAM = freeRam(); statusValue = lowByte(currentStatus.freeRAM); break; //(byte)((currentStatus.loopsPerSecond >> 8) & 0xFF); break;
-    case 28: currentStatus.freeRAM = freeRam(); statusValue = highByte(currentStatus.freeRAM); break;
-
-    case 29: statusValue = (byte)(currentStatus.boostTarget >> 1); break; //Divide boost target by 2 to fit in a byte
-    case 30: statusValue = (byte)(currentStatus.boostDuty / 100); break;
-    case 31: statusValue = currentStatus.spark; break; //Spark related bitfield, launchHard(0), launchSoft(1), hardLimitOn(2), softLimitOn(3), boostCutSpark(4), error(5), idleControlOn(6), sync(7)
-    case 32: statusValue = lowByte(currentStatus.rpmDOT); break;
-    case 33: statusValue = highByte(currentStatus.rpmDOT); break;
-    case 34: statusValue = currentStatus.ethanolPct; break; //Flex sensor value (or 0 if not used)
-    case 35: statusValue = currentStatus.flexCorrection; break; //Flex fuel correction (% above or below 100)
-    case 36: statusValue = currentStatus.flexIgnCorrection; break; //Ignition correction (Increased degrees of advance) for flex fuel
-    case 37: statusValue = currentStatus.idleLoad; break;
-    case 38: statusValue = currentStatus.testOutputs; break; // testEnabled(0), testActive(1)
-    case 39: statusValue = currentStatus.O2_2; break; //O2
-    case 40: statusValue = currentStatus.baro; break; //Barometer value
-    case 41: statusValue = lowByte(currentStatus.canin[0]); break;
-    case 42: statusValue = highByte(currentStatus.canin[0]); break;
-    case 43: statusValue = lowByte(currentStatus.canin[1]); break;
-    case 44: statusValue = highByte(currentStatus.canin[1]); break;
-    case 45: statusValue = lowByte(currentStatus.canin[2]); break;
-    case 46: statusValue = highByte(currentStatus.canin[2]); break;
-    case 47: statusValue = lowByte(currentStatus.canin[3]); break;
-    case 48: statusValue = highByte(currentStatus.canin[3]); break;
-    case 49: statusValue = lowByte(currentStatus.canin[4]); break;
-    case 50: statusValue = highByte(currentStatus.canin[4]); break;
-    case 51: statusValue = lowByte(currentStatus.canin[5]); break;
-    case 52: statusValue = highByte(currentStatus.canin[5]); break;
-    case 53: statusValue = lowByte(currentStatus.canin[6]); break;
-    case 54: statusValue = highByte(currentStatus.canin[6]); break;
-    case 55: statusValue = lowByte(currentStatus.canin[7]); break;
-    case 56: statusValue = highByte(currentStatus.canin[7]); break;
-    case 57: statusValue = lowByte(currentStatus.canin[8]); break;
-    case 58: statusValue = highByte(currentStatus.canin[8]); break;
-    case 59: statusValue = lowByte(currentStatus.canin[9]); break;
-    case 60: statusValue = highByte(currentStatus.canin[9]); break;
-    case 61: statusValue = lowByte(currentStatus.canin[10]); break;
-    case 62: statusValue = highByte(currentStatus.canin[10]); break;
-    case 63: statusValue = lowByte(currentStatus.canin[11]); break;
-    case 64: statusValue = highByte(currentStatus.canin[11]); break;
-    case 65: statusValue = lowByte(currentStatus.canin[12]); break;
-    case 66: statusValue = highByte(currentStatus.canin[12]); break;
-    case 67: statusValue = lowByte(currentStatus.canin[13]); break;
-    case 68: statusValue = highByte(currentStatus.canin[13]); break;
-    case 69: statusValue = lowByte(currentStatus.canin[14]); break;
-    case 70: statusValue = highByte(currentStatus.canin[14]); break;
-    case 71: statusValue = lowByte(currentStatus.canin[15]); break;
-    case 72: statusValue = highByte(currentStatus.canin[15]); break;
-
-    case 73: statusValue = currentStatus.tpsADC; break;
-    case 74: statusValue = getNextError(); break; // errorNum (0:1), currentError(2:7)
-
-    case 75: statusValue = currentStatus.launchCorrection; break;
-    case 76: statusValue = lowByte(currentStatus.PW2); break; //Pulsewidth 2 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 77: statusValue = highByte(currentStatus.PW2); break; //Pulsewidth 2 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 78: statusValue = lowByte(currentStatus.PW3); break; //Pulsewidth 3 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 79: statusValue = highByte(currentStatus.PW3); break; //Pulsewidth 3 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 80: statusValue = lowByte(currentStatus.PW4); break; //Pulsewidth 4 multiplied by 10 in ms. Have to convert from uS to mS.
-    case 81: statusValue = highByte(currentStatus.PW4); break; //Pulsewidth 4 multiplied by 10 in ms. Have to convert from uS to mS.
-
-    case 82: statusValue = currentStatus.status3; break; // resentLockOn(0), nitrousOn(1), fuel2Active(2), vssRefresh(3), halfSync(4), nSquirts(6:7)
-    case 83: statusValue = currentStatus.engineProtectStatus; break; //RPM(0), MAP(1), OIL(2), AFR(3), Unused(4:7)
-    case 84: statusValue = lowByte(currentStatus.fuelLoad); break;
-    case 85: statusValue = highByte(currentStatus.fuelLoad); break;
-    case 86: statusValue = lowByte(currentStatus.ignLoad); break;
-    case 87: statusValue = highByte(currentStatus.ignLoad); break;
-    case 88: statusValue = lowByte(currentStatus.injAngle); break; 
-    case 89: statusValue = highByte(currentStatus.injAngle); break; 
-    case 90: statusValue = currentStatus.idleLoad; break;
-    case 91: statusValue = currentStatus.CLIdleTarget; break; //closed loop idle target
-    case 92: statusValue = (uint8_t)(currentStatus.mapDOT / 10); break; //rate of change of the map 
-    case 93: statusValue = (int8_t)currentStatus.vvt1Angle; break;
-    case 94: statusValue = currentStatus.vvt1TargetAngle; break;
-    case 95: statusValue = currentStatus.vvt1Duty; break;
-    case 96: statusValue = lowByte(currentStatus.flexBoostCorrection); break;
-    case 97: statusValue = highByte(currentStatus.flexBoostCorrection); break;
-    case 98: statusValue = currentStatus.baroCorrection; break;
-    case 99: statusValue = currentStatus.ASEValue; break; //Current ASE (%)
-    case 100: statusValue = lowByte(currentStatus.vss); break; //speed reading from the speed sensor
-    case 101: statusValue = highByte(currentStatus.vss); break;
-    case 102: statusValue = currentStatus.gear; break; 
-    case 103: statusValue = currentStatus.fuelPressure; break;
-    case 104: statusValue = currentStatus.oilPressure; break;
-    case 105: statusValue = currentStatus.wmiPW; break;
-    case 106: statusValue = currentStatus.status4; break; // wmiEmptyBit(0), vvt1Error(1), vvt2Error(2), fanStatus(3), UnusedBits(4:7)
-    case 107: statusValue = (int8_t)currentStatus.vvt2Angle; break;
-    case 108: statusValue = currentStatus.vvt2TargetAngle; break;
-    case 109: statusValue = currentStatus.vvt2Duty; break;
-    case 110: statusValue = currentStatus.outputsStatus; break;
-    case 111: statusValue = (byte)(currentStatus.fuelTemp + CALIBRATION_TEMPERATURE_OFFSET); break; //Fuel temperature from flex sensor
-    case 112: statusValue = currentStatus.fuelTempCorrection; break; //Fuel temperature Correction (%)
-    case 113: statusValue = currentStatus.VE1; break; //VE 1 (%)
-    case 114: statusValue = currentStatus.VE2; break; //VE 2 (%)
-    case 115: statusValue = currentStatus.advance1; break; //advance 1 
-    case 116: statusValue = currentStatus.advance2; break; //advance 2 
-    case 117: statusValue = currentStatus.nitrous_status; break;
-    case 118: statusValue = currentStatus.TS_SD_Status; break; //SD card status
-    case 119: statusValue = lowByte(currentStatus.EMAP); break; //2 bytes for EMAP
-    case 120: statusValue = highByte(currentStatus.EMAP); break;
-    case 121: statusValue = currentStatus.fanDuty; break;
-    case 122: statusValue = currentStatus.airConStatus; break;
+    switch(byteNum)
+    {
+      case 3: statusValue = (byte)div100(currentStatus.dwell); break; //Dwell in ms * 10
+      case 16: statusValue = lowByte(currentStatus.AEamount); break; //acceleration enrichment (%). Not halved like the live data
+      case 22: statusValue = (uint8_t)(currentStatus.tpsDOT / 10); break; //TPS DOT
+      case 75: statusValue = currentStatus.launchCorrection; break;
+      case 88: statusValue = lowByte(currentStatus.injAngle); break; 
+      case 89: statusValue = highByte(currentStatus.injAngle); break; 
+      case 92: statusValue = (uint8_t)(currentStatus.mapDOT / 10); break; //rate of change of the map 
+      case 117: statusValue = currentStatus.nitrous_status; break;
+      default: statusValue = 0; break; //Beyond the end of the legacy packet
+    }
   }
 
   return statusValue;
@@ -504,12 +505,51 @@ bool is2ByteEntry(uint8_t key)
   return key == pgm_read_byte(&fsIntIndex[bot]);
 }
 
+/** 
+ * Makes the tooth log buffer that is currently being filled available to send, even though it is not full. This is used when the tuning software 
+ * has timed out waiting for a full buffer. The unused entries are padded: Tooth times are 0 and composite entries repeat the last time with no status bits. 
+ * Does nothing if a full buffer is already waiting to be sent.
+ */
+void readyToothLog(void)
+{
+  noInterrupts();
+  if(BIT_CHECK(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY))
+  {
+    interrupts();
+    return;
+  }
+  uint8_t buffer = toothHistoryBuffer;
+  unsigned int count = toothHistoryIndex;
+  toothHistoryBuffer = buffer ^ 1U;
+  toothHistoryIndex = 0;
+  BIT_SET(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
+  interrupts();
+
+  //The interrupts are now filling the other buffer, so this one can be padded safely
+  if(count == 0U) { compositeLogStartTime[buffer] = micros(); }
+  for(; count < TOOTH_LOG_SIZE; count++)
+  {
+    toothHistory[buffer][count] = 0;
+    compositeLogHistory[buffer][count] = 0;
+  }
+}
+
+/** 
+ * Resets both tooth log buffers at the start of a new tooth or composite log 
+ */
+static void resetToothLog(void)
+{
+  BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
+  toothHistoryIndex = 0U;
+  toothHistoryBuffer = 0U;
+  toothLogOverflows = 0U;
+}
+
 void startToothLogger(void)
 {
   currentStatus.toothLogEnabled = true;
   currentStatus.compositeTriggerUsed = 0U; //Safety first (Should never be required)
-  BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-  toothHistoryIndex = 0U;
+  resetToothLog();
 
   //Disconnect the standard interrupt and add the logger version
   detachInterrupt( digitalPinToInterrupt(pinTrigger) );
@@ -542,8 +582,7 @@ void startCompositeLogger(void)
 {
   currentStatus.compositeTriggerUsed = 2U;
   currentStatus.toothLogEnabled = false; //Safety first (Should never be required)
-  BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-  toothHistoryIndex = 0U;
+  resetToothLog();
 
   //Disconnect the standard interrupt and add the logger version
   detachInterrupt( digitalPinToInterrupt(pinTrigger) );
@@ -575,8 +614,7 @@ void startCompositeLoggerTertiary(void)
 {
   currentStatus.compositeTriggerUsed = 3U;
   currentStatus.toothLogEnabled = false; //Safety first (Should never be required)
-  BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-  toothHistoryIndex = 0U;
+  resetToothLog();
 
   //Disconnect the standard interrupt and add the logger version
   detachInterrupt( digitalPinToInterrupt(pinTrigger) );
@@ -603,8 +641,7 @@ void startCompositeLoggerCams(void)
 {
   currentStatus.compositeTriggerUsed = 4;
   currentStatus.toothLogEnabled = false; //Safety first (Should never be required)
-  BIT_CLEAR(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY);
-  toothHistoryIndex = 0;
+  resetToothLog();
 
   //Disconnect the standard interrupt and add the logger version
   if( (VSS_USES_RPM2() != true) && (FLEX_USES_RPM2() != true) )
@@ -10,21 +10,169 @@
 #define LOGGER_H
 
 #include "globals.h" // Needed for FPU_MAX_SIZE
+#include <stddef.h>
 
 #ifndef UNIT_TEST // Scope guard for unit testing
-  #define LOG_ENTRY_SIZE      127 /**< The size of the live data packet. This MUST match ochBlockSize setting in the ini file */
+  #define LOG_ENTRY_SIZE      129 /**< The size of the live data packet. This MUST match ochBlockSize setting in the ini file */
 #else
   #define LOG_ENTRY_SIZE      1 /**< The size of the live data packet. This MUST match ochBlockSize setting in the ini file */
 #endif
 
+/**
+ * The live data (Output channels) block in the exact byte layout that TunerStudio expects. 
+ * The offset of each field MUST match the output channels in the ini file and the total size MUST match ochBlockSize
+ * Multi byte fields are little endian, which is the native byte order of all supported boards.
+ * Values have the offsets and shifts expected by TunerStudio applied. They will not all be a 'human readable value'
+ */
+struct liveDataBlock {
+  uint8_t secl;                 //0 - Counter that increments each second. Used to track unexpected resets
+  uint8_t status1;              //1
+  uint8_t engine;               //2
+  uint8_t syncLossCounter;      //3
+  uint16_t MAP;                 //4
+  uint8_t IAT;                  //6 - Includes CALIBRATION_TEMPERATURE_OFFSET
+  uint8_t coolant;              //7 - Includes CALIBRATION_TEMPERATURE_OFFSET
+  uint8_t batCorrection;        //8
+  uint8_t battery10;            //9
+  uint8_t O2;                   //10
+  uint8_t egoCorrection;        //11
+  uint8_t iatCorrection;        //12
+  uint8_t wueCorrection;        //13
+  uint16_t RPM;                 //14
+  uint8_t AEamount;             //16 - Divided by 2 (Can exceed 255)
+  uint16_t corrections;         //17
+  uint8_t VE1;                  //19
+  uint8_t VE2;                  //20
+  uint8_t afrTarget;            //21
+  int16_t tpsDOT;               //22
+  int8_t advance;               //24
+  uint8_t TPS;                  //25
+  uint16_t loopsPerSecond;      //26 - Limited to 60000
+  uint16_t freeRAM;             //28
+  uint8_t boostTarget;          //30 - Divided by 2
+  uint8_t boostDuty;            //31 - Divided by 100
+  uint8_t spark;                //32
+  int16_t rpmDOT;               //33
+  uint8_t ethanolPct;           //35
+  uint8_t flexCorrection;       //36
+  int8_t flexIgnCorrection;     //37
+  uint8_t idleLoad;             //38
+  uint8_t testOutputs;          //39
+  uint8_t O2_2;                 //40
+  uint8_t baro;                 //41
+  uint16_t canin[16];           //42
+  uint8_t tpsADC;               //74
+  uint8_t nextError;            //75
+  uint16_t PW1;                 //76
+  uint16_t PW2;                 //78
+  uint16_t PW3;                 //80
+  uint16_t PW4;                 //82
+  uint8_t status3;              //84
+  uint8_t engineProtectStatus;  //85
+  int16_t fuelLoad;             //86
+  int16_t ignLoad;              //88
+  uint16_t dwell;               //90
+  uint8_t CLIdleTarget;         //92
+  int16_t mapDOT;               //93
+  int16_t vvt1Angle;            //95
+  uint8_t vvt1TargetAngle;      //97
+  uint8_t vvt1Duty;             //98
+  int16_t flexBoostCorrection;  //99
+  uint8_t baroCorrection;       //101
+  uint8_t VE;                   //102
+  uint8_t ASEValue;             //103
+  uint16_t vss;                 //104
+  uint8_t gear;                 //106
+  uint8_t fuelPressure;         //107
+  uint8_t oilPressure;          //108
+  uint8_t wmiPW;                //109
+  uint8_t status4;              //110
+  int16_t vvt2Angle;            //111
+  uint8_t vvt2TargetAngle;      //113
+  uint8_t vvt2Duty;             //114
+  uint8_t outputsStatus;        //115
+  uint8_t fuelTemp;             //116 - Includes CALIBRATION_TEMPERATURE_OFFSET
+  uint8_t fuelTempCorrection;   //117
+  int8_t advance1;              //118
+  int8_t advance2;              //119
+  uint8_t TS_SD_Status;         //120
+  int16_t EMAP;                 //121
+  uint8_t fanDuty;              //123
+  uint8_t airConStatus;         //124
+  uint16_t actualDwell;         //125
+  uint8_t toothLogOverflows;    //127 - Gaps in the tooth/composite log. Saturates at 255
+  uint8_t tuneBank;             //128 - Active tune bank (Bits 0-3), the number of banks the board has (Bits 4-6) and whether the bank tables have changed since TunerStudio read them (Bit 7). See tuneBanks.h
+} __attribute__((__packed__)); //The block is copied directly to the serial buffer, so there must be no padding
+
+static_assert(sizeof(liveDataBlock) == 129U, "Live data block must match ochBlockSize in the ini file");
+static_assert( (offsetof(liveDataBlock, RPM) == 14U) && (offsetof(liveDataBlock, canin) == 42U) && (offsetof(liveDataBlock, PW1) == 76U) && (offsetof(liveDataBlock, actualDwell) == 125U), "Live data block offsets must match the ini file");
+
+extern liveDataBlock liveData; /**< The most recent snapshot of the live data. Refreshed by updateLiveData() */
+
+//Types of the readable log fields. These values are the same as the MLG binary log field types so that they can be written to binary log headers directly
+#define LOG_FIELD_U08   0
+#define LOG_FIELD_S08   1
+#define LOG_FIELD_U16   2
+#define LOG_FIELD_S16   3
+#define LOG_FIELD_NONE  255 /**< Log index with no data. Always reads as 0 and is not included in binary logs */
+
+#define LOG_FIELD_COUNT         93 /**< The number of readable log fields. This is always smaller than the entry size due to some fields being 2 bytes */
+#define LOG_FIELD_UNITS_LENGTH  8
+
+/**
+ * Describes one of the readable log fields (As used by the SD card logs).
+ * Every field is read from the live data snapshot (@ref liveData), so adding a field only needs it to be in @ref liveDataBlock and a line added to the logFields table in logger.cpp.
+ * The human readable value of a field is (raw + transform) * scale
+ */
+struct logFieldDescriptor {
+  const char *name; //Field name. This is a PROGMEM string
+  uint8_t offset; //Byte offset of the field within liveDataBlock
+  uint8_t type; //LOG_FIELD_*
+  uint8_t digits; //Number of decimal places of the readable value
+  float scale;
+  int8_t transform;
+  char units[LOG_FIELD_UNITS_LENGTH];
+};
+
+bool isLiveDataLocked(void);
+void updateLiveData(void); //Callers outside of the serial comms must check isLiveDataLocked() first
+void updateLiveData(liveDataBlock &block); //Fills a separate snapshot, leaving liveData untouched
+void copyLiveData(byte *buffer, uint16_t offset, uint16_t length);
 byte getTSLogEntry(uint16_t byteNum);
-int16_t getReadableLogEntry(uint16_t logIndex);
+void getLogField(uint16_t logIndex, logFieldDescriptor &field);
+int32_t getLogFieldRaw(const logFieldDescriptor &field, const liveDataBlock &block = liveData);
+int16_t getReadableLogEntry(uint16_t logIndex, const liveDataBlock &block = liveData);
 #if defined(FPU_MAX_SIZE) && FPU_MAX_SIZE >= 32 //cppcheck-suppress misra-c2012-20.9
+  float getLogFieldValue(const logFieldDescriptor &field, const liveDataBlock &block = liveData);
   float getReadableFloatLogEntry(uint16_t logIndex);
 #endif
 uint8_t getLegacySecondarySerialLogEntry(uint16_t byteNum);
 bool is2ByteEntry(uint8_t key);
 
+#define TOOTH_LOG_LONG_FLAG   0x8000U //Tooth log times of 32.768ms or more are stored in units of 32uS with this bit set
+#define TOOTH_LOG_LONG_SHIFT  5U
+
+/** 
+ * Packs a tooth log time (uS) into 16 bits. Times below 32.768ms (Almost all teeth above cranking speed) are stored exactly. 
+ * Longer times are stored at 32uS resolution, up to ~1 second
+ */
+static inline uint16_t encodeToothLogTime(uint32_t time)
+{
+  if(time < TOOTH_LOG_LONG_FLAG) { return (uint16_t)time; }
+  uint32_t longTime = time >> TOOTH_LOG_LONG_SHIFT;
+  if(longTime > (TOOTH_LOG_LONG_FLAG - 1U)) { longTime = TOOTH_LOG_LONG_FLAG - 1U; }
+  return (uint16_t)(TOOTH_LOG_LONG_FLAG | longTime);
+}
+
+/** @brief Reverses encodeToothLogTime() */
+static inline uint32_t decodeToothLogTime(uint16_t value)
+{
+  if((value & TOOTH_LOG_LONG_FLAG) == 0U) { return value; }
+  return (uint32_t)(value & (TOOTH_LOG_LONG_FLAG - 1U)) << TOOTH_LOG_LONG_SHIFT;
+}
+
+void readyToothLog(void);
+
 void startToothLogger(void);
 void stopToothLogger(void);
 
@@ -2,6 +2,8 @@
 #include "page_crc.h"
 #include "pages.h"
 #include "table3d_axis_io.h"
+#include "utilities.h"
+#include "crc32_zeros.h"
 
 using pCrcCalc = uint32_t (FastCRC32::*)(const uint8_t *, const uint16_t, bool);
 
@@ -51,13 +53,16 @@ static inline uint32_t compute_table_crc(const page_iterator_t &entity, pCrcCalc
                 crcCalc);
 }
 
+// Feed a run of zero bytes into the CRC, continuing the calculation in crcCalc.
+// Used for padding in the middle of a page where the calculation must continue afterwards
 static inline uint32_t pad_crc(uint16_t padding, uint32_t crc, FastCRC32 &crcCalc)
 {
-    const uint8_t raw_value = 0u;
+    static const uint8_t zeros[16] = { 0 };
     while (padding>0)
     {
-        crc = crcCalc.crc32_upd(&raw_value, 1, false);
-        --padding;
+        uint16_t chunk = padding < sizeof(zeros) ? padding : sizeof(zeros);
+        crc = crcCalc.crc32_upd(zeros, chunk, false);
+        padding = padding - chunk;
     }
     return crc;
 }
@@ -84,7 +89,7 @@ static inline uint32_t compute_crc(const page_iterator_t &entity, pCrcCalc calcF
     }
 }
 
-uint32_t calculatePageCRC32(byte pageNum)
+static uint32_t computePageCRC32(byte pageNum)
 {
   FastCRC32 crcCalc;
   page_iterator_t entity = page_begin(pageNum);
@@ -97,5 +102,33 @@ uint32_t calculatePageCRC32(byte pageNum)
     crc = compute_crc(entity, &FastCRC32::crc32_upd /* Note that we are *updating* */, crcCalc);
     entity = advance(entity);
   }
-  return ~pad_crc(getPageSize(pageNum) - entity.size, crc, crcCalc);
+  return ~append_zeros_crc(getPageSize(pageNum) - entity.size, crc);
+}
+
+// Page 0 is unused, but is included so that the page number can be used directly as the index
+static uint32_t pageCrcCache[16];
+static volatile bool pageCrcValid[16]; // A byte per page so that invalidation is atomic, even from an interrupt
+
+uint32_t calculatePageCRC32(byte pageNum)
+{
+  if (pageNum >= _countof(pageCrcCache))
+  {
+    return computePageCRC32(pageNum);
+  }
+  if (!pageCrcValid[pageNum])
+  {
+    pageCrcValid[pageNum] = true; // Set before the calculation so that a change part way through is not lost
+    pageCrcCache[pageNum] = computePageCRC32(pageNum);
+  }
+  return pageCrcCache[pageNum];
+}
+
+void invalidatePageCRC(byte pageNum)
+{
+  if (pageNum < _countof(pageCrcValid)) { pageCrcValid[pageNum] = false; }
+}
+
+void invalidateAllPageCRCs(void)
+{
+  for (uint8_t page = 0; page < _countof(pageCrcValid); page++) { pageCrcValid[page] = false; }
 }
\ No newline at end of file
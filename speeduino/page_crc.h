@@ -2,6 +2,18 @@
 #include <Arduino.h>
 
 /*
- * Calculates and returns the CRC32 value of a given page of memory
+ * Returns the CRC32 value of a given page of memory.
+ * The CRC of each page is cached and only recalculated if the page has been invalidated since the last call
  */
-uint32_t calculatePageCRC32(byte pageNum /**< [in] The page number to compute CRC for. */);
\ No newline at end of file
+uint32_t calculatePageCRC32(byte pageNum /**< [in] The page number to compute CRC for. */);
+
+/*
+ * Marks the cached CRC of a page as stale. Must be called whenever a page is modified other than through setPageValue()/setPageValues() or writeConfig()
+ * Changes that are made during init don't need this, as the whole cache is cleared when init completes
+ */
+void invalidatePageCRC(byte pageNum /**< [in] The page number that has been modified. */);
+
+/*
+ * Marks the cached CRC of all pages as stale
+ */
+void invalidateAllPageCRCs(void);
\ No newline at end of file
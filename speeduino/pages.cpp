@@ -2,6 +2,9 @@
 #include "globals.h"
 #include "utilities.h"
 #include "table3d_axis_io.h"
+#include "page_crc.h"
+#include "storage.h"
+#include "tuneBanks.h"
 
 // Maps from virtual page "addresses" to addresses/bytes of real in memory entities
 //
@@ -26,6 +29,13 @@
 // Page sizes as defined in the .ini file
 constexpr const uint16_t PROGMEM ini_page_sizes[] = { 0, 128, 288, 288, 128, 288, 128, 240, 384, 192, 192, 288, 192, 128, 288, 256 };
 
+static constexpr uint16_t get_max_page_size(uint8_t pageNum = 0U)
+{
+  return pageNum >= _countof(ini_page_sizes) ? 0U : (ini_page_sizes[pageNum] > get_max_page_size(pageNum + 1U) ? ini_page_sizes[pageNum] : get_max_page_size(pageNum + 1U));
+}
+static_assert(get_max_page_size() <= MAX_PAGE_SIZE, "A page is larger than MAX_PAGE_SIZE");
+static_assert(_countof(ini_page_sizes) <= MAX_PAGE_COUNT, "There are more pages than MAX_PAGE_COUNT");
+
 // ========================= Table size calculations =========================
 // Note that these should be computed at compile time, assuming the correct
 // calling context.
@@ -194,6 +204,105 @@ inline void set_value(page_iterator_t &entity, byte value, uint16_t offset)
   }
 }
 
+// ========================= Entity range copy =========================
+
+// Tables store each row contiguously (Rows are in reverse order) so the values 
+// can be copied a row span at a time. The axes need converting, so are done per element.
+template<class table_t>
+static inline uint16_t table_value_index(uint16_t table_offset)
+{
+  constexpr uint16_t row_size = table_t::value_t::row_size;
+  constexpr uint16_t num_rows = table_t::value_t::num_rows;
+  return ((num_rows - 1U - (table_offset / row_size)) * row_size) + (table_offset % row_size);
+}
+
+template<class table_t>
+static inline uint16_t table_row_span(uint16_t table_offset, uint16_t length)
+{
+  uint16_t span = table_t::value_t::row_size - (table_offset % table_t::value_t::row_size);
+  return span < length ? span : length;
+}
+
+template<class table_t>
+static void get_table_values(table_t *pTable, uint16_t table_offset, byte *buffer, uint16_t length)
+{
+  while ( (length > 0U) && (table_offset < get_table_value_end<table_t>()) )
+  {
+    uint16_t span = table_row_span<table_t>(table_offset, length);
+    memcpy(buffer, &pTable->values.values[table_value_index<table_t>(table_offset)], span);
+    buffer += span;
+    table_offset += span;
+    length -= span;
+  }
+  while (length > 0U)
+  {
+    *buffer = *offset_to_table<table_t>(pTable, table_offset);
+    buffer++;
+    table_offset++;
+    length--;
+  }
+}
+
+template<class table_t>
+static void set_table_values(table_t *pTable, uint16_t table_offset, const byte *buffer, uint16_t length)
+{
+  while ( (length > 0U) && (table_offset < get_table_value_end<table_t>()) )
+  {
+    uint16_t span = table_row_span<table_t>(table_offset, length);
+    memcpy(&pTable->values.values[table_value_index<table_t>(table_offset)], buffer, span);
+    buffer += span;
+    table_offset += span;
+    length -= span;
+  }
+  while (length > 0U)
+  {
+    offset_to_table<table_t>(pTable, table_offset) = *buffer;
+    buffer++;
+    table_offset++;
+    length--;
+  }
+  invalidate_cache(&pTable->get_value_cache);
+}
+
+// Copy a range that lies entirely within a single entity
+static void get_entity_values(const page_iterator_t &entity, uint16_t offset, byte *buffer, uint16_t length)
+{
+  if (Raw==entity.type)
+  {
+    memcpy(buffer, (const byte*)entity.pData + (offset-entity.start), length);
+  }
+  else if (Table==entity.type)
+  {
+    #define CTA_GET_TABLE_VALUES(size, xDomain, yDomain, pTable, offset, buffer, length) \
+        get_table_values<TABLE3D_TYPENAME_BASE(size, xDomain, yDomain)>((TABLE3D_TYPENAME_BASE(size, xDomain, yDomain)*)pTable, offset, buffer, length); break;
+    #define CTA_GET_TABLE_VALUES_DEFAULT ({ memset(buffer, 0, length); })
+    CONCRETE_TABLE_ACTION(entity.table_key, CTA_GET_TABLE_VALUES, CTA_GET_TABLE_VALUES_DEFAULT, entity.pData, (offset-entity.start), buffer, length);
+  }
+  else
+  {
+    memset(buffer, 0, length);
+  }
+}
+
+static void set_entity_values(const page_iterator_t &entity, uint16_t offset, const byte *buffer, uint16_t length)
+{
+  if (Raw==entity.type)
+  {
+    memcpy((byte*)entity.pData + (offset-entity.start), buffer, length);
+  }
+  else if (Table==entity.type)
+  {
+    #define CTA_SET_TABLE_VALUES(size, xDomain, yDomain, pTable, offset, buffer, length) \
+        set_table_values<TABLE3D_TYPENAME_BASE(size, xDomain, yDomain)>((TABLE3D_TYPENAME_BASE(size, xDomain, yDomain)*)pTable, offset, buffer, length); break;
+    #define CTA_SET_TABLE_VALUES_DEFAULT ({ })
+    CONCRETE_TABLE_ACTION(entity.table_key, CTA_SET_TABLE_VALUES, CTA_SET_TABLE_VALUES_DEFAULT, entity.pData, (offset-entity.start), buffer, length);
+  }
+  else
+  {
+    // No entity - nothing to write to
+  }
+}
+
 // ========================= Static page size computation & checking ===================
 
 // This will fail AND print the page number and required size
@@ -257,6 +366,7 @@ inline const page_iterator_t create_table_iterator(void *pTable, table_type_t ke
 }
 
 // If the offset is in range, create a Table entity_t
+// The table size only depends on the table type, so the next entity start is still a constant when pTable is only known at runtime (Eg The tune bank tables)
 #define CHECK_TABLE(pageNum, offset, pTable, entityNum) \
   if (offset < ENTITY_START_VAR(entityNum)+get_table_axisy_end(pTable)) \
   { \
@@ -264,7 +374,7 @@ inline const page_iterator_t create_table_iterator(void *pTable, table_type_t ke
                                   pageNum, \
                                   ENTITY_START_VAR(entityNum), get_table_axisy_end(pTable)); \
   } \
-  DECLARE_NEXT_ENTITY_START(entityNum, get_table_axisy_end(pTable))
+  DECLARE_NEXT_ENTITY_START(entityNum, get_table_axisy_end((decltype(pTable))nullptr))
 
 // ========================= Raw memory block processing  ===================
 
@@ -307,19 +417,19 @@ page_iterator_t map_page_offset_to_entity(uint8_t pageNumber, uint16_t offset)
 
     case veMapPage:
     {
-      CHECK_TABLE(veMapPage, offset, &fuelTable, 0)
+      CHECK_TABLE(veMapPage, offset, pFuelTable, 0)
       END_OF_PAGE(veMapPage, 1)
     }
 
     case ignMapPage: //Ignition settings page (Page 2)
     {
-      CHECK_TABLE(ignMapPage, offset, &ignitionTable, 0)
+      CHECK_TABLE(ignMapPage, offset, pIgnitionTable, 0)
       END_OF_PAGE(ignMapPage, 1)
     }
 
     case afrMapPage: //Air/Fuel ratio target settings page
     {
-      CHECK_TABLE(afrMapPage, offset, &afrTable, 0)
+      CHECK_TABLE(afrMapPage, offset, pAfrTable, 0)
       END_OF_PAGE(afrMapPage, 1)
     }
 
@@ -431,6 +541,8 @@ void setPageValue(byte pageNum, uint16_t offset, byte value)
   page_iterator_t entity = map_page_offset_to_entity(pageNum, offset);
 
   set_value(entity, value, offset);
+  invalidatePageCRC(pageNum);
+  setPageDirty(pageNum, offset, 1U);
 }
 
 byte getPageValue(byte pageNum, uint16_t offset)
@@ -440,6 +552,44 @@ byte getPageValue(byte pageNum, uint16_t offset)
   return get_value(entity, offset);
 }
 
+// The entity is only resolved once per entity spanned by the range, rather than once per byte
+void getPageValues(byte pageNum, uint16_t offset, byte *buffer, uint16_t length)
+{
+  page_iterator_t entity = map_page_offset_to_entity(pageNum, offset);
+  while (length > 0U)
+  {
+    if (End==entity.type)
+    {
+      memset(buffer, 0, length);
+      break;
+    }
+    uint16_t entityEnd = entity.start + entity.size;
+    uint16_t span = (entityEnd - offset) < length ? (entityEnd - offset) : length;
+    get_entity_values(entity, offset, buffer, span);
+    buffer += span;
+    offset += span;
+    length -= span;
+    entity = advance(entity);
+  }
+}
+
+void setPageValues(byte pageNum, uint16_t offset, const byte *buffer, uint16_t length)
+{
+  invalidatePageCRC(pageNum);
+  setPageDirty(pageNum, offset, length);
+  page_iterator_t entity = map_page_offset_to_entity(pageNum, offset);
+  while ( (length > 0U) && (End!=entity.type) )
+  {
+    uint16_t entityEnd = entity.start + entity.size;
+    uint16_t span = (entityEnd - offset) < length ? (entityEnd - offset) : length;
+    set_entity_values(entity, offset, buffer, span);
+    buffer += span;
+    offset += span;
+    length -= span;
+    entity = advance(entity);
+  }
+}
+
 // Support iteration over a pages entities.
 // Check for entity.type==End
 page_iterator_t page_begin(byte pageNum)
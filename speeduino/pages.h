@@ -2,6 +2,9 @@
 #include <Arduino.h>
 #include "table3d.h"
 
+#define MAX_PAGE_COUNT  16U  //Upper limit of getPageCount(). Checked in pages.cpp
+#define MAX_PAGE_SIZE   384U //Upper limit of getPageSize(). Checked in pages.cpp
+
 /**
  * Page count, as defined in the INI file
  */
@@ -46,6 +49,28 @@ void setPageValue(  byte pageNum,       /**< [in] The page number to retrieve da
                     byte value          /**< [in] The new value */
                     );
 
+// ============================== Page range access ==========================
+
+/**
+ * Gets a range of values from a page, with data aligned as per the ini file.
+ * Equivalent to calling getPageValue() for each byte, but much faster
+ */
+void getPageValues( byte pageNum,       /**< [in] The page number to retrieve data from. */
+                    uint16_t offset,    /**< [in] The address in the page of the first byte. This is as per the page definition in the ini. */
+                    byte *buffer,       /**< [out] The buffer to copy the values into. Must be at least length bytes */
+                    uint16_t length     /**< [in] The number of bytes to copy */
+                    );
+
+/**
+ * Sets a range of values in a page, with data aligned as per the ini file.
+ * Equivalent to calling setPageValue() for each byte, but much faster
+ */
+void setPageValues( byte pageNum,       /**< [in] The page number to update. */
+                    uint16_t offset,    /**< [in] The address in the page of the first byte. This is as per the page definition in the ini. */
+                    const byte *buffer, /**< [in] The new values */
+                    uint16_t length     /**< [in] The number of bytes to copy */
+                    );
+
 // ============================== Page Iteration ==========================
 
 // A logical TS page is actually multiple in memory entities. Allow iteration
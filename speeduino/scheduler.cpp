@@ -29,6 +29,7 @@ A full copy of the license may be found in the projects root directory
 #include "scheduledIO.h"
 #include "timers.h"
 #include "schedule_calcs.h"
+#include "knock.h"
 
 FuelSchedule fuelSchedule1(FUEL1_COUNTER, FUEL1_COMPARE, FUEL1_TIMER_DISABLE, FUEL1_TIMER_ENABLE);
 FuelSchedule fuelSchedule2(FUEL2_COUNTER, FUEL2_COMPARE, FUEL2_TIMER_DISABLE, FUEL2_TIMER_ENABLE);
@@ -444,7 +445,7 @@ void fuelSchedule8Interrupt() //Most ARM chips can simply call a function
 // Shared ISR function for all ignition timers.
 // This is completely inlined into the ISR - there is no function call
 // overhead.
-static inline __attribute__((always_inline)) void ignitionScheduleISR(IgnitionSchedule &schedule)
+static inline __attribute__((always_inline)) void ignitionScheduleISR(IgnitionSchedule &schedule, uint8_t channel)
 {
   if (schedule.Status == PENDING) //Check to see if this schedule is turn on
   {
@@ -460,7 +461,9 @@ static inline __attribute__((always_inline)) void ignitionScheduleISR(IgnitionSc
     schedule.Status = OFF; //Turn off the schedule
     schedule.endScheduleSetByDecoder = false;
     ignitionCount = ignitionCount + 1; //Increment the ignition counter
-    currentStatus.actualDwell = DWELL_AVERAGE( (micros() - schedule.startTime) );
+    uint32_t endTime = micros();
+    currentStatus.actualDwell = DWELL_AVERAGE( (endTime - schedule.startTime) );
+    knockIgnitionEvent(channel, endTime); //Knock window for this channel is timed from here
 
     //If there is a next schedule queued up, activate it
     if(schedule.hasNextSchedule == true)
@@ -487,7 +490,7 @@ ISR(TIMER5_COMPA_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule1Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule1);
+    ignitionScheduleISR(ignitionSchedule1, 0);
   }
 
 #if IGN_CHANNELS >= 2
@@ -497,7 +500,7 @@ ISR(TIMER5_COMPB_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule2Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule2);
+    ignitionScheduleISR(ignitionSchedule2, 1);
   }
 #endif
 
@@ -508,7 +511,7 @@ ISR(TIMER5_COMPC_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule3Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule3);
+    ignitionScheduleISR(ignitionSchedule3, 2);
   }
 #endif
 
@@ -519,7 +522,7 @@ ISR(TIMER4_COMPA_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule4Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule4);
+    ignitionScheduleISR(ignitionSchedule4, 3);
   }
 #endif
 
@@ -530,7 +533,7 @@ ISR(TIMER4_COMPC_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule5Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule5);
+    ignitionScheduleISR(ignitionSchedule5, 4);
   }
 #endif
 
@@ -541,7 +544,7 @@ ISR(TIMER4_COMPB_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule6Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule6);
+    ignitionScheduleISR(ignitionSchedule6, 5);
   }
 #endif
 
@@ -552,7 +555,7 @@ ISR(TIMER3_COMPC_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule7Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule7);
+    ignitionScheduleISR(ignitionSchedule7, 6);
   }
 #endif
 
@@ -563,7 +566,7 @@ ISR(TIMER3_COMPB_vect) //cppcheck-suppress misra-c2012-8.2
 void ignitionSchedule8Interrupt(void) //Most ARM chips can simply call a function
 #endif
   {
-    ignitionScheduleISR(ignitionSchedule8);
+    ignitionScheduleISR(ignitionSchedule8, 7);
   }
 #endif
 
@@ -645,3 +648,46 @@ void disablePendingIgnSchedule(byte channel)
   }
   interrupts();
 }
+
+/** Check whether a schedule has an edge (Start or end) within the given number of timer ticks, or has only just had one
+ * The compare register always holds the next edge of a PENDING or RUNNING schedule. An edge that has just passed wraps around to a very large number of ticks
+ */
+template <class schedule_t>
+static inline __attribute__((always_inline)) bool isScheduleEdgeNear(const schedule_t &schedule, COMPARE_TYPE window)
+{
+  if( (schedule.Status != PENDING) && (schedule.Status != RUNNING) ) { return false; }
+  COMPARE_TYPE ticks = (COMPARE_TYPE)(schedule.compare - schedule.counter);
+  return (ticks <= window) || (ticks >= (COMPARE_TYPE)(0U - window));
+}
+
+/** Check whether any fuel or ignition schedule is due to fire within the given number of timer ticks.
+ * Used to hold off background work that runs in an interrupt (Eg EEPROM writes on AVR) so that it never delays a schedule interrupt
+ * @param window - Number of timer ticks (See uS_TO_TIMER_COMPARE())
+ */
+bool isScheduleEventDue(COMPARE_TYPE window)
+{
+  bool isDue = isScheduleEdgeNear(fuelSchedule1, window) || isScheduleEdgeNear(fuelSchedule2, window) || isScheduleEdgeNear(fuelSchedule3, window) || isScheduleEdgeNear(fuelSchedule4, window)
+            || isScheduleEdgeNear(ignitionSchedule1, window) || isScheduleEdgeNear(ignitionSchedule2, window) || isScheduleEdgeNear(ignitionSchedule3, window) || isScheduleEdgeNear(ignitionSchedule4, window) || isScheduleEdgeNear(ignitionSchedule5, window);
+#if (INJ_CHANNELS >= 5)
+  isDue = isDue || isScheduleEdgeNear(fuelSchedule5, window);
+#endif
+#if (INJ_CHANNELS >= 6)
+  isDue = isDue || isScheduleEdgeNear(fuelSchedule6, window);
+#endif
+#if (INJ_CHANNELS >= 7)
+  isDue = isDue || isScheduleEdgeNear(fuelSchedule7, window);
+#endif
+#if (INJ_CHANNELS >= 8)
+  isDue = isDue || isScheduleEdgeNear(fuelSchedule8, window);
+#endif
+#if IGN_CHANNELS >= 6
+  isDue = isDue || isScheduleEdgeNear(ignitionSchedule6, window);
+#endif
+#if IGN_CHANNELS >= 7
+  isDue = isDue || isScheduleEdgeNear(ignitionSchedule7, window);
+#endif
+#if IGN_CHANNELS >= 8
+  isDue = isDue || isScheduleEdgeNear(ignitionSchedule8, window);
+#endif
+  return isDue;
+}
@@ -57,6 +57,7 @@ void disablePendingFuelSchedule(byte channel);
 void disablePendingIgnSchedule(byte channel);
 
 void refreshIgnitionSchedule1(unsigned long timeToEnd);
+bool isScheduleEventDue(COMPARE_TYPE window);
 
 //The ARM cores use separate functions for their ISRs
 #if defined(ARDUINO_ARCH_STM32) || defined(CORE_TEENSY)
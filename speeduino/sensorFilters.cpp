@@ -0,0 +1,108 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Filter bank for the analog sensor inputs. See sensorFilters.h
+ */
+#include "sensorFilters.h"
+#include "sensors.h"
+
+struct adcFilterState
+{
+  uint16_t history[ADCFILTER_HISTORY_SIZE]; //Ring buffer of the most recent raw readings
+  uint8_t index; //The position in history that the next reading will be stored at
+  uint8_t count; //Number of valid readings in history
+};
+
+//The state of all channels is held in a single block
+static adcFilterState filterStates[ADCFILTER_CHANNEL_COUNT];
+
+void resetADCFilters(void)
+{
+  for(uint8_t x = 0; x < ADCFILTER_CHANNEL_COUNT; x++)
+  {
+    filterStates[x].index = 0;
+    filterStates[x].count = 0;
+  }
+}
+
+/** Returns a reading from the history of a channel. 0 is the most recent reading, 1 the one before that etc. */
+static inline uint16_t getHistory(const adcFilterState &state, uint8_t age)
+{
+  uint8_t position = state.index + (ADCFILTER_HISTORY_SIZE - 1U) - age;
+  if(position >= ADCFILTER_HISTORY_SIZE) { position -= ADCFILTER_HISTORY_SIZE; }
+  return state.history[position];
+}
+
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+  if(a > b) { uint16_t temp = a; a = b; b = temp; }
+  if(b > c) { b = c; }
+  return (a > b) ? a : b;
+}
+
+static uint16_t median5(const adcFilterState &state)
+{
+  uint16_t values[5];
+  for(uint8_t x = 0; x < 5U; x++) { values[x] = getHistory(state, x); }
+
+  //Only the lower 3 values need to be in order to find the median
+  for(uint8_t x = 0; x < 3U; x++)
+  {
+    uint8_t minIndex = x;
+    for(uint8_t y = x + 1U; y < 5U; y++)
+    {
+      if(values[y] < values[minIndex]) { minIndex = y; }
+    }
+    uint16_t temp = values[x];
+    values[x] = values[minIndex];
+    values[minIndex] = temp;
+  }
+  return values[2];
+}
+
+/**
+ * @brief Applies the selected filter to a new reading on one of the analog channels
+ * 
+ * Until enough readings have been taken to fill the selected filter, the reading is passed straight through to the IIR filter.
+ * 
+ * @param channel The analog channel the reading is from
+ * @param filterType One of the ADCFILTER_TYPE_* values
+ * @param input The new raw reading
+ * @param alpha The IIR filter alpha value (0-240). 0 disables the IIR filter
+ * @param prior The previous filtered value
+ * @return The new filtered value
+ */
+uint16_t filterADC(adcFilterChannel_t channel, byte filterType, uint16_t input, byte alpha, uint16_t prior)
+{
+  if(filterType != ADCFILTER_TYPE_IIR)
+  {
+    adcFilterState &state = filterStates[channel];
+    state.history[state.index] = input;
+    state.index++;
+    if(state.index >= ADCFILTER_HISTORY_SIZE) { state.index = 0; }
+    if(state.count < ADCFILTER_HISTORY_SIZE) { state.count++; }
+
+    switch(filterType)
+    {
+      case ADCFILTER_TYPE_MEDIAN3:
+        if(state.count >= 3U) { input = median3(getHistory(state, 0), getHistory(state, 1), getHistory(state, 2)); }
+        break;
+
+      case ADCFILTER_TYPE_MEDIAN5:
+        if(state.count >= 5U) { input = median5(state); }
+        break;
+
+      case ADCFILTER_TYPE_AVERAGE4:
+        if(state.count >= 4U) { input = ((uint32_t)getHistory(state, 0) + getHistory(state, 1) + getHistory(state, 2) + getHistory(state, 3)) >> 2; }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return ADC_FILTER(input, alpha, prior);
+}
@@ -0,0 +1,35 @@
+#ifndef SENSOR_FILTERS_H
+#define SENSOR_FILTERS_H
+
+#include "globals.h"
+
+/** @file
+ * Filter bank for the analog sensor inputs.
+ * Each channel keeps a short history of its raw readings so that spikes can be rejected (Median) or smoothed (Moving average) before the low pass IIR filter (ADC_FILTER) is applied.
+ */
+
+// Filter types that can be selected for each channel. The IIR filter is always applied after these
+#define ADCFILTER_TYPE_IIR       0 //IIR filter only (Original behaviour)
+#define ADCFILTER_TYPE_MEDIAN3   1 //Median of the last 3 readings. Rejects single sample spikes
+#define ADCFILTER_TYPE_MEDIAN5   2 //Median of the last 5 readings. Rejects spikes up to 2 samples long
+#define ADCFILTER_TYPE_AVERAGE4  3 //Average of the last 4 readings
+
+#define ADCFILTER_HISTORY_SIZE   5 //Must be at least as large as the largest filter above
+
+enum adcFilterChannel_t : uint8_t {
+  ADCFILTER_CHANNEL_TPS,
+  ADCFILTER_CHANNEL_CLT,
+  ADCFILTER_CHANNEL_IAT,
+  ADCFILTER_CHANNEL_O2,
+  ADCFILTER_CHANNEL_O2_2,
+  ADCFILTER_CHANNEL_BAT,
+  ADCFILTER_CHANNEL_MAP,
+  ADCFILTER_CHANNEL_EMAP,
+  ADCFILTER_CHANNEL_BARO,
+  ADCFILTER_CHANNEL_COUNT, //Must be last
+};
+
+void resetADCFilters(void);
+uint16_t filterADC(adcFilterChannel_t channel, byte filterType, uint16_t input, byte alpha, uint16_t prior);
+
+#endif // SENSOR_FILTERS_H
@@ -7,6 +7,7 @@ A full copy of the license may be found in the projects root directory
  * Read sensors with appropriate timing / scheduling.
  */
 #include "sensors.h"
+#include "sensorFilters.h"
 #include "crankMaths.h"
 #include "globals.h"
 #include "maths.h"
@@ -19,6 +20,7 @@ A full copy of the license may be found in the projects root directory
 #include "decoders.h"
 #include "auxiliaries.h"
 #include "utilities.h"
+#include "schedule_calcs.h"
 #include BOARD_H
 
 uint32_t MAPcurRev; //Tracks which revolution we're sampling on
@@ -36,8 +38,31 @@ volatile byte flexCounter = 0;
 volatile unsigned long flexStartTime;
 volatile unsigned long flexPulseWidth;
 
-volatile byte knockCounter = 0;
-volatile uint16_t knockAngle;
+#if defined(MAP_SYNC_AVAILABLE)
+//Crank angle synchronous MAP sampling. The decoder calls mapSyncTooth() on every tooth and a MAP sample is taken on the first tooth at or after each of the angles below
+#define MAP_SYNC_MAX_SAMPLES (IGN_CHANNELS * 4U) //Up to 4 samples per cylinder
+static uint16_t mapSyncAngles[MAP_SYNC_MAX_SAMPLES]; //Sorted list of the crank angles that MAP samples are taken at
+static volatile byte mapSyncAngleCount = 0; //Number of valid entries in mapSyncAngles
+static volatile byte mapSyncNextIndex = 0; //The next entry in mapSyncAngles that is waiting to be sampled in this cycle
+static volatile int16_t mapSyncLastAngle = 0; //The crank angle of the previous tooth. Used to detect the start of a new cycle
+static volatile uint32_t mapSyncRunningValue = 0; //Sum of the samples taken so far in this cycle
+static volatile byte mapSyncRunningCount = 0;
+static volatile uint32_t mapSyncCycleValue = 0; //Sum of the samples from the last completed cycle
+static volatile byte mapSyncCycleCount = 0; //Number of samples from the last completed cycle. 0 when the cycle result has already been used
+static uint16_t mapSyncAngleMax = 0; //The value of CRANK_ANGLE_MAX_IGN that mapSyncAngles was calculated for
+#endif
+
+//ADC indexed lookups of the CLT, IAT and O2 calibration tables. These are regenerated from the calibration tables by updateCalibrationLookups() whenever the calibration changes so that converting a reading doesn't require a table2D interpolation
+#if defined(CORE_AVR)
+  #define CALIBRATION_LOOKUP_SHIFT 3U //AVR doesn't have the RAM for a full lookup. Store every 8th ADC value and interpolate between them
+  #define CALIBRATION_LOOKUP_SIZE ((1024U >> CALIBRATION_LOOKUP_SHIFT) + 1U) //Extra entry is the end point for interpolating the top ADC values
+#else
+  #define CALIBRATION_LOOKUP_SHIFT 0U
+  #define CALIBRATION_LOOKUP_SIZE 1024U
+#endif
+static uint8_t cltCalibrationLookup[CALIBRATION_LOOKUP_SIZE]; //Offset by CALIBRATION_TEMPERATURE_OFFSET, same as the calibration table
+static uint8_t iatCalibrationLookup[CALIBRATION_LOOKUP_SIZE]; //Offset by CALIBRATION_TEMPERATURE_OFFSET, same as the calibration table
+static uint8_t o2CalibrationLookup[CALIBRATION_LOOKUP_SIZE];
 
 //These variables are used for tracking the number of running sensors values that appear to be errors. Once a threshold is reached, the sensor reading will go to default value and assume the sensor is faulty
 byte mapErrorCount = 0;
@@ -45,6 +70,7 @@ byte mapErrorCount = 0;
 //byte cltErrorCount = 0; Not used
 
 static inline void validateMAP(void);
+static inline void instantaneousEMAPReading(void);
 
 #if defined(ANALOG_ISR)
 static volatile uint16_t AnChannel[16];
@@ -126,6 +152,7 @@ void initialiseADC(void)
   MAPcurRev = 0;
   MAPcount = 0;
   MAPrunningValue = 0;
+  resetADCFilters();
 
   //The following checks the aux inputs and initialises pins if required
   auxIsEnabled = false;
@@ -233,45 +260,294 @@ void instanteneousMAPReading(void)
   #if defined(ANALOG_ISR_MAP)
     tempReading = AnChannel[pinMAP-A0];
   #else
-    tempReading = analogRead(pinMAP);
-    tempReading = analogRead(pinMAP);
+    tempReading = readADC(pinMAP);
+    tempReading = readADC(pinMAP);
   #endif
   //Error checking
   if( (tempReading >= VALID_MAP_MAX) || (tempReading <= VALID_MAP_MIN) ) { mapErrorCount += 1; }
   else { mapErrorCount = 0; }
 
   //During startup a call is made here to get the baro reading. In this case, we can't apply the ADC filter
-  if(currentStatus.initialisationComplete == true) { currentStatus.mapADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC); } //Very weak filter
+  if(currentStatus.initialisationComplete == true) { currentStatus.mapADC = filterADC(ADCFILTER_CHANNEL_MAP, configPage15.adcFilterTypeMAP, tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC); } //Very weak filter
   else { currentStatus.mapADC = tempReading; } //Baro reading (No filter)
 
   currentStatus.MAP = fastMap10Bit(currentStatus.mapADC, configPage2.mapMin, configPage2.mapMax); //Get the current MAP value
   if(currentStatus.MAP < 0) { currentStatus.MAP = 0; } //Sanity check
   
   //Repeat for EMAP if it's enabled
+  instantaneousEMAPReading();
+}
+
+static inline void instantaneousEMAPReading(void)
+{
+  unsigned int tempReading;
   if(configPage6.useEMAP == true)
   {
     #if defined(ANALOG_ISR_MAP)
       tempReading = AnChannel[pinEMAP-A0];
     #else
-      tempReading = analogRead(pinEMAP);
-      tempReading = analogRead(pinEMAP);
+      tempReading = readADC(pinEMAP);
+      tempReading = readADC(pinEMAP);
     #endif
 
     //Error check
     if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
       {
-        currentStatus.EMAPADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_MAP, currentStatus.EMAPADC);
+        currentStatus.EMAPADC = filterADC(ADCFILTER_CHANNEL_EMAP, configPage15.adcFilterTypeMAP, tempReading, configPage4.ADCFILTER_MAP, currentStatus.EMAPADC);
       }
     else { mapErrorCount += 1; }
     currentStatus.EMAP = fastMap10Bit(currentStatus.EMAPADC, configPage2.EMAPMin, configPage2.EMAPMax);
     if(currentStatus.EMAP < 0) { currentStatus.EMAP = 0; } //Sanity check
   }
+}
+
+#if defined(MAP_SYNC_AVAILABLE)
+/**
+ * Builds the sorted list of crank angles that the synchronous MAP samples are taken at.
+ * Each ignition channel (Ie cylinder or cylinder pair) gets configPage15.mapSyncSamples+1 samples, the first being mapSyncAngle degrees after that cylinders TDC.
+ * This must be rerun whenever CRANK_ANGLE_MAX_IGN changes (Eg between half and full sync) as the angles are wrapped into the current cycle length.
+ */
+static void calculateMAPSyncAngles(void)
+{
+  uint16_t newAngles[MAP_SYNC_MAX_SAMPLES];
+  byte newCount = 0;
+
+  for(byte channel = 0; channel < maxIgnOutputs; channel++)
+  {
+    int16_t channelDegrees = 0;
+    switch(channel)
+    {
+      case 0: channelDegrees = channel1IgnDegrees; break;
+      case 1: channelDegrees = channel2IgnDegrees; break;
+      case 2: channelDegrees = channel3IgnDegrees; break;
+      case 3: channelDegrees = channel4IgnDegrees; break;
+#if IGN_CHANNELS >= 5
+      case 4: channelDegrees = channel5IgnDegrees; break;
+#endif
+#if IGN_CHANNELS >= 6
+      case 5: channelDegrees = channel6IgnDegrees; break;
+#endif
+#if IGN_CHANNELS >= 7
+      case 6: channelDegrees = channel7IgnDegrees; break;
+#endif
+#if IGN_CHANNELS >= 8
+      case 7: channelDegrees = channel8IgnDegrees; break;
+#endif
+      default: continue;
+    }
+
+    for(byte sample = 0; sample <= configPage15.mapSyncSamples; sample++)
+    {
+      int16_t angle = channelDegrees + (int16_t)configPage15.mapSyncAngle + ((int16_t)sample * configPage15.mapSyncSpacing);
+      while(angle >= CRANK_ANGLE_MAX_IGN) { angle -= CRANK_ANGLE_MAX_IGN; }
+
+      //Insertion sort, dropping any duplicates (These occur when wasted spark outputs wrap onto each other)
+      byte pos = 0;
+      while( (pos < newCount) && (newAngles[pos] < (uint16_t)angle) ) { pos++; }
+      if( (pos < newCount) && (newAngles[pos] == (uint16_t)angle) ) { continue; }
+      for(byte x = newCount; x > pos; x--) { newAngles[x] = newAngles[x-1]; }
+      newAngles[pos] = angle;
+      newCount++;
+    }
+  }
+
+  noInterrupts();
+  for(byte x = 0; x < newCount; x++) { mapSyncAngles[x] = newAngles[x]; }
+  mapSyncAngleCount = newCount;
+  mapSyncNextIndex = 0;
+  mapSyncLastAngle = 0;
+  mapSyncRunningValue = 0;
+  mapSyncRunningCount = 0;
+  mapSyncCycleCount = 0;
+  interrupts();
+
+  mapSyncAngleMax = CRANK_ANGLE_MAX_IGN;
+}
+
+/**
+ * Adds a MAP sample to the running total of the current cycle. Called from within the trigger interrupt or, on AVR, the ADC interrupt
+ */
+static inline void addMAPSyncSample(uint16_t tempReading)
+{
+  if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
+  {
+    mapSyncRunningValue += tempReading;
+    mapSyncRunningCount++;
+  }
+}
+
+/**
+ * Hands the samples from the cycle that just finished over to readMAP() and starts a new cycle
+ */
+static inline void completeMAPSyncCycle(void)
+{
+  mapSyncCycleValue = mapSyncRunningValue;
+  mapSyncCycleCount = mapSyncRunningCount;
+  mapSyncRunningValue = 0;
+  mapSyncRunningCount = 0;
+}
+
+#if !defined(ANALOG_ISR)
+/*
+ * On AVR a conversion takes around 13uS, which is too long to wait for inside the trigger interrupt. The trigger interrupt only starts the MAP conversion and the
+ * result is collected by the ADC interrupt below. Main loop reads go through readADC() so that they don't change the ADC channel while a MAP conversion is running.
+ */
+static volatile bool mapSyncConversionActive = false; //A MAP conversion started by the trigger interrupt is running
+static volatile bool mapSyncConversionPending = false; //A MAP sample is due but the ADC was busy. It is started as soon as the ADC is free
+static volatile bool mapSyncCycleEndPending = false; //The cycle ended before its last sample was converted. The cycle is handed over once that sample is added
+static volatile bool adcMainLoopActive = false; //The main loop is part way through an analogRead()
+
+/**
+ * Starts a conversion of the MAP channel, or marks it as pending if the ADC is in use. Must be called with interrupts disabled
+ */
+static inline void startMAPSyncConversion(void)
+{
+  if( mapSyncConversionActive || adcMainLoopActive ) { mapSyncConversionPending = true; return; }
+
+  mapSyncConversionPending = false;
+  mapSyncConversionActive = true;
+  byte channel = pinMAP - A0;
+  #if defined(MUX5)
+    if( BIT_CHECK(channel, 3) ) { BIT_SET(ADCSRB, MUX5); }
+    else { BIT_CLEAR(ADCSRB, MUX5); }
+  #endif
+  ADMUX = ADMUX_DEFAULT_CONFIG | (channel & 0x07);
+  ADCSRA |= (1 << ADIF) | (1 << ADIE) | (1 << ADSC); //Writing 1 to ADIF clears the flag left set by the last analogRead()
+}
+
+ISR(ADC_vect)
+{
+  byte result_low = ADCL;
+  byte result_high = ADCH;
+  BIT_CLEAR(ADCSRA, ADIE);
+  mapSyncConversionActive = false;
+
+  addMAPSyncSample((result_high << 8) | result_low);
+  //A pending sample was due before the end of the cycle, so the cycle is only handed over once there are no samples left to convert
+  if( mapSyncCycleEndPending && (mapSyncConversionPending == false) )
+  {
+    mapSyncCycleEndPending = false;
+    completeMAPSyncCycle();
+  }
+  if( mapSyncConversionPending ) { startMAPSyncConversion(); }
+}
+
+uint16_t readADC(uint8_t pin)
+{
+  adcMainLoopActive = true;
+  while( mapSyncConversionActive ) { } //Wait for any MAP conversion that the trigger interrupt has started
+  uint16_t tempReading = analogRead(pin);
+
+  noInterrupts();
+  adcMainLoopActive = false;
+  if( mapSyncConversionPending ) { startMAPSyncConversion(); } //A MAP sample fell due during the read
+  interrupts();
+  return tempReading;
+}
+
+/**
+ * Called by the decoder (From within the trigger interrupt) when a MAP sample is due
+ */
+static inline void takeMAPSyncSample(void) { startMAPSyncConversion(); }
+
+/**
+ * Called by the decoder (From within the trigger interrupt) at the end of a cycle. If the last sample of the cycle is still being converted, the ADC interrupt hands the cycle over instead
+ */
+static inline void endMAPSyncCycle(void)
+{
+  if( mapSyncConversionActive || mapSyncConversionPending ) { mapSyncCycleEndPending = true; }
+  else { completeMAPSyncCycle(); }
+}
+
+#else
+static inline void takeMAPSyncSample(void) { addMAPSyncSample(AnChannel[pinMAP-A0]); } //The ADC interrupt keeps every channel up to date
+
+static inline void endMAPSyncCycle(void) { completeMAPSyncCycle(); }
+#endif
+
+/**
+ * Called by the decoder (From within the trigger interrupt) on every tooth when crank angle synchronous MAP sampling is enabled.
+ * A sample is taken on the first tooth at or after each of the angles in mapSyncAngles. When the crank angle wraps around, the samples from the cycle that just finished are handed over to readMAP().
+ * @param crankAngle The current crank angle (0 - CRANK_ANGLE_MAX_IGN)
+ */
+void mapSyncTooth(int16_t crankAngle)
+{
+  if(mapSyncAngleCount == 0) { return; }
+
+  if(crankAngle < mapSyncLastAngle)
+  {
+    //Start of a new cycle. Any samples that fell between the last tooth and the end of the cycle are taken now
+    if(mapSyncNextIndex < mapSyncAngleCount) { takeMAPSyncSample(); }
+    endMAPSyncCycle();
+    mapSyncNextIndex = 0;
+  }
+  mapSyncLastAngle = crankAngle;
+
+  if( (mapSyncNextIndex < mapSyncAngleCount) && (mapSyncAngles[mapSyncNextIndex] <= (uint16_t)crankAngle) )
+  {
+    //Skip over any other sample angles that have also been passed. On coarse wheels a single tooth can cover several samples
+    while( (mapSyncNextIndex < mapSyncAngleCount) && (mapSyncAngles[mapSyncNextIndex] <= (uint16_t)crankAngle) ) { mapSyncNextIndex++; }
+    takeMAPSyncSample();
+  }
+}
+
+/**
+ * Crank angle synchronous MAP reading. The samples themselves are taken by mapSyncTooth(), this averages the samples from the most recently completed cycle.
+ * Falls back to instantaneous readings when the engine isn't running, is below the switch point or the decoder has stopped supplying samples.
+ */
+static inline void readMAPSync(void)
+{
+  if(mapSyncAngleMax != CRANK_ANGLE_MAX_IGN) { calculateMAPSyncAngles(); }
 
+  if ( (currentStatus.RPMdiv100 > configPage2.mapSwitchPoint) && HasAnySync(currentStatus) && (currentStatus.startRevolutions > 1) )
+  {
+    if(mapSyncCycleCount > 0)
+    {
+      noInterrupts();
+      uint32_t cycleValue = mapSyncCycleValue;
+      byte cycleCount = mapSyncCycleCount;
+      mapSyncCycleCount = 0;
+      interrupts();
+
+      //Update the calculation times and last value. These are used by the MAP based Accel enrich
+      MAPlast = currentStatus.MAP;
+      MAPlast_time = MAP_time;
+      MAP_time = micros();
+
+      currentStatus.mapADC = udiv_32_16(cycleValue, cycleCount);
+      currentStatus.MAP = fastMap10Bit(currentStatus.mapADC, configPage2.mapMin, configPage2.mapMax); //Get the current MAP value
+      validateMAP();
+      instantaneousEMAPReading();
+
+      MAPcurRev = currentStatus.startRevolutions;
+    }
+    else if( (currentStatus.startRevolutions - MAPcurRev) > 3U ) { instanteneousMAPReading(); } //No completed cycle for more than 3 revolutions
+  }
+  else
+  {
+    instanteneousMAPReading();
+    MAPcurRev = currentStatus.startRevolutions;
+  }
 }
 
+#endif
+
+#if !defined(MAP_SYNC_AVAILABLE) || defined(ANALOG_ISR)
+uint16_t readADC(uint8_t pin) { return analogRead(pin); } //Nothing else uses the ADC outside of the main loop
+#endif
+
 void readMAP(void)
 {
   unsigned int tempReading;
+
+#if defined(MAP_SYNC_AVAILABLE)
+  if( (configPage15.mapSyncEnable == true) && BIT_CHECK(decoderState, BIT_DECODER_MAP_SYNC) )
+  {
+    readMAPSync();
+    return;
+  }
+#endif
+
   //MAP Sampling system
   switch(configPage2.mapSample)
   {
@@ -290,14 +566,14 @@ void readMAP(void)
           #if defined(ANALOG_ISR_MAP)
             tempReading = AnChannel[pinMAP-A0];
           #else
-            tempReading = analogRead(pinMAP);
-            tempReading = analogRead(pinMAP);
+            tempReading = readADC(pinMAP);
+            tempReading = readADC(pinMAP);
           #endif
 
           //Error check
           if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
           {
-            currentStatus.mapADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC);
+            currentStatus.mapADC = filterADC(ADCFILTER_CHANNEL_MAP, configPage15.adcFilterTypeMAP, tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC);
             MAPrunningValue += currentStatus.mapADC; //Add the current reading onto the total
             MAPcount++;
           }
@@ -309,14 +585,14 @@ void readMAP(void)
             #if defined(ANALOG_ISR_MAP)
               tempReading = AnChannel[pinEMAP-A0];
             #else
-              tempReading = analogRead(pinEMAP);
-              tempReading = analogRead(pinEMAP);
+              tempReading = readADC(pinEMAP);
+              tempReading = readADC(pinEMAP);
             #endif
 
             //Error check
             if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
             {
-              currentStatus.EMAPADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_MAP, currentStatus.EMAPADC);
+              currentStatus.EMAPADC = filterADC(ADCFILTER_CHANNEL_EMAP, configPage15.adcFilterTypeMAP, tempReading, configPage4.ADCFILTER_MAP, currentStatus.EMAPADC);
               EMAPrunningValue += currentStatus.EMAPADC; //Add the current reading onto the total
             }
             else { mapErrorCount += 1; }
@@ -374,8 +650,8 @@ void readMAP(void)
           #if defined(ANALOG_ISR_MAP)
             tempReading = AnChannel[pinMAP-A0];
           #else
-            tempReading = analogRead(pinMAP);
-            tempReading = analogRead(pinMAP);
+            tempReading = readADC(pinMAP);
+            tempReading = readADC(pinMAP);
           #endif
           //Error check
           if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
@@ -417,14 +693,14 @@ void readMAP(void)
           #if defined(ANALOG_ISR_MAP)
             tempReading = AnChannel[pinMAP-A0];
           #else
-            tempReading = analogRead(pinMAP);
-            tempReading = analogRead(pinMAP);
+            tempReading = readADC(pinMAP);
+            tempReading = readADC(pinMAP);
           #endif
 
           //Error check
           if( (tempReading < VALID_MAP_MAX) && (tempReading > VALID_MAP_MIN) )
           {
-            currentStatus.mapADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC);
+            currentStatus.mapADC = filterADC(ADCFILTER_CHANNEL_MAP, configPage15.adcFilterTypeMAP, tempReading, configPage4.ADCFILTER_MAP, currentStatus.mapADC);
             MAPrunningValue += currentStatus.mapADC; //Add the current reading onto the total
             MAPcount++;
           }
@@ -473,11 +749,11 @@ void readTPS(bool useFilter)
   #if defined(ANALOG_ISR)
     byte tempTPS = fastMap1023toX(AnChannel[pinTPS-A0], 255); //Get the current raw TPS ADC value and map it into a byte
   #else
-    analogRead(pinTPS);
-    byte tempTPS = fastMap1023toX(analogRead(pinTPS), 255); //Get the current raw TPS ADC value and map it into a byte
+    readADC(pinTPS);
+    byte tempTPS = fastMap1023toX(readADC(pinTPS), 255); //Get the current raw TPS ADC value and map it into a byte
   #endif
   //The use of the filter can be overridden if required. This is used on startup to disable priming pulse if flood clear is wanted
-  if(useFilter == true) { currentStatus.tpsADC = ADC_FILTER(tempTPS, configPage4.ADCFILTER_TPS, currentStatus.tpsADC); }
+  if(useFilter == true) { currentStatus.tpsADC = filterADC(ADCFILTER_CHANNEL_TPS, configPage15.adcFilterTypeTPS, tempTPS, configPage4.ADCFILTER_TPS, currentStatus.tpsADC); }
   else { currentStatus.tpsADC = tempTPS; }
   byte tempADC = currentStatus.tpsADC; //The tempADC value is used in order to allow TunerStudio to recover and redo the TPS calibration if this somehow gets corrupted
 
@@ -512,21 +788,56 @@ void readTPS(bool useFilter)
   else { currentStatus.CTPSActive = 0; }
 }
 
+static void fillCalibrationLookup(struct table2D *fromTable, uint8_t *lookup)
+{
+  for(uint16_t x = 0; x < CALIBRATION_LOOKUP_SIZE; x++)
+  {
+    uint16_t adcValue = x << CALIBRATION_LOOKUP_SHIFT;
+    if(adcValue > 1023U) { adcValue = 1023U; }
+    int16_t tempValue = table2D_getValue(fromTable, adcValue);
+    lookup[x] = (uint8_t)constrain(tempValue, 0, UINT8_MAX); //Temperatures above 215C are capped
+  }
+}
+
+/**
+ * Regenerates the ADC indexed lookups from the CLT, IAT and O2 calibration tables. 
+ * Must be called after the calibration tables are loaded or changed.
+ */
+void updateCalibrationLookups(void)
+{
+  fillCalibrationLookup(&cltCalibrationTable, cltCalibrationLookup);
+  fillCalibrationLookup(&iatCalibrationTable, iatCalibrationLookup);
+  fillCalibrationLookup(&o2CalibrationTable, o2CalibrationLookup);
+}
+
+static inline int16_t getCalibrationLookup(const uint8_t *lookup, uint16_t adcValue)
+{
+  if(adcValue > 1023U) { adcValue = 1023U; }
+#if CALIBRATION_LOOKUP_SHIFT > 0
+  uint16_t index = adcValue >> CALIBRATION_LOOKUP_SHIFT;
+  int16_t lowValue = lookup[index];
+  int16_t step = (adcValue & ((1U << CALIBRATION_LOOKUP_SHIFT) - 1U));
+  return lowValue + (( ((int16_t)lookup[index+1U] - lowValue) * step) / (1 << CALIBRATION_LOOKUP_SHIFT));
+#else
+  return lookup[adcValue];
+#endif
+}
+
 void readCLT(bool useFilter)
 {
   unsigned int tempReading;
   #if defined(ANALOG_ISR)
     tempReading = AnChannel[pinCLT-A0]; //Get the current raw CLT value
   #else
-    tempReading = analogRead(pinCLT);
-    tempReading = analogRead(pinCLT);
+    tempReading = readADC(pinCLT);
+    tempReading = readADC(pinCLT);
     //tempReading = fastMap1023toX(analogRead(pinCLT), 511); //Get the current raw CLT value
   #endif
   //The use of the filter can be overridden if required. This is used on startup so there can be an immediately accurate coolant value for priming
-  if(useFilter == true) { currentStatus.cltADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_CLT, currentStatus.cltADC); }
+  if(useFilter == true) { currentStatus.cltADC = filterADC(ADCFILTER_CHANNEL_CLT, configPage15.adcFilterTypeCLT, tempReading, configPage4.ADCFILTER_CLT, currentStatus.cltADC); }
   else { currentStatus.cltADC = tempReading; }
   
-  currentStatus.coolant = table2D_getValue(&cltCalibrationTable, currentStatus.cltADC) - CALIBRATION_TEMPERATURE_OFFSET; //Temperature calibration values are stored as positive bytes. We subtract 40 from them to allow for negative temperatures
+  currentStatus.coolant = getCalibrationLookup(cltCalibrationLookup, currentStatus.cltADC) - CALIBRATION_TEMPERATURE_OFFSET; //Temperature calibration values are stored as positive bytes. We subtract 40 from them to allow for negative temperatures
 }
 
 void readIAT(void)
@@ -535,11 +846,11 @@ void readIAT(void)
   #if defined(ANALOG_ISR)
     tempReading = AnChannel[pinIAT-A0]; //Get the current raw IAT value
   #else
-    tempReading = analogRead(pinIAT);
-    tempReading = analogRead(pinIAT);
+    tempReading = readADC(pinIAT);
+    tempReading = readADC(pinIAT);
   #endif
-  currentStatus.iatADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_IAT, currentStatus.iatADC);
-  currentStatus.IAT = table2D_getValue(&iatCalibrationTable, currentStatus.iatADC) - CALIBRATION_TEMPERATURE_OFFSET;
+  currentStatus.iatADC = filterADC(ADCFILTER_CHANNEL_IAT, configPage15.adcFilterTypeIAT, tempReading, configPage4.ADCFILTER_IAT, currentStatus.iatADC);
+  currentStatus.IAT = getCalibrationLookup(iatCalibrationLookup, currentStatus.iatADC) - CALIBRATION_TEMPERATURE_OFFSET;
 }
 
 void readBaro(void)
@@ -551,11 +862,11 @@ void readBaro(void)
     #if defined(ANALOG_ISR_MAP)
       tempReading = AnChannel[pinBaro-A0];
     #else
-      tempReading = analogRead(pinBaro);
-      tempReading = analogRead(pinBaro);
+      tempReading = readADC(pinBaro);
+      tempReading = readADC(pinBaro);
     #endif
 
-    if(currentStatus.initialisationComplete == true) { currentStatus.baroADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_BARO, currentStatus.baroADC); }//Very weak filter
+    if(currentStatus.initialisationComplete == true) { currentStatus.baroADC = filterADC(ADCFILTER_CHANNEL_BARO, configPage15.adcFilterTypeBaro, tempReading, configPage4.ADCFILTER_BARO, currentStatus.baroADC); }//Very weak filter
     else { currentStatus.baroADC = tempReading; } //Baro reading (No filter)
 
     currentStatus.baro = fastMap10Bit(currentStatus.baroADC, configPage2.baroMin, configPage2.baroMax); //Get the current MAP value
@@ -602,13 +913,13 @@ void readO2(void)
     #if defined(ANALOG_ISR)
       tempReading = AnChannel[pinO2-A0]; //Get the current O2 value.
     #else
-      tempReading = analogRead(pinO2);
-      tempReading = analogRead(pinO2);
+      tempReading = readADC(pinO2);
+      tempReading = readADC(pinO2);
       //tempReading = fastMap1023toX(analogRead(pinO2), 511); //Get the current O2 value.
     #endif
-    currentStatus.O2ADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_O2, currentStatus.O2ADC);
+    currentStatus.O2ADC = filterADC(ADCFILTER_CHANNEL_O2, configPage15.adcFilterTypeO2, tempReading, configPage4.ADCFILTER_O2, currentStatus.O2ADC);
     //currentStatus.O2 = o2CalibrationTable[currentStatus.O2ADC];
-    currentStatus.O2 = table2D_getValue(&o2CalibrationTable, currentStatus.O2ADC);
+    currentStatus.O2 = getCalibrationLookup(o2CalibrationLookup, currentStatus.O2ADC);
   }
   else
   {
@@ -626,12 +937,12 @@ void readO2_2(void)
   #if defined(ANALOG_ISR)
     tempReading = AnChannel[pinO2_2-A0]; //Get the current O2 value.
   #else
-    tempReading = analogRead(pinO2_2);
-    tempReading = analogRead(pinO2_2);
+    tempReading = readADC(pinO2_2);
+    tempReading = readADC(pinO2_2);
     //tempReading = fastMap1023toX(analogRead(pinO2_2), 511); //Get the current O2 value.
   #endif
-  currentStatus.O2_2ADC = ADC_FILTER(tempReading, configPage4.ADCFILTER_O2, currentStatus.O2_2ADC);
-  currentStatus.O2_2 = table2D_getValue(&o2CalibrationTable, currentStatus.O2_2ADC);
+  currentStatus.O2_2ADC = filterADC(ADCFILTER_CHANNEL_O2_2, configPage15.adcFilterTypeO2, tempReading, configPage4.ADCFILTER_O2, currentStatus.O2_2ADC);
+  currentStatus.O2_2 = getCalibrationLookup(o2CalibrationLookup, currentStatus.O2_2ADC);
 }
 
 void readBat(void)
@@ -640,8 +951,8 @@ void readBat(void)
   #if defined(ANALOG_ISR)
     tempReading = fastMap1023toX(AnChannel[pinBat-A0], 245); //Get the current raw Battery value. Permissible values are from 0v to 24.5v (245)
   #else
-    tempReading = analogRead(pinBat);
-    tempReading = fastMap1023toX(analogRead(pinBat), 245); //Get the current raw Battery value. Permissible values are from 0v to 24.5v (245)
+    tempReading = readADC(pinBat);
+    tempReading = fastMap1023toX(readADC(pinBat), 245); //Get the current raw Battery value. Permissible values are from 0v to 24.5v (245)
   #endif
 
   //Apply the offset calibration value to the reading
@@ -668,7 +979,7 @@ void readBat(void)
     }
   }
 
-  currentStatus.battery10 = ADC_FILTER(tempReading, configPage4.ADCFILTER_BAT, currentStatus.battery10);
+  currentStatus.battery10 = filterADC(ADCFILTER_CHANNEL_BAT, configPage15.adcFilterTypeBat, tempReading, configPage4.ADCFILTER_BAT, currentStatus.battery10);
 }
 
 /**
@@ -768,8 +1079,8 @@ byte getFuelPressure(void)
     #if defined(ANALOG_ISR)
       tempReading = AnChannel[pinFuelPressure-A0];
     #else
-      tempReading = analogRead(pinFuelPressure);
-      tempReading = analogRead(pinFuelPressure);
+      tempReading = readADC(pinFuelPressure);
+      tempReading = readADC(pinFuelPressure);
     #endif
 
     tempFuelPressure = fastMap10Bit(tempReading, configPage10.fuelPressureMin, configPage10.fuelPressureMax);
@@ -793,8 +1104,8 @@ byte getOilPressure(void)
     #if defined(ANALOG_ISR)
       tempReading = AnChannel[pinOilPressure-A0];
     #else
-      tempReading = analogRead(pinOilPressure);
-      tempReading = analogRead(pinOilPressure);
+      tempReading = readADC(pinOilPressure);
+      tempReading = readADC(pinOilPressure);
     #endif
 
 
@@ -827,23 +1138,6 @@ void flexPulse(void)
   }
 }
 
-/*
- * The interrupt function for pulses from a knock conditioner / controller
- * 
- */
-void knockPulse(void)
-{
-  //Check if this the start of a knock. 
-  if(knockCounter == 0)
-  {
-    //knockAngle = crankAngle + timeToAngleDegPerMicroSec( (micros() - lastCrankAngleCalc) ); 
-    knockStartTime = micros();
-    knockCounter = 1;
-  }
-  else { ++knockCounter; } //Knock has already started, so just increment the counter for this
-
-}
-
 /**
  * @brief The ISR function for VSS pulses
  * 
@@ -864,8 +1158,8 @@ uint16_t readAuxanalog(uint8_t analogPin)
   #if defined(ANALOG_ISR)
     tempReading = AnChannel[analogPin-A0]; //Get the current raw Auxanalog value
   #else
-    tempReading = analogRead(analogPin);
-    tempReading = analogRead(analogPin);
+    tempReading = readADC(analogPin);
+    tempReading = readADC(analogPin);
   #endif
   return tempReading;
 } 
@@ -40,8 +40,6 @@ extern volatile unsigned long flexPulseWidth;
 
 #define ADMUX_DEFAULT_CONFIG  0x40 //AVCC reference, ADC0 input, right adjusted, ADC enabled
 
-extern volatile byte knockCounter;
-
 extern unsigned int MAPcount; //Number of samples taken in the current MAP cycle
 extern uint32_t MAPcurRev; //Tracks which revolution we're sampling on
 extern bool auxIsEnabled;
@@ -75,5 +73,10 @@ void readBat(void);
 void readBaro(void);
 void readMAP(void);
 void instanteneousMAPReading(void);
+#if defined(MAP_SYNC_AVAILABLE)
+void mapSyncTooth(int16_t crankAngle);
+#endif
+uint16_t readADC(uint8_t pin); //analogRead() for use from the main loop. On AVR this waits for any crank angle synchronous MAP conversion to finish first
+void updateCalibrationLookups(void);
 
 #endif // SENSORS_H
@@ -44,6 +44,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "comms_CAN.h"
 #include "SD_logger.h"
 #include "schedule_calcs.h"
+#include "knock.h"
+#include "fuelLearn.h"
+#include "transientFuel.h"
+#include "tuneBanks.h"
 #include "auxiliaries.h"
 #include RTC_LIB_H //Defined in each boards .h file
 #include BOARD_H //Note that this is not a real file, it is defined in globals.h. 
@@ -101,10 +105,11 @@ void loop(void)
       }
 
       //Check for any new or in-progress requests from serial.
-      if (Serial.available()>0 || serialRecieveInProgress())
+      if (Serial.available()>0 || serialRecieveInProgress() || serialCommandQueued())
       {
         serialReceive();
       }
+      serialStream();
       
       //Check for any CAN comms requiring action 
       #if defined(secondarySerial_AVAILABLE)
@@ -122,12 +127,7 @@ void loop(void)
         {            
           //check local can module
           // if ( BIT_CHECK(LOOP_TIMER, BIT_TIMER_15HZ) or (CANbus0.available())
-          while (CAN_read()) 
-          {
-            can_Command();
-            readAuxCanBus();
-            if (configPage2.canWBO > 0) { receiveCANwbo(); }
-          }
+          while (CAN_read()) { receiveCAN(); }
         }   
       #endif
           
@@ -182,6 +182,7 @@ void loop(void)
       BIT_CLEAR(currentStatus.engine, BIT_ENGINE_ASE); //Same as above except for ASE status
       BIT_CLEAR(currentStatus.engine, BIT_ENGINE_ACC); //Same as above but the accel enrich (If using MAP accel enrich a stall will cause this to trigger)
       BIT_CLEAR(currentStatus.engine, BIT_ENGINE_DCC); //Same as above but the decel enleanment
+      invalidateSlowFuelCorrections(); //The warmup bit above is set again by the WUE correction
       //This is a safety check. If for some reason the interrupts have got screwed up (Leading to 0rpm), this resets them.
       //It can possibly be run much less frequently.
       //This should only be run if the high speed logger are off because it will change the trigger interrupts back to defaults rather than the logger versions
@@ -199,10 +200,18 @@ void loop(void)
     {
       BIT_CLEAR(TIMER_mask, BIT_TIMER_1KHZ);
       readMAP();
+      readKnock();
+      tuneBankControl();
+      #ifdef SD_LOGGING
+        flushSDCapture();
+      #endif
     }
     if(BIT_CHECK(LOOP_TIMER, BIT_TIMER_200HZ))
     {
       BIT_CLEAR(TIMER_mask, BIT_TIMER_200HZ);
+      #ifdef SD_LOGGING
+        captureSDLogFrame();
+      #endif
       #if defined(ANALOG_ISR)
         //ADC in free running mode does 1 complete conversion of all 16 channels and then the interrupt is disabled. Every 200Hz we re-enable the interrupt to get another conversion cycle
         BIT_SET(ADCSRA,ADIE); //Enable ADC interrupt
@@ -225,11 +234,6 @@ void loop(void)
 
       checkLaunchAndFlatShift(); //Check for launch control and flat shift being active
 
-      //And check whether the tooth log buffer is ready
-      if(toothHistoryIndex > TOOTH_LOG_SIZE) { BIT_SET(currentStatus.status1, BIT_STATUS1_TOOTHLOG1READY); }
-
-      
-
     }
     if(BIT_CHECK(LOOP_TIMER, BIT_TIMER_10HZ)) //10 hertz
     {
@@ -241,6 +245,8 @@ void loop(void)
       // Air conditioning control
       airConControl();
 
+      fuelLearnControl(); //Learn the closed loop correction into the long term trims
+
       currentStatus.vss = getSpeed();
       currentStatus.gear = getGear();
 
@@ -257,9 +263,12 @@ void loop(void)
       vvtControl();
       //Water methanol injection
       wmiControl();
+      //Knock retard is stepped at a fixed rate (See KNOCK_CONTROL_RATE)
+      knockControl();
       #if defined(NATIVE_CAN_AVAILABLE)
       if (configPage2.canBMWCluster == true) { sendBMWCluster(); }
       if (configPage2.canVAGCluster == true) { sendVAGCluster(); }
+      if ( (configPage2.canWBO > 0) && (configPage9.enable_intcan == 1) ) { sendCANwbo(); }
       #endif
       #if TPS_READ_FREQUENCY == 30
         readTPS();
@@ -274,7 +283,7 @@ void loop(void)
       #endif
 
       //Check for any outstanding EEPROM writes.
-      if( (isEepromWritePending() == true) && (serialStatusFlag == SERIAL_INACTIVE) && (micros() > deferEEPROMWritesUntil)) { writeAllConfig(); } 
+      if( (isEepromWritePending() == true) && (serialStatusFlag == SERIAL_INACTIVE) && (micros() > deferEEPROMWritesUntil)) { writePendingConfig(); } 
     }
     if (BIT_CHECK(LOOP_TIMER, BIT_TIMER_4HZ))
     {
@@ -380,6 +389,14 @@ void loop(void)
         if(configPage13.onboard_log_file_rate == LOGGER_RATE_1HZ) { writeSDLogEntry(); }
       #endif
 
+      //Save any changed long term fuel trims, but never while a burn is in progress or comms are active
+      if( isFuelLearnWritePending() && !isEepromWritePending() && (serialStatusFlag == SERIAL_INACTIVE) && (micros() > deferEEPROMWritesUntil) ) { writeFuelLearn(); }
+
+      #if defined(USE_FLASH_JOURNAL)
+        //Prepare a new journal sector ahead of time, so that burns don't have to wait for a sector erase
+        if( (currentStatus.RPM == 0) && !isEepromWritePending() && (serialStatusFlag == SERIAL_INACTIVE) ) { maintainConfigJournal(); }
+      #endif
+
     } //1Hz timer
 
     if( (configPage6.iacAlgorithm == IAC_ALGORITHM_STEP_OL)
@@ -420,6 +437,7 @@ void loop(void)
           if( !BIT_CHECK(currentStatus.engine, BIT_ENGINE_RUN) || (currentStatus.RPM < (currentStatus.crankRPM - CRANK_RUN_HYSTER)) )
           {
             //Sets the engine cranking bit, clears the engine running bit
+            if( !BIT_CHECK(currentStatus.engine, BIT_ENGINE_CRANK) ) { invalidateSlowFuelCorrections(); } //Only needed on the transition into cranking
             BIT_SET(currentStatus.engine, BIT_ENGINE_CRANK);
             BIT_CLEAR(currentStatus.engine, BIT_ENGINE_RUN);
             currentStatus.runSecs = 0; //We're cranking (hopefully), so reset the engine run time to prompt ASE.
@@ -437,6 +455,7 @@ void loop(void)
       currentStatus.corrections = correctionsFuel();
 
       currentStatus.PW1 = PW(req_fuel_uS, currentStatus.VE, currentStatus.MAP, currentStatus.corrections, inj_opentime_uS);
+      if(configPage2.aeMode == AE_MODE_XTAU) { currentStatus.PW1 = correctionWallWetting(currentStatus.PW1, inj_opentime_uS); } //Transient fuel from the wall wetting model
 
       //Manual adder for nitrous. These are not in correctionsFuel() because they are direct adders to the ms value, not % based
       if( (currentStatus.nitrous_status == NITROUS_STAGE1) || (currentStatus.nitrous_status == NITROUS_BOTH) )
@@ -1286,7 +1305,8 @@ byte getVE1(void)
     currentStatus.fuelLoad = ((int16_t)currentStatus.MAP * 100U) / currentStatus.EMAP;
   }
   else { currentStatus.fuelLoad = currentStatus.MAP; } //Fallback position
-  tempVE = get3DTableValue(&fuelTable, currentStatus.fuelLoad, currentStatus.RPM); //Perform lookup into fuel map for RPM vs MAP value
+  tempVE = get3DTableValue(pFuelTable, currentStatus.fuelLoad, currentStatus.RPM); //Perform lookup into fuel map for RPM vs MAP value
+  tempVE = applyFuelLearn(tempVE); //Apply the long term fuel trim for this cell (If enabled)
 
   return tempVE;
 }
@@ -1315,7 +1335,7 @@ byte getAdvance1(void)
     //IMAP / EMAP
     currentStatus.ignLoad = ((int16_t)currentStatus.MAP * 100U) / currentStatus.EMAP;
   }
-  tempAdvance = get3DTableValue(&ignitionTable, currentStatus.ignLoad, currentStatus.RPM) - OFFSET_IGNITION; //As above, but for ignition advance
+  tempAdvance = get3DTableValue(pIgnitionTable, currentStatus.ignLoad, currentStatus.RPM) - OFFSET_IGNITION; //As above, but for ignition advance
   tempAdvance = correctionsIgn(tempAdvance);
 
   return tempAdvance;
@@ -1332,31 +1352,31 @@ void calculateIgnitionAngles(uint16_t dwellAngle)
   {
     //1 cylinder
     case 1:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
       break;
     //2 cylinders
     case 2:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
       break;
     //3 cylinders
     case 3:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance, &ignition3EndAngle, &ignition3StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance - knockChannelRetard[2], &ignition3EndAngle, &ignition3StartAngle);
       break;
     //4 cylinders
     case 4:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
 
       #if IGN_CHANNELS >= 4
       if((configPage4.sparkMode == IGN_MODE_SEQUENTIAL) && currentStatus.hasSync)
       {
         if( CRANK_ANGLE_MAX_IGN != 720 ) { changeHalfToFullSync(); }
 
-        calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance, &ignition3EndAngle, &ignition3StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance, &ignition4EndAngle, &ignition4StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance - knockChannelRetard[2], &ignition3EndAngle, &ignition3StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance - knockChannelRetard[3], &ignition4EndAngle, &ignition4StartAngle);
       }
       else if(configPage4.sparkMode == IGN_MODE_ROTARY)
       {
@@ -1375,28 +1395,28 @@ void calculateIgnitionAngles(uint16_t dwellAngle)
       break;
     //5 cylinders
     case 5:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance, &ignition3EndAngle, &ignition3StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance, &ignition4EndAngle, &ignition4StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance - knockChannelRetard[2], &ignition3EndAngle, &ignition3StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance - knockChannelRetard[3], &ignition4EndAngle, &ignition4StartAngle);
       #if (IGN_CHANNELS >= 5)
-      calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance, &ignition5EndAngle, &ignition5StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance - knockChannelRetard[4], &ignition5EndAngle, &ignition5StartAngle);
       #endif
       break;
     //6 cylinders
     case 6:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance, &ignition3EndAngle, &ignition3StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance - knockChannelRetard[2], &ignition3EndAngle, &ignition3StartAngle);
 
       #if IGN_CHANNELS >= 6
       if((configPage4.sparkMode == IGN_MODE_SEQUENTIAL) && currentStatus.hasSync)
       {
         if( CRANK_ANGLE_MAX_IGN != 720 ) { changeHalfToFullSync(); }
 
-        calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance, &ignition4EndAngle, &ignition4StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance, &ignition5EndAngle, &ignition5StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel6IgnDegrees, currentStatus.advance, &ignition6EndAngle, &ignition6StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance - knockChannelRetard[3], &ignition4EndAngle, &ignition4StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance - knockChannelRetard[4], &ignition5EndAngle, &ignition5StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel6IgnDegrees, currentStatus.advance - knockChannelRetard[5], &ignition6EndAngle, &ignition6StartAngle);
       }
       else
       {
@@ -1406,20 +1426,20 @@ void calculateIgnitionAngles(uint16_t dwellAngle)
       break;
     //8 cylinders
     case 8:
-      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance, &ignition1EndAngle, &ignition1StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance, &ignition2EndAngle, &ignition2StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance, &ignition3EndAngle, &ignition3StartAngle);
-      calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance, &ignition4EndAngle, &ignition4StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel1IgnDegrees, currentStatus.advance - knockChannelRetard[0], &ignition1EndAngle, &ignition1StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel2IgnDegrees, currentStatus.advance - knockChannelRetard[1], &ignition2EndAngle, &ignition2StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel3IgnDegrees, currentStatus.advance - knockChannelRetard[2], &ignition3EndAngle, &ignition3StartAngle);
+      calculateIgnitionAngle(dwellAngle, channel4IgnDegrees, currentStatus.advance - knockChannelRetard[3], &ignition4EndAngle, &ignition4StartAngle);
 
       #if IGN_CHANNELS >= 8
       if((configPage4.sparkMode == IGN_MODE_SEQUENTIAL) && currentStatus.hasSync)
       {
         if( CRANK_ANGLE_MAX_IGN != 720 ) { changeHalfToFullSync(); }
 
-        calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance, &ignition5EndAngle, &ignition5StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel6IgnDegrees, currentStatus.advance, &ignition6EndAngle, &ignition6StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel7IgnDegrees, currentStatus.advance, &ignition7EndAngle, &ignition7StartAngle);
-        calculateIgnitionAngle(dwellAngle, channel8IgnDegrees, currentStatus.advance, &ignition8EndAngle, &ignition8StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel5IgnDegrees, currentStatus.advance - knockChannelRetard[4], &ignition5EndAngle, &ignition5StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel6IgnDegrees, currentStatus.advance - knockChannelRetard[5], &ignition6EndAngle, &ignition6StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel7IgnDegrees, currentStatus.advance - knockChannelRetard[6], &ignition7EndAngle, &ignition7StartAngle);
+        calculateIgnitionAngle(dwellAngle, channel8IgnDegrees, currentStatus.advance - knockChannelRetard[7], &ignition8EndAngle, &ignition8StartAngle);
       }
       else
       {
@@ -40,7 +40,19 @@
 
 
 // Set this to 0 for smaller 32BIT-CRC-Tables:
+#if !defined(CRC_BIGTABLES)
 #define CRC_BIGTABLES 1
+#endif
+
+// Use slicing by 8 for the 32BIT-CRC on 32 bit boards, where the extra 4kB of tables in flash is not an issue
+// Both of these can be set before this file is included (Eg the native CRC32 test builds each variant)
+#if !defined(CRC_SLICE8)
+#if CRC_BIGTABLES && !defined(__AVR__)
+#define CRC_SLICE8 1
+#else
+#define CRC_SLICE8 0
+#endif
+#endif
 
 
 #if !defined(FastCRC_h)
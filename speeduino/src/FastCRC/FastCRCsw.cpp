@@ -30,13 +30,24 @@
 // - Danjel McGougan (CRC-Table-Generator)
 //
 
+#if defined(ARDUINO)
 #include "Arduino.h"
+#endif
 #if !defined(KINETISK)
 
 #include "FastCRC.h"
 #include "FastCRC_cpu.h"
 #include "FastCRC_tables.h"
 
+// The STM32 CRC unit uses the CRC32 polynomial, so can be used for the bulk of a 32BIT-CRC calculation
+#if !defined(CRC_STM32_HW)
+#if defined(ARDUINO_ARCH_STM32) && defined(CRC) && defined(CRC_CR_RESET)
+#define CRC_STM32_HW 1
+#else
+#define CRC_STM32_HW 0
+#endif
+#endif
+
 
 // ================= 7-BIT CRC ===================
 
@@ -398,6 +409,56 @@ FastCRC32::FastCRC32(){}
 	crc = (crc >> 8) ^ pgm_read_dword(&table[crc & 0xff]); \
 	crc = (crc >> 8) ^ pgm_read_dword(&table[crc & 0xff]);
 
+#define crc_n8d(crc, data0, data1, table, table8) crc ^= data0; \
+	crc = pgm_read_dword(&table8[(crc & 0xff) + 0x300]) ^	\
+	pgm_read_dword(&table8[((crc >> 8) & 0xff) + 0x200]) ^	\
+	pgm_read_dword(&table8[((crc >> 16) & 0xff) + 0x100]) ^	\
+	pgm_read_dword(&table8[(crc >> 24) & 0xff]) ^	\
+	pgm_read_dword(&table[(data1 & 0xff) + 0x300]) ^	\
+	pgm_read_dword(&table[((data1 >> 8) & 0xff) + 0x200]) ^	\
+	pgm_read_dword(&table[((data1 >> 16) & 0xff) + 0x100]) ^	\
+	pgm_read_dword(&table[(data1 >> 24) & 0xff]);
+
+#if CRC_STM32_HW
+// Multiply a and b modulo the (reflected) CRC32 polynomial
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b)
+{
+	uint32_t product = 0;
+	for (uint32_t mask = 1UL << 31; mask != 0; mask >>= 1) {
+		if (a & mask) { product ^= b; }
+		b = (b & 1) ? (b >> 1) ^ 0xEDB88320UL : b >> 1;
+	}
+	return product;
+}
+
+// Returns crc multiplied by x^(8 * len), ie the effect of feeding len zero bytes into the register
+static uint32_t crc32_shift(uint32_t crc, uint16_t len)
+{
+	uint32_t x2n = 0x00800000UL; // x^8
+	while (len) {
+		if (len & 1) { crc = crc32_multmodp(x2n, crc); }
+		x2n = crc32_multmodp(x2n, x2n);
+		len >>= 1;
+	}
+	return crc;
+}
+
+// Feeds whole 32 bit words through the CRC unit. The unit always starts from 0xFFFFFFFF, so the 
+// current register is combined with the result: CRC(seed, data) = CRC(0xFFFFFFFF, data) ^ (seed ^ 0xFFFFFFFF) * x^(8 * len)
+// The unit is MSB first, so the words and the result are bit reversed to get the reflected CRC32
+static uint32_t crc32_hw_words(uint32_t crc, const uint32_t *data, uint16_t words)
+{
+	static bool clockEnabled = false;
+	if (!clockEnabled) { __HAL_RCC_CRC_CLK_ENABLE(); clockEnabled = true; }
+
+	CRC->CR = CRC_CR_RESET;
+	for (uint16_t i = 0; i < words; i++) {
+		CRC->DR = __RBIT(data[i]);
+	}
+	return __RBIT(CRC->DR) ^ crc32_shift(crc ^ 0xFFFFFFFFUL, words * 4U);
+}
+#endif
+
 /** CRC32
  * Alias CRC-32/ADCCP, PKZIP, Ethernet, 802.3
  * @param data Pointer to Data
@@ -420,9 +481,21 @@ uint32_t FastCRC32::crc32_upd(const uint8_t *data, uint16_t len, bool reflect)
 		len--;
 	}
 
+	#if CRC_STM32_HW
+	if (len >= 16) {
+		uint16_t words = len >> 2;
+		crc = crc32_hw_words(crc, (const uint32_t *)data, words);
+		data += words * 4U;
+		len -= words * 4U;
+	}
+	#endif
+
 	while (len >= 16) {
 		len -= 16;
-		#if CRC_BIGTABLES
+		#if CRC_SLICE8
+		crc_n8d(crc, ((uint32_t *)data)[0], ((uint32_t *)data)[1], CRC_TABLE_CRC32, crc_table_crc32_slice8);
+		crc_n8d(crc, ((uint32_t *)data)[2], ((uint32_t *)data)[3], CRC_TABLE_CRC32, crc_table_crc32_slice8);
+		#elif CRC_BIGTABLES
 		crc_n4d(crc, ((uint32_t *)data)[0], CRC_TABLE_CRC32);
 		crc_n4d(crc, ((uint32_t *)data)[1], CRC_TABLE_CRC32);
 		crc_n4d(crc, ((uint32_t *)data)[2], CRC_TABLE_CRC32);
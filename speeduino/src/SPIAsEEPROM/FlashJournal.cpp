@@ -0,0 +1,297 @@
+/* Speeduino flash journal
+ *
+ * This file is part of the Speeduino project.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * See FlashJournal.h for a description of the journal layout.
+ */
+#include "FlashJournal.h"
+#include "../FastCRC/FastCRC.h"
+#include <stddef.h>
+
+#define JOURNAL_SECTOR_MAGIC    0x314E4A53UL //"SJN1"
+#define JOURNAL_RECORD_MAGIC    0x4A52U
+#define JOURNAL_PROGRAM_PAGE    256U //A single flash write must not cross a page boundary (Winbond page program wraps around within the page)
+#define JOURNAL_CHUNK_SIZE      64U
+#define JOURNAL_MAINTAIN_FREE   4U //maintain() moves on to the next sector once less than 1/x of the current sector is free
+
+FlashJournal::FlashJournal(FLASH_EEPROM_BaseClass &flash, Flash_Journal_Config config) : _flash(flash), _config(config)
+{
+  for (uint8_t id = 0; id < FLASH_JOURNAL_MAX_IDS; id++)
+  {
+    _records[id] = FLASH_JOURNAL_NO_RECORD;
+    _recordVersions[id] = 0;
+    _recordLengths[id] = 0;
+  }
+}
+
+int8_t FlashJournal::begin()
+{
+  _available = false;
+  _recordVersion = 0;
+  _erasedSectors = 0;
+  for (uint8_t id = 0; id < FLASH_JOURNAL_MAX_IDS; id++) { _records[id] = FLASH_JOURNAL_NO_RECORD; }
+  if ( (_config.Flash_Sectors_Used < 3U) || (_config.Flash_Sectors_Used > FLASH_JOURNAL_MAX_SECTORS) ) { return -1; }
+
+  //Find the sectors that are in use
+  SectorHeader headers[FLASH_JOURNAL_MAX_SECTORS];
+  uint32_t usedSectors = 0;
+  for (uint32_t sector = 0; sector < _config.Flash_Sectors_Used; sector++)
+  {
+    readFlash(sectorStart(sector), (byte*)&headers[sector], sizeof(SectorHeader));
+    if (headers[sector].magic == JOURNAL_SECTOR_MAGIC) { usedSectors |= (1UL << sector); }
+    else if (isSectorErased(sector)) { _erasedSectors |= (1UL << sector); }
+    //Sectors that are neither are left over from an interrupted erase (Or were never part of the journal). They are erased when they are next needed
+  }
+
+  //Scan the sectors oldest first, so that the last sector scanned is the one to carry on writing to
+  uint32_t scannedSectors = 0;
+  bool found = false;
+  for (uint32_t n = 0; n < _config.Flash_Sectors_Used; n++)
+  {
+    uint32_t oldest = FLASH_JOURNAL_MAX_SECTORS;
+    for (uint32_t sector = 0; sector < _config.Flash_Sectors_Used; sector++)
+    {
+      uint32_t mask = (1UL << sector);
+      if ( ((usedSectors & mask) != 0U) && ((scannedSectors & mask) == 0U) && ((oldest == FLASH_JOURNAL_MAX_SECTORS) || (headers[sector].version < headers[oldest].version)) ) { oldest = sector; }
+    }
+    if (oldest == FLASH_JOURNAL_MAX_SECTORS) { break; }
+
+    scannedSectors |= (1UL << oldest);
+    _writeAddress = scanSector(oldest);
+    _currentSector = oldest;
+    _sectorVersion = headers[oldest].version;
+    found = true;
+  }
+
+  if (!found)
+  {
+    //New (Or completely unreadable) journal
+    _sectorVersion = 0;
+    if (startSector(0) < 0) { return -1; }
+  }
+
+  //The sector after the current one must always be erased. It won't be if the last collection or erase was interrupted, so finish it now
+  if (collectSector((_currentSector + 1U) % _config.Flash_Sectors_Used) < 0) { return -1; }
+
+  _available = true;
+  return 0;
+}
+
+uint16_t FlashJournal::recordLength(uint8_t id)
+{
+  if ( (!_available) || (id >= FLASH_JOURNAL_MAX_IDS) || (_records[id] == FLASH_JOURNAL_NO_RECORD) ) { return 0; }
+  return _recordLengths[id];
+}
+
+int8_t FlashJournal::readRecord(uint8_t id, uint16_t offset, byte *buffer, uint16_t length)
+{
+  if ( (recordLength(id) == 0U) || ((uint32_t)offset + length > _recordLengths[id]) ) { return -1; }
+  readFlash(_records[id] + sizeof(RecordHeader) + offset, buffer, length);
+  return 0;
+}
+
+int8_t FlashJournal::writeRecord(uint8_t id, uint16_t length, dataSource source)
+{
+  if ( (!_available) || (id >= FLASH_JOURNAL_MAX_IDS) || (length == 0U) ) { return -1; }
+  if (makeSpace(recordSize(length)) < 0) { return -1; }
+
+  RecordHeader header = { JOURNAL_RECORD_MAGIC, id, 0xFFU, length, (uint16_t)~length, _recordVersion + 1U, 0xFFFFFFFFUL };
+  const uint32_t address = _writeAddress;
+  _writeAddress += recordSize(length); //The space is used even if the write fails
+  if (programFlash(address, (byte*)&header, sizeof(header)) < 0) { return -1; }
+
+  FastCRC32 crcCalc;
+  byte buffer[JOURNAL_CHUNK_SIZE];
+  for (uint16_t offset = 0; offset < length; )
+  {
+    uint16_t chunk = (uint16_t)(length - offset) < JOURNAL_CHUNK_SIZE ? (uint16_t)(length - offset) : JOURNAL_CHUNK_SIZE;
+    source(id, offset, buffer, chunk);
+    header.crc = (offset == 0U) ? crcCalc.crc32(buffer, chunk) : crcCalc.crc32_upd(buffer, chunk);
+    if (programFlash(address + sizeof(RecordHeader) + offset, buffer, chunk) < 0) { return -1; }
+    offset += chunk;
+  }
+
+  //The record only becomes valid once the CRC has been written
+  if (programFlash(address + offsetof(RecordHeader, crc), (byte*)&header.crc, sizeof(header.crc)) < 0) { return -1; }
+
+  _recordVersion = header.version;
+  _records[id] = address;
+  _recordVersions[id] = header.version;
+  _recordLengths[id] = length;
+  return 0;
+}
+
+int8_t FlashJournal::maintain()
+{
+  if (!_available) { return -1; }
+
+  uint32_t freeSpace = sectorStart(_currentSector) + _config.Flash_Sector_Size - _writeAddress;
+  if (freeSpace < (_config.Flash_Sector_Size / JOURNAL_MAINTAIN_FREE)) { return advanceSector(); }
+  return 0;
+}
+
+uint32_t FlashJournal::sectorStart(uint32_t sector) { return sector * _config.Flash_Sector_Size; }
+
+uint32_t FlashJournal::recordSize(uint16_t length) { return (sizeof(RecordHeader) + length + 3UL) & ~3UL; } //Records are kept 4 byte aligned
+
+bool FlashJournal::isSectorErased(uint32_t sector)
+{
+  byte buffer[JOURNAL_CHUNK_SIZE];
+  for (uint32_t offset = 0; offset < _config.Flash_Sector_Size; offset += JOURNAL_CHUNK_SIZE)
+  {
+    readFlash(sectorStart(sector) + offset, buffer, JOURNAL_CHUNK_SIZE);
+    for (uint8_t i = 0; i < JOURNAL_CHUNK_SIZE; i++)
+    {
+      if (buffer[i] != 0xFFU) { return false; }
+    }
+  }
+  return true;
+}
+
+bool FlashJournal::isRecordValid(uint32_t address, const RecordHeader &header)
+{
+  FastCRC32 crcCalc;
+  uint32_t crc = 0;
+  byte buffer[JOURNAL_CHUNK_SIZE];
+  for (uint16_t offset = 0; offset < header.length; )
+  {
+    uint16_t chunk = (uint16_t)(header.length - offset) < JOURNAL_CHUNK_SIZE ? (uint16_t)(header.length - offset) : JOURNAL_CHUNK_SIZE;
+    readFlash(address + sizeof(RecordHeader) + offset, buffer, chunk);
+    crc = (offset == 0U) ? crcCalc.crc32(buffer, chunk) : crcCalc.crc32_upd(buffer, chunk);
+    offset += chunk;
+  }
+  return (header.length > 0U) && (crc == header.crc);
+}
+
+/** Add the valid records of a sector to the index.
+ * @return The address after the last record in the sector
+ */
+uint32_t FlashJournal::scanSector(uint32_t sector)
+{
+  const uint32_t end = sectorStart(sector) + _config.Flash_Sector_Size;
+  uint32_t address = sectorStart(sector) + sizeof(SectorHeader);
+  while (address + sizeof(RecordHeader) <= end)
+  {
+    RecordHeader header;
+    readFlash(address, (byte*)&header, sizeof(header));
+
+    bool blank = true;
+    for (uint8_t i = 0; i < sizeof(header); i++) { blank = blank && (((byte*)&header)[i] == 0xFFU); }
+    if (blank) { break; }
+
+    if ( (header.magic != JOURNAL_RECORD_MAGIC) || (header.lengthCheck != (uint16_t)~header.length) || (address + recordSize(header.length) > end) )
+    {
+      //Damaged header (Interrupted write). Nothing was written after it, so step over the bytes that were programmed until the erased space after them is found.
+      //Records are 4 byte aligned, and writing carries on from there. This keeps the rest of the sector usable, which begin() relies on to finish an interrupted collectSector()
+      address += 4U;
+      continue;
+    }
+
+    if ( (header.id < FLASH_JOURNAL_MAX_IDS) && isRecordValid(address, header) )
+    {
+      //Sectors are scanned oldest first, so a copy made when a sector was collected (Same version) replaces the original
+      if ( (_records[header.id] == FLASH_JOURNAL_NO_RECORD) || (header.version >= _recordVersions[header.id]) )
+      {
+        _records[header.id] = address;
+        _recordVersions[header.id] = header.version;
+        _recordLengths[header.id] = header.length;
+      }
+      if (header.version > _recordVersion) { _recordVersion = header.version; }
+    }
+    address += recordSize(header.length);
+  }
+  return address;
+}
+
+/** Start writing to a sector. The sector is erased first if needed */
+int8_t FlashJournal::startSector(uint32_t sector)
+{
+  if ( ((_erasedSectors & (1UL << sector)) == 0U) && (eraseSector(sector) < 0) ) { return -1; }
+
+  SectorHeader header = { JOURNAL_SECTOR_MAGIC, _sectorVersion + 1U };
+  if (programFlash(sectorStart(sector), (byte*)&header, sizeof(header)) < 0) { return -1; }
+  _erasedSectors &= ~(1UL << sector);
+  _sectorVersion = header.version;
+  _currentSector = sector;
+  _writeAddress = sectorStart(sector) + sizeof(SectorHeader);
+  return 0;
+}
+
+/** Copy the current records out of a sector to the end of the current sector, then erase it */
+int8_t FlashJournal::collectSector(uint32_t sector)
+{
+  if ((_erasedSectors & (1UL << sector)) != 0U) { return 0; }
+
+  const uint32_t start = sectorStart(sector);
+  const uint32_t end = start + _config.Flash_Sector_Size;
+  const uint32_t currentEnd = sectorStart(_currentSector) + _config.Flash_Sector_Size;
+  byte buffer[JOURNAL_CHUNK_SIZE];
+  for (uint8_t id = 0; id < FLASH_JOURNAL_MAX_IDS; id++)
+  {
+    if ( (_records[id] == FLASH_JOURNAL_NO_RECORD) || (_records[id] < start) || (_records[id] >= end) ) { continue; }
+
+    const uint32_t size = recordSize(_recordLengths[id]);
+    if (_writeAddress + size > currentEnd) { return -1; } //Too much current data for the journal size
+    for (uint32_t offset = 0; offset < size; offset += JOURNAL_CHUNK_SIZE)
+    {
+      uint32_t chunk = (size - offset) < JOURNAL_CHUNK_SIZE ? (size - offset) : JOURNAL_CHUNK_SIZE;
+      readFlash(_records[id] + offset, buffer, chunk);
+      if (programFlash(_writeAddress + offset, buffer, chunk) < 0) { return -1; }
+    }
+    _records[id] = _writeAddress;
+    _writeAddress += size;
+  }
+  return eraseSector(sector);
+}
+
+/** Move on to the next (Erased) sector, then collect the one after it so that it is erased in turn */
+int8_t FlashJournal::advanceSector()
+{
+  const uint32_t next = (_currentSector + 1U) % _config.Flash_Sectors_Used;
+  if (startSector(next) < 0) { return -1; }
+  return collectSector((next + 1U) % _config.Flash_Sectors_Used);
+}
+
+int8_t FlashJournal::makeSpace(uint32_t size)
+{
+  if (size > (_config.Flash_Sector_Size - sizeof(SectorHeader))) { return -1; }
+
+  for (uint32_t tries = 0; tries < _config.Flash_Sectors_Used; tries++)
+  {
+    if (_writeAddress + size <= sectorStart(_currentSector) + _config.Flash_Sector_Size) { return 0; }
+    if (advanceSector() < 0) { return -1; }
+  }
+  return -1;
+}
+
+int8_t FlashJournal::readFlash(uint32_t address, byte *buffer, uint32_t length)
+{
+  return _flash.readFlashBytes(_config.Flash_Offset + address, buffer, length);
+}
+
+int8_t FlashJournal::programFlash(uint32_t address, byte *buffer, uint32_t length)
+{
+  int8_t result = 0;
+  while ( (length > 0U) && (result >= 0) )
+  {
+    uint32_t chunk = JOURNAL_PROGRAM_PAGE - ((_config.Flash_Offset + address) % JOURNAL_PROGRAM_PAGE);
+    if (chunk > length) { chunk = length; }
+    result = _flash.writeFlashBytes(_config.Flash_Offset + address, buffer, chunk);
+    address += chunk;
+    buffer += chunk;
+    length -= chunk;
+  }
+  return result;
+}
+
+int8_t FlashJournal::eraseSector(uint32_t sector)
+{
+  int8_t result = _flash.eraseFlashSector(_config.Flash_Offset + sectorStart(sector), _config.Flash_Sector_Size);
+  if (result >= 0) { _erasedSectors |= (1UL << sector); }
+  return result;
+}
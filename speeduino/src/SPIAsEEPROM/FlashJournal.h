@@ -0,0 +1,150 @@
+/* Speeduino flash journal
+ *
+ * This file is part of the Speeduino project.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ----------------- Explanation of the flash journal -------------------
+ * The byte emulation in SPIAsEEPROM.h writes every changed EEPROM byte separately and erases
+ * a flash sector whenever the history of a byte runs out. A full tune burn touches a few thousand
+ * bytes, so it is slow and can hit several sector erases.
+ *
+ * The journal instead stores whole records (Eg a config page) that are appended one after the other
+ * to a ring of flash sectors. Writing a record is a single sequential write and never needs an erase
+ * unless the ring has run out of erased sectors. Old copies of a record are left in place until their
+ * sector is reused.
+ *
+ * - Each record has a version. The record with the highest version for each id is the current one.
+ * - The CRC of a record is written after its payload, so a record that was interrupted by a power
+ *   loss never passes the CRC check and the previous version is used.
+ * - The sector after the one being written to is always kept erased. Moving on to it copies the
+ *   current records out of the sector after that (The oldest) before it is erased, so no current
+ *   record is ever lost.
+ * - maintain() does the move ahead of time when the current sector is nearly full, so that it
+ *   happens while the system is idle rather than during a burn.
+ *
+ * table 1: Each flash sector
+ * +--------------------+------------------------+-------------------------------------------------------+
+ * | Address in sector  |      Description       |                      Explanation                      |
+ * +--------------------+------------------------+-------------------------------------------------------+
+ * | 0                  | Sector header          | "Magic number and sector version (8 bytes)"           |
+ * | 8                  | Record 0               | "Record header (16 bytes) + payload, 4 byte aligned"  |
+ * | ....               | Record X               | ....                                                  |
+ * | ....               | Erased (0xFF)          | "Free space for following records"                    |
+ * +--------------------+------------------------+-------------------------------------------------------+
+ */
+
+#ifndef FLASH_JOURNAL_h
+#define FLASH_JOURNAL_h
+
+#include "SPIAsEEPROM.h"
+
+#define FLASH_JOURNAL_MAX_IDS       32U //Maximum number of different records
+#define FLASH_JOURNAL_MAX_SECTORS   32U
+#define FLASH_JOURNAL_NO_RECORD     0xFFFFFFFFUL
+
+typedef struct {
+  uint32_t Flash_Sectors_Used;  //Number of flash sectors in the ring. Must be at least 3
+  uint32_t Flash_Sector_Size;   //Flash sector size. Must be large enough to hold the largest record
+  uint32_t Flash_Offset;        //Start of the journal, relative to the base address of the flash class
+} Flash_Journal_Config;
+
+class FlashJournal
+{
+  public:
+    /**
+     * Provides the payload of a record as it is written
+     * @param id
+     * @param offset
+     * @param buffer
+     * @param length
+     */
+    typedef void (*dataSource)(uint8_t, uint16_t, byte*, uint16_t);
+
+    FlashJournal(FLASH_EEPROM_BaseClass&, Flash_Journal_Config);
+
+    /**
+     * Find the current version of every record. The flash class must already be initialised.
+     * @return success
+     */
+    int8_t begin();
+
+    /**
+     * Length of the current version of a record
+     * @param id
+     * @return length, 0 if there is no record with this id
+     */
+    uint16_t recordLength(uint8_t);
+
+    /**
+     * Read part of the current version of a record
+     * @param id
+     * @param offset
+     * @param buffer
+     * @param length
+     * @return success
+     */
+    int8_t readRecord(uint8_t, uint16_t, byte*, uint16_t);
+
+    /**
+     * Append a new version of a record
+     * @param id
+     * @param length
+     * @param source
+     * @return success
+     */
+    int8_t writeRecord(uint8_t, uint16_t, dataSource);
+
+    /**
+     * Moves on to a new sector if the current one is nearly full. Call when idle.
+     * @return success
+     */
+    int8_t maintain();
+
+  private:
+    struct SectorHeader {
+      uint32_t magic;
+      uint32_t version;
+    };
+
+    struct RecordHeader {
+      uint16_t magic;
+      uint8_t id;
+      uint8_t reserved;
+      uint16_t length;
+      uint16_t lengthCheck; //Inverse of length, to detect an incomplete header
+      uint32_t version;
+      uint32_t crc;         //CRC32 of the payload. Written last
+    };
+
+    uint32_t sectorStart(uint32_t);
+    uint32_t recordSize(uint16_t);
+    bool isSectorErased(uint32_t);
+    bool isRecordValid(uint32_t, const RecordHeader&);
+    uint32_t scanSector(uint32_t);
+    int8_t startSector(uint32_t);
+    int8_t collectSector(uint32_t);
+    int8_t advanceSector();
+    int8_t makeSpace(uint32_t);
+    int8_t readFlash(uint32_t, byte*, uint32_t);
+    int8_t programFlash(uint32_t, byte*, uint32_t);
+    int8_t eraseSector(uint32_t);
+
+    FLASH_EEPROM_BaseClass &_flash;
+    Flash_Journal_Config _config;
+
+    uint32_t _records[FLASH_JOURNAL_MAX_IDS];         //Address of the current version of each record
+    uint32_t _recordVersions[FLASH_JOURNAL_MAX_IDS];
+    uint16_t _recordLengths[FLASH_JOURNAL_MAX_IDS];
+    uint32_t _recordVersion = 0;  //Highest record version written so far
+    uint32_t _sectorVersion = 0;  //Version of the current sector
+    uint32_t _currentSector = 0;
+    uint32_t _writeAddress = 0;   //Address that the next record will be written to
+    uint32_t _erasedSectors = 0;  //Bit mask of the sectors that are known to be erased
+    bool _available = false;
+};
+
+#endif
@@ -143,6 +143,7 @@ typedef struct {
 //Base class for flash read and write. SPI and internal flash inherit from this class. 
 class FLASH_EEPROM_BaseClass 
 {
+  friend class FlashJournal; //The journal uses the flash access functions directly (See FlashJournal.h)
 
   public:
     FLASH_EEPROM_BaseClass(EEPROM_Emulation_Config);
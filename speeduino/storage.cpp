@@ -10,8 +10,15 @@ A full copy of the license may be found in the projects root directory
 #include "globals.h"
 #include EEPROM_LIB_H //This is defined in the board .h files
 #include "storage.h"
+#include "storage_dirty.h"
 #include "pages.h"
+#include "page_crc.h"
+#include "errors.h"
 #include "table3d_axis_io.h"
+#include "tuneBanks.h"
+#if defined(EEPROM_BACKGROUND_WRITES)
+  #include "scheduler.h"
+#endif
 
 
 #define EEPROM_DATA_VERSION   0
@@ -36,21 +43,143 @@ bool isEepromWritePending(void)
 }
 
 /** Write all config pages to EEPROM.
+ * For use after the config has been changed directly (Rather than through setPageValue()/setPageValues()), so every page is written in full
  */
 void writeAllConfig(void)
+{
+  uint8_t pageCount = getPageCount();
+  for (uint8_t page = 1U; page < pageCount; page++) { setPageDirty(page, 0U, getPageSize(page)); }
+  writePendingConfig();
+}
+
+/** Write the changed parts of all config pages to EEPROM.
+ * This is used to continue a burn that could not be completed in one go (See @ref isEepromWritePending)
+ */
+void writePendingConfig(void)
 {
   uint8_t pageCount = getPageCount();
   uint8_t page = 1U;
-  writeConfig(page);
+  writeConfigChanges(page);
   page = page + 1;
   while (page<pageCount && !isEepromWritePending())
   {
-    writeConfig(page);
+    writeConfigChanges(page);
     page = page + 1;
   }
 }
 
 
+//  ================================= Dirty block tracking ===============================
+// See storage_dirty.h
+static_assert(EEPROM_DIRTY_PAGE_SIZE >= MAX_PAGE_SIZE, "The largest page must fit in the dirty block tracking");
+static_assert(EEPROM_DIRTY_PAGES >= MAX_PAGE_COUNT, "Every page must have dirty block tracking");
+
+static dirty_blocks_t dirtyBlocks[EEPROM_DIRTY_PAGES];
+static uint16_t pageCRCPending = 0; //Bit per page. Set when a page has changed and the CRC stored for it is out of date (See writePageCRC())
+
+void setPageDirty(uint8_t pageNum, uint16_t offset, uint16_t length)
+{
+  if ( (pageNum < EEPROM_DIRTY_PAGES) && (length > 0U) )
+  {
+    markDirtyBlocks(dirtyBlocks[pageNum], offset, length);
+    BIT_SET(pageCRCPending, pageNum);
+  }
+}
+
+bool isPageDirty(uint8_t pageNum)
+{
+  bool isDirty = false;
+  if (pageNum < EEPROM_DIRTY_PAGES)
+  {
+    for (uint8_t x = 0; x < (EEPROM_DIRTY_BLOCKS / 8U); x++) { isDirty = isDirty || (dirtyBlocks[pageNum][x] != 0U); }
+  }
+  return isDirty;
+}
+
+#if defined(USE_FLASH_JOURNAL)
+static void clearPageDirty(uint8_t pageNum)
+{
+  if (pageNum < EEPROM_DIRTY_PAGES) { memset(dirtyBlocks[pageNum], 0, sizeof(dirtyBlocks[pageNum])); }
+}
+
+//  ================================= Journal records ===============================
+// Each config page is stored as the journal record with the same id as the page number. 
+// The tune bank pages of banks other than bank 0 have their own records (See getJournalRecordId() in tuneBanks.cpp)
+static_assert(JOURNAL_TUNE_BANK_RECORDS + ((TUNE_BANK_COUNT - 1U) * TUNE_BANK_PAGES) <= FLASH_JOURNAL_MAX_IDS, "Too many tune banks for the config journal");
+
+//Provides the payload of a record as it is written. This is the page in memory, which for the tune bank pages is that of the active bank
+static void getJournalRecordValues(uint8_t recordId, uint16_t offset, byte *buffer, uint16_t length)
+{
+  getPageValues(getJournalRecordPage(recordId), offset, buffer, length);
+}
+#endif
+
+//  ================================= Background writes (AVR) ===============================
+#if defined(EEPROM_BACKGROUND_WRITES)
+// Each EEPROM byte write on the AVR takes ~3.4ms, and the EEPROM library blocks until any previous write has completed before starting the next one.
+// Once the system is running, bytes to be burnt are instead queued and written one at a time by the EEPROM ready interrupt, so the main loop never waits on the EEPROM.
+// A write is never started when an ignition or injection edge is due soon, so the interrupt can't delay a schedule interrupt.
+// The 1ms timer resumes the writes once the edge has passed (See resumeEEPROMWrites()).
+#define EEPROM_QUEUE_SIZE   16U //Must be a power of 2
+#define EEPROM_WRITE_GUARD  uS_TO_TIMER_COMPARE(48U) //Time either side of a schedule edge that no write will be started in. Must be longer than the EEPROM ready interrupt
+
+struct eeprom_queue_entry {
+  uint16_t address;
+  uint8_t value;
+};
+static eeprom_queue_entry eepromQueue[EEPROM_QUEUE_SIZE];
+static volatile uint8_t eepromQueueHead = 0; //Free running index of the next entry to write. Only changed by the interrupt
+static volatile uint8_t eepromQueueTail = 0; //Free running index of the next free entry. Only changed by the main loop
+
+static inline uint8_t getEEPROMQueueCount(void) { return (uint8_t)(eepromQueueTail - eepromQueueHead); }
+
+static inline void queueEEPROMWrite(uint16_t address, uint8_t value)
+{
+  eepromQueue[eepromQueueTail & (EEPROM_QUEUE_SIZE - 1U)] = { address, value };
+  eepromQueueTail = eepromQueueTail + 1U;
+  BIT_SET(EECR, EERIE);
+}
+
+/** Restart the EEPROM ready interrupt if it was stopped to let a schedule edge pass. Called from the 1ms timer interrupt */
+void resumeEEPROMWrites(void)
+{
+  if (getEEPROMQueueCount() != 0U) { BIT_SET(EECR, EERIE); }
+}
+
+//The EEPROM ready interrupt fires continuously while the EEPROM is idle and the interrupt is enabled, so it is disabled whenever there is nothing it can write
+ISR(EE_READY_vect) //cppcheck-suppress misra-c2012-8.2
+{
+  if( (getEEPROMQueueCount() == 0U) || isScheduleEventDue(EEPROM_WRITE_GUARD) ) 
+  { 
+    BIT_CLEAR(EECR, EERIE);
+  }
+  else
+  {
+    const eeprom_queue_entry &entry = eepromQueue[eepromQueueHead & (EEPROM_QUEUE_SIZE - 1U)];
+    EEAR = entry.address;
+    BIT_SET(EECR, EERE);
+    //Only write bytes that have changed. If nothing is written the interrupt fires again straight away for the next entry
+    if (EEDR != entry.value)
+    {
+      EEDR = entry.value;
+      BIT_SET(EECR, EEMPE);
+      BIT_SET(EECR, EEPE); //Must be within 4 cycles of setting EEMPE
+    }
+    eepromQueueHead = eepromQueueHead + 1U;
+  }
+}
+
+static inline bool isBackgroundWriteActive(void) { return currentStatus.initialisationComplete; } //Startup (Including the updates in updates.cpp) writes directly
+#endif
+
+/** Wait for any queued background writes to complete. Must be called before the EEPROM is accessed directly */
+static inline void waitForEEPROMWrites(void)
+{
+#if defined(EEPROM_BACKGROUND_WRITES)
+  while (getEEPROMQueueCount() != 0U) { } //The queue is emptied by the EEPROM ready interrupt
+#endif
+}
+
 //  ================================= Internal write support ===============================
 struct write_location {
   eeprom_address_t address; // EEPROM address to write next
@@ -63,6 +192,15 @@ struct write_location {
   */
   void update(uint8_t value)
   {
+#if defined(EEPROM_BACKGROUND_WRITES)
+    if (isBackgroundWriteActive())
+    {
+      //The comparison with the stored value is made by the interrupt, as the EEPROM can't be read while it is being written
+      queueEEPROMWrite((uint16_t)address, value);
+      ++counter;
+      return;
+    }
+#endif
     if (EEPROM.read(address)!=value)
     {
       EEPROM.write(address, value);
@@ -70,21 +208,11 @@ struct write_location {
     }
   }
 
-  /** Create a copy with a different write address.
-   * Allows chaining of instances.
-   */
-  write_location changeWriteAddress(eeprom_address_t newAddress) const {
-    return { newAddress, counter, write_block_size };
-  }
-
-  write_location& operator++()
-  {
-    ++address;
-    return *this;
-  }
-
   bool can_write() const
   {
+#if defined(EEPROM_BACKGROUND_WRITES)
+    if (isBackgroundWriteActive()) { return getEEPROMQueueCount() < EEPROM_QUEUE_SIZE; } //Writes don't block, so the only limit is the queue
+#endif
     bool canWrite = false;
     if(currentStatus.RPM > 0) { canWrite = (counter <= write_block_size); }
     else { canWrite = (counter <= (write_block_size * 8)); } //Write to EEPROM more aggressively if the engine is not running
@@ -93,64 +221,190 @@ struct write_location {
   }
 };
 
-static inline write_location write_range(const byte *pStart, const byte *pEnd, write_location location)
+/** EEPROM address of the start of each entity of a page. The entities are in the same order as in map_page_offset_to_entity() (pages.cpp). 
+ * See storage.h for the layout
+ */
+static eeprom_address_t getEntityAddress(uint8_t pageNum, uint8_t entityNum)
 {
-  while ( location.can_write() && pStart!=pEnd)
+  static constexpr uint16_t PROGMEM boostvvtAddresses[] = { EEPROM_CONFIG7_MAP1, EEPROM_CONFIG7_MAP2, EEPROM_CONFIG7_MAP3 };
+  static constexpr uint16_t PROGMEM seqFuelAddresses[] = { EEPROM_CONFIG8_MAP1, EEPROM_CONFIG8_MAP2, EEPROM_CONFIG8_MAP3, EEPROM_CONFIG8_MAP4, EEPROM_CONFIG8_MAP5, EEPROM_CONFIG8_MAP6, EEPROM_CONFIG8_MAP7, EEPROM_CONFIG8_MAP8 };
+  static constexpr uint16_t PROGMEM wmiAddresses[] = { EEPROM_CONFIG12_MAP, EEPROM_CONFIG12_MAP2, EEPROM_CONFIG12_MAP3 };
+  static constexpr uint16_t PROGMEM boostvvt2Addresses[] = { EEPROM_CONFIG15_MAP, EEPROM_CONFIG15_START };
+
+  eeprom_address_t address = 0;
+  switch(pageNum)
   {
-    location.update(*pStart);
-    ++pStart; 
-    ++location;
+    case veMapPage: address = EEPROM_CONFIG1_MAP; break;
+    case veSetPage: address = EEPROM_CONFIG2_START; break;
+    case ignMapPage: address = EEPROM_CONFIG3_MAP; break;
+    case ignSetPage: address = EEPROM_CONFIG4_START; break;
+    case afrMapPage: address = EEPROM_CONFIG5_MAP; break;
+    case afrSetPage: address = EEPROM_CONFIG6_START; break;
+    case boostvvtPage: address = pgm_read_word(&boostvvtAddresses[entityNum]); break;
+    case seqFuelPage: address = pgm_read_word(&seqFuelAddresses[entityNum]); break;
+    case canbusPage: address = EEPROM_CONFIG9_START; break;
+    case warmupPage: address = EEPROM_CONFIG10_START; break;
+    case fuelMap2Page: address = EEPROM_CONFIG11_MAP; break;
+    case wmiMapPage: address = pgm_read_word(&wmiAddresses[entityNum]); break;
+    case progOutsPage: address = EEPROM_CONFIG13_START; break;
+    case ignMap2Page: address = EEPROM_CONFIG14_MAP; break;
+    case boostvvtPage2: address = pgm_read_word(&boostvvt2Addresses[entityNum]); break;
+    default: break;
   }
-  return location;
+  return address;
 }
 
-static inline write_location write(const table_row_iterator &row, write_location location)
+/** Offset of a byte from the start of its entity's EEPROM storage
+ * @param entity - The entity containing the byte
+ * @param offset - Offset of the byte within the page
+ */
+static uint16_t getEntityStorageOffset(const page_iterator_t &entity, uint16_t offset)
 {
-  return write_range(&*row, row.end(), location);
+  uint16_t entityOffset = offset - entity.start;
+  if (Table==entity.type)
+  {
+    #define CTA_STORAGE_OFFSET(size, xDomain, yDomain, entityOffset) \
+        return table_storage_offset<TABLE3D_TYPENAME_BASE(size, xDomain, yDomain)>(entityOffset);
+    #define CTA_STORAGE_OFFSET_DEFAULT ({ return entityOffset; })
+    CONCRETE_TABLE_ACTION(entity.table_key, CTA_STORAGE_OFFSET, CTA_STORAGE_OFFSET_DEFAULT, entityOffset);
+  }
+  return entityOffset;
 }
 
-static inline write_location write(table_value_iterator it, write_location location)
-{
-  while (location.can_write() && !it.at_end())
+/** The bytes of a page and where they are stored, for writeDirtyBlocks() in storage_dirty.h.
+ * The offsets must be visited in increasing order, as the entities are moved through as they are reached
+ */
+struct page_storage {
+  uint8_t pageNum;
+  page_iterator_t entity;
+  uint8_t entityNum;
+
+  void getValues(uint16_t offset, byte *buffer, uint16_t length) const
   {
-    location = write(*it, location);
-    ++it;
+    getPageValues(pageNum, offset, buffer, length);
   }
+
+  bool getStorageAddress(uint16_t offset, eeprom_address_t &address)
+  {
+    //Move on to the entity that holds this byte
+    while ( (End!=entity.type) && (offset >= (entity.start + entity.size)) )
+    {
+      entity = advance(entity);
+      entityNum++;
+    }
+    if ( (Raw!=entity.type) && (Table!=entity.type) ) { return false; }
+    address = getEntityAddress(pageNum, entityNum) + getEntityStorageOffset(entity, offset);
+    return true;
+  }
+};
+
+/** Write the dirty blocks of a page to the EEPROM (See writeDirtyBlocks() in storage_dirty.h) */
+static write_location writePageDirtyBlocks(uint8_t pageNum, write_location location)
+{
+  if (pageNum >= EEPROM_DIRTY_PAGES) { return location; }
+
+  page_storage page = { pageNum, page_begin(pageNum), 0 };
+  writeDirtyBlocks(dirtyBlocks[pageNum], getPageSize(pageNum), page, location);
   return location;
 }
 
-static inline write_location write(table_axis_iterator it, write_location location)
+// The page CRCs are stored directly below the calibration CRCs, last page first
+static eeprom_address_t compute_crc_address(uint8_t pageNum)
+{
+  return EEPROM_CALIBRATION_CLT_CRC-((getPageCount() - pageNum)*sizeof(uint32_t));
+}
+
+/** CRC32 of a page as it is stored in the EEPROM. This matches calculatePageCRC32() for the page once it has been loaded by loadConfig().
+ * The stored CRC is calculated from the EEPROM rather than from the page in memory, as some settings are changed in memory without being burnt (Eg The trigger settings that some decoders override)
+ */
+static uint32_t computeStoredPageCRC32(uint8_t pageNum)
 {
-  const table3d_axis_io_converter converter = get_table3d_axis_converter(it.get_domain());
-  while (location.can_write() && !it.at_end())
+  FastCRC32 crcCalc;
+  const uint16_t pageSize = getPageSize(pageNum);
+  page_iterator_t entity = page_begin(pageNum);
+  uint8_t entityNum = 0;
+  byte values[EEPROM_DIRTY_BLOCK_SIZE];
+  uint32_t crc = 0;
+
+  uint16_t offset = 0;
+  while (offset < pageSize)
   {
-    location.update(converter.to_byte(*it));
-    ++location;
-    ++it;
+    uint8_t length = 0;
+    while ( (length < sizeof(values)) && (offset < pageSize) )
+    {
+      while ( (End!=entity.type) && (offset >= (entity.start + entity.size)) )
+      {
+        entity = advance(entity);
+        entityNum++;
+      }
+      //Anything that isn't stored (Padding and the end of the page) is 0, the same as in calculatePageCRC32()
+      values[length] = 0U;
+      if ( (Raw==entity.type) || (Table==entity.type) ) { values[length] = EEPROM.read(getEntityAddress(pageNum, entityNum) + getEntityStorageOffset(entity, offset)); }
+      ++length;
+      ++offset;
+    }
+    crc = (offset == length) ? crcCalc.crc32(values, length, false) : crcCalc.crc32_upd(values, length, false);
   }
-  return location;
+  return ~crc;
 }
 
-
-static inline write_location writeTable(void *pTable, table_type_t key, write_location location)
+/** Store the CRC of a page once all of its changes have been written to the EEPROM. The CRC is used to check the page when it is next loaded (See verifyConfigCRCs())
+ * The CRC is written through the same write limit as the page, and stays pending until all 4 bytes have been written
+ */
+static write_location writePageCRC(uint8_t pageNum, write_location location)
 {
-  return write(y_rbegin(pTable, key), 
-                write(x_begin(pTable, key), 
-                  write(rows_begin(pTable, key), location)));
+  if ( (pageNum >= EEPROM_DIRTY_PAGES) || !BIT_CHECK(pageCRCPending, pageNum) || isPageDirty(pageNum) ) { return location; }
+#if defined(EEPROM_BACKGROUND_WRITES)
+  if (isBackgroundWriteActive() && (getEEPROMQueueCount() != 0U)) { return location; } //The page can only be read back once all of its queued writes have completed
+#endif
+
+  uint32_t crc = computeStoredPageCRC32(pageNum);
+  const byte *pCRC = (const byte *)&crc; //Same byte order as EEPROM.put() in storePageCRC32()
+  location.address = compute_crc_address(pageNum);
+  uint8_t written = 0;
+  while ( (written < sizeof(crc)) && location.can_write() )
+  {
+    location.update(pCRC[written]);
+    ++location.address;
+    ++written;
+  }
+  if (written == sizeof(crc)) { BIT_CLEAR(pageCRCPending, pageNum); }
+  return location;
 }
 
 //Simply an alias for EEPROM.update()
-void EEPROMWriteRaw(uint16_t address, uint8_t data) { EEPROM.update(address, data); }
-uint8_t EEPROMReadRaw(uint16_t address) { return EEPROM.read(address); }
+void EEPROMWriteRaw(uint16_t address, uint8_t data) { waitForEEPROMWrites(); EEPROM.update(address, data); }
+uint8_t EEPROMReadRaw(uint16_t address) { waitForEEPROMWrites(); return EEPROM.read(address); }
 
 //  ================================= End write support ===============================
 
-/** Write a table or map to EEPROM storage.
-Takes the current configuration (config pages and maps)
-and writes them to EEPROM as per the layout defined in storage.h.
+/** Write a config page to EEPROM storage in full.
+For use after the page has been changed directly (Rather than through setPageValue()/setPageValues()).
+Takes the current configuration (config pages and maps) and writes them to EEPROM as per the layout defined in storage.h.
 */
 void writeConfig(uint8_t pageNum)
 {
+  invalidatePageCRC(pageNum); //The page has been changed directly, so its cached CRC may be stale
+  setPageDirty(pageNum, 0U, getPageSize(pageNum));
+  writeConfigChanges(pageNum);
+}
+
+/** Write the parts of a config page that have changed since they were last written to EEPROM storage.
+*/
+void writeConfigChanges(uint8_t pageNum)
+{
+#if defined(USE_FLASH_JOURNAL)
+  //The whole page is appended to the journal in a single sequential write. The EEPROM copy of the page is no longer updated
+  bool isWritten = true;
+  //A tune bank page can only have changed in the active bank, as a bank can't be switched while it has unburnt changes
+  if (isPageDirty(pageNum)) { isWritten = (configJournal.writeRecord(getJournalRecordId(pageNum, activeTuneBank), getPageSize(pageNum), getJournalRecordValues) >= 0); }
+  if (isWritten)
+  {
+    clearPageDirty(pageNum);
+    BIT_CLEAR(pageCRCPending, pageNum); //Each journal record has its own CRC, so no page CRC is stored
+  }
+  BIT_WRITE(currentStatus.status4, BIT_STATUS4_BURNPENDING, !isWritten);
+#else
 //The maximum number of write operations that will be performed in one go.
 //If we try to write to the EEPROM too fast (Eg Each write takes ~3ms on the AVR) then 
 //the rest of the system can hang)
@@ -166,6 +420,7 @@ void writeConfig(uint8_t pageNum)
   #ifdef CORE_AVR
     //In order to prevent missed pulses during EEPROM writes on AVR, scale the
     //maximum write block size based on the RPM.
+    //Once initialisation is complete the writes are made in the background instead (See EEPROM_BACKGROUND_WRITES) and this limit is not used
     //This calculation is based on EEPROM writes taking approximately 4ms per byte
     //(Actual value is 3.8ms, so 4ms has some safety margin) 
     if(currentStatus.RPM > 65) //Min RPM of 65 prevents overflow of uint8_t
@@ -178,153 +433,21 @@ void writeConfig(uint8_t pageNum)
 
 #endif
 
-  write_location result = { 0, 0, EEPROM_MAX_WRITE_BLOCK };
-
-  switch(pageNum)
-  {
-    case veMapPage:
-      /*---------------------------------------------------
-      | Fuel table (See storage.h for data layout) - Page 1
-      | 16x16 table itself + the 16 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&fuelTable, decltype(fuelTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG1_MAP));
-      break;
-
-    case veSetPage:
-      /*---------------------------------------------------
-      | Config page 2 (See storage.h for data layout)
-      | 64 byte long config table
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage2, (byte *)&configPage2+sizeof(configPage2), result.changeWriteAddress(EEPROM_CONFIG2_START));
-      break;
-
-    case ignMapPage:
-      /*---------------------------------------------------
-      | Ignition table (See storage.h for data layout) - Page 1
-      | 16x16 table itself + the 16 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&ignitionTable, decltype(ignitionTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG3_MAP));
-      break;
-
-    case ignSetPage:
-      /*---------------------------------------------------
-      | Config page 2 (See storage.h for data layout)
-      | 64 byte long config table
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage4, (byte *)&configPage4+sizeof(configPage4), result.changeWriteAddress(EEPROM_CONFIG4_START));
-      break;
-
-    case afrMapPage:
-      /*---------------------------------------------------
-      | AFR table (See storage.h for data layout) - Page 5
-      | 16x16 table itself + the 16 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&afrTable, decltype(afrTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG5_MAP));
-      break;
-
-    case afrSetPage:
-      /*---------------------------------------------------
-      | Config page 3 (See storage.h for data layout)
-      | 64 byte long config table
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage6, (byte *)&configPage6+sizeof(configPage6), result.changeWriteAddress(EEPROM_CONFIG6_START));
-      break;
-
-    case boostvvtPage:
-      /*---------------------------------------------------
-      | Boost and vvt tables (See storage.h for data layout) - Page 8
-      | 8x8 table itself + the 8 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&boostTable, decltype(boostTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG7_MAP1));
-      result = writeTable(&vvtTable, decltype(vvtTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG7_MAP2));
-      result = writeTable(&stagingTable, decltype(stagingTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG7_MAP3));
-      break;
-
-    case seqFuelPage:
-      /*---------------------------------------------------
-      | Fuel trim tables (See storage.h for data layout) - Page 9
-      | 6x6 tables itself + the 6 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&trim1Table, decltype(trim1Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP1));
-      result = writeTable(&trim2Table, decltype(trim2Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP2));
-      result = writeTable(&trim3Table, decltype(trim3Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP3));
-      result = writeTable(&trim4Table, decltype(trim4Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP4));
-      result = writeTable(&trim5Table, decltype(trim5Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP5));
-      result = writeTable(&trim6Table, decltype(trim6Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP6));
-      result = writeTable(&trim7Table, decltype(trim7Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP7));
-      result = writeTable(&trim8Table, decltype(trim8Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG8_MAP8));
-      break;
-
-    case canbusPage:
-      /*---------------------------------------------------
-      | Config page 10 (See storage.h for data layout)
-      | 192 byte long config table
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage9, (byte *)&configPage9+sizeof(configPage9), result.changeWriteAddress(EEPROM_CONFIG9_START));
-      break;
-
-    case warmupPage:
-      /*---------------------------------------------------
-      | Config page 11 (See storage.h for data layout)
-      | 192 byte long config table
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage10, (byte *)&configPage10+sizeof(configPage10), result.changeWriteAddress(EEPROM_CONFIG10_START));
-      break;
-
-    case fuelMap2Page:
-      /*---------------------------------------------------
-      | Fuel table 2 (See storage.h for data layout)
-      | 16x16 table itself + the 16 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&fuelTable2, decltype(fuelTable2)::type_key, result.changeWriteAddress(EEPROM_CONFIG11_MAP));
-      break;
-
-    case wmiMapPage:
-      /*---------------------------------------------------
-      | WMI and Dwell tables (See storage.h for data layout) - Page 12
-      | 8x8 WMI table itself + the 8 values along each of the axis
-      | 8x8 VVT2 table + the 8 values along each of the axis
-      | 4x4 Dwell table itself + the 4 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&wmiTable, decltype(wmiTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG12_MAP));
-      result = writeTable(&vvt2Table, decltype(vvt2Table)::type_key, result.changeWriteAddress(EEPROM_CONFIG12_MAP2));
-      result = writeTable(&dwellTable, decltype(dwellTable)::type_key, result.changeWriteAddress(EEPROM_CONFIG12_MAP3));
-      break;
-      
-    case progOutsPage:
-      /*---------------------------------------------------
-      | Config page 13 (See storage.h for data layout)
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage13, (byte *)&configPage13+sizeof(configPage13), result.changeWriteAddress(EEPROM_CONFIG13_START));
-      break;
-    
-    case ignMap2Page:
-      /*---------------------------------------------------
-      | Ignition table (See storage.h for data layout) - Page 1
-      | 16x16 table itself + the 16 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&ignitionTable2, decltype(ignitionTable2)::type_key, result.changeWriteAddress(EEPROM_CONFIG14_MAP));
-      break;
+  write_location result = writePageCRC(pageNum, writePageDirtyBlocks(pageNum, { 0, 0, EEPROM_MAX_WRITE_BLOCK }));
 
-    case boostvvtPage2:
-      /*---------------------------------------------------
-      | Boost duty cycle lookuptable (See storage.h for data layout) - Page 15
-      | 8x8 table itself + the 8 values along each of the axis
-      -----------------------------------------------------*/
-      result = writeTable(&boostTableLookupDuty, decltype(boostTableLookupDuty)::type_key, result.changeWriteAddress(EEPROM_CONFIG15_MAP));
-
-      /*---------------------------------------------------
-      | Config page 15 (See storage.h for data layout)
-      -----------------------------------------------------*/
-      result = write_range((byte *)&configPage15, (byte *)&configPage15+sizeof(configPage15), result.changeWriteAddress(EEPROM_CONFIG15_START));
-      break;
-
-    default:
-      break;
-  }
+  //The burn continues until the page CRC has been stored. This can be later than the last block when the writes are queued (See writePageCRC())
+  BIT_WRITE(currentStatus.status4, BIT_STATUS4_BURNPENDING, !result.can_write() || ((pageNum < EEPROM_DIRTY_PAGES) && BIT_CHECK(pageCRCPending, pageNum)));
+#endif
+}
 
-  BIT_WRITE(currentStatus.status4, BIT_STATUS4_BURNPENDING, !result.can_write());
+#if defined(USE_FLASH_JOURNAL)
+/** Move the config journal on to a new flash sector if it is nearly full. The sector erase this needs takes 10s of ms, so this should only be called when idle
+ */
+void maintainConfigJournal(void)
+{
+  configJournal.maintain();
 }
+#endif
 
 /** Reset all configPage* structs (2,4,6,9,10,13) and write them full of null-bytes.
  */
@@ -367,40 +490,68 @@ static inline eeprom_address_t load_range(eeprom_address_t address, byte *pFirst
 #endif
 }
 
-static inline eeprom_address_t load(table_row_iterator row, eeprom_address_t address)
+/** Reads the EEPROM in order, for the table loads in storage_dirty.h */
+struct eeprom_reader {
+  eeprom_address_t address; // EEPROM address to read next
+
+  void read(byte *pBuffer, uint8_t length)
+  {
+    address = load_range(address, pBuffer, pBuffer + length);
+  }
+};
+
+static inline eeprom_address_t loadTable(void *pTable, table_type_t key, eeprom_address_t address)
 {
-  return load_range(address, &*row, row.end());
+  eeprom_reader reader = { address };
+  loadTableStorage(reader, pTable, key);
+  return reader.address;
 }
 
-static inline eeprom_address_t load(table_value_iterator it, eeprom_address_t address)
+#if defined(USE_FLASH_JOURNAL)
+/** Replace a page in memory with a record from the config journal. The page is left as it is if there is no record */
+static void loadJournalPage(uint8_t recordId, uint8_t pageNum)
 {
-  while (!it.at_end())
+  byte values[64];
+  uint16_t length = configJournal.recordLength(recordId);
+  if (length > getPageSize(pageNum)) { length = getPageSize(pageNum); } //Page has been made smaller by a firmware update
+  uint16_t offset = 0;
+  while (offset < length)
   {
-    address = load(*it, address);
-    ++it;
+    uint16_t chunk = (uint16_t)(length - offset) < sizeof(values) ? (uint16_t)(length - offset) : (uint16_t)sizeof(values);
+    configJournal.readRecord(recordId, offset, values, chunk);
+    setPageValues(pageNum, offset, values, chunk);
+    offset = offset + chunk;
   }
-  return address; 
+  clearPageDirty(pageNum);
 }
 
-static inline eeprom_address_t load(table_axis_iterator it, eeprom_address_t address)
+/** Replace the pages loaded from the EEPROM with the latest copy from the config journal. 
+ * Pages that have not been burnt since the journal was enabled don't have a record, so the EEPROM copy is kept for them
+ */
+static void loadJournalPages(void)
 {
-    const table3d_axis_io_converter converter = get_table3d_axis_converter(it.get_domain());
-  while (!it.at_end())
+  if (configJournal.begin() < 0)
   {
-    *it = converter.from_byte(EEPROM.read(address));
-    ++address;
-    ++it;
+    //The journal can't be used. Only the EEPROM copy of the tune is left, which hasn't been updated since the journal was first used, so this must be reported.
+    //Every burn will also fail (And leave BURNPENDING set) until the journal can be read again
+    setError(ERR_CONFIG_JOURNAL);
+    return;
   }
-  return address;    
-}
 
+  for (uint8_t page = 1; page < getPageCount(); page++) { loadJournalPage(page, page); }
 
-static inline eeprom_address_t loadTable(void *pTable, table_type_t key, eeprom_address_t address)
-{
-  return load(y_rbegin(pTable, key),
-                load(x_begin(pTable, key), 
-                  load(rows_begin(pTable, key), address)));
+#if TUNE_BANK_COUNT > 1
+  //Every other bank starts as a copy of bank 0, and then has whichever of its own tables have been stored loaded over the top
+  initialiseTuneBanks();
+  for (uint8_t bank = 1; bank < TUNE_BANK_COUNT; bank++)
+  {
+    setTuneBankTables(bank);
+    for (uint8_t index = 0; index < TUNE_BANK_PAGES; index++) { loadJournalPage(getJournalRecordId(getTuneBankPage(index), bank), getTuneBankPage(index)); }
+  }
+  setTuneBankTables(0);
+#endif
 }
+#endif
 
 //  ================================= End internal read support ===============================
 
@@ -475,6 +626,28 @@ void loadConfig(void)
   load_range(EEPROM_CONFIG15_START, (byte *)&configPage15, (byte *)&configPage15+sizeof(configPage15));  
 
   //*********************************************************************************************************************************************************************************
+#if defined(USE_FLASH_JOURNAL)
+  loadJournalPages();
+#endif
+}
+
+/** Check each config page against the CRC that was stored when it was last burnt (See writePageCRC()). 
+ * A page that doesn't match has been corrupted or had its last burn interrupted, and is reported with @ref ERR_CONFIG_CRC.
+ * Must be called straight after the config has been loaded and updated, before anything changes the pages in memory.
+ * The rest of init still changes some of the pages directly, so the page CRC cache is cleared again once init is complete (See initialiseAll())
+ */
+void verifyConfigCRCs(void)
+{
+#if !defined(USE_FLASH_JOURNAL) //Each journal record has its own CRC, and a record that fails it is never loaded
+  bool isValid = true;
+  for (uint8_t page = 1; page < getPageCount(); page++)
+  {
+    uint32_t storedCRC = readPageCRC32(page);
+    //A page that is still being burnt, or has never had a CRC stored (Erased EEPROM), can't be checked
+    if ( !BIT_CHECK(pageCRCPending, page) && (storedCRC != 0xFFFFFFFFUL) ) { isValid = isValid && (calculatePageCRC32(page) == storedCRC); }
+  }
+  if (!isValid) { setError(ERR_CONFIG_CRC); }
+#endif
 }
 
 /** Read the calibration information from EEPROM.
@@ -501,6 +674,7 @@ and saves them to the EEPROM.
 */
 void writeCalibration(void)
 {
+  waitForEEPROMWrites();
   // If you modify this function be sure to also modify loadCalibration();
   // it should be a mirror image of this function.
 
@@ -516,6 +690,7 @@ void writeCalibration(void)
 
 void writeCalibrationPage(uint8_t pageNum)
 {
+  waitForEEPROMWrites();
   if(pageNum == O2_CALIBRATION_PAGE)
   {
     EEPROM.put(EEPROM_CALIBRATION_O2_BINS, o2Calibration_bins);
@@ -533,11 +708,6 @@ void writeCalibrationPage(uint8_t pageNum)
   }
 }
 
-static eeprom_address_t compute_crc_address(uint8_t pageNum)
-{
-  return EEPROM_LAST_BARO-((getPageCount() - pageNum)*sizeof(uint32_t));
-}
-
 /** Write CRC32 checksum to EEPROM.
 Takes a page number and CRC32 value then stores it in the relevant place in EEPROM
 @param pageNum - Config page number
@@ -545,6 +715,7 @@ Takes a page number and CRC32 value then stores it in the relevant place in EEPR
 */
 void storePageCRC32(uint8_t pageNum, uint32_t crcValue)
 {
+  waitForEEPROMWrites();
   EEPROM.put(compute_crc_address(pageNum), crcValue);
 }
 
@@ -553,6 +724,7 @@ void storePageCRC32(uint8_t pageNum, uint32_t crcValue)
 */
 uint32_t readPageCRC32(uint8_t pageNum)
 {
+  waitForEEPROMWrites();
   uint32_t crc32_val;
   return EEPROM.get(compute_crc_address(pageNum), crc32_val);
 }
@@ -563,6 +735,7 @@ uint32_t readPageCRC32(uint8_t pageNum)
 */
 void storeCalibrationCRC32(uint8_t calibrationPageNum, uint32_t calibrationCRC)
 {
+  waitForEEPROMWrites();
   uint16_t targetAddress;
   switch(calibrationPageNum)
   {
@@ -588,6 +761,7 @@ void storeCalibrationCRC32(uint8_t calibrationPageNum, uint32_t calibrationCRC)
 */
 uint32_t readCalibrationCRC32(uint8_t calibrationPageNum)
 {
+  waitForEEPROMWrites();
   uint32_t crc32_val;
   uint16_t targetAddress;
   switch(calibrationPageNum)
@@ -618,9 +792,9 @@ uint16_t getEEPROMSize(void)
 // Utility functions.
 // By having these in this file, it prevents other files from calling EEPROM functions directly. This is useful due to differences in the EEPROM libraries on different devces
 /// Read last stored barometer reading from EEPROM.
-byte readLastBaro(void) { return EEPROM.read(EEPROM_LAST_BARO); }
+byte readLastBaro(void) { waitForEEPROMWrites(); return EEPROM.read(EEPROM_LAST_BARO); }
 /// Write last acquired arometer reading to EEPROM.
-void storeLastBaro(byte newValue) { EEPROM.update(EEPROM_LAST_BARO, newValue); }
+void storeLastBaro(byte newValue) { waitForEEPROMWrites(); EEPROM.update(EEPROM_LAST_BARO, newValue); }
 /// Read EEPROM current data format version (from offset EEPROM_DATA_VERSION).
 byte readEEPROMVersion(void) { return EEPROM.read(EEPROM_DATA_VERSION); }
 /// Store EEPROM current data format version (to offset EEPROM_DATA_VERSION).
@@ -104,11 +104,13 @@
  * | 3283       |1           | boostControlEnableThreshold          |                                    |
  * | 3284       |14          | A/C Control Settings                 |                                    |
  * | 3298       |159         | Page 15 spare                        |                                    |
- * | 3457       |217         | EMPTY                                |                                    |
+ * | 3457       |64          | Learnt fuel trims (8x8)              | @ref EEPROM_FUEL_LEARN             |
+ * | 3521       |93          | EMPTY                                |                                    |
+ * | 3614       |60          | Page CRC32 sums (4x15)               | Last first, 15 -> 1                |
  * | 3674       |4           | CLT Calibration CRC32                |                                    |
  * | 3678       |4           | IAT Calibration CRC32                |                                    |
  * | 3682       |4           | O2 Calibration CRC32                 |                                    |
- * | 3686       |56          | Page CRC32 sums (4x14)               | Last first, 14 -> 1                |
+ * | 3686       |56          | EMPTY (Previously page CRC32 sums)   |                                    |
  * | 3742       |1           | Baro value saved at init             | @ref EEPROM_LAST_BARO              |
  * | 3743       |64          | O2 Calibration Bins                  | @ref EEPROM_CALIBRATION_O2_BINS    |
  * | 3807       |32          | O2 Calibration Values                | @ref EEPROM_CALIBRATION_O2_VALUES  |
@@ -121,10 +123,15 @@
  */
 
 void writeAllConfig(void);
+void writePendingConfig(void);
 void writeConfig(uint8_t pageNum);
+void writeConfigChanges(uint8_t pageNum);
+void setPageDirty(uint8_t pageNum, uint16_t offset, uint16_t length);
+bool isPageDirty(uint8_t pageNum);
 void EEPROMWriteRaw(uint16_t address, uint8_t data);
 uint8_t EEPROMReadRaw(uint16_t address);
 void loadConfig(void);
+void verifyConfigCRCs(void);
 void loadCalibration(void);
 void writeCalibration(void);
 void writeCalibrationPage(uint8_t pageNum);
@@ -141,6 +148,12 @@ void storeCalibrationCRC32(uint8_t calibrationPageNum, uint32_t calibrationCRC);
 uint32_t readCalibrationCRC32(uint8_t calibrationPageNum);
 uint16_t getEEPROMSize(void);
 bool isEepromWritePending(void);
+#if defined(EEPROM_BACKGROUND_WRITES)
+void resumeEEPROMWrites(void);
+#endif
+#if defined(USE_FLASH_JOURNAL)
+void maintainConfigJournal(void);
+#endif
 
 extern uint32_t deferEEPROMWritesUntil;
 
@@ -185,6 +198,7 @@ extern uint32_t deferEEPROMWritesUntil;
 #define EEPROM_CONFIG15_MAP   3199
 #define EEPROM_CONFIG15_START 3281
 #define EEPROM_CONFIG15_END   3457
+#define EEPROM_FUEL_LEARN     3457
 
 
 #define EEPROM_CALIBRATION_CLT_CRC  3674
@@ -0,0 +1,127 @@
+#ifndef STORAGE_DIRTY_H
+#define STORAGE_DIRTY_H
+
+/** @file storage_dirty.h
+ * @brief Dirty block tracking of the config pages, and the mapping of a page byte to where it is stored in the EEPROM
+ *
+ * Each page is split into blocks of EEPROM_DIRTY_BLOCK_SIZE bytes. A block is marked dirty when any byte in it is set through setPageValue()/setPageValues()
+ * and cleared once the whole block has been written to the EEPROM. Burns then only need to visit the dirty blocks rather than comparing every byte of the page.
+ * The EEPROM access is passed in by storage.cpp, so this has no hardware dependencies and can be tested on the host (See test/test_storage_native).
+ */
+#include <stdint.h>
+#include "table3d.h"
+#include "table3d_axis_io.h"
+
+#define EEPROM_DIRTY_BLOCK_SIZE   16U
+#define EEPROM_DIRTY_PAGES        16U //Must be at least the page count in pages.cpp
+#define EEPROM_DIRTY_BLOCKS       24U //Blocks in the largest page (384 bytes)
+#define EEPROM_DIRTY_PAGE_SIZE    (EEPROM_DIRTY_BLOCKS * EEPROM_DIRTY_BLOCK_SIZE) //The largest page that can be tracked
+
+typedef uint8_t dirty_blocks_t[EEPROM_DIRTY_BLOCKS / 8U]; //Bit per block of a page
+
+/** Marks the blocks holding the given range of a page as dirty. The range is clipped to EEPROM_DIRTY_PAGE_SIZE */
+static inline void markDirtyBlocks(dirty_blocks_t &blocks, uint16_t offset, uint16_t length)
+{
+  if ( (length == 0U) || (offset >= EEPROM_DIRTY_PAGE_SIZE) ) { return; }
+
+  uint16_t lastBlock = (offset + length - 1U) / EEPROM_DIRTY_BLOCK_SIZE;
+  if (lastBlock >= EEPROM_DIRTY_BLOCKS) { lastBlock = EEPROM_DIRTY_BLOCKS - 1U; }
+  for (uint16_t block = offset / EEPROM_DIRTY_BLOCK_SIZE; block <= lastBlock; block++)
+  {
+    blocks[block >> 3] |= (uint8_t)(1U << (block & 7U));
+  }
+}
+
+static inline bool isDirtyBlock(const dirty_blocks_t &blocks, uint8_t block)
+{
+  return (blocks[block >> 3] & (1U << (block & 7U))) != 0U;
+}
+
+static inline void clearDirtyBlock(dirty_blocks_t &blocks, uint8_t block)
+{
+  blocks[block >> 3] &= (uint8_t)~(1U << (block & 7U));
+}
+
+/** Offset of a table byte from the start of the table's EEPROM storage.
+ * Tables are stored as the values and X axis in the same order as the page, followed by the Y axis in reverse order (See loadTableStorage())
+ * @param table_offset - Offset of the byte from the start of the table in the page
+ */
+template <class table_t>
+static inline uint16_t table_storage_offset(uint16_t table_offset)
+{
+  constexpr uint16_t yAxisStart = (table_t::xaxis_t::length * table_t::yaxis_t::length) + table_t::xaxis_t::length;
+  return table_offset < yAxisStart ? table_offset : (yAxisStart + table_t::yaxis_t::length - 1U) - (table_offset - yAxisStart);
+}
+
+/**
+ * Write the dirty blocks of a page to the EEPROM. Each block is marked clean once it has been completely written.
+ * Stops once the write limit is reached, leaving the remaining blocks dirty to be written later
+ * @param page - Provides the page bytes: getValues(offset, pBuffer, length). And where each is stored: getStorageAddress(offset, address), which returns false for bytes that are not stored
+ * @param location - The EEPROM writes: can_write(), and update(value) to write a byte at location.address
+ */
+template <class page_t, class location_t>
+static inline void writeDirtyBlocks(dirty_blocks_t &blocks, uint16_t pageSize, page_t &page, location_t &location)
+{
+  uint8_t values[EEPROM_DIRTY_BLOCK_SIZE];
+
+  for (uint8_t block = 0; (block < EEPROM_DIRTY_BLOCKS) && location.can_write(); block++)
+  {
+    uint16_t offset = (uint16_t)block * EEPROM_DIRTY_BLOCK_SIZE;
+    if ( (offset >= pageSize) || !isDirtyBlock(blocks, block) ) { continue; }
+
+    uint16_t blockEnd = offset + EEPROM_DIRTY_BLOCK_SIZE;
+    if (blockEnd > pageSize) { blockEnd = pageSize; }
+    page.getValues(offset, values, blockEnd - offset);
+    const uint8_t *pValue = values;
+    while ( (offset < blockEnd) && location.can_write() )
+    {
+      if (page.getStorageAddress(offset, location.address)) { location.update(*pValue); }
+      ++offset;
+      ++pValue;
+    }
+    if (offset == blockEnd) { clearDirtyBlock(blocks, block); }
+  }
+}
+
+//  ================================= Table loads ===============================
+// Each load reads the next bytes from the EEPROM through reader.read(pBuffer, length), in the order given by table_storage_offset()
+
+template <class reader_t>
+static inline void loadTableRows(reader_t &reader, table_value_iterator it)
+{
+  while (!it.at_end())
+  {
+    table_row_iterator row = *it;
+    reader.read(&*row, (uint8_t)(row.end() - &*row));
+    ++it;
+  }
+}
+
+template <class reader_t>
+static inline void loadTableAxis(reader_t &reader, table_axis_iterator it)
+{
+  const table3d_axis_io_converter converter = get_table3d_axis_converter(it.get_domain());
+  //The axis is read as a single block and then converted
+  uint8_t values[32]; // Fingers crossed we don't have a table bigger than 32x32
+  uint8_t length = 0;
+  for (table_axis_iterator counter = it; !counter.at_end() && (length < sizeof(values)); ++counter) { ++length; }
+  reader.read(values, length);
+  const uint8_t *pValue = values;
+  while (!it.at_end())
+  {
+    *it = converter.from_byte(*pValue);
+    ++pValue;
+    ++it;
+  }
+}
+
+/** Load a 3D table from its EEPROM storage. This is the reverse of the writes through table_storage_offset() */
+template <class reader_t>
+static inline void loadTableStorage(reader_t &reader, void *pTable, table_type_t key)
+{
+  loadTableRows(reader, rows_begin(pTable, key));
+  loadTableAxis(reader, x_begin(pTable, key));
+  loadTableAxis(reader, y_rbegin(pTable, key));
+}
+
+#endif // STORAGE_DIRTY_H
@@ -20,6 +20,7 @@ Timers are typically low resolution (Compared to Schedulers), with maximum frequ
 #include "auxiliaries.h"
 #include "comms.h"
 #include "maths.h"
+#include "storage.h"
 
 #if defined(CORE_AVR)
   #include <avr/wdt.h>
@@ -77,6 +78,10 @@ void oneMSInterval(void) //Most ARM chips can simply call a function
   BIT_SET(TIMER_mask, BIT_TIMER_1KHZ);
   ms_counter++;
 
+  #if defined(EEPROM_BACKGROUND_WRITES)
+    resumeEEPROMWrites(); //Restart any EEPROM writes that were held off for a schedule edge
+  #endif
+
   //Increment Loop Counters
   loop5ms++;
   loop33ms++;
@@ -0,0 +1,145 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Wall wetting (X-Tau) transient fuel model. See transientFuel.h
+ */
+#include "transientFuel.h"
+#include "table2d.h"
+#if defined(CORE_AVR)
+  #include <util/atomic.h>
+#endif
+
+static uint32_t wallFilm[TRANSIENT_FUEL_MAX_CYLINDERS]; //Fuel film (uS x 16) for each cylinder
+static uint8_t wallFilmCylinder = 0; //The cylinder that the next injection is for
+static uint16_t wallWetLastEvent = 0; //ignitionCount when the films were last updated
+static uint16_t wallWetLastReported = 0; //ignitionCount when the AE amount was last updated
+static uint16_t wallWetX = 0; //Fraction of the injection that goes into the film (Q8)
+static uint16_t wallWetCompensation = 256; //1 / (1 - X) (Q8)
+static uint16_t wallWetEvaporation = 256; //Fraction of the film that evaporates into the cylinder each cycle (Q8)
+static uint16_t wallWetLastInjection = 0; //The most recent compensated injection (uS, excluding the opening time)
+
+/*
+ignitionCount is updated from the ignition interrupt. A 16 bit read is not atomic on AVR
+*/
+static inline uint16_t readIgnitionCount(void)
+{
+  uint16_t count;
+#if defined(CORE_AVR)
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { count = ignitionCount; }
+#else
+  count = ignitionCount;
+#endif
+  return count;
+}
+
+void initialiseTransientFuel(void)
+{
+  for(uint8_t x = 0; x < TRANSIENT_FUEL_MAX_CYLINDERS; x++) { wallFilm[x] = 0; }
+  wallFilmCylinder = 0;
+  wallWetLastInjection = 0;
+}
+
+/*
+Recalculates X, 1/(1-X) and the per cycle evaporation fraction. Called once per ignition event so that the evaporation tracks RPM
+*/
+static inline void updateWallWetParameters(void)
+{
+  int16_t coolant = currentStatus.coolant + CALIBRATION_TEMPERATURE_OFFSET;
+
+  uint16_t x = ((uint16_t)table2D_getValue(&wallWetXTable, coolant) * 256U) / 100U;
+  if(x > 230U) { x = 230U; } //Limit X to 90%, any higher and the compensation becomes unstable
+  wallWetX = x;
+  wallWetCompensation = (uint16_t)(65536UL / (256U - x));
+
+  //Each cylinder only receives 1 injection per cycle, so the evaporation is per cycle
+  uint32_t cycleTime = revolutionTime;
+  if(configPage2.strokes == FOUR_STROKE) { cycleTime = cycleTime * 2U; }
+  uint32_t tau = (uint32_t)table2D_getValue(&wallWetTauTable, coolant) * 10000UL; //Tau is in 10ms
+  if( (tau == 0U) || (cycleTime >= tau) ) { wallWetEvaporation = 256U; }
+  else { wallWetEvaporation = (uint16_t)((cycleTime << 8) / tau); }
+  if(wallWetEvaporation == 0U) { wallWetEvaporation = 1U; } //Always evaporate something so that the film cannot grow without limit
+}
+
+/*
+Returns the injection (uS) needed to deliver the demanded fuel to the cylinder given its current film
+*/
+static inline uint16_t compensateInjection(uint16_t demand, uint32_t film)
+{
+  uint32_t evaporated = (film * wallWetEvaporation) >> 8;
+  uint32_t demandFilm = (uint32_t)demand << TRANSIENT_FUEL_FILM_SHIFT;
+  if(evaporated >= demandFilm) { return 0; } //The film alone can supply the demand
+
+  uint32_t injected = (((demandFilm - evaporated) * wallWetCompensation) >> 8) >> TRANSIENT_FUEL_FILM_SHIFT;
+  if(injected > UINT16_MAX) { injected = UINT16_MAX; }
+  return (uint16_t)injected;
+}
+
+/** Applies the wall wetting compensation to a pulsewidth.
+ * Should be called every time the pulsewidth is calculated. The films are only advanced when an ignition event has occurred since the last call.
+ * The pulsewidth returned is compensated for the film of the cylinder that is next to be injected. It is applied to the shared PW1, see transientFuel.h
+ * 
+ * @param pulseWidth The pulsewidth (uS) including the injector opening time
+ * @param injOpen The injector opening time (uS)
+ * @return uint16_t The compensated pulsewidth (uS) including the injector opening time
+ */
+uint16_t correctionWallWetting(uint16_t pulseWidth, uint16_t injOpen)
+{
+  uint16_t demand = 0;
+  if(pulseWidth > injOpen) { demand = pulseWidth - injOpen; }
+
+  uint8_t cylinders = configPage2.nCylinders;
+  if(cylinders > TRANSIENT_FUEL_MAX_CYLINDERS) { cylinders = TRANSIENT_FUEL_MAX_CYLINDERS; }
+  if(cylinders == 0U) { cylinders = 1U; }
+
+  if( !BIT_CHECK(currentStatus.engine, BIT_ENGINE_RUN) || BIT_CHECK(currentStatus.engine, BIT_ENGINE_CRANK) )
+  {
+    //Not running (Or cranking, where the cranking enrichment already accounts for the wall film). Hold the films at the steady state for the current demand so that there is no step when the model takes over
+    updateWallWetParameters();
+    uint32_t steadyFilm = (((uint32_t)demand << TRANSIENT_FUEL_FILM_SHIFT) * wallWetX) / wallWetEvaporation;
+    for(uint8_t x = 0; x < cylinders; x++) { wallFilm[x] = steadyFilm; }
+    wallWetLastEvent = readIgnitionCount();
+    wallWetLastInjection = demand;
+    currentStatus.AEamount = 100;
+    return pulseWidth;
+  }
+
+  //Advance the films for each ignition event since the last call. Each event is an injection into the next cylinder in turn
+  uint16_t currentEvent = readIgnitionCount();
+  uint16_t events = currentEvent - wallWetLastEvent;
+  if(events > cylinders) { events = cylinders; } //No need to catch up more than a full cycle
+  if(events > 0U)
+  {
+    updateWallWetParameters();
+    while(events > 0U)
+    {
+      uint32_t film = wallFilm[wallFilmCylinder];
+      uint32_t evaporated = (film * wallWetEvaporation) >> 8;
+      uint32_t deposited = ((uint32_t)wallWetLastInjection << TRANSIENT_FUEL_FILM_SHIFT) * wallWetX >> 8;
+      wallFilm[wallFilmCylinder] = film - evaporated + deposited;
+
+      wallFilmCylinder++;
+      if(wallFilmCylinder >= cylinders) { wallFilmCylinder = 0; }
+      events--;
+    }
+    wallWetLastEvent = currentEvent;
+  }
+
+  uint16_t injected = compensateInjection(demand, wallFilm[wallFilmCylinder]);
+  wallWetLastInjection = injected;
+
+  if(currentEvent != wallWetLastReported)
+  {
+    //Report the compensation in the same way as the AE amount. Only done once per event to keep the division out of every loop
+    wallWetLastReported = currentEvent;
+    if(demand > 0U) { currentStatus.AEamount = (uint16_t)(((uint32_t)injected * 100U) / demand); }
+    else { currentStatus.AEamount = 100; }
+  }
+
+  if(injected == 0U) { return 0; }
+  uint32_t compensatedPW = (uint32_t)injected + injOpen;
+  if(compensatedPW > UINT16_MAX) { compensatedPW = UINT16_MAX; }
+  return (uint16_t)compensatedPW;
+}
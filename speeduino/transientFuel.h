@@ -0,0 +1,27 @@
+#ifndef TRANSIENTFUEL_H
+#define TRANSIENTFUEL_H
+
+#include "globals.h"
+
+/** @file
+ * Wall wetting (X-Tau) transient fuel model. Used instead of the threshold based acceleration enrichment when @ref config2.aeMode is AE_MODE_XTAU.
+ *
+ * A fraction (X) of each injection goes into a film of fuel on the port walls rather than directly into the cylinder. The film then evaporates into the cylinder with a time constant of Tau.
+ * A film (puddle) is tracked for each cylinder and updated on every ignition event. The pulsewidth is then compensated so that the fuel reaching the cylinder matches the demand:
+ *
+ *   injected = (demand - evaporated) / (1 - X)
+ *
+ * Both X and Tau are looked up against coolant temperature. All calculations use fixed point, with the film held in uS of injector open time x 16.
+ *
+ * This is a per event model. The films are tracked for each cylinder, but the compensation is applied to the single shared pulsewidth (PW1) that all injection channels are scheduled from.
+ * Between ignition events PW1 carries the compensation for the cylinder that is next in the firing order. Channels that are scheduled from it at other points in the cycle
+ * (Batch or semi-sequential injection, or an injection angle well away from that cylinders event) receive that cylinders compensation rather than their own.
+ */
+
+#define TRANSIENT_FUEL_MAX_CYLINDERS  8
+#define TRANSIENT_FUEL_FILM_SHIFT     4 //The film is held with 4 fractional bits
+
+void initialiseTransientFuel(void);
+uint16_t correctionWallWetting(uint16_t pulseWidth, uint16_t injOpen);
+
+#endif // TRANSIENTFUEL_H
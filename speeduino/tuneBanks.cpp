@@ -0,0 +1,211 @@
+/*
+Speeduino - Simple engine management for the Arduino Mega 2560 platform
+Copyright (C) Josh Stewart
+A full copy of the license may be found in the projects root directory
+*/
+/** @file
+ * Switchable tune banks. See tuneBanks.h
+ */
+#include "tuneBanks.h"
+#include "pages.h"
+#include "page_crc.h"
+#include "storage.h"
+
+struct table3d16RpmLoad *pFuelTable = &fuelTable;
+struct table3d16RpmLoad *pIgnitionTable = &ignitionTable;
+struct table3d16RpmLoad *pAfrTable = &afrTable;
+uint8_t activeTuneBank = 0;
+
+#if TUNE_BANK_COUNT > 1
+struct tune_bank_tables {
+  struct table3d16RpmLoad fuelTable;
+  struct table3d16RpmLoad ignitionTable;
+  struct table3d16RpmLoad afrTable;
+};
+static tune_bank_tables bankTables[TUNE_BANK_COUNT - 1U]; //Bank 0 is the standard tables, so isn't included here
+
+static uint8_t requestedTuneBank = 0; //Bank selected by TunerStudio. Only used in TUNE_BANK_MODE_COMMS
+static uint8_t staleTuneBankPages = 0; //Bit for each bank page (See getTuneBankPage()) that has changed bank since the tuning software last read it or its CRC
+
+/*
+Reads the bank that is selected by the configured inputs
+*/
+static inline uint8_t readTuneBankInput(void)
+{
+  uint8_t bank = 0;
+  if(configPage15.tuneBankMode == TUNE_BANK_MODE_INPUT)
+  {
+    if( (configPage15.tuneBankPin1 != 0U) && (digitalRead(pinTuneBank1) == configPage15.tuneBankPolarity) ) { bank = bank + 1U; }
+    if( (configPage15.tuneBankPin2 != 0U) && (digitalRead(pinTuneBank2) == configPage15.tuneBankPolarity) ) { bank = bank + 2U; }
+  }
+  else if(configPage15.tuneBankMode == TUNE_BANK_MODE_CAN)
+  {
+    uint16_t canValue = currentStatus.canin[configPage15.tuneBankCanInput];
+    bank = (canValue < TUNE_BANK_COUNT) ? (uint8_t)canValue : (uint8_t)(TUNE_BANK_COUNT - 1U);
+  }
+  else { bank = requestedTuneBank; }
+
+  if(bank >= TUNE_BANK_COUNT) { bank = TUNE_BANK_COUNT - 1U; }
+  return bank;
+}
+
+/*
+A bank can only be switched once all of its changes have been burnt
+*/
+static inline bool isTuneBankBurnt(void)
+{
+  bool isBurnt = true;
+  for(uint8_t index = 0; index < TUNE_BANK_PAGES; index++) { isBurnt = isBurnt && !isPageDirty(getTuneBankPage(index)); }
+  return isBurnt;
+}
+#endif
+
+/** Sets all banks to the bank 0 tables. The other banks are then overwritten with their own tables by loadConfig() where they have been stored
+ */
+void initialiseTuneBanks(void)
+{
+#if TUNE_BANK_COUNT > 1
+  for(uint8_t bank = 0; bank < (TUNE_BANK_COUNT - 1U); bank++)
+  {
+    bankTables[bank].fuelTable = fuelTable;
+    bankTables[bank].ignitionTable = ignitionTable;
+    bankTables[bank].afrTable = afrTable;
+  }
+  requestedTuneBank = 0;
+  staleTuneBankPages = 0;
+#endif
+  setTuneBankTables(0);
+}
+
+/** Switches to the bank selected by the configured source (See @ref config15.tuneBankMode).
+ * The switch is a pointer swap, so this is cheap enough to call every 1ms. That ensures a switch takes effect within one engine cycle.
+ * The switch happens whether or not the tuning software is connected. It only reads the tables when it connects, so the bank pages are marked as changed until it reads them again (See isTuneBankChanged())
+ */
+void tuneBankControl(void)
+{
+#if TUNE_BANK_COUNT > 1
+  uint8_t bank = readTuneBankInput();
+  if( (bank != activeTuneBank) && isTuneBankBurnt() )
+  {
+    setTuneBankTables(bank);
+    for(uint8_t index = 0; index < TUNE_BANK_PAGES; index++) { invalidatePageCRC(getTuneBankPage(index)); }
+    staleTuneBankPages = (1U << TUNE_BANK_PAGES) - 1U;
+  }
+#endif
+}
+
+/** Whether the tables of the active bank have changed since the tuning software last read them. Shown in the live data so that the tuning software can prompt for a reload
+ */
+bool isTuneBankChanged(void)
+{
+#if TUNE_BANK_COUNT > 1
+  return staleTuneBankPages != 0U;
+#else
+  return false;
+#endif
+}
+
+/** Whether a page has changed bank since the tuning software last read it. Writes from the tuning software to these pages are rejected, as they are edits to the tables of the previous bank
+ * @param pageNum The config page
+ */
+bool isTuneBankPageStale(uint8_t pageNum)
+{
+#if TUNE_BANK_COUNT > 1
+  int8_t index = getTuneBankPageIndex(pageNum);
+  return (index >= 0) && BIT_CHECK(staleTuneBankPages, (uint8_t)index);
+#else
+  (void)pageNum;
+  return false;
+#endif
+}
+
+/** Called when the tuning software reads a page or its CRC. Either way it now knows the tables of the active bank, so edits to the page are accepted again
+ * @param pageNum The config page
+ */
+void markTuneBankPageRead(uint8_t pageNum)
+{
+#if TUNE_BANK_COUNT > 1
+  int8_t index = getTuneBankPageIndex(pageNum);
+  if(index >= 0) { BIT_CLEAR(staleTuneBankPages, (uint8_t)index); }
+#else
+  (void)pageNum;
+#endif
+}
+
+/** Selects a bank from TunerStudio. Only has an effect when the bank is selected by comms
+ * @param bank The bank to switch to. Banks that don't exist are ignored
+ */
+void selectTuneBank(uint8_t bank)
+{
+#if TUNE_BANK_COUNT > 1
+  if(bank < TUNE_BANK_COUNT) { requestedTuneBank = bank; }
+#else
+  (void)bank;
+#endif
+}
+
+/** Points the active tables at the tables of a bank.
+ * This doesn't check whether the current bank has unburnt changes. It is used directly by the storage functions to load and store each of the banks
+ * @param bank The bank to point to. Must be less than TUNE_BANK_COUNT
+ */
+void setTuneBankTables(uint8_t bank)
+{
+#if TUNE_BANK_COUNT > 1
+  if( (bank > 0U) && (bank < TUNE_BANK_COUNT) )
+  {
+    pFuelTable = &bankTables[bank - 1U].fuelTable;
+    pIgnitionTable = &bankTables[bank - 1U].ignitionTable;
+    pAfrTable = &bankTables[bank - 1U].afrTable;
+    activeTuneBank = bank;
+    return;
+  }
+#else
+  (void)bank;
+#endif
+  pFuelTable = &fuelTable;
+  pIgnitionTable = &ignitionTable;
+  pAfrTable = &afrTable;
+  activeTuneBank = 0;
+}
+
+/** The config page that holds each of the banked tables
+ * @param index The table index within a bank (0 to TUNE_BANK_PAGES-1)
+ */
+uint8_t getTuneBankPage(uint8_t index)
+{
+  static constexpr uint8_t PROGMEM bankPages[TUNE_BANK_PAGES] = { veMapPage, ignMapPage, afrMapPage };
+  return (index < TUNE_BANK_PAGES) ? pgm_read_byte(&bankPages[index]) : 0U;
+}
+
+/** The reverse of getTuneBankPage()
+ * @return The table index within a bank, or -1 if the page isn't part of the banks
+ */
+int8_t getTuneBankPageIndex(uint8_t pageNum)
+{
+  for(uint8_t index = 0; index < TUNE_BANK_PAGES; index++)
+  {
+    if(getTuneBankPage(index) == pageNum) { return (int8_t)index; }
+  }
+  return -1;
+}
+
+/** The config journal record that a page of a bank is stored in.
+ * Bank 0 and the pages that aren't part of the banks use the page number. The bank pages of the other banks follow on from JOURNAL_TUNE_BANK_RECORDS, one block of TUNE_BANK_PAGES records per bank
+ * @param pageNum The config page
+ * @param bank The bank the page belongs to
+ */
+uint8_t getJournalRecordId(uint8_t pageNum, uint8_t bank)
+{
+  int8_t index = getTuneBankPageIndex(pageNum);
+  if( (bank == 0U) || (index < 0) ) { return pageNum; }
+  return JOURNAL_TUNE_BANK_RECORDS + ((bank - 1U) * TUNE_BANK_PAGES) + (uint8_t)index;
+}
+
+/** The reverse of getJournalRecordId(). The bank isn't returned, as the page in memory is always that of the active bank
+ * @return The config page that is stored in a journal record
+ */
+uint8_t getJournalRecordPage(uint8_t recordId)
+{
+  if(recordId < JOURNAL_TUNE_BANK_RECORDS) { return recordId; }
+  return getTuneBankPage((recordId - JOURNAL_TUNE_BANK_RECORDS) % TUNE_BANK_PAGES);
+}
@@ -0,0 +1,54 @@
+#ifndef TUNEBANKS_H
+#define TUNEBANKS_H
+
+#include "globals.h"
+
+/** @file
+ * Switchable tune banks.
+ *
+ * Each bank is a complete set of the primary fuel (VE), ignition and AFR target tables. Bank 0 is the tables that are stored in the config pages as normal (@ref fuelTable, @ref ignitionTable and @ref afrTable).
+ * The other banks are held in RAM alongside them and are stored as their own records in the config journal (See USE_FLASH_JOURNAL). All other settings are shared by every bank.
+ *
+ * Switching bank only changes the table pointers below, so it takes effect from the next lookup. Everything that looks up or edits these tables uses the pointers, so it always works on the active bank.
+ * The bank can be selected from TunerStudio, a pair of input pins or a CAN input (See @ref config15.tuneBankMode). The active bank is included in the live data.
+ * A switch is held off while the active bank has changes that have not been burnt, so that the changes aren't lost or burnt into the wrong bank.
+ * TunerStudio only reads the tables when it connects, so after a switch the live data shows that the tune has changed (See isTuneBankChanged()) until it has read each bank page or its CRC again.
+ * Until then, writes from TunerStudio to those pages are rejected, as they would be edits to the tables of the previous bank.
+ *
+ * Boards that have the storage and RAM for them set TUNE_BANK_COUNT in their board .h file. All other boards only have bank 0.
+ * Currently this is the STM32 boards built with USE_SPI_EEPROM and USE_FLASH_JOURNAL (See the black_F407VE_journal environment in platformio.ini).
+ */
+
+#ifndef TUNE_BANK_COUNT
+  #define TUNE_BANK_COUNT   1
+#endif
+
+#if (TUNE_BANK_COUNT > 1) && !defined(USE_FLASH_JOURNAL)
+  #error "Tune banks are stored in the config journal. USE_FLASH_JOURNAL must be defined"
+#endif
+
+#define TUNE_BANK_MODE_COMMS  0 //Bank is selected by TunerStudio command buttons
+#define TUNE_BANK_MODE_INPUT  1 //Bank is selected by the tuneBankPin1 and tuneBankPin2 inputs
+#define TUNE_BANK_MODE_CAN    2 //Bank is selected by the value of a CAN input
+
+#define TUNE_BANK_PAGES       3 //Number of pages in each bank. See getTuneBankPage()
+#define JOURNAL_TUNE_BANK_RECORDS 16U //Config journal record id of the first page of bank 1. The ids below this are the config pages themselves
+
+extern struct table3d16RpmLoad *pFuelTable; /**< The fuel table of the active bank */
+extern struct table3d16RpmLoad *pIgnitionTable; /**< The ignition table of the active bank */
+extern struct table3d16RpmLoad *pAfrTable; /**< The AFR target table of the active bank */
+extern uint8_t activeTuneBank;
+
+void initialiseTuneBanks(void);
+void tuneBankControl(void);
+bool isTuneBankChanged(void);
+bool isTuneBankPageStale(uint8_t pageNum);
+void markTuneBankPageRead(uint8_t pageNum);
+void selectTuneBank(uint8_t bank);
+void setTuneBankTables(uint8_t bank);
+uint8_t getTuneBankPage(uint8_t index);
+int8_t getTuneBankPageIndex(uint8_t pageNum);
+uint8_t getJournalRecordId(uint8_t pageNum, uint8_t bank);
+uint8_t getJournalRecordPage(uint8_t recordId);
+
+#endif // TUNEBANKS_H
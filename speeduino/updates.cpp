@@ -13,11 +13,12 @@
 #include "sensors.h"
 #include "updates.h"
 #include "pages.h"
+#include "fuelLearn.h"
 #include EEPROM_LIB_H //This is defined in the board .h files
 
 void doUpdates(void)
 {
-  #define CURRENT_DATA_VERSION    23
+  #define CURRENT_DATA_VERSION    25
   //Only the latest update for small flash devices must be retained
    #ifndef SMALL_FLASH_MODE
 
@@ -751,6 +752,77 @@ void doUpdates(void)
     writeAllConfig();
     storeEEPROMVersion(23);
   }
+
+  if(readEEPROMVersion() == 23)
+  {
+    //Crank angle synchronous MAP sampling added. Disabled by default
+    configPage15.mapSyncEnable = 0;
+    configPage15.mapSyncSamples = 0; //1 sample per cylinder
+    configPage15.mapSyncAngle = 450; //Middle of the intake stroke
+    configPage15.mapSyncSpacing = 20;
+
+    //Analog filter bank added. Default to the IIR filter only, which matches the existing behaviour
+    configPage15.adcFilterTypeTPS = 0;
+    configPage15.adcFilterTypeCLT = 0;
+    configPage15.adcFilterTypeIAT = 0;
+    configPage15.adcFilterTypeO2 = 0;
+    configPage15.adcFilterTypeBat = 0;
+    configPage15.adcFilterTypeMAP = 0;
+    configPage15.adcFilterTypeBaro = 0;
+
+    //Long term fuel trim learning added. Disabled by default and with all learnt trims starting at 0
+    configPage15.fuelLearnEnable = 0;
+    configPage15.fuelLearnMaxTrim = 15;
+    configPage15.fuelLearnThreshold = 50; //5% correction sustained for 1 second moves the trim by 1%
+    for(uint16_t x = 0; x < FUEL_LEARN_CELLS; x++) { EEPROMWriteRaw(EEPROM_FUEL_LEARN + x, 0); }
+
+    //Wall wetting transient fuel model added. Only used if selected as the AE mode
+    configPage15.wallWetBins[0] = 30; //-10C
+    configPage15.wallWetBins[1] = 50;
+    configPage15.wallWetBins[2] = 70;
+    configPage15.wallWetBins[3] = 90;
+    configPage15.wallWetBins[4] = 110;
+    configPage15.wallWetBins[5] = 130; //90C
+    configPage15.wallWetX[0] = 40;
+    configPage15.wallWetX[1] = 35;
+    configPage15.wallWetX[2] = 30;
+    configPage15.wallWetX[3] = 25;
+    configPage15.wallWetX[4] = 20;
+    configPage15.wallWetX[5] = 18;
+    configPage15.wallWetTau[0] = 80; //0.8s
+    configPage15.wallWetTau[1] = 60;
+    configPage15.wallWetTau[2] = 40;
+    configPage15.wallWetTau[3] = 25;
+    configPage15.wallWetTau[4] = 15;
+    configPage15.wallWetTau[5] = 10; //0.1s
+
+    //Pre/post trigger SD log capture added. Disabled by default
+    configPage13.onboard_log_capture_trigger = 0;
+    configPage13.onboard_log_capture_output = 0;
+    configPage13.onboard_log_capture_rate = 2; //100Hz
+    configPage13.onboard_log_capture_pre = 50; //5s
+    configPage13.onboard_log_capture_post = 20; //2s
+
+    writeAllConfig();
+    storeEEPROMVersion(24);
+  }
+
+  if(readEEPROMVersion() == 24)
+  {
+    //Page CRCs are now stored after each burn and checked at startup. Burn all pages so that each of them has a CRC stored (Only the CRCs will actually change)
+    //The page CRCs have also moved, as the previous location of the page 1 CRC overlapped the O2 calibration CRC
+
+    //Tune banks. Selected from TunerStudio by default, which keeps bank 0 active until another bank is selected
+    configPage15.tuneBankMode = 0;
+    configPage15.tuneBankCanInput = 0;
+    configPage15.tuneBankPin1 = 0;
+    configPage15.tuneBankPin2 = 0;
+    configPage15.tuneBankPolarity = 0;
+    configPage15.tuneBankPullup = 0;
+
+    writeAllConfig();
+    storeEEPROMVersion(25);
+  }
   
   //Final check is always for 255 and 0 (Brand new arduino)
   if( (readEEPROMVersion() == 0) || (readEEPROMVersion() == 255) )
@@ -769,6 +841,9 @@ void doUpdates(void)
 
     configPage4.FILTER_FLEX = FILTER_FLEX_DEFAULT;
 
+    //Erased EEPROM reads as 0xFF, which would load as a -1% learnt trim in every cell
+    for(uint16_t x = 0; x < FUEL_LEARN_CELLS; x++) { EEPROMWriteRaw(EEPROM_FUEL_LEARN + x, 0); }
+
     storeEEPROMVersion(CURRENT_DATA_VERSION);
   }
 
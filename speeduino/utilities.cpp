@@ -158,6 +158,9 @@ void checkProgrammableIO(void)
   uint8_t dataRequested;
   bool firstCheck, secondCheck;
 
+  //The rules read their data from the live data snapshot. While a legacy send is using the snapshot, the rules use it as it is
+  if( (pinIsValid != 0U) && !isLiveDataLocked() ) { updateLiveData(); }
+
   for (uint8_t y = 0; y < sizeof(configPage13.outputPin); y++)
   {
     firstCheck = false;
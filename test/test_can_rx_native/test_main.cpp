@@ -0,0 +1,166 @@
+// Host test of the received CAN frame ID table (See speeduino/comms_CAN_rx.h)
+// Every frame that is added must be found with the handlers and CAN input channels it was added with, and every other frame must not be found.
+// A standard and an extended frame with the same ID number are different frames.
+// Run with: pio test -e native -f test_can_rx_native
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../../speeduino/comms_CAN_rx.cpp"
+
+#define CAN_RX_MAX_IDS 20U //16 CAN inputs, 2 OBD and 2 WBO
+
+static can_rx_table table;
+
+//Linear search of the IDs list. Used as the reference for the hash table
+static bool listContains(uint32_t id, bool extended)
+{
+  for (uint8_t x = 0; x < table.idCount; x++) { if (isSameCANFrame(table.ids[x], id, extended)) { return true; } }
+  return false;
+}
+
+//Every standard ID, and the extended IDs up to 0x11FFF, must give the same answer as the IDs list
+static void check_all_ids(void)
+{
+  for (uint32_t id = 0; id <= CAN_STD_ID_MAX; id++) { TEST_ASSERT_EQUAL(listContains(id, false), findCANRxEntry(&table, id, false) != nullptr); }
+  for (uint32_t id = 0; id <= 0x11FFFUL; id++) { TEST_ASSERT_EQUAL(listContains(id, true), findCANRxEntry(&table, id, true) != nullptr); }
+  TEST_ASSERT_NULL(findCANRxEntry(&table, 0xEF50000UL, true)); //Extended ID sent to the wideband
+}
+
+static void test_can_rx_empty(void)
+{
+  clearCANRxTable(&table);
+  TEST_ASSERT_EQUAL_UINT8(0, table.idCount);
+  check_all_ids();
+}
+
+static void test_can_rx_handlers(void)
+{
+  clearCANRxTable(&table);
+  addCANRxEntry(&table, 0x7DF, false, CAN_RX_OBD, 0);
+  addCANRxEntry(&table, 0x190, false, CAN_RX_WBO, 0);
+  addCANRxEntry(&table, 0x200, false, CAN_RX_CANIN, 0x0001);
+  addCANRxEntry(&table, 0x200, false, CAN_RX_CANIN, 0x8000); //Two inputs reading the same frame
+  addCANRxEntry(&table, 0x190, false, CAN_RX_CANIN, 0x0010); //A CAN input reading the wideband frame
+
+  TEST_ASSERT_EQUAL_UINT8(3, table.idCount); //Each ID is only listed once for the hardware filters
+  TEST_ASSERT_EQUAL_UINT32(0x7DF, table.ids[0].id);
+  TEST_ASSERT_EQUAL_UINT32(0x190, table.ids[1].id);
+  TEST_ASSERT_EQUAL_UINT32(0x200, table.ids[2].id);
+  for (uint8_t x = 0; x < table.idCount; x++) { TEST_ASSERT_FALSE(table.ids[x].extended); }
+
+  const can_rx_entry *pEntry = findCANRxEntry(&table, 0x200, false);
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_HEX8(CAN_RX_CANIN, pEntry->handlers);
+  TEST_ASSERT_EQUAL_HEX16(0x8001, pEntry->caninChannels);
+
+  pEntry = findCANRxEntry(&table, 0x190, false);
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_HEX8(CAN_RX_WBO | CAN_RX_CANIN, pEntry->handlers);
+  TEST_ASSERT_EQUAL_HEX16(0x0010, pEntry->caninChannels);
+
+  pEntry = findCANRxEntry(&table, 0x7DF, false);
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_HEX8(CAN_RX_OBD, pEntry->handlers);
+  check_all_ids();
+}
+
+//IDs that all hash to the last slot, so that probing has to wrap around to the start of the table
+static void test_can_rx_collisions(void)
+{
+  clearCANRxTable(&table);
+  uint8_t added = 0;
+  for (uint32_t id = 0; (id <= 0x7FFU) && (added < CAN_RX_MAX_IDS); id++)
+  {
+    if (canRxHash(id) == (CAN_RX_TABLE_SIZE - 1U))
+    {
+      addCANRxEntry(&table, id, false, CAN_RX_CANIN, (uint16_t)(1U << (added & 15U)));
+      added++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT8(CAN_RX_MAX_IDS, table.idCount);
+  for (uint8_t x = 0; x < table.idCount; x++)
+  {
+    const can_rx_entry *pEntry = findCANRxEntry(&table, table.ids[x].id, false);
+    TEST_ASSERT_NOT_NULL(pEntry);
+    TEST_ASSERT_EQUAL_UINT32(table.ids[x].id, pEntry->frame.id);
+    TEST_ASSERT_EQUAL_HEX16(1U << (x & 15U), pEntry->caninChannels);
+  }
+  check_all_ids();
+}
+
+//A standard and an extended frame with the same ID are kept apart, and are each given their own hardware filter
+static void test_can_rx_frame_format(void)
+{
+  clearCANRxTable(&table);
+  addCANRxEntry(&table, 0x190, false, CAN_RX_WBO, 0);
+  addCANRxEntry(&table, 0x190, true, CAN_RX_CANIN, 0x0002);
+  addCANRxEntry(&table, 0x1000, true, CAN_RX_CANIN, 0x0004);
+
+  TEST_ASSERT_EQUAL_UINT8(3, table.idCount);
+  TEST_ASSERT_FALSE(table.ids[0].extended);
+  TEST_ASSERT_TRUE(table.ids[1].extended);
+  TEST_ASSERT_TRUE(table.ids[2].extended);
+
+  const can_rx_entry *pEntry = findCANRxEntry(&table, 0x190, false);
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_HEX8(CAN_RX_WBO, pEntry->handlers);
+  pEntry = findCANRxEntry(&table, 0x190, true);
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_HEX8(CAN_RX_CANIN, pEntry->handlers);
+  TEST_ASSERT_EQUAL_HEX16(0x0002, pEntry->caninChannels);
+  TEST_ASSERT_NULL(findCANRxEntry(&table, 0x1000, false));
+  TEST_ASSERT_NOT_NULL(findCANRxEntry(&table, 0x1000, true));
+  check_all_ids();
+}
+
+//IDs too large for their frame format can never be received, so are not added (Eg an OBD address of 0x7F0 plus the 0x100 offset)
+static void test_can_rx_id_range(void)
+{
+  clearCANRxTable(&table);
+  addCANRxEntry(&table, CAN_STD_ID_MAX + 1U, false, CAN_RX_OBD, 0);
+  addCANRxEntry(&table, 0x8F0, false, CAN_RX_OBD, 0);
+  addCANRxEntry(&table, CAN_EXT_ID_MAX + 1U, true, CAN_RX_CANIN, 0x0001);
+  TEST_ASSERT_EQUAL_UINT8(0, table.idCount);
+
+  addCANRxEntry(&table, CAN_STD_ID_MAX, false, CAN_RX_OBD, 0);
+  addCANRxEntry(&table, CAN_EXT_ID_MAX, true, CAN_RX_CANIN, 0x0001);
+  TEST_ASSERT_EQUAL_UINT8(2, table.idCount);
+  TEST_ASSERT_NOT_NULL(findCANRxEntry(&table, CAN_STD_ID_MAX, false));
+  TEST_ASSERT_NOT_NULL(findCANRxEntry(&table, CAN_EXT_ID_MAX, true));
+  check_all_ids();
+}
+
+//Random configs of the largest number of IDs, including extended frames and duplicates
+static void test_can_rx_random(void)
+{
+  srand(1);
+  for (uint16_t config = 0; config < 200U; config++)
+  {
+    clearCANRxTable(&table);
+    for (uint8_t x = 0; x < CAN_RX_MAX_IDS; x++)
+    {
+      uint32_t id = (rand() % 4) == 0 ? (0x100U + (rand() % 16)) : (uint32_t)(rand() % 0x12000);
+      bool extended = (id > CAN_STD_ID_MAX) || ((rand() % 4) == 0);
+      addCANRxEntry(&table, id, extended, CAN_RX_CANIN, (uint16_t)(1U << (x & 15U)));
+    }
+    TEST_ASSERT_TRUE(table.idCount <= CAN_RX_MAX_IDS);
+    for (uint8_t x = 0; x < table.idCount; x++) { TEST_ASSERT_NOT_NULL(findCANRxEntry(&table, table.ids[x].id, table.ids[x].extended)); }
+    check_all_ids();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+
+  RUN_TEST(test_can_rx_empty);
+  RUN_TEST(test_can_rx_handlers);
+  RUN_TEST(test_can_rx_collisions);
+  RUN_TEST(test_can_rx_frame_format);
+  RUN_TEST(test_can_rx_id_range);
+  RUN_TEST(test_can_rx_random);
+
+  return UNITY_END();
+}
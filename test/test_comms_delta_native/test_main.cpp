@@ -0,0 +1,168 @@
+// Host test of the delta encoded output channels (See speeduino/comms_delta.h)
+// Each frame is applied to the client's copy of the previous frame, which must then match a full copy of the output channels.
+// Run with: pio test -e native -f test_comms_delta_native
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../speeduino/comms_delta.cpp"
+
+#define TEST_BLOCK_SIZE DELTA_MAX_LENGTH
+
+static delta_encoder encoder;
+static uint8_t values[TEST_BLOCK_SIZE]; //The output channels on the ECU
+static uint8_t client[TEST_BLOCK_SIZE]; //The output channels as decoded by the client
+static uint8_t frame[DELTA_MAX_FRAME_SIZE];
+static uint8_t clientSequence = 0;
+
+//Client side of the encoding. Returns the frame type
+static uint8_t decodeFrame(uint16_t frameLength, uint16_t offset, uint16_t length)
+{
+  clientSequence = frame[0];
+  if (frame[1] == DELTA_FRAME_KEY)
+  {
+    TEST_ASSERT_EQUAL_UINT16(DELTA_HEADER_SIZE + length, frameLength);
+    memcpy(&client[offset], &frame[DELTA_HEADER_SIZE], length);
+    return DELTA_FRAME_KEY;
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, frame[1]);
+  const uint8_t *bitmap = &frame[DELTA_HEADER_SIZE];
+  uint16_t position = DELTA_HEADER_SIZE + ((length + 7U) / 8U);
+  for (uint16_t x = 0; x < length; x++)
+  {
+    if ((bitmap[x >> 3U] & (1U << (x & 7U))) != 0U) { client[offset + x] = frame[position++]; }
+  }
+  //Bitmap bits past the end of the range must be clear
+  for (uint16_t x = length; x < (((length + 7U) / 8U) * 8U); x++) { TEST_ASSERT_EQUAL(0, bitmap[x >> 3U] & (1U << (x & 7U))); }
+  TEST_ASSERT_EQUAL_UINT16(position, frameLength);
+  return DELTA_FRAME_DELTA;
+}
+
+static uint8_t sendFrame(uint16_t offset, uint16_t length)
+{
+  uint16_t frameLength = encodeDeltaFrame(&encoder, frame, &values[offset], offset, length, clientSequence);
+  TEST_ASSERT_TRUE(frameLength <= DELTA_MAX_FRAME_SIZE);
+  uint8_t type = decodeFrame(frameLength, offset, length);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&values[offset], &client[offset], length);
+  return type;
+}
+
+static void setup(void)
+{
+  resetDeltaEncoder(&encoder);
+  for (uint16_t x = 0; x < TEST_BLOCK_SIZE; x++) { values[x] = (uint8_t)(x * 7U); }
+  memset(client, 0, sizeof(client));
+  clientSequence = 0;
+  srand(1);
+}
+
+static void test_delta_first_frame_is_keyframe(void)
+{
+  setup();
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(0, TEST_BLOCK_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(1, frame[0]);
+}
+
+static void test_delta_unchanged(void)
+{
+  setup();
+  sendFrame(0, TEST_BLOCK_SIZE);
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, sendFrame(0, TEST_BLOCK_SIZE));
+  //Only the bitmap is sent, and no bits are set
+  uint16_t frameLength = encodeDeltaFrame(&encoder, frame, values, 0, TEST_BLOCK_SIZE, clientSequence);
+  TEST_ASSERT_EQUAL_UINT16(DELTA_HEADER_SIZE + ((TEST_BLOCK_SIZE + 7U) / 8U), frameLength);
+  for (uint16_t x = DELTA_HEADER_SIZE; x < frameLength; x++) { TEST_ASSERT_EQUAL_UINT8(0, frame[x]); }
+}
+
+//The first and last bytes of the range, and the last byte of a bitmap byte, must all be picked up
+static void test_delta_bitmap(void)
+{
+  setup();
+  sendFrame(0, TEST_BLOCK_SIZE);
+  values[0]++;
+  values[7]++;
+  values[8]++;
+  values[TEST_BLOCK_SIZE - 1U]++;
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, sendFrame(0, TEST_BLOCK_SIZE));
+  TEST_ASSERT_EQUAL_HEX8(0x81, frame[DELTA_HEADER_SIZE]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, frame[DELTA_HEADER_SIZE + 1U]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, frame[DELTA_HEADER_SIZE + ((TEST_BLOCK_SIZE - 1U) / 8U)]); //129 bytes, so the last byte is alone in the last bitmap byte
+}
+
+//Random changes over many frames. The client copy must always match, with a keyframe after every DELTA_KEYFRAME_INTERVAL delta frames
+static void test_delta_random_changes(void)
+{
+  setup();
+  const uint16_t offset = 3;
+  const uint16_t length = 100;
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(offset, length));
+  for (uint16_t frameNum = 1; frameNum <= (4U * (DELTA_KEYFRAME_INTERVAL + 1U)); frameNum++)
+  {
+    uint8_t changes = (uint8_t)(rand() % 20);
+    for (uint8_t x = 0; x < changes; x++) { values[rand() % TEST_BLOCK_SIZE] = (uint8_t)rand(); }
+    uint8_t expected = ((frameNum % (DELTA_KEYFRAME_INTERVAL + 1U)) == 0U) ? DELTA_FRAME_KEY : DELTA_FRAME_DELTA;
+    TEST_ASSERT_EQUAL_UINT8(expected, sendFrame(offset, length));
+  }
+}
+
+//A frame that the client did not receive must not be used as the reference
+static void test_delta_missed_frame(void)
+{
+  setup();
+  sendFrame(0, TEST_BLOCK_SIZE);
+  values[10]++;
+  (void)encodeDeltaFrame(&encoder, frame, values, 0, TEST_BLOCK_SIZE, clientSequence); //Lost
+  values[20]++;
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(0, TEST_BLOCK_SIZE)); //Client acknowledges the frame before the lost one
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, sendFrame(0, TEST_BLOCK_SIZE));
+}
+
+static void test_delta_range_change(void)
+{
+  setup();
+  sendFrame(0, 50);
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(0, 60));
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(10, 60));
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, sendFrame(10, 60));
+}
+
+static void test_delta_reset(void)
+{
+  setup();
+  sendFrame(0, TEST_BLOCK_SIZE);
+  sendFrame(0, TEST_BLOCK_SIZE);
+  resetDeltaEncoder(&encoder);
+  clientSequence = 0; //Matches the sequence of the reset encoder, so only the lack of a reference forces the keyframe
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_KEY, sendFrame(0, TEST_BLOCK_SIZE));
+  TEST_ASSERT_EQUAL_UINT8(DELTA_FRAME_DELTA, sendFrame(0, TEST_BLOCK_SIZE));
+}
+
+//The range check used by the 0x32 handler before any frame is encoded
+static void test_delta_range_valid(void)
+{
+  TEST_ASSERT_TRUE(isDeltaRangeValid(0, 129, 129));
+  TEST_ASSERT_TRUE(isDeltaRangeValid(128, 1, 129));
+  TEST_ASSERT_FALSE(isDeltaRangeValid(0, 0, 129));
+  TEST_ASSERT_FALSE(isDeltaRangeValid(0, 130, 129));
+  TEST_ASSERT_FALSE(isDeltaRangeValid(1, 129, 129));
+  TEST_ASSERT_FALSE(isDeltaRangeValid(129, 1, 129));
+  TEST_ASSERT_FALSE(isDeltaRangeValid(0xFFFFU, 2, 129)); //Offset + length overflows
+  TEST_ASSERT_FALSE(isDeltaRangeValid(0, DELTA_MAX_LENGTH + 1U, 0xFFFFU)); //Larger than the reference
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_delta_first_frame_is_keyframe);
+  RUN_TEST(test_delta_unchanged);
+  RUN_TEST(test_delta_bitmap);
+  RUN_TEST(test_delta_random_changes);
+  RUN_TEST(test_delta_missed_frame);
+  RUN_TEST(test_delta_range_change);
+  RUN_TEST(test_delta_reset);
+  RUN_TEST(test_delta_range_valid);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// Host test of the serial command receive queue (See speeduino/comms_queue.h)
+// Commands must come out in the order they were received, a full queue must not accept another command, and every command
+// (Including those too large to be queued) must get exactly one entry with the matching status.
+// Run with: pio test -e native -f test_comms_queue_native
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../speeduino/comms_queue.cpp"
+
+static serial_queue queue;
+
+//Stand in for the CRC32 of the payload. The queue only compares it with the CRC that was received
+static uint32_t testCrc(const uint8_t *data, uint16_t length)
+{
+  uint32_t crc = 0x12345678UL;
+  for (uint16_t x = 0; x < length; x++) { crc = (crc * 31U) + data[x]; }
+  return crc;
+}
+
+//Receives a command of the given length, with payload bytes of first, first+1... Returns false if the queue did not accept it
+static bool receiveCommand(uint16_t length, uint8_t first, bool goodCrc)
+{
+  if (!beginSerialQueueRx(&queue, length)) { return false; }
+
+  uint8_t payload[300];
+  for (uint16_t x = 0; x < length; x++) { payload[x] = (uint8_t)(first + x); }
+  uint32_t crc = testCrc(payload, length);
+  if (!goodCrc) { crc ^= 1U; }
+
+  bool complete = false;
+  for (uint16_t x = 0; x < length; x++)
+  {
+    TEST_ASSERT_FALSE(complete);
+    complete = serialQueueRxByte(&queue, payload[x]);
+  }
+  for (uint8_t x = 0; x < SERIAL_QUEUE_CRC_SIZE; x++)
+  {
+    TEST_ASSERT_FALSE(complete);
+    complete = serialQueueRxByte(&queue, (uint8_t)(crc >> (24U - (8U * x))));
+  }
+  TEST_ASSERT_TRUE(complete);
+
+  uint32_t payloadCrc = 0;
+  if (length <= SERIAL_QUEUE_PAYLOAD_SIZE) { payloadCrc = testCrc(serialQueueRxEntry(&queue)->payload, length); }
+  (void)endSerialQueueRx(&queue, payloadCrc);
+  return true;
+}
+
+static void checkEntry(const serial_queue_entry *pEntry, uint8_t status, uint8_t length, uint8_t first)
+{
+  TEST_ASSERT_NOT_NULL(pEntry);
+  TEST_ASSERT_EQUAL_UINT8(status, pEntry->status);
+  TEST_ASSERT_EQUAL_UINT8(length, pEntry->length);
+  for (uint8_t x = 0; x < length; x++) { TEST_ASSERT_EQUAL_UINT8((uint8_t)(first + x), pEntry->payload[x]); }
+}
+
+static void test_queue_empty(void)
+{
+  clearSerialQueue(&queue);
+  TEST_ASSERT_NULL(popSerialQueue(&queue));
+}
+
+static void test_queue_fifo_order(void)
+{
+  clearSerialQueue(&queue);
+  //Run several times round the queue so that the head wraps
+  for (uint8_t x = 0; x < 5U; x++)
+  {
+    TEST_ASSERT_TRUE(receiveCommand(7, 10U * x, true));
+    TEST_ASSERT_TRUE(receiveCommand(SERIAL_QUEUE_PAYLOAD_SIZE, (10U * x) + 100U, true));
+    checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 7, 10U * x);
+    checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, SERIAL_QUEUE_PAYLOAD_SIZE, (10U * x) + 100U);
+    TEST_ASSERT_NULL(popSerialQueue(&queue));
+  }
+}
+
+//Popping one entry makes room for exactly one more, which goes after the entries already queued
+static void test_queue_full(void)
+{
+  clearSerialQueue(&queue);
+  for (uint8_t x = 0; x < SERIAL_QUEUE_DEPTH; x++) { TEST_ASSERT_TRUE(receiveCommand(3, 10U * x, true)); }
+  TEST_ASSERT_FALSE(beginSerialQueueRx(&queue, 3));
+
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 3, 0);
+  TEST_ASSERT_TRUE(receiveCommand(4, 50, true));
+  TEST_ASSERT_FALSE(beginSerialQueueRx(&queue, 3));
+  for (uint8_t x = 1; x < SERIAL_QUEUE_DEPTH; x++) { checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 3, 10U * x); }
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 4, 50);
+  TEST_ASSERT_NULL(popSerialQueue(&queue));
+}
+
+//A command too large to be queued is read in full (So that it does not back up in the serial buffer) and given its own entry in order
+static void test_queue_oversize_order(void)
+{
+  clearSerialQueue(&queue);
+  TEST_ASSERT_TRUE(receiveCommand(2, 1, true));
+  TEST_ASSERT_TRUE(receiveCommand(SERIAL_QUEUE_PAYLOAD_SIZE + 1U, 0, true));
+  TEST_ASSERT_FALSE(beginSerialQueueRx(&queue, 2));
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 2, 1);
+  TEST_ASSERT_TRUE(receiveCommand(261, 0, true)); //Page write size
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OVERSIZE, 0, 0);
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OVERSIZE, 0, 0);
+  TEST_ASSERT_NULL(popSerialQueue(&queue));
+}
+
+static void test_queue_crc_error(void)
+{
+  clearSerialQueue(&queue);
+  TEST_ASSERT_TRUE(receiveCommand(5, 1, false));
+  TEST_ASSERT_TRUE(receiveCommand(5, 1, true));
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_CRC_ERR, 0, 0);
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 5, 1);
+}
+
+static void test_queue_timeout(void)
+{
+  clearSerialQueue(&queue);
+  TEST_ASSERT_TRUE(receiveCommand(5, 1, true));
+  TEST_ASSERT_TRUE(beginSerialQueueRx(&queue, 5));
+  TEST_ASSERT_FALSE(serialQueueRxByte(&queue, 1));
+  TEST_ASSERT_FALSE(beginSerialQueueRx(&queue, 5)); //Already receiving
+  timeoutSerialQueueRx(&queue);
+  TEST_ASSERT_FALSE(queue.rxInProgress);
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_OK, 5, 1);
+  checkEntry(popSerialQueue(&queue), SERIAL_QUEUE_TIMEOUT, 0, 0);
+  timeoutSerialQueueRx(&queue); //Nothing being received
+  TEST_ASSERT_NULL(popSerialQueue(&queue));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_queue_empty);
+  RUN_TEST(test_queue_fifo_order);
+  RUN_TEST(test_queue_full);
+  RUN_TEST(test_queue_oversize_order);
+  RUN_TEST(test_queue_crc_error);
+  RUN_TEST(test_queue_timeout);
+  return UNITY_END();
+}
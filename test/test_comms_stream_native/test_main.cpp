@@ -0,0 +1,117 @@
+// Host test of the output channel streaming parameters and timing (See speeduino/comms_stream.h)
+// Run with: pio test -e native -f test_comms_stream_native
+#include <unity.h>
+#include <stdint.h>
+#include "../../speeduino/comms_stream.h"
+
+#define TEST_BLOCK_SIZE 129U //LOG_ENTRY_SIZE
+
+static stream_state stream;
+
+//Counts the frames that would be sent by calling the stream pump every ms for the given time
+static uint16_t countFrames(uint32_t start, uint32_t duration)
+{
+  uint16_t frames = 0;
+  for (uint32_t now = start; now < (start + duration); now++)
+  {
+    if (isStreamFrameDue(&stream, now)) { frames++; }
+  }
+  return frames;
+}
+
+static void test_stream_subset(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 4, 10, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(4, stream.offset);
+  TEST_ASSERT_EQUAL_UINT16(10, stream.length);
+
+  TEST_ASSERT_TRUE(startStream(&stream, 0, TEST_BLOCK_SIZE, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(0, stream.offset);
+  TEST_ASSERT_EQUAL_UINT16(TEST_BLOCK_SIZE, stream.length);
+
+  TEST_ASSERT_TRUE(startStream(&stream, TEST_BLOCK_SIZE - 1U, 1, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(TEST_BLOCK_SIZE - 1U, stream.offset);
+  TEST_ASSERT_EQUAL_UINT16(1, stream.length);
+}
+
+//A subset that runs past the end of the output channels is clamped to the end of them
+static void test_stream_subset_clamped(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 100, 100, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(100, stream.offset);
+  TEST_ASSERT_EQUAL_UINT16(TEST_BLOCK_SIZE - 100U, stream.length);
+
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 0xFFFFU, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(TEST_BLOCK_SIZE, stream.length);
+}
+
+static void test_stream_subset_invalid(void)
+{
+  stopStream(&stream);
+  TEST_ASSERT_FALSE(startStream(&stream, 0, 0, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_FALSE(startStream(&stream, TEST_BLOCK_SIZE, 1, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_FALSE(startStream(&stream, 0xFFFFU, 2, 50, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_FALSE(startStream(&stream, 0, 10, 0, TEST_BLOCK_SIZE, 0));
+  //A rejected request must not start streaming
+  TEST_ASSERT_EQUAL_UINT16(0, countFrames(0, 1000));
+}
+
+static void test_stream_rate(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 50, TEST_BLOCK_SIZE, 1000));
+  TEST_ASSERT_EQUAL_UINT16(20, stream.interval);
+  TEST_ASSERT_EQUAL_UINT16(50, countFrames(1001, 1000)); //The first frame is sent when the stream starts
+
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 3, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(333, stream.interval);
+  TEST_ASSERT_EQUAL_UINT16(3, countFrames(1, 1000));
+}
+
+static void test_stream_rate_limit(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, STREAM_MAX_RATE + 1U, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(1000U / STREAM_MAX_RATE, stream.interval);
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 0xFFFFU, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_EQUAL_UINT16(1000U / STREAM_MAX_RATE, stream.interval);
+  TEST_ASSERT_EQUAL_UINT16(STREAM_MAX_RATE, countFrames(1, 1000));
+}
+
+//A pump that is called late sends one frame, rather than catching up on the missed ones
+static void test_stream_late(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 100, TEST_BLOCK_SIZE, 0));
+  TEST_ASSERT_TRUE(isStreamFrameDue(&stream, 55));
+  TEST_ASSERT_FALSE(isStreamFrameDue(&stream, 56));
+  TEST_ASSERT_FALSE(isStreamFrameDue(&stream, 64));
+  TEST_ASSERT_TRUE(isStreamFrameDue(&stream, 65));
+}
+
+static void test_stream_timer_wrap(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 100, TEST_BLOCK_SIZE, 0xFFFFFFF0UL));
+  TEST_ASSERT_FALSE(isStreamFrameDue(&stream, 0xFFFFFFF9UL));
+  TEST_ASSERT_TRUE(isStreamFrameDue(&stream, 0x00000000UL));
+}
+
+static void test_stream_stop(void)
+{
+  TEST_ASSERT_TRUE(startStream(&stream, 0, 10, 100, TEST_BLOCK_SIZE, 0));
+  stopStream(&stream);
+  TEST_ASSERT_EQUAL_UINT16(0, countFrames(1, 1000));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_stream_subset);
+  RUN_TEST(test_stream_subset_clamped);
+  RUN_TEST(test_stream_subset_invalid);
+  RUN_TEST(test_stream_rate);
+  RUN_TEST(test_stream_rate_limit);
+  RUN_TEST(test_stream_late);
+  RUN_TEST(test_stream_timer_wrap);
+  RUN_TEST(test_stream_stop);
+  return UNITY_END();
+}
@@ -0,0 +1,209 @@
+// Host test and benchmark of the 32 bit CRC in FastCRC (See speeduino/src/FastCRC/FastCRCsw.cpp)
+// FastCRCsw.cpp is built once for each of the ways a board can calculate the CRC, then FastCRC32::crc32() and crc32_upd()
+// of each build are checked against a bitwise reference. Their throughput is also reported.
+// The zero run combine used to pad the page CRCs (See speeduino/crc32_zeros.h) is also checked against the bitwise reference.
+// Run with: pio test -e native -f test_crc32_native
+#include <unity.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ================= Model of the STM32 CRC unit ===================
+// Fixed CRC32 polynomial, MSB first, 32 bit words, reset to 0xFFFFFFFF and no output XOR. This lets the hardware combine in
+// crc32_upd() run on the host
+static uint32_t crcUnitRegister = 0xFFFFFFFFUL;
+struct crc_unit_cr { void operator=(uint32_t value) { if (value != 0U) { crcUnitRegister = 0xFFFFFFFFUL; } } };
+struct crc_unit_dr
+{
+  void operator=(uint32_t word)
+  {
+    crcUnitRegister ^= word;
+    for (uint8_t bit = 0; bit < 32U; bit++) { crcUnitRegister = (crcUnitRegister & 0x80000000UL) ? (crcUnitRegister << 1) ^ 0x04C11DB7UL : crcUnitRegister << 1; }
+  }
+  operator uint32_t() const { return crcUnitRegister; }
+};
+struct crc_unit { crc_unit_cr CR; crc_unit_dr DR; };
+static crc_unit crcUnit;
+
+static inline uint32_t reverseBits(uint32_t value)
+{
+  uint32_t result = 0;
+  for (uint8_t bit = 0; bit < 32U; bit++) { result = (result << 1) | ((value >> bit) & 1U); }
+  return result;
+}
+
+// ================= Each variant of FastCRCsw.cpp ===================
+#define CRC_BIGTABLES 1
+
+//Slice by 8. Used by most 32 bit boards
+namespace crc_slice8 {
+#define CRC_SLICE8 1
+#define CRC_STM32_HW 0
+#include "../../speeduino/src/FastCRC/FastCRCsw.cpp"
+}
+#undef FastCRC_h
+#undef FastCRC_tables
+#undef FastCRC_cpu
+#undef CRC_SLICE8
+#undef CRC_STM32_HW
+#undef CRC_TABLE_CRC32
+#undef CRC_TABLE_CKSUM
+
+//Slice by 4. Used by AVR
+namespace crc_slice4 {
+#define CRC_SLICE8 0
+#define CRC_STM32_HW 0
+#include "../../speeduino/src/FastCRC/FastCRCsw.cpp"
+}
+#undef FastCRC_h
+#undef FastCRC_tables
+#undef FastCRC_cpu
+#undef CRC_SLICE8
+#undef CRC_STM32_HW
+#undef CRC_TABLE_CRC32
+#undef CRC_TABLE_CKSUM
+
+//STM32 CRC unit, with slice by 8 for any bytes that aren't in whole words
+namespace crc_stm32 {
+#define CRC_SLICE8 1
+#define CRC_STM32_HW 1
+#define CRC (&crcUnit)
+#define CRC_CR_RESET 1U
+#define __RBIT(value) reverseBits(value)
+#define __HAL_RCC_CRC_CLK_ENABLE()
+#include "../../speeduino/src/FastCRC/FastCRCsw.cpp"
+}
+
+#include "../../speeduino/crc32_zeros.h"
+
+#define BENCH_BUFFER_SIZE 2048U //The largest serial payload (SD sector reads)
+#define BENCH_ITERATIONS  2000U
+
+static uint8_t buffer[BENCH_BUFFER_SIZE + 8U]; //Extra bytes so that unaligned starts can be tested
+
+static uint32_t crc32_bitwise(const uint8_t *data, uint16_t len)
+{
+  uint32_t crc = 0xFFFFFFFFUL;
+  while (len--)
+  {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8U; bit++) { crc = (crc & 1U) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1; }
+  }
+  return ~crc;
+}
+
+static void fill_buffer(void)
+{
+  uint32_t state = 12345UL;
+  for (uint16_t x = 0; x < sizeof(buffer); x++)
+  {
+    state = (state * 1103515245UL) + 12345UL;
+    buffer[x] = (uint8_t)(state >> 16);
+  }
+}
+
+template <typename crc_t>
+static void check_variant(void)
+{
+  fill_buffer();
+  crc_t crcCalc;
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926UL, crcCalc.crc32((const uint8_t *)"123456789", 9)); //Standard CRC32 check value
+
+  //Every length up to a few words past the 16 byte blocks, from each alignment
+  for (uint8_t start = 0; start < 4U; start++)
+  {
+    for (uint16_t len = 0; len < 72U; len++) { TEST_ASSERT_EQUAL_HEX32(crc32_bitwise(buffer + start, len), crcCalc.crc32(buffer + start, len)); }
+  }
+  TEST_ASSERT_EQUAL_HEX32(crc32_bitwise(buffer, BENCH_BUFFER_SIZE), crcCalc.crc32(buffer, BENCH_BUFFER_SIZE));
+
+  //A calculation continued with crc32_upd() over uneven pieces (As the page CRC does) must match the calculation in one go
+  const uint16_t pieces[] = { 3, 17, 64, 1, 250, 33, 0, 500, 7 };
+  uint16_t offset = 0;
+  uint32_t crc = 0;
+  for (uint8_t x = 0; x < (sizeof(pieces) / sizeof(pieces[0])); x++)
+  {
+    crc = (x == 0U) ? crcCalc.crc32(buffer + offset, pieces[x], false) : crcCalc.crc32_upd(buffer + offset, pieces[x], false);
+    offset += pieces[x];
+  }
+  TEST_ASSERT_EQUAL_HEX32(crc32_bitwise(buffer, offset), ~crc);
+}
+
+//Continues a CRC register (Not inverted, as used within the page CRC calculation) over a run of zero bytes, a byte at a time
+static uint32_t crc32_bitwise_zeros(uint32_t crc, uint16_t len)
+{
+  while (len--)
+  {
+    for (uint8_t bit = 0; bit < 8U; bit++) { crc = (crc & 1U) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1; }
+  }
+  return crc;
+}
+
+static void test_crc32_append_zeros(void)
+{
+  fill_buffer();
+  //0, single bits of the length, and lengths with many bits set, up to the largest that the table covers
+  const uint16_t lengths[] = { 0, 1, 2, 3, 5, 7, 8, 13, 100, 127, 255, 256, 1000, 4095, 12345, 32768, 65535 };
+  //Starting from the initial register, after some data, and after data that leaves the register at 0
+  const uint32_t registers[] = { 0xFFFFFFFFUL, ~crc32_bitwise(buffer, 9), ~crc32_bitwise(buffer, BENCH_BUFFER_SIZE), 0UL };
+  for (uint8_t r = 0; r < (sizeof(registers) / sizeof(registers[0])); r++)
+  {
+    for (uint8_t x = 0; x < (sizeof(lengths) / sizeof(lengths[0])); x++)
+    {
+      TEST_ASSERT_EQUAL_HEX32(crc32_bitwise_zeros(registers[r], lengths[x]), append_zeros_crc(lengths[x], registers[r]));
+    }
+  }
+
+  //Padding a page after its data (As computePageCRC32() does) must match the CRC of the data and the zero bytes in one go
+  static uint8_t page[300];
+  memcpy(page, buffer, 100);
+  memset(page + 100, 0, sizeof(page) - 100U);
+  TEST_ASSERT_EQUAL_HEX32(crc32_bitwise(page, sizeof(page)), ~append_zeros_crc(sizeof(page) - 100U, ~crc32_bitwise(page, 100)));
+}
+
+static void test_crc32_slice8(void) { check_variant<crc_slice8::FastCRC32>(); }
+static void test_crc32_slice4(void) { check_variant<crc_slice4::FastCRC32>(); }
+static void test_crc32_stm32(void)
+{
+  crcUnitRegister = 0U;
+  check_variant<crc_stm32::FastCRC32>();
+  TEST_ASSERT_TRUE(crcUnitRegister != 0U); //The CRC unit was used
+}
+
+template <typename crc_t>
+static void benchmark_variant(const char *name)
+{
+  crc_t crcCalc;
+  volatile uint32_t result = 0;
+  clock_t start = clock();
+  for (uint16_t x = 0; x < BENCH_ITERATIONS; x++) { result ^= crcCalc.crc32(buffer, BENCH_BUFFER_SIZE); }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  double mbPerSecond = seconds > 0 ? ((double)BENCH_BUFFER_SIZE * BENCH_ITERATIONS) / (seconds * 1000000.0) : 0;
+  char message[80];
+  snprintf(message, sizeof(message), "%-9s %8.1f MB/s", name, mbPerSecond);
+  TEST_MESSAGE(message);
+  (void)result;
+}
+
+static void test_crc32_benchmark(void)
+{
+  fill_buffer();
+  benchmark_variant<crc_slice4::FastCRC32>("slice4");
+  benchmark_variant<crc_slice8::FastCRC32>("slice8");
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+
+  RUN_TEST(test_crc32_slice8);
+  RUN_TEST(test_crc32_slice4);
+  RUN_TEST(test_crc32_stm32);
+  RUN_TEST(test_crc32_append_zeros);
+  RUN_TEST(test_crc32_benchmark);
+
+  return UNITY_END();
+}
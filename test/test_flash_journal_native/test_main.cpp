@@ -0,0 +1,253 @@
+// Host test of the flash journal (See speeduino/src/SPIAsEEPROM/FlashJournal.h)
+// The journal runs on a RAM model of a NOR flash chip. Programming can only clear bits, erases set a whole sector back to 0xFF
+// and a simulated power loss can stop a write part way through. After every power loss the journal is started again and each
+// record must still be either the previous or the new version, never a mix of the two and never missing.
+// Run with: pio test -e native -f test_flash_journal_native
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ================= NOR flash model ===================
+//Stands in for SPIAsEEPROM.h, which needs the Arduino SPI and Winbond drivers
+#define FLASH_AS_EEPROM_h
+typedef uint8_t byte;
+
+#define FLASH_SIZE          (64UL * 1024UL)
+#define FLASH_SECTOR_SIZE   4096UL
+#define FLASH_PAGE_SIZE     256UL
+
+struct power_loss {};
+
+class FLASH_EEPROM_BaseClass
+{
+  friend class FlashJournal;
+
+  public:
+    byte memory[FLASH_SIZE];
+    int32_t programBudget = -1; //Number of bytes that can be programmed before the power is lost. -1 for no limit
+    uint32_t erases = 0;
+    bool pageCrossed = false;   //A single write crossed a program page
+
+  protected:
+    virtual int8_t readFlashBytes(uint32_t address, byte *buffer, uint32_t length)
+    {
+      memcpy(buffer, memory + address, length);
+      return 0;
+    }
+
+    virtual int8_t writeFlashBytes(uint32_t address, byte *buffer, uint32_t length)
+    {
+      if ( (length > 0U) && ((address / FLASH_PAGE_SIZE) != ((address + length - 1U) / FLASH_PAGE_SIZE)) ) { pageCrossed = true; }
+      for (uint32_t i = 0; i < length; i++)
+      {
+        if (programBudget == 0) { throw power_loss(); }
+        if (programBudget > 0) { programBudget--; }
+        memory[address + i] &= buffer[i];
+      }
+      return 0;
+    }
+
+    virtual int8_t eraseFlashSector(uint32_t address, uint32_t length)
+    {
+      if (programBudget == 0) { throw power_loss(); }
+      erases++;
+      memset(memory + address, 0xFF, length);
+      return 0;
+    }
+};
+
+#include "../../speeduino/src/SPIAsEEPROM/FlashJournal.cpp"
+#include "../../speeduino/src/FastCRC/FastCRCsw.cpp"
+
+// ================= Records ===================
+#define RECORD_COUNT        16U
+#define RECORD_MAX_LENGTH   384U //The largest config page
+#define JOURNAL_OFFSET      FLASH_SECTOR_SIZE //The first sector is left out, to check that the journal stays inside its own area
+#define OUTSIDE_VALUE       0x5AU
+
+static const Flash_Journal_Config journalConfig = { 8, FLASH_SECTOR_SIZE, JOURNAL_OFFSET };
+
+static FLASH_EEPROM_BaseClass flash;
+static byte pages[RECORD_COUNT][RECORD_MAX_LENGTH];     //Data that is written
+static byte committed[RECORD_COUNT][RECORD_MAX_LENGTH]; //Data of the last write that completed
+static uint16_t lengths[RECORD_COUNT];
+
+static void pageSource(uint8_t id, uint16_t offset, byte *buffer, uint16_t length) { memcpy(buffer, pages[id] + offset, length); }
+
+static void setup_records(uint8_t count)
+{
+  memset(flash.memory, OUTSIDE_VALUE, sizeof(flash.memory)); //Content left over from before the journal was used
+  flash.programBudget = -1;
+  flash.pageCrossed = false;
+  srand(1);
+  for (uint8_t id = 0; id < count; id++)
+  {
+    lengths[id] = 128U + (rand() % (RECORD_MAX_LENGTH - 127U));
+    for (uint16_t x = 0; x < lengths[id]; x++) { pages[id][x] = (byte)rand(); }
+  }
+  for (uint8_t id = count; id < RECORD_COUNT; id++) { lengths[id] = 0; }
+
+  FlashJournal journal(flash, journalConfig);
+  TEST_ASSERT_EQUAL_INT8(0, journal.begin());
+  for (uint8_t id = 0; id < count; id++) { TEST_ASSERT_EQUAL_INT8(0, journal.writeRecord(id, lengths[id], pageSource)); }
+  memcpy(committed, pages, sizeof(committed));
+}
+
+static void change_record(uint8_t id)
+{
+  for (uint16_t x = 0; x < lengths[id]; x++)
+  {
+    if ((rand() % 4) == 0) { pages[id][x] = (byte)rand(); }
+  }
+}
+
+//Every record must be the committed version. The record that was being written when the power was lost may also be the new version
+static void check_records(FlashJournal &journal, int16_t writtenId)
+{
+  byte buffer[RECORD_MAX_LENGTH];
+  for (uint8_t id = 0; id < RECORD_COUNT; id++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(lengths[id], journal.recordLength(id));
+    if (lengths[id] == 0U) { continue; }
+    TEST_ASSERT_EQUAL_INT8(0, journal.readRecord(id, 0, buffer, lengths[id]));
+
+    if ( (id == writtenId) && (memcmp(buffer, pages[id], lengths[id]) == 0) ) { memcpy(committed[id], pages[id], lengths[id]); }
+    TEST_ASSERT_EQUAL_MEMORY(committed[id], buffer, lengths[id]);
+    if (id == writtenId) { memcpy(pages[id], committed[id], lengths[id]); }
+  }
+  TEST_ASSERT_EQUAL_HEX8(OUTSIDE_VALUE, flash.memory[0]);
+  TEST_ASSERT_EQUAL_HEX8(OUTSIDE_VALUE, flash.memory[JOURNAL_OFFSET - 1U]);
+  TEST_ASSERT_EQUAL_HEX8(OUTSIDE_VALUE, flash.memory[JOURNAL_OFFSET + (journalConfig.Flash_Sectors_Used * FLASH_SECTOR_SIZE)]);
+  TEST_ASSERT_FALSE(flash.pageCrossed);
+}
+
+static void test_journal_write_read(void)
+{
+  setup_records(RECORD_COUNT);
+  FlashJournal journal(flash, journalConfig);
+  TEST_ASSERT_EQUAL_INT8(0, journal.begin());
+  check_records(journal, -1);
+
+  //Enough burns to go round the sector ring several times
+  for (uint16_t burn = 0; burn < 200U; burn++)
+  {
+    uint8_t id = rand() % RECORD_COUNT;
+    change_record(id);
+    TEST_ASSERT_EQUAL_INT8(0, journal.writeRecord(id, lengths[id], pageSource));
+    memcpy(committed[id], pages[id], lengths[id]);
+  }
+  check_records(journal, -1);
+
+  FlashJournal restarted(flash, journalConfig);
+  TEST_ASSERT_EQUAL_INT8(0, restarted.begin());
+  check_records(restarted, -1);
+}
+
+//Power loss at every byte of a move to a new sector, including while the records of the oldest sector are being copied
+static void test_journal_power_loss_during_advance(void)
+{
+  setup_records(8);
+  FlashJournal journal(flash, journalConfig);
+  TEST_ASSERT_EQUAL_INT8(0, journal.begin());
+
+  //Keep changing all but the last record until a move to a new sector has to copy that record out of the oldest sector.
+  //Each candidate move is tried on the flash first, then the flash is put back
+  static byte saved[FLASH_SIZE];
+  while (true)
+  {
+    memcpy(saved, flash.memory, sizeof(saved));
+    FlashJournal probe(flash, journalConfig);
+    TEST_ASSERT_EQUAL_INT8(0, probe.begin());
+    uint32_t erases = flash.erases;
+    flash.programBudget = 0x7FFFFFFFL;
+    TEST_ASSERT_EQUAL_INT8(0, probe.maintain());
+    int32_t programmed = 0x7FFFFFFFL - flash.programBudget;
+    flash.programBudget = -1;
+    memcpy(flash.memory, saved, sizeof(saved));
+    if ( (flash.erases != erases) && (programmed > 8) ) { break; } //More than the new sector header was written
+
+    uint8_t id = rand() % 7U;
+    change_record(id);
+    TEST_ASSERT_EQUAL_INT8(0, journal.writeRecord(id, lengths[id], pageSource));
+    memcpy(committed[id], pages[id], lengths[id]);
+  }
+
+  int32_t budget = 0;
+  for (; ; budget++)
+  {
+    memcpy(flash.memory, saved, sizeof(saved));
+    FlashJournal interrupted(flash, journalConfig);
+    TEST_ASSERT_EQUAL_INT8(0, interrupted.begin());
+    flash.programBudget = budget;
+    bool completed = true;
+    try { TEST_ASSERT_EQUAL_INT8(0, interrupted.maintain()); }
+    catch (power_loss&) { completed = false; }
+    flash.programBudget = -1;
+    if (completed) { break; }
+
+    FlashJournal restarted(flash, journalConfig);
+    TEST_ASSERT_EQUAL_INT8(0, restarted.begin());
+    check_records(restarted, -1);
+
+    //The journal must still take new records after the interrupted move
+    change_record(1);
+    TEST_ASSERT_EQUAL_INT8(0, restarted.writeRecord(1, lengths[1], pageSource));
+    FlashJournal reread(flash, journalConfig);
+    TEST_ASSERT_EQUAL_INT8(0, reread.begin());
+    byte buffer[RECORD_MAX_LENGTH];
+    TEST_ASSERT_EQUAL_INT8(0, reread.readRecord(1, 0, buffer, lengths[1]));
+    TEST_ASSERT_EQUAL_MEMORY(pages[1], buffer, lengths[1]);
+    memcpy(pages[1], committed[1], lengths[1]);
+  }
+}
+
+//Many burns with a power loss at a random point in some of them
+static void test_journal_random_power_loss(void)
+{
+  setup_records(RECORD_COUNT);
+  uint16_t losses = 0;
+  for (uint16_t burn = 0; burn < 3000U; burn++)
+  {
+    FlashJournal journal(flash, journalConfig);
+    TEST_ASSERT_EQUAL_INT8(0, journal.begin());
+    check_records(journal, -1);
+
+    uint8_t id = rand() % RECORD_COUNT;
+    change_record(id);
+    flash.programBudget = ((rand() % 5) == 0) ? (rand() % 600) : -1;
+    try
+    {
+      if ((rand() % 3) == 0) { journal.maintain(); }
+      TEST_ASSERT_EQUAL_INT8(0, journal.writeRecord(id, lengths[id], pageSource));
+      memcpy(committed[id], pages[id], lengths[id]);
+    }
+    catch (power_loss&)
+    {
+      losses++;
+      flash.programBudget = -1;
+      FlashJournal restarted(flash, journalConfig);
+      TEST_ASSERT_EQUAL_INT8(0, restarted.begin());
+      check_records(restarted, id);
+    }
+    flash.programBudget = -1;
+  }
+  char message[64];
+  snprintf(message, sizeof(message), "%u power losses, %u sector erases", (unsigned)losses, (unsigned)flash.erases);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(losses > 0U);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+
+  RUN_TEST(test_journal_write_read);
+  RUN_TEST(test_journal_power_loss_during_advance);
+  RUN_TEST(test_journal_random_power_loss);
+
+  return UNITY_END();
+}
@@ -1,5 +1,8 @@
 #include <globals.h>
 #include <corrections.h>
+#include <knock.h>
+#include <transientFuel.h>
+#include <crankMaths.h>
 #include <unity.h>
 #include "test_corrections.h"
 #include "../test_utils.h"
@@ -12,6 +15,8 @@ void testCorrections()
   test_corrections_WUE();
   test_corrections_dfco();
   test_corrections_TAE(); //TPS based accel enrichment corrections
+  test_corrections_knock();
+  test_corrections_wallWetting();
   /*
   RUN_TEST(test_corrections_cranking); //Not written yet
   RUN_TEST(test_corrections_ASE); //Not written yet
@@ -84,12 +89,55 @@ void test_corrections_WUE_active_value(void)
   TEST_ASSERT_EQUAL(125, correctionWUE() );
 }
 
+void test_corrections_WUE_stall(void)
+{
+  //The warmup bit is cleared when the engine stalls. The cached WUE must be recalculated (Setting the bit again) even though the coolant temp hasn't changed
+  currentStatus.coolant = 0;
+  ((uint8_t*)WUETable.axisX)[9] = 120 + CALIBRATION_TEMPERATURE_OFFSET; //Set a WUE end value of 120
+  initialiseCorrections();
+  correctionsFuel();
+  TEST_ASSERT_BIT_HIGH(BIT_ENGINE_WARMUP, currentStatus.engine);
+
+  BIT_CLEAR(currentStatus.engine, BIT_ENGINE_WARMUP); //As done by the main loop on a stall
+  invalidateSlowFuelCorrections();
+  correctionsFuel();
+  TEST_ASSERT_BIT_HIGH(BIT_ENGINE_WARMUP, currentStatus.engine);
+}
+
+void test_corrections_WUE_cached_value(void)
+{
+  //Once invalidated, the cached WUE value must follow a change to the WUE curve with the coolant temp unchanged
+  currentStatus.coolant = 80;
+  ((uint8_t*)WUETable.axisX)[6] = 70 + CALIBRATION_TEMPERATURE_OFFSET;
+  ((uint8_t*)WUETable.axisX)[7] = 90 + CALIBRATION_TEMPERATURE_OFFSET;
+  ((uint8_t*)WUETable.axisX)[8] = 100 + CALIBRATION_TEMPERATURE_OFFSET;
+  ((uint8_t*)WUETable.axisX)[9] = 120 + CALIBRATION_TEMPERATURE_OFFSET;
+  ((uint8_t*)WUETable.values)[6] = 120;
+  ((uint8_t*)WUETable.values)[7] = 130;
+  WUETable.cacheTime = currentStatus.secl - 1;
+  invalidateSlowFuelCorrections();
+  correctionsFuel();
+  TEST_ASSERT_EQUAL(125, currentStatus.wueCorrection);
+
+  ((uint8_t*)WUETable.values)[6] = 140;
+  ((uint8_t*)WUETable.values)[7] = 150;
+  WUETable.cacheTime = currentStatus.secl - 1;
+  correctionsFuel();
+  TEST_ASSERT_EQUAL(125, currentStatus.wueCorrection); //Coolant is unchanged, so the cached value is still used
+
+  invalidateSlowFuelCorrections(); //As done by the main loop when cranking starts
+  correctionsFuel();
+  TEST_ASSERT_EQUAL(145, currentStatus.wueCorrection);
+}
+
 void test_corrections_WUE(void)
 {
   RUN_TEST(test_corrections_WUE_active);
   RUN_TEST(test_corrections_WUE_inactive);
   RUN_TEST(test_corrections_WUE_active_value);
   RUN_TEST(test_corrections_WUE_inactive_value);
+  RUN_TEST(test_corrections_WUE_stall);
+  RUN_TEST(test_corrections_WUE_cached_value);
 }
 void test_corrections_cranking(void)
 {
@@ -394,4 +442,183 @@ void test_corrections_TAE()
   RUN_TEST(test_corrections_TAE_50pc_warmup_taper);
 	
 	
-}
\ No newline at end of file
+}
+//**********************************************************************************************************************
+//Knock windows open at TDC and last 100 degrees. At 600rpm this gives a window of ~28ms after each ignition event
+void test_corrections_knock_setup()
+{
+  configPage10.knock_mode = KNOCK_MODE_DIGITAL;
+  configPage10.knock_count = 2;
+  configPage10.knock_maxMAP = 255; //510kPa
+  configPage10.knock_maxRPM = 100; //10000rpm
+  configPage10.knock_firstStep = 4;
+  configPage10.knock_stepSize = 2;
+  configPage10.knock_stepTime = 0;
+  configPage10.knock_maxRetard = 8;
+  configPage10.knock_duration = 0;
+  configPage10.knock_recoveryStepTime = 0;
+  configPage10.knock_recoveryStep = 1;
+  for(uint8_t x = 0; x < 6; x++)
+  {
+    configPage10.knock_window_rpms[x] = (x + 1) * 10;
+    configPage10.knock_window_angle[x] = KNOCK_WINDOW_ANGLE_OFFSET; //0 degrees ATDC
+    configPage10.knock_window_dur[x] = 100;
+  }
+
+  maxIgnOutputs = 4;
+  currentStatus.RPM = 600;
+  currentStatus.RPMdiv100 = 6;
+  currentStatus.MAP = 100;
+  currentStatus.advance = 0;
+  setAngleConverterRevolutionTime(100000UL); //600rpm
+
+  initialiseKnock();
+  knockControl(); //Sets the window times
+}
+
+void test_corrections_knock_single_channel()
+{
+  test_corrections_knock_setup();
+
+  //2 pulses in the window of channel 2 only
+  knockIgnitionEvent(1, micros());
+  knockPulse();
+  knockPulse();
+  knockIgnitionEvent(2, micros());
+  knockControl();
+
+  TEST_ASSERT_EQUAL(0, knockChannelRetard[0]);
+  TEST_ASSERT_EQUAL(4, knockChannelRetard[1]); //First step
+  TEST_ASSERT_EQUAL(0, knockChannelRetard[2]);
+  TEST_ASSERT_EQUAL(0, knockChannelRetard[3]);
+  TEST_ASSERT_EQUAL(4, currentStatus.knockRetard);
+  TEST_ASSERT_TRUE(currentStatus.knockActive);
+}
+
+void test_corrections_knock_below_count()
+{
+  test_corrections_knock_setup();
+
+  //Only 1 pulse, but 2 are required
+  knockIgnitionEvent(0, micros());
+  knockPulse();
+  knockControl();
+
+  TEST_ASSERT_EQUAL(0, knockChannelRetard[0]);
+  TEST_ASSERT_FALSE(currentStatus.knockActive);
+}
+
+void test_corrections_knock_step_and_recover()
+{
+  test_corrections_knock_setup();
+
+  for(uint8_t x = 0; x < 4; x++)
+  {
+    knockIgnitionEvent(3, micros());
+    knockPulse();
+    knockPulse();
+    knockControl();
+  }
+  TEST_ASSERT_EQUAL(8, knockChannelRetard[3]); //4 + 2 + 2, limited to the max of 8
+
+  //No more knock. Retard recovers 1 degree at a time
+  knockControl();
+  TEST_ASSERT_EQUAL(7, knockChannelRetard[3]);
+  knockControl();
+  TEST_ASSERT_EQUAL(6, knockChannelRetard[3]);
+}
+
+//The step timer is in 0.1s, which is every 3rd call of knockControl() at 30Hz
+void test_corrections_knock_step_time()
+{
+  test_corrections_knock_setup();
+  configPage10.knock_stepTime = 1;
+  initialiseKnock(); //Restart the timers. The window times are kept
+
+  const uint8_t expected[] = { 4, 4, 6, 6, 6, 8 };
+  for(uint8_t x = 0; x < sizeof(expected); x++)
+  {
+    knockIgnitionEvent(0, micros());
+    knockPulse();
+    knockPulse();
+    knockControl();
+    TEST_ASSERT_EQUAL(expected[x], knockChannelRetard[0]);
+  }
+}
+
+void test_corrections_knock()
+{
+  RUN_TEST(test_corrections_knock_single_channel);
+  RUN_TEST(test_corrections_knock_below_count);
+  RUN_TEST(test_corrections_knock_step_and_recover);
+  RUN_TEST(test_corrections_knock_step_time);
+
+  configPage10.knock_mode = KNOCK_MODE_OFF;
+  initialiseKnock();
+}
+
+void test_corrections_wallWetting_setup()
+{
+  configPage2.aeMode = AE_MODE_XTAU;
+  configPage2.nCylinders = 4;
+  configPage2.strokes = FOUR_STROKE;
+  for(uint8_t x = 0; x < 6; x++)
+  {
+    configPage15.wallWetBins[x] = (x * 20) + 30;
+    configPage15.wallWetX[x] = 25; //64/256
+    configPage15.wallWetTau[x] = 50; //0.5s
+  }
+  currentStatus.coolant = 80;
+  revolutionTime = 20000UL; //3000rpm, 40ms per cycle
+  ignitionCount = 0;
+  initialiseTransientFuel();
+
+  //Establish the steady state film whilst not running
+  BIT_CLEAR(currentStatus.engine, BIT_ENGINE_RUN);
+  correctionWallWetting(5000, 1000);
+  BIT_SET(currentStatus.engine, BIT_ENGINE_RUN);
+  BIT_CLEAR(currentStatus.engine, BIT_ENGINE_CRANK);
+}
+
+void test_corrections_wallWetting_steady()
+{
+  test_corrections_wallWetting_setup();
+
+  //With a constant demand, the film stays at its steady state and the pulsewidth is (Within rounding) unchanged
+  for(uint8_t x = 0; x < 20; x++)
+  {
+    ignitionCount++;
+    TEST_ASSERT_UINT16_WITHIN(10, 5000, correctionWallWetting(5000, 1000));
+  }
+}
+
+void test_corrections_wallWetting_step()
+{
+  test_corrections_wallWetting_setup();
+
+  //Step up in demand. The first injections must be richer than the demand to fill the film, then settle back towards the demand
+  ignitionCount++;
+  uint16_t firstPW = correctionWallWetting(9000, 1000);
+  TEST_ASSERT_GREATER_THAN(9000, firstPW);
+  for(uint16_t x = 0; x < 400; x++)
+  {
+    ignitionCount++;
+    correctionWallWetting(9000, 1000);
+  }
+  ignitionCount++;
+  uint16_t settledPW = correctionWallWetting(9000, 1000);
+  TEST_ASSERT_LESS_THAN(firstPW, settledPW);
+  TEST_ASSERT_UINT16_WITHIN(10, 9000, settledPW);
+
+  //Step back down. The film now supplies some of the fuel, so the injections are leaner than the demand
+  ignitionCount++;
+  TEST_ASSERT_LESS_THAN(5000, correctionWallWetting(5000, 1000));
+}
+
+void test_corrections_wallWetting(void)
+{
+  RUN_TEST(test_corrections_wallWetting_steady);
+  RUN_TEST(test_corrections_wallWetting_step);
+
+  configPage2.aeMode = AE_MODE_TPS;
+}
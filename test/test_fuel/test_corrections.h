@@ -10,4 +10,6 @@ void test_corrections_iatdensity(void);
 void test_corrections_baro(void);
 void test_corrections_launch(void);
 void test_corrections_dfco(void);
-void test_corrections_TAE(void);
\ No newline at end of file
+void test_corrections_TAE(void);
+void test_corrections_knock(void);
+void test_corrections_wallWetting(void);
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "test_corrections.h"
 #include "test_PW.h"
 #include "test_staging.h"
+#include "test_fuel_learn.h"
 
 #define UNITY_EXCLUDE_DETAILS
 
@@ -23,6 +24,7 @@ void setup()
     testCorrections();
     testPW();
     testStaging();
+    testFuelLearn();
 
     UNITY_END(); // stop unit testing
 }
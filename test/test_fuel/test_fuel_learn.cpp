@@ -0,0 +1,174 @@
+#include <globals.h>
+#include <fuelLearn.h>
+#include <table3d.h>
+#include <tuneBanks.h>
+#include <unity.h>
+#include "test_fuel_learn.h"
+#include "../test_utils.h"
+
+#define TEST_VE 50U
+
+//Sets every fuel table cell to TEST_VE, with RPM bins of 500-8000 and load bins of 10-160
+static void setupFuelTable(void)
+{
+  table3d_axis_t axisValue = 500;
+  for (table_axis_iterator itX = fuelTable.axisX.begin(); !itX.at_end(); ++itX)
+  {
+    *itX = axisValue;
+    axisValue += 500;
+  }
+  axisValue = 10;
+  for (table_axis_iterator itY = fuelTable.axisY.begin(); !itY.at_end(); ++itY)
+  {
+    *itY = axisValue;
+    axisValue += 10;
+  }
+  for (table_value_iterator itZ = fuelTable.values.begin(); !itZ.at_end(); ++itZ)
+  {
+    table_row_iterator itRow = *itZ;
+    while (!itRow.at_end())
+    {
+      *itRow = TEST_VE;
+      ++itRow;
+    }
+  }
+  invalidate_cache(&fuelTable.get_value_cache);
+}
+
+static void setupFuelLearn(void)
+{
+  setupFuelTable();
+  activeTuneBank = 0;
+  configPage15.fuelLearnEnable = 1;
+  configPage15.fuelLearnMaxTrim = 15;
+  configPage15.fuelLearnThreshold = 50;
+  configPage6.egoType = 2;
+  configPage6.egoAlgorithm = EGO_ALGORITHM_SIMPLE;
+  configPage6.ego_sdelay = 0;
+  configPage6.egoTemp = 70 + CALIBRATION_TEMPERATURE_OFFSET;
+  currentStatus.runSecs = 10;
+  currentStatus.coolant = 90;
+  currentStatus.status1 = 0;
+  currentStatus.engine = 0;
+  currentStatus.egoCorrection = 100;
+  currentStatus.RPM = 0;
+  resetFuelLearn();
+  writeFuelLearn(); //Clears the pending writes from the reset
+
+  //Operating point exactly on a fuel table cell, so that the full error is learnt against its trim cell
+  (void)get3DTableValue(&fuelTable, 60, 3000);
+  (void)applyFuelLearn(TEST_VE);
+}
+
+//Returns the index of the only trim cell that isn't 0, or FUEL_LEARN_CELLS if there isn't exactly one
+static uint8_t learntCell(void)
+{
+  uint8_t cell = FUEL_LEARN_CELLS;
+  for (uint8_t x = 0; x < FUEL_LEARN_CELLS; x++)
+  {
+    if (fuelLearnTrim[x] != 0)
+    {
+      if (cell != FUEL_LEARN_CELLS) { return FUEL_LEARN_CELLS; }
+      cell = x;
+    }
+  }
+  return cell;
+}
+
+static void test_fuelLearn_trim_steps_at_threshold(void)
+{
+  setupFuelLearn();
+  currentStatus.egoCorrection = 110; //+10% error, accumulated at the full weight of 255/256 (9 per call)
+
+  for (uint8_t x = 0; x < 5; x++) { fuelLearnControl(); }
+  TEST_ASSERT_EQUAL_UINT8(FUEL_LEARN_CELLS, learntCell()); //45 accumulated, below the threshold of 50
+
+  fuelLearnControl();
+  uint8_t cell = learntCell();
+  TEST_ASSERT_NOT_EQUAL(FUEL_LEARN_CELLS, cell);
+  TEST_ASSERT_EQUAL_INT8(1, fuelLearnTrim[cell]);
+  TEST_ASSERT_TRUE(isFuelLearnWritePending());
+
+  //The trim is applied to the VE at the same operating point
+  (void)get3DTableValue(&fuelTable, 60, 3000);
+  TEST_ASSERT_EQUAL_UINT8(101, applyFuelLearn(100));
+}
+
+static void test_fuelLearn_trim_not_learnt_outside_steady_state(void)
+{
+  setupFuelLearn();
+  currentStatus.egoCorrection = 150;
+  BIT_SET(currentStatus.engine, BIT_ENGINE_ACC);
+
+  for (uint8_t x = 0; x < 20; x++) { fuelLearnControl(); }
+  TEST_ASSERT_EQUAL_UINT8(FUEL_LEARN_CELLS, learntCell());
+  TEST_ASSERT_FALSE(isFuelLearnWritePending());
+}
+
+static void test_fuelLearn_trim_clamped(void)
+{
+  setupFuelLearn();
+  configPage15.fuelLearnMaxTrim = 3;
+
+  currentStatus.egoCorrection = 200; //Trim moves by 1 on every call
+  for (uint8_t x = 0; x < 20; x++) { fuelLearnControl(); }
+  uint8_t cell = learntCell();
+  TEST_ASSERT_NOT_EQUAL(FUEL_LEARN_CELLS, cell);
+  TEST_ASSERT_EQUAL_INT8(3, fuelLearnTrim[cell]);
+
+  currentStatus.egoCorrection = 0;
+  for (uint8_t x = 0; x < 60; x++) { fuelLearnControl(); }
+  TEST_ASSERT_EQUAL_INT8(-3, fuelLearnTrim[cell]);
+}
+
+static void test_fuelLearn_merge(void)
+{
+  setupFuelLearn();
+  fuelLearnTrim[0] = 10;
+  fuelLearnTrim[FUEL_LEARN_CELLS - 1U] = -10;
+
+  mergeFuelLearn();
+
+  //Each trim cell covers 2x2 fuel table cells
+  const table3d_dim_t axisSize = decltype(fuelTable)::value_t::row_size;
+  for (uint8_t row = 0; row < axisSize; row++)
+  {
+    for (uint8_t col = 0; col < axisSize; col++)
+    {
+      uint8_t expected = TEST_VE;
+      if ( (row < 2U) && (col < 2U) ) { expected = 55; }
+      else if ( (row >= (axisSize - 2U)) && (col >= (axisSize - 2U)) ) { expected = 45; }
+      TEST_ASSERT_EQUAL_UINT8(expected, fuelTable.values.values[((uint16_t)row * axisSize) + col]);
+    }
+  }
+  //The trims are cleared once they are in the table
+  TEST_ASSERT_EQUAL_UINT8(FUEL_LEARN_CELLS, learntCell());
+  TEST_ASSERT_EQUAL_INT8(0, fuelLearnTrim[0]);
+}
+
+static void test_fuelLearn_merge_only_bank0(void)
+{
+  setupFuelLearn();
+  fuelLearnTrim[0] = 10;
+  activeTuneBank = 1;
+
+  mergeFuelLearn();
+
+  TEST_ASSERT_EQUAL_UINT8(TEST_VE, fuelTable.values.values[0]);
+  TEST_ASSERT_EQUAL_INT8(10, fuelLearnTrim[0]);
+  activeTuneBank = 0;
+  resetFuelLearn();
+}
+
+void testFuelLearn()
+{
+  SET_UNITY_FILENAME() {
+
+  RUN_TEST(test_fuelLearn_trim_steps_at_threshold);
+  RUN_TEST(test_fuelLearn_trim_not_learnt_outside_steady_state);
+  RUN_TEST(test_fuelLearn_trim_clamped);
+  RUN_TEST(test_fuelLearn_merge);
+  RUN_TEST(test_fuelLearn_merge_only_bank0);
+
+  }
+}
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_log_fields.h"
+#include "globals.h"
+#include "logger.h"
+#include "maths.h"
+
+//The tables below are the field order and sizes of the switch based log functions that the logFields table and the legacy serial map replaced.
+//They are written out again here, rather than taken from logger.cpp, so that a change to the order of either table is caught
+
+#define OLD_LOG_UNUSED  0xFFU //Log index 59, which was never used
+
+//TS byte number (getTSLogEntry()) that each log index (getReadableLogEntry()) read from, and whether it was a 2 byte field
+struct old_log_field { uint8_t tsByte; uint8_t size; };
+static const old_log_field oldLogFields[LOG_FIELD_COUNT] PROGMEM = {
+  {   0, 1 }, {   1, 1 }, {   2, 1 }, {   3, 1 }, {   4, 2 }, {   6, 1 }, {   7, 1 }, {   8, 1 }, {   9, 1 }, {  10, 1 }, //0
+  {  11, 1 }, {  12, 1 }, {  13, 1 }, {  14, 2 }, {  16, 1 }, {  17, 2 }, {  19, 1 }, {  20, 1 }, {  21, 1 }, {  22, 2 }, //10
+  {  24, 1 }, {  25, 1 }, {  26, 2 }, {  28, 2 }, {  30, 1 }, {  31, 1 }, {  32, 1 }, {  33, 2 }, {  35, 1 }, {  36, 1 }, //20
+  {  37, 1 }, {  38, 1 }, {  39, 1 }, {  40, 1 }, {  41, 1 }, {  42, 2 }, {  44, 2 }, {  46, 2 }, {  48, 2 }, {  50, 2 }, //30
+  {  52, 2 }, {  54, 2 }, {  56, 2 }, {  58, 2 }, {  60, 2 }, {  62, 2 }, {  64, 2 }, {  66, 2 }, {  68, 2 }, {  70, 2 }, //40
+  {  72, 2 }, {  74, 1 }, {  75, 1 }, {  76, 2 }, {  78, 2 }, {  80, 2 }, {  82, 2 }, {  84, 1 }, {  85, 1 }, { OLD_LOG_UNUSED, 0 }, //50
+  {  86, 2 }, {  88, 2 }, {  90, 2 }, {  92, 1 }, {  93, 2 }, {  95, 2 }, {  97, 1 }, {  98, 1 }, {  99, 2 }, { 101, 1 }, //60
+  { 102, 1 }, { 103, 1 }, { 104, 2 }, { 106, 1 }, { 107, 1 }, { 108, 1 }, { 109, 1 }, { 110, 1 }, { 111, 2 }, { 113, 1 }, //70
+  { 114, 1 }, { 115, 1 }, { 116, 1 }, { 117, 1 }, { 118, 1 }, { 119, 1 }, { 120, 1 }, { 121, 2 }, { 123, 1 }, { 124, 1 }, //80
+  { 125, 2 }, { 127, 1 }, { 128, 1 } //90
+};
+
+#define OLD_LEGACY_SPECIAL  0xFFU //Legacy byte that was not a copy of a TS byte
+#define OLD_LEGACY_LENGTH   123U
+
+//TS byte number that each byte of the legacy secondary serial packet (getLegacySecondarySerialLogEntry()) sent
+static const uint8_t oldLegacyBytes[OLD_LEGACY_LENGTH] PROGMEM = {
+    0,   1,   2, OLD_LEGACY_SPECIAL,   4,   5,   6,   7,   8,   9, //0 (3 = Dwell / 10)
+   10,  11,  12,  13,  14,  15, OLD_LEGACY_SPECIAL,  17, 102,  21, //10 (16 = AE not halved, 18 = VE)
+   76,  77, OLD_LEGACY_SPECIAL,  24,  25,  26,  27,  28,  29,  30, //20 (20/21 = PW1, 22 = TPSdot / 10)
+   31,  32,  33,  34,  35,  36,  37,  38,  39,  40, //30
+   41,  42,  43,  44,  45,  46,  47,  48,  49,  50, //40
+   51,  52,  53,  54,  55,  56,  57,  58,  59,  60, //50
+   61,  62,  63,  64,  65,  66,  67,  68,  69,  70, //60
+   71,  72,  73,  74,  75, OLD_LEGACY_SPECIAL,  78,  79,  80,  81, //70 (75 = Launch correction)
+   82,  83,  84,  85,  86,  87,  88,  89, OLD_LEGACY_SPECIAL, OLD_LEGACY_SPECIAL, //80 (88/89 = Injection angle)
+   38,  92, OLD_LEGACY_SPECIAL,  95,  97,  98,  99, 100, 101, 103, //90 (90 = Idle load, 92 = MAPdot / 10)
+  104, 105, 106, 107, 108, 109, 110, 111, 113, 114, //100
+  115, 116, 117,  19,  20, 118, 119, OLD_LEGACY_SPECIAL, 120, 121, //110 (113/114 = VE1/VE2, 117 = Nitrous status)
+  122, 123, 124 //120
+};
+
+//Gives every byte of the live data snapshot a different value, so that reading the wrong byte is seen
+static void fillLiveData(void)
+{
+  byte *pLiveData = (byte *)&liveData;
+  for (uint16_t x = 0; x < sizeof(liveData); x++) { pLiveData[x] = (byte)(x + 1U); }
+}
+
+static void test_logFields_old_order_and_size(void)
+{
+  logFieldDescriptor field;
+  for (uint16_t logIndex = 0; logIndex < LOG_FIELD_COUNT; logIndex++)
+  {
+    old_log_field expected;
+    memcpy_P(&expected, &oldLogFields[logIndex], sizeof(expected));
+    getLogField(logIndex, field);
+
+    if (expected.tsByte == OLD_LOG_UNUSED)
+    {
+      TEST_ASSERT_EQUAL_UINT8(LOG_FIELD_NONE, field.type);
+      continue;
+    }
+    TEST_ASSERT_EQUAL_UINT8(expected.tsByte, field.offset);
+    bool isWord = (field.type == LOG_FIELD_U16) || (field.type == LOG_FIELD_S16);
+    TEST_ASSERT_EQUAL(expected.size == 2U, isWord);
+    TEST_ASSERT_TRUE(field.offset + expected.size <= sizeof(liveData));
+    //The TS log list of 2 byte fields must agree. The fields added after it have no entries in it
+    if (field.offset < 127U) { TEST_ASSERT_EQUAL(expected.size == 2U, is2ByteEntry(field.offset)); }
+  }
+}
+
+//The readable values must come from the same live data bytes as the TS values
+static void test_logFields_read_ts_bytes(void)
+{
+  fillLiveData();
+  logFieldDescriptor field;
+  for (uint16_t logIndex = 0; logIndex < LOG_FIELD_COUNT; logIndex++)
+  {
+    getLogField(logIndex, field);
+    int32_t expected = 0;
+    switch (field.type)
+    {
+      case LOG_FIELD_U08: expected = getTSLogEntry(field.offset); break;
+      case LOG_FIELD_S08: expected = (int8_t)getTSLogEntry(field.offset); break;
+      case LOG_FIELD_U16: expected = word(getTSLogEntry(field.offset + 1U), getTSLogEntry(field.offset)); break;
+      case LOG_FIELD_S16: expected = (int16_t)word(getTSLogEntry(field.offset + 1U), getTSLogEntry(field.offset)); break;
+      default: expected = 0; break;
+    }
+    TEST_ASSERT_EQUAL_INT32(expected, getLogFieldRaw(field));
+  }
+}
+
+//Fields that need no scaling must give the same readable value as the old switch, which read currentStatus directly
+static void test_logFields_readable_values(void)
+{
+  currentStatus.RPM = 6543;
+  currentStatus.MAP = 245;
+  currentStatus.IAT = -12;
+  currentStatus.coolant = 87;
+  currentStatus.rpmDOT = -1500;
+  currentStatus.vvt1Angle = -35;
+  currentStatus.PW1 = 12345;
+  currentStatus.canin[15] = 0xBEEF;
+  currentStatus.actualDwell = 3210;
+  currentStatus.fuelTemp = 45;
+  updateLiveData();
+
+  TEST_ASSERT_EQUAL_INT16(currentStatus.MAP, getReadableLogEntry(4));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.IAT, getReadableLogEntry(5));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.coolant, getReadableLogEntry(6));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.RPM, getReadableLogEntry(13));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.rpmDOT, getReadableLogEntry(27));
+  TEST_ASSERT_EQUAL_INT16((int16_t)currentStatus.canin[15], getReadableLogEntry(50));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.PW1, getReadableLogEntry(53));
+  TEST_ASSERT_EQUAL_INT16(0, getReadableLogEntry(59));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.vvt1Angle, getReadableLogEntry(65));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.fuelTemp, getReadableLogEntry(82));
+  TEST_ASSERT_EQUAL_INT16(currentStatus.actualDwell, getReadableLogEntry(90));
+  TEST_ASSERT_EQUAL_INT16(0, getReadableLogEntry(LOG_FIELD_COUNT));
+}
+
+static void test_legacySerial_old_order(void)
+{
+  fillLiveData();
+  for (uint16_t byteNum = 0; byteNum < OLD_LEGACY_LENGTH; byteNum++)
+  {
+    uint8_t tsByte = pgm_read_byte(&oldLegacyBytes[byteNum]);
+    if (tsByte != OLD_LEGACY_SPECIAL) { TEST_ASSERT_EQUAL_UINT8(getTSLogEntry(tsByte), getLegacySecondarySerialLogEntry(byteNum)); }
+  }
+  TEST_ASSERT_EQUAL_UINT8(0, getLegacySecondarySerialLogEntry(OLD_LEGACY_LENGTH));
+}
+
+//The legacy bytes that are not in the live data are read from currentStatus in the same way as before
+static void test_legacySerial_special_bytes(void)
+{
+  fillLiveData();
+  currentStatus.dwell = 3456;
+  currentStatus.AEamount = 180;
+  currentStatus.tpsDOT = 870;
+  currentStatus.launchCorrection = 17;
+  currentStatus.injAngle = 0x1234;
+  currentStatus.mapDOT = 430;
+  currentStatus.nitrous_status = 2;
+
+  TEST_ASSERT_EQUAL_UINT8((byte)div100(currentStatus.dwell), getLegacySecondarySerialLogEntry(3));
+  TEST_ASSERT_EQUAL_UINT8(currentStatus.AEamount, getLegacySecondarySerialLogEntry(16));
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)(currentStatus.tpsDOT / 10), getLegacySecondarySerialLogEntry(22));
+  TEST_ASSERT_EQUAL_UINT8(currentStatus.launchCorrection, getLegacySecondarySerialLogEntry(75));
+  TEST_ASSERT_EQUAL_UINT8(lowByte(currentStatus.injAngle), getLegacySecondarySerialLogEntry(88));
+  TEST_ASSERT_EQUAL_UINT8(highByte(currentStatus.injAngle), getLegacySecondarySerialLogEntry(89));
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)(currentStatus.mapDOT / 10), getLegacySecondarySerialLogEntry(92));
+  TEST_ASSERT_EQUAL_UINT8(currentStatus.nitrous_status, getLegacySecondarySerialLogEntry(117));
+}
+
+void testLogFields()
+{
+  RUN_TEST(test_logFields_old_order_and_size);
+  RUN_TEST(test_logFields_read_ts_bytes);
+  RUN_TEST(test_logFields_readable_values);
+  RUN_TEST(test_legacySerial_old_order);
+  RUN_TEST(test_legacySerial_special_bytes);
+}
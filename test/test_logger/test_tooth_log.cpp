@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "test_tooth_log.h"
+#include "logger.h"
+
+#define TOOTH_LOG_LONG_MAX  ((uint32_t)(TOOTH_LOG_LONG_FLAG - 1U) << TOOTH_LOG_LONG_SHIFT) //The longest time that can be stored (1048544uS)
+
+static void test_toothLogTime_short_exact(void)
+{
+  TEST_ASSERT_EQUAL_UINT16(0, encodeToothLogTime(0));
+  TEST_ASSERT_EQUAL_UINT32(0, decodeToothLogTime(encodeToothLogTime(0)));
+  TEST_ASSERT_EQUAL_UINT16(1, encodeToothLogTime(1));
+  TEST_ASSERT_EQUAL_UINT16(TOOTH_LOG_LONG_FLAG - 1U, encodeToothLogTime(TOOTH_LOG_LONG_FLAG - 1U));
+
+  //Every time below 32.768ms is stored exactly, and without the long flag
+  for (uint32_t time = 0; time < TOOTH_LOG_LONG_FLAG; time += 7U)
+  {
+    TEST_ASSERT_EQUAL_UINT16(0, encodeToothLogTime(time) & TOOTH_LOG_LONG_FLAG);
+    TEST_ASSERT_EQUAL_UINT32(time, decodeToothLogTime(encodeToothLogTime(time)));
+  }
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_FLAG - 1U, decodeToothLogTime(encodeToothLogTime(TOOTH_LOG_LONG_FLAG - 1U)));
+}
+
+static void test_toothLogTime_long_boundary(void)
+{
+  //The first long time is exactly representable
+  TEST_ASSERT_EQUAL_UINT16(TOOTH_LOG_LONG_FLAG | (TOOTH_LOG_LONG_FLAG >> TOOTH_LOG_LONG_SHIFT), encodeToothLogTime(TOOTH_LOG_LONG_FLAG));
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_FLAG, decodeToothLogTime(encodeToothLogTime(TOOTH_LOG_LONG_FLAG)));
+  //Times between the 32uS steps are rounded down
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_FLAG, decodeToothLogTime(encodeToothLogTime(TOOTH_LOG_LONG_FLAG + 31U)));
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_FLAG + 32U, decodeToothLogTime(encodeToothLogTime(TOOTH_LOG_LONG_FLAG + 32U)));
+}
+
+static void test_toothLogTime_long_resolution(void)
+{
+  //Long times are never out by more than the 32uS resolution, and are never longer than the real time
+  for (uint32_t time = TOOTH_LOG_LONG_FLAG; time <= TOOTH_LOG_LONG_MAX; time += 997U)
+  {
+    uint32_t decoded = decodeToothLogTime(encodeToothLogTime(time));
+    TEST_ASSERT_TRUE(decoded <= time);
+    TEST_ASSERT_TRUE((time - decoded) < (1UL << TOOTH_LOG_LONG_SHIFT));
+  }
+}
+
+static void test_toothLogTime_saturation(void)
+{
+  TEST_ASSERT_EQUAL_UINT16(0xFFFFU, encodeToothLogTime(TOOTH_LOG_LONG_MAX));
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_MAX, decodeToothLogTime(0xFFFFU));
+
+  //Anything longer is stored as the longest time, rather than wrapping to a short one
+  TEST_ASSERT_EQUAL_UINT16(0xFFFFU, encodeToothLogTime(TOOTH_LOG_LONG_MAX + 31U));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFFU, encodeToothLogTime(TOOTH_LOG_LONG_MAX + 32U));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFFU, encodeToothLogTime(2000000UL));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFFU, encodeToothLogTime(0xFFFFFFFFUL));
+  TEST_ASSERT_EQUAL_UINT32(TOOTH_LOG_LONG_MAX, decodeToothLogTime(encodeToothLogTime(0xFFFFFFFFUL)));
+}
+
+//Every stored value that encodeToothLogTime() can produce decodes to a time that encodes back to the same value
+static void test_toothLogTime_decode_roundtrip(void)
+{
+  for (uint32_t value = 0; value <= 0xFFFFU; value++)
+  {
+    //Long values below 32.768ms are never produced, as those times are stored as short values
+    if (value == TOOTH_LOG_LONG_FLAG) { value = TOOTH_LOG_LONG_FLAG | (TOOTH_LOG_LONG_FLAG >> TOOTH_LOG_LONG_SHIFT); }
+    TEST_ASSERT_EQUAL_UINT16(value, encodeToothLogTime(decodeToothLogTime((uint16_t)value)));
+  }
+}
+
+void testToothLogTime()
+{
+  RUN_TEST(test_toothLogTime_short_exact);
+  RUN_TEST(test_toothLogTime_long_boundary);
+  RUN_TEST(test_toothLogTime_long_resolution);
+  RUN_TEST(test_toothLogTime_saturation);
+  RUN_TEST(test_toothLogTime_decode_roundtrip);
+}
@@ -0,0 +1,179 @@
+#include <unity.h>
+#include "sensorFilters.h"
+#include "utilities.h"
+#include "../test_utils.h"
+
+//With an alpha of 0 the IIR filter passes its input straight through, so the output is that of the selected filter alone
+#define NO_IIR  0U
+
+//Feeds the readings through a filter on a freshly reset channel and returns the output for the last one
+static uint16_t filterReadings(byte filterType, const uint16_t *readings, uint8_t count)
+{
+  resetADCFilters();
+  uint16_t output = 0;
+  for (uint8_t x = 0; x < count; x++) { output = filterADC(ADCFILTER_CHANNEL_TPS, filterType, readings[x], NO_IIR, output); }
+  return output;
+}
+
+//Checks the output after each reading
+static void assertFilterOutputs(byte filterType, const uint16_t *readings, const uint16_t *expected, uint8_t count)
+{
+  resetADCFilters();
+  uint16_t output = 0;
+  for (uint8_t x = 0; x < count; x++)
+  {
+    output = filterADC(ADCFILTER_CHANNEL_TPS, filterType, readings[x], NO_IIR, output);
+    TEST_ASSERT_EQUAL_UINT16(expected[x], output);
+  }
+}
+
+static void test_filter_median3_spike(void)
+{
+  //The first 2 readings are passed through until the filter is full
+  const uint16_t readings[] = { 100, 101, 900, 102, 103, 0, 104 };
+  const uint16_t expected[] = { 100, 101, 101, 102, 103, 102, 103 };
+  assertFilterOutputs(ADCFILTER_TYPE_MEDIAN3, readings, expected, _countof(readings));
+}
+
+static void test_filter_median3_order(void)
+{
+  const uint16_t rising[] = { 10, 20, 30, 40, 50 };
+  const uint16_t risingExpected[] = { 10, 20, 20, 30, 40 };
+  assertFilterOutputs(ADCFILTER_TYPE_MEDIAN3, rising, risingExpected, _countof(rising));
+
+  const uint16_t falling[] = { 50, 40, 30, 20, 10 };
+  const uint16_t fallingExpected[] = { 50, 40, 40, 30, 20 };
+  assertFilterOutputs(ADCFILTER_TYPE_MEDIAN3, falling, fallingExpected, _countof(falling));
+
+  //Every order of 3 readings
+  const uint16_t orders[6][3] = { { 1, 2, 3 }, { 1, 3, 2 }, { 2, 1, 3 }, { 2, 3, 1 }, { 3, 1, 2 }, { 3, 2, 1 } };
+  for (uint8_t x = 0; x < _countof(orders); x++) { TEST_ASSERT_EQUAL_UINT16(2, filterReadings(ADCFILTER_TYPE_MEDIAN3, orders[x], 3)); }
+}
+
+static void test_filter_median3_equal(void)
+{
+  const uint16_t equal[] = { 500, 500, 500, 500 };
+  TEST_ASSERT_EQUAL_UINT16(500, filterReadings(ADCFILTER_TYPE_MEDIAN3, equal, _countof(equal)));
+  const uint16_t twoEqual[] = { 7, 3, 7 };
+  TEST_ASSERT_EQUAL_UINT16(7, filterReadings(ADCFILTER_TYPE_MEDIAN3, twoEqual, _countof(twoEqual)));
+  const uint16_t twoEqualLow[] = { 3, 3, 7 };
+  TEST_ASSERT_EQUAL_UINT16(3, filterReadings(ADCFILTER_TYPE_MEDIAN3, twoEqualLow, _countof(twoEqualLow)));
+}
+
+static void test_filter_median5_spike(void)
+{
+  //Spikes of up to 2 samples are rejected, a step of 3 samples gets through
+  const uint16_t readings[] = { 100, 100, 100, 100, 100, 900, 900, 100, 100, 100, 900, 900, 900, 900 };
+  const uint16_t expected[] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 900, 900 };
+  assertFilterOutputs(ADCFILTER_TYPE_MEDIAN5, readings, expected, _countof(readings));
+
+  const uint16_t dropout[] = { 600, 610, 0, 0, 620, 630 };
+  const uint16_t dropoutExpected[] = { 600, 610, 0, 0, 600, 610 };
+  assertFilterOutputs(ADCFILTER_TYPE_MEDIAN5, dropout, dropoutExpected, _countof(dropout));
+}
+
+static void test_filter_median5_order(void)
+{
+  const uint16_t rising[] = { 10, 20, 30, 40, 50, 60 };
+  TEST_ASSERT_EQUAL_UINT16(30, filterReadings(ADCFILTER_TYPE_MEDIAN5, rising, 5));
+  TEST_ASSERT_EQUAL_UINT16(40, filterReadings(ADCFILTER_TYPE_MEDIAN5, rising, 6));
+  const uint16_t falling[] = { 60, 50, 40, 30, 20, 10 };
+  TEST_ASSERT_EQUAL_UINT16(40, filterReadings(ADCFILTER_TYPE_MEDIAN5, falling, 5));
+  TEST_ASSERT_EQUAL_UINT16(30, filterReadings(ADCFILTER_TYPE_MEDIAN5, falling, 6));
+
+  //Every order of 5 readings (Heap's algorithm)
+  uint16_t values[5] = { 1, 2, 3, 4, 5 };
+  uint8_t counters[5] = { 0 };
+  TEST_ASSERT_EQUAL_UINT16(3, filterReadings(ADCFILTER_TYPE_MEDIAN5, values, 5));
+  uint8_t x = 1;
+  while (x < 5U)
+  {
+    if (counters[x] < x)
+    {
+      uint8_t swapIndex = ((x & 1U) == 0U) ? 0U : counters[x];
+      uint16_t temp = values[swapIndex];
+      values[swapIndex] = values[x];
+      values[x] = temp;
+      TEST_ASSERT_EQUAL_UINT16(3, filterReadings(ADCFILTER_TYPE_MEDIAN5, values, 5));
+      counters[x]++;
+      x = 1;
+    }
+    else
+    {
+      counters[x] = 0;
+      x++;
+    }
+  }
+}
+
+static void test_filter_median5_equal(void)
+{
+  const uint16_t equal[] = { 1023, 1023, 1023, 1023, 1023 };
+  TEST_ASSERT_EQUAL_UINT16(1023, filterReadings(ADCFILTER_TYPE_MEDIAN5, equal, _countof(equal)));
+  const uint16_t repeated[] = { 5, 5, 1, 5, 1 };
+  TEST_ASSERT_EQUAL_UINT16(5, filterReadings(ADCFILTER_TYPE_MEDIAN5, repeated, _countof(repeated)));
+  const uint16_t repeatedLow[] = { 1, 5, 1, 9, 1 };
+  TEST_ASSERT_EQUAL_UINT16(1, filterReadings(ADCFILTER_TYPE_MEDIAN5, repeatedLow, _countof(repeatedLow)));
+}
+
+static void test_filter_average4(void)
+{
+  //The first 3 readings are passed through until the filter is full
+  const uint16_t rising[] = { 100, 200, 300, 400, 500 };
+  const uint16_t risingExpected[] = { 100, 200, 300, 250, 350 };
+  assertFilterOutputs(ADCFILTER_TYPE_AVERAGE4, rising, risingExpected, _countof(rising));
+
+  const uint16_t falling[] = { 500, 400, 300, 200, 100 };
+  const uint16_t fallingExpected[] = { 500, 400, 300, 350, 250 };
+  assertFilterOutputs(ADCFILTER_TYPE_AVERAGE4, falling, fallingExpected, _countof(falling));
+
+  //A spike is spread over 4 outputs rather than rejected
+  const uint16_t spike[] = { 100, 100, 100, 100, 500, 100, 100, 100, 100 };
+  const uint16_t spikeExpected[] = { 100, 100, 100, 100, 200, 200, 200, 200, 100 };
+  assertFilterOutputs(ADCFILTER_TYPE_AVERAGE4, spike, spikeExpected, _countof(spike));
+}
+
+static void test_filter_average4_equal(void)
+{
+  const uint16_t equal[] = { 1023, 1023, 1023, 1023 };
+  TEST_ASSERT_EQUAL_UINT16(1023, filterReadings(ADCFILTER_TYPE_AVERAGE4, equal, _countof(equal)));
+  //The sum must not overflow
+  const uint16_t largest[] = { 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, filterReadings(ADCFILTER_TYPE_AVERAGE4, largest, _countof(largest)));
+  //Rounded down
+  const uint16_t uneven[] = { 1, 1, 1, 2 };
+  TEST_ASSERT_EQUAL_UINT16(1, filterReadings(ADCFILTER_TYPE_AVERAGE4, uneven, _countof(uneven)));
+}
+
+//Each channel keeps its own history
+static void test_filter_channels_independent(void)
+{
+  resetADCFilters();
+  const uint16_t tps[] = { 100, 900, 100 };
+  const uint16_t clt[] = { 500, 510, 520 };
+  uint16_t tpsOutput = 0;
+  uint16_t cltOutput = 0;
+  for (uint8_t x = 0; x < _countof(tps); x++)
+  {
+    tpsOutput = filterADC(ADCFILTER_CHANNEL_TPS, ADCFILTER_TYPE_MEDIAN3, tps[x], NO_IIR, tpsOutput);
+    cltOutput = filterADC(ADCFILTER_CHANNEL_CLT, ADCFILTER_TYPE_MEDIAN3, clt[x], NO_IIR, cltOutput);
+  }
+  TEST_ASSERT_EQUAL_UINT16(100, tpsOutput);
+  TEST_ASSERT_EQUAL_UINT16(510, cltOutput);
+}
+
+void testSensorFilters()
+{
+  SET_UNITY_FILENAME() {
+
+  RUN_TEST(test_filter_median3_spike);
+  RUN_TEST(test_filter_median3_order);
+  RUN_TEST(test_filter_median3_equal);
+  RUN_TEST(test_filter_median5_spike);
+  RUN_TEST(test_filter_median5_order);
+  RUN_TEST(test_filter_median5_equal);
+  RUN_TEST(test_filter_average4);
+  RUN_TEST(test_filter_average4_equal);
+  RUN_TEST(test_filter_channels_independent);
+  }
+}
@@ -0,0 +1,263 @@
+// Host test of the dirty block tracking and the page byte to EEPROM address mapping used by burns (See speeduino/storage_dirty.h)
+// A table is changed through the same offset mapping as the TunerStudio page writes (offset_to_table in pages.cpp), only the dirty blocks are
+// written to a model of the EEPROM by writeDirtyBlocks(), and the table is then loaded back by loadTableStorage(). These are the burn and load
+// that storage.cpp uses. The loaded table must match the table in memory. In particular the Y axis, which is stored in the reverse of the page order.
+// Run with: pio test -e native -f test_storage_native
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../speeduino/table3d.h"
+#include "../../speeduino/table3d.cpp"
+#include "../../speeduino/storage_dirty.h"
+
+static uint8_t eeprom[EEPROM_DIRTY_PAGE_SIZE];
+
+//Axis values are kept below 256 so that they are stored as they are (See getPageByte())
+static byte to_byte_1(int16_t value) { return (byte)value; }
+static int16_t from_byte_1(byte in) { return (int16_t)in; }
+table3d_axis_io_converter get_table3d_axis_converter(axis_domain domain) { (void)domain; return table3d_axis_io_converter { &to_byte_1, &from_byte_1 }; }
+
+// ================= Page access (As offset_to_table in pages.cpp) ===================
+template <class table_t>
+static constexpr uint16_t table_value_end(void) { return table_t::xaxis_t::length * table_t::yaxis_t::length; }
+template <class table_t>
+static constexpr uint16_t table_axisx_end(void) { return table_value_end<table_t>() + table_t::xaxis_t::length; }
+template <class table_t>
+static constexpr uint16_t table_page_size(void) { return table_axisx_end<table_t>() + table_t::yaxis_t::length; }
+
+//Axis values are kept below 256 so that they are stored as they are, without the axis converters
+template <class table_t>
+static uint8_t getPageByte(table_t &table, uint16_t offset)
+{
+  if (offset < table_value_end<table_t>()) { return table.values.value_at((uint8_t)offset); }
+  if (offset < table_axisx_end<table_t>()) { return (uint8_t)*(table.axisX.begin().advance(offset - table_value_end<table_t>())); }
+  return (uint8_t)*(table.axisY.begin().advance(offset - table_axisx_end<table_t>()));
+}
+
+template <class table_t>
+static void setPageByte(table_t &table, uint16_t offset, uint8_t value)
+{
+  if (offset < table_value_end<table_t>()) { table.values.value_at((uint8_t)offset) = value; }
+  else if (offset < table_axisx_end<table_t>()) { *(table.axisX.begin().advance(offset - table_value_end<table_t>())) = value; }
+  else { *(table.axisY.begin().advance(offset - table_axisx_end<table_t>())) = value; }
+}
+
+// ================= Burn and load through the EEPROM model ===================
+//A table as the only entity of a page (As page_storage in storage.cpp)
+template <class table_t>
+struct table_storage {
+  table_t &table;
+
+  void getValues(uint16_t offset, uint8_t *buffer, uint16_t length) const
+  {
+    for (uint16_t x = 0; x < length; x++) { buffer[x] = getPageByte(table, offset + x); }
+  }
+
+  bool getStorageAddress(uint16_t offset, uint16_t &address) const
+  {
+    address = table_storage_offset<table_t>(offset);
+    return true;
+  }
+};
+
+//EEPROM writes of the bytes that have changed, limited to a number of bytes per burn (As write_location in storage.cpp)
+struct eeprom_location {
+  uint16_t address;
+  uint16_t counter;
+  uint16_t write_block_size;
+
+  void update(uint8_t value)
+  {
+    TEST_ASSERT_TRUE(address < sizeof(eeprom));
+    if (eeprom[address] != value)
+    {
+      eeprom[address] = value;
+      ++counter;
+    }
+  }
+
+  bool can_write() const { return counter <= write_block_size; }
+};
+
+//Reads the EEPROM model in order (As eeprom_reader in storage.cpp)
+struct eeprom_reader {
+  uint16_t address;
+
+  void read(byte *pBuffer, uint8_t length)
+  {
+    memcpy(pBuffer, eeprom + address, length);
+    address += length;
+  }
+};
+
+//Burns the dirty blocks, a limited number of bytes at a time as writeConfigChanges() does. Returns the number of burns needed
+template <class table_t>
+static uint16_t writeDirtyTable(table_t &table, dirty_blocks_t &blocks, uint16_t writeLimit = 0xFFFFU)
+{
+  table_storage<table_t> page = { table };
+  uint16_t burns = 0;
+  bool isDirty = true;
+  while (isDirty)
+  {
+    eeprom_location location = { 0, 0, writeLimit };
+    writeDirtyBlocks(blocks, table_page_size<table_t>(), page, location);
+    TEST_ASSERT_TRUE(location.counter <= (writeLimit + 1U));
+    ++burns;
+    isDirty = false;
+    for (uint8_t block = 0; block < EEPROM_DIRTY_BLOCKS; block++) { isDirty = isDirty || isDirtyBlock(blocks, block); }
+    TEST_ASSERT_TRUE(burns < 1000U);
+  }
+  return burns;
+}
+
+template <class table_t>
+static void loadTable(table_t &table)
+{
+  eeprom_reader reader = { 0 };
+  loadTableStorage(reader, &table, table_t::type_key);
+  TEST_ASSERT_EQUAL_UINT16(table_page_size<table_t>(), reader.address);
+}
+
+template <class table_t>
+static void fillTable(table_t &table)
+{
+  for (uint16_t offset = 0; offset < table_page_size<table_t>(); offset++) { setPageByte(table, offset, (uint8_t)rand()); }
+}
+
+template <class table_t>
+static void checkTablesMatch(table_t &expected, table_t &actual)
+{
+  for (uint16_t offset = 0; offset < table_page_size<table_t>(); offset++) { TEST_ASSERT_EQUAL_HEX8(getPageByte(expected, offset), getPageByte(actual, offset)); }
+}
+
+// ================= Tests ===================
+//Every page offset of a table maps to a different storage offset within the table's storage
+template <class table_t>
+static void check_storage_offsets(void)
+{
+  bool used[EEPROM_DIRTY_PAGE_SIZE] = { false };
+  for (uint16_t offset = 0; offset < table_page_size<table_t>(); offset++)
+  {
+    uint16_t storage = table_storage_offset<table_t>(offset);
+    TEST_ASSERT_TRUE(storage < table_page_size<table_t>());
+    TEST_ASSERT_FALSE(used[storage]);
+    used[storage] = true;
+  }
+  //The Y axis is reversed and everything before it is unchanged
+  TEST_ASSERT_EQUAL_UINT16(table_axisx_end<table_t>() - 1U, table_storage_offset<table_t>(table_axisx_end<table_t>() - 1U));
+  TEST_ASSERT_EQUAL_UINT16(table_page_size<table_t>() - 1U, table_storage_offset<table_t>(table_axisx_end<table_t>()));
+  TEST_ASSERT_EQUAL_UINT16(table_axisx_end<table_t>(), table_storage_offset<table_t>(table_page_size<table_t>() - 1U));
+}
+
+static void test_storage_offsets(void)
+{
+  check_storage_offsets<table3d16RpmLoad>();
+  check_storage_offsets<table3d8RpmLoad>();
+  check_storage_offsets<table3d6RpmLoad>();
+  check_storage_offsets<table3d4RpmLoad>();
+}
+
+//Dirty blocks are exactly the blocks that overlap the range, clipped to the largest page
+static void test_storage_dirty_ranges(void)
+{
+  for (uint16_t offset = 0; offset < (EEPROM_DIRTY_PAGE_SIZE + 20U); offset++)
+  {
+    for (uint16_t length = 0; length < (EEPROM_DIRTY_PAGE_SIZE + 20U); length++)
+    {
+      dirty_blocks_t blocks = { 0 };
+      markDirtyBlocks(blocks, offset, length);
+      for (uint8_t block = 0; block < EEPROM_DIRTY_BLOCKS; block++)
+      {
+        uint16_t blockStart = (uint16_t)block * EEPROM_DIRTY_BLOCK_SIZE;
+        bool overlaps = (length > 0U) && (offset < (blockStart + EEPROM_DIRTY_BLOCK_SIZE)) && ((uint32_t)(offset + length) > blockStart);
+        TEST_ASSERT_EQUAL(overlaps, isDirtyBlock(blocks, block));
+      }
+    }
+  }
+}
+
+//Writes to random ranges of a table, each burnt through the dirty blocks and then loaded back from the EEPROM
+template <class table_t>
+static void check_burn_and_load(void)
+{
+  table_t table;
+  table_t loaded;
+  dirty_blocks_t blocks = { 0 };
+  srand(1);
+
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  fillTable(table);
+  markDirtyBlocks(blocks, 0U, table_page_size<table_t>());
+  writeDirtyTable(table, blocks);
+  loadTable(loaded);
+  checkTablesMatch(table, loaded);
+
+  for (uint16_t write = 0; write < 500U; write++)
+  {
+    uint16_t offset = rand() % table_page_size<table_t>();
+    uint16_t length = 1U + (rand() % (table_page_size<table_t>() - offset));
+    if ((rand() % 2) == 0) { length = (length > 4U) ? 4U : length; } //Mostly single cell edits, as the table editor sends
+    for (uint16_t x = offset; x < (offset + length); x++) { setPageByte(table, x, (uint8_t)rand()); }
+    markDirtyBlocks(blocks, offset, length);
+
+    writeDirtyTable(table, blocks);
+    for (uint8_t block = 0; block < EEPROM_DIRTY_BLOCKS; block++) { TEST_ASSERT_FALSE(isDirtyBlock(blocks, block)); }
+    loadTable(loaded);
+    checkTablesMatch(table, loaded);
+  }
+}
+
+static void test_storage_burn_and_load(void)
+{
+  check_burn_and_load<table3d16RpmLoad>();
+  check_burn_and_load<table3d8RpmTps>();
+  check_burn_and_load<table3d6RpmLoad>();
+  check_burn_and_load<table3d4RpmLoad>();
+}
+
+//A burn that reaches the write limit part way through a block leaves that block dirty, and a later burn completes it
+template <class table_t>
+static void check_burn_limited(void)
+{
+  table_t table;
+  table_t loaded;
+  dirty_blocks_t blocks = { 0 };
+  const uint16_t writeLimit = 6U; //Burns stop after 7 bytes have been written. Not a factor of the block size
+  srand(2);
+
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  fillTable(table);
+  for (uint16_t offset = 0; offset < table_page_size<table_t>(); offset++) { if (getPageByte(table, offset) == 0xFFU) { setPageByte(table, offset, 0); } } //Every byte must be written
+  markDirtyBlocks(blocks, 0U, table_page_size<table_t>());
+  TEST_ASSERT_EQUAL_UINT16((table_page_size<table_t>() + writeLimit) / (writeLimit + 1U), writeDirtyTable(table, blocks, writeLimit));
+  loadTable(loaded);
+  checkTablesMatch(table, loaded);
+
+  //An edit to a whole block, which is more than one burn can write
+  for (uint16_t offset = 16; offset < 32U; offset++) { setPageByte(table, offset, (uint8_t)(getPageByte(table, offset) ^ 0x55U)); }
+  markDirtyBlocks(blocks, 16, 16);
+  TEST_ASSERT_EQUAL_UINT16((EEPROM_DIRTY_BLOCK_SIZE + writeLimit) / (writeLimit + 1U), writeDirtyTable(table, blocks, writeLimit));
+  loadTable(loaded);
+  checkTablesMatch(table, loaded);
+}
+
+static void test_storage_burn_limited(void)
+{
+  check_burn_limited<table3d16RpmLoad>();
+  check_burn_limited<table3d6RpmLoad>();
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+
+  RUN_TEST(test_storage_offsets);
+  RUN_TEST(test_storage_dirty_ranges);
+  RUN_TEST(test_storage_burn_and_load);
+  RUN_TEST(test_storage_burn_limited);
+
+  return UNITY_END();
+}
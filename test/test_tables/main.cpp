@@ -3,6 +3,8 @@
 
 #include "tests_tables.h"
 #include "test_table2d.h"
+#include "test_pages.h"
+#include "test_tune_banks.h"
 
 #define UNITY_EXCLUDE_DETAILS
 
@@ -18,6 +20,8 @@ void setup()
 
     testTables();
     testTable2d();
+    testPages();
+    testTuneBanks();
 
     UNITY_END(); // stop unit testing
 }
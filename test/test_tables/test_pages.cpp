@@ -0,0 +1,88 @@
+#include <string.h> // memset
+#include <unity.h>
+#include "test_pages.h"
+#include "pages.h"
+#include "page_crc.h"
+#include "../test_utils.h"
+
+// Fill every page with a known pattern, one byte at a time
+static void fill_pages(void)
+{
+  for (uint8_t page = 1; page < getPageCount(); page++)
+  {
+    for (uint16_t offset = 0; offset < getPageSize(page); offset++)
+    {
+      setPageValue(page, offset, (byte)(offset + page));
+    }
+  }
+}
+
+static void test_getPageValues_matches_getPageValue(void)
+{
+  fill_pages();
+
+  static byte buffer[384];
+  for (uint8_t page = 1; page < getPageCount(); page++)
+  {
+    uint16_t pageSize = getPageSize(page);
+    memset(buffer, 0xAA, sizeof(buffer));
+    getPageValues(page, 0, buffer, pageSize);
+    for (uint16_t offset = 0; offset < pageSize; offset++)
+    {
+      TEST_ASSERT_EQUAL_UINT8(getPageValue(page, offset), buffer[offset]);
+    }
+  }
+}
+
+static void test_getPageValues_partial_range(void)
+{
+  fill_pages();
+
+  //Start part way through a table row and finish part way through the x axis
+  static byte buffer[100];
+  getPageValues(veMapPage, 250, buffer, sizeof(buffer));
+  for (uint16_t offset = 0; offset < sizeof(buffer); offset++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(getPageValue(veMapPage, 250 + offset), buffer[offset]);
+  }
+}
+
+static void test_setPageValues_matches_setPageValue(void)
+{
+  fill_pages();
+
+  //Span the boundary between the last table and the config block on the page
+  static byte buffer[64];
+  for (uint8_t x = 0; x < sizeof(buffer); x++) { buffer[x] = (byte)(200U - x); }
+  setPageValues(boostvvtPage2, 60, buffer, sizeof(buffer));
+  for (uint8_t x = 0; x < sizeof(buffer); x++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(buffer[x], getPageValue(boostvvtPage2, 60 + x));
+  }
+  //Neighbouring bytes must be unchanged
+  TEST_ASSERT_EQUAL_UINT8((byte)(59 + boostvvtPage2), getPageValue(boostvvtPage2, 59));
+  TEST_ASSERT_EQUAL_UINT8((byte)(124 + boostvvtPage2), getPageValue(boostvvtPage2, 124));
+}
+
+static void test_pageCRC_invalidated_by_write(void)
+{
+  fill_pages();
+
+  uint32_t crc = calculatePageCRC32(veSetPage);
+  TEST_ASSERT_EQUAL_UINT32(crc, calculatePageCRC32(veSetPage)); //Cached value
+
+  byte original = getPageValue(veSetPage, 10);
+  setPageValue(veSetPage, 10, original + 1U);
+  TEST_ASSERT_NOT_EQUAL(crc, calculatePageCRC32(veSetPage));
+
+  setPageValues(veSetPage, 10, &original, 1);
+  TEST_ASSERT_EQUAL_UINT32(crc, calculatePageCRC32(veSetPage));
+}
+
+void testPages()
+{
+  RUN_TEST(test_getPageValues_matches_getPageValue);
+  RUN_TEST(test_getPageValues_partial_range);
+  RUN_TEST(test_setPageValues_matches_setPageValue);
+  RUN_TEST(test_pageCRC_invalidated_by_write);
+}
@@ -0,0 +1,104 @@
+#include <unity.h>
+#include "test_tune_banks.h"
+#include "tuneBanks.h"
+#include "pages.h"
+
+#define TEST_BANK_COUNT 4U //The most banks that can be selected (Pins or TunerStudio buttons). The mapping doesn't depend on TUNE_BANK_COUNT
+
+static void test_tuneBankPage_index_roundtrip(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(veMapPage, getTuneBankPage(0));
+  TEST_ASSERT_EQUAL_UINT8(ignMapPage, getTuneBankPage(1));
+  TEST_ASSERT_EQUAL_UINT8(afrMapPage, getTuneBankPage(2));
+  for (uint8_t index = 0; index < TUNE_BANK_PAGES; index++)
+  {
+    TEST_ASSERT_EQUAL_INT8(index, getTuneBankPageIndex(getTuneBankPage(index)));
+  }
+  TEST_ASSERT_EQUAL_INT8(-1, getTuneBankPageIndex(veSetPage));
+  TEST_ASSERT_EQUAL_INT8(-1, getTuneBankPageIndex(fuelMap2Page));
+}
+
+//Bank 0, and every page that isn't part of a bank, is stored in the record with the same id as the page
+static void test_journalRecordId_unbanked_pages(void)
+{
+  for (uint8_t page = 0; page < getPageCount(); page++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(page, getJournalRecordId(page, 0));
+    TEST_ASSERT_EQUAL_UINT8(page, getJournalRecordPage(page));
+    if (getTuneBankPageIndex(page) < 0) { TEST_ASSERT_EQUAL_UINT8(page, getJournalRecordId(page, TEST_BANK_COUNT - 1U)); }
+  }
+  TEST_ASSERT_TRUE(JOURNAL_TUNE_BANK_RECORDS >= getPageCount()); //Bank records can't overlap the page records
+}
+
+//Each page of each bank has its own record, which maps back to the page
+static void test_journalRecordId_banked_pages(void)
+{
+  bool used[JOURNAL_TUNE_BANK_RECORDS + ((TEST_BANK_COUNT - 1U) * TUNE_BANK_PAGES)] = { false };
+  for (uint8_t bank = 1; bank < TEST_BANK_COUNT; bank++)
+  {
+    for (uint8_t index = 0; index < TUNE_BANK_PAGES; index++)
+    {
+      uint8_t recordId = getJournalRecordId(getTuneBankPage(index), bank);
+      TEST_ASSERT_TRUE(recordId >= JOURNAL_TUNE_BANK_RECORDS);
+      TEST_ASSERT_TRUE(recordId < sizeof(used));
+      TEST_ASSERT_FALSE(used[recordId]);
+      used[recordId] = true;
+      TEST_ASSERT_EQUAL_UINT8(getTuneBankPage(index), getJournalRecordPage(recordId));
+    }
+  }
+}
+
+static void test_setTuneBankTables_bank0(void)
+{
+  setTuneBankTables(0);
+  TEST_ASSERT_EQUAL_UINT8(0, activeTuneBank);
+  TEST_ASSERT_EQUAL_PTR(&fuelTable, pFuelTable);
+  TEST_ASSERT_EQUAL_PTR(&ignitionTable, pIgnitionTable);
+  TEST_ASSERT_EQUAL_PTR(&afrTable, pAfrTable);
+
+  //Banks that the board doesn't have are ignored
+  setTuneBankTables(TUNE_BANK_COUNT);
+  TEST_ASSERT_EQUAL_UINT8(0, activeTuneBank);
+  TEST_ASSERT_EQUAL_PTR(&fuelTable, pFuelTable);
+}
+
+//A switch marks every bank page as changed until the tuning software reads it or its CRC. Other pages are never marked
+static void test_tuneBank_changed_until_read(void)
+{
+  initialiseTuneBanks();
+  TEST_ASSERT_FALSE(isTuneBankChanged());
+#if TUNE_BANK_COUNT > 1
+  uint8_t savedMode = configPage15.tuneBankMode;
+  configPage15.tuneBankMode = TUNE_BANK_MODE_COMMS;
+  selectTuneBank(1);
+  tuneBankControl();
+  TEST_ASSERT_EQUAL_UINT8(1, activeTuneBank);
+  TEST_ASSERT_TRUE(isTuneBankChanged());
+  for (uint8_t index = 0; index < TUNE_BANK_PAGES; index++) { TEST_ASSERT_TRUE(isTuneBankPageStale(getTuneBankPage(index))); }
+  TEST_ASSERT_FALSE(isTuneBankPageStale(veSetPage));
+
+  for (uint8_t index = 0; index < TUNE_BANK_PAGES; index++)
+  {
+    TEST_ASSERT_TRUE(isTuneBankChanged());
+    markTuneBankPageRead(getTuneBankPage(index));
+    TEST_ASSERT_FALSE(isTuneBankPageStale(getTuneBankPage(index)));
+  }
+  TEST_ASSERT_FALSE(isTuneBankChanged());
+
+  configPage15.tuneBankMode = savedMode;
+  initialiseTuneBanks();
+#else
+  markTuneBankPageRead(veMapPage);
+  for (uint8_t page = 0; page < getPageCount(); page++) { TEST_ASSERT_FALSE(isTuneBankPageStale(page)); }
+  TEST_ASSERT_FALSE(isTuneBankChanged());
+#endif
+}
+
+void testTuneBanks()
+{
+  RUN_TEST(test_tuneBankPage_index_roundtrip);
+  RUN_TEST(test_journalRecordId_unbanked_pages);
+  RUN_TEST(test_journalRecordId_banked_pages);
+  RUN_TEST(test_setTuneBankTables_bank0);
+  RUN_TEST(test_tuneBank_changed_until_read);
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+extern void testTuneBanks();